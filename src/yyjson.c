@@ -305,6 +305,23 @@ uint32_t yyjson_version(void) {
 #define YYJSON_WRITER_ESTIMATED_PRETTY_RATIO 32
 #define YYJSON_WRITER_ESTIMATED_MINIFY_RATIO 18
 
+/* The minimum data size of each thread in the multi-threaded reader. */
+#define YYJSON_READER_PARALLEL_MIN_SIZE     0x100000
+
+/* The minimum number of values of each thread in the multi-threaded writer. */
+#define YYJSON_WRITER_PARALLEL_MIN_NUM      0x10000
+
+/* The default buffer size of the streaming writer. */
+#define YYJSON_WRITER_STREAM_BUF_SIZE       0x10000
+
+/* The initial data buffer size of the incremental reader. */
+#define YYJSON_READER_INCR_BUF_INIT_SIZE    0x1000
+
+/* The initial stream buffer size, and the minimum data size of each thread
+   in the lines reader. */
+#define YYJSON_READER_LINES_BUF_INIT_SIZE   0x10000
+#define YYJSON_READER_LINES_MIN_SIZE        0x40000
+
 /* The initial and maximum size of the memory pool's chunk in yyjson_mut_doc. */
 #define YYJSON_MUT_DOC_STR_POOL_INIT_SIZE   0x100
 #define YYJSON_MUT_DOC_STR_POOL_MAX_SIZE    0x10000000
@@ -333,6 +350,121 @@ uint32_t yyjson_version(void) {
 #ifndef YYJSON_DISABLE_UTF8_VALIDATION
 #define YYJSON_DISABLE_UTF8_VALIDATION 0
 #endif
+#ifndef YYJSON_DISABLE_SIMD
+#define YYJSON_DISABLE_SIMD 0
+#endif
+#ifndef YYJSON_DISABLE_THREADS
+#define YYJSON_DISABLE_THREADS 0
+#endif
+
+/*
+ SIMD instruction sets.
+ 
+ SSE2 is part of the x86-64 baseline and NEON is part of the AArch64 baseline,
+ so the kernels for them are selected at compile-time. AVX2 and AVX-512 kernels
+ are compiled with function-level target attributes and selected at run-time
+ after a CPU feature check, so the binary still runs on older CPUs.
+ */
+#if !YYJSON_DISABLE_SIMD && (defined(__SSE2__) || defined(_M_X64) || \
+    defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#   define YYJSON_HAS_SSE2 1
+#   include <emmintrin.h>
+#else
+#   define YYJSON_HAS_SSE2 0
+#endif
+
+#if !YYJSON_DISABLE_SIMD && !YYJSON_HAS_SSE2 && \
+    (defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)) && \
+    YYJSON_ENDIAN == YYJSON_LITTLE_ENDIAN
+#   define YYJSON_HAS_NEON 1
+#   include <arm_neon.h>
+#else
+#   define YYJSON_HAS_NEON 0
+#endif
+
+#if YYJSON_HAS_SSE2 && !YYJSON_MSC_VER && \
+    (defined(__x86_64__) || defined(__i386__)) && \
+    ((YYJSON_IS_REAL_GCC && yyjson_gcc_available(5, 0, 0)) || \
+     (defined(__clang__) && yyjson_has_builtin(__builtin_cpu_supports)))
+#   define YYJSON_HAS_X86_DISPATCH 1
+#   include <immintrin.h>
+#   define YYJSON_TARGET_AVX2 __attribute__((target("avx2")))
+#   define YYJSON_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+#else
+#   define YYJSON_HAS_X86_DISPATCH 0
+#endif
+
+#define YYJSON_HAS_SIMD (YYJSON_HAS_SSE2 || YYJSON_HAS_NEON)
+
+/*
+ Thread support, used by the multi-threaded reader and writer only.
+ Windows threads are used on Windows, POSIX threads are used on Unix-like OS.
+ */
+#if !YYJSON_DISABLE_THREADS && \
+    (!YYJSON_DISABLE_READER || !YYJSON_DISABLE_WRITER) && defined(_WIN32)
+#   define YYJSON_HAS_WIN_THREADS 1
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+#   include <windows.h>
+#else
+#   define YYJSON_HAS_WIN_THREADS 0
+#endif
+
+#if !YYJSON_DISABLE_THREADS && \
+    (!YYJSON_DISABLE_READER || !YYJSON_DISABLE_WRITER) && !defined(_WIN32) && \
+    (defined(__unix__) || defined(__unix) || defined(__APPLE__))
+#   define YYJSON_HAS_PTHREADS 1
+#   include <pthread.h>
+#   include <unistd.h>
+#else
+#   define YYJSON_HAS_PTHREADS 0
+#endif
+
+#define YYJSON_HAS_THREADS (YYJSON_HAS_WIN_THREADS || YYJSON_HAS_PTHREADS)
+
+/*
+ Memory-mapped file support, used by `yyjson_read_file()` and
+ `yyjson_compact_load_binary()` with the flag `YYJSON_READ_MMAP` only.
+ The anonymous mapping is required to place zero padding after the file
+ content.
+ */
+#if !YYJSON_DISABLE_READER && !defined(_WIN32) && \
+    (defined(__unix__) || defined(__unix) || defined(__APPLE__))
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+#if !YYJSON_DISABLE_READER && defined(MAP_FIXED) && defined(S_ISREG) && \
+    (defined(MAP_ANONYMOUS) || defined(MAP_ANON))
+#   define YYJSON_HAS_MMAP 1
+#   ifndef MAP_ANONYMOUS
+#       define MAP_ANONYMOUS MAP_ANON
+#   endif
+#   ifndef O_CLOEXEC
+#       define O_CLOEXEC 0
+#   endif
+#else
+#   define YYJSON_HAS_MMAP 0
+#endif
+
+/*
+ File descriptor support, used by `yyjson_write_fd()` and other `_fd` writers
+ only.
+ */
+#if !YYJSON_DISABLE_WRITER && defined(_WIN32)
+#   define YYJSON_HAS_FD_WRITE 1
+#   include <io.h>
+#elif !YYJSON_DISABLE_WRITER && \
+    (defined(__unix__) || defined(__unix) || defined(__APPLE__))
+#   define YYJSON_HAS_FD_WRITE 1
+#   include <errno.h>
+#   include <unistd.h>
+#else
+#   define YYJSON_HAS_FD_WRITE 0
+#endif
 
 
 
@@ -414,7 +546,9 @@ static_inline bool write_flag_eq(yyjson_write_flag flg, yyjson_write_flag chk) {
  * Integer Constants
  *============================================================================*/
 
-/* U64 constant values */
+/* U32 and U64 constant values */
+#undef  U32_MAX
+#define U32_MAX         ((u32)0xFFFFFFFF)
 #undef  U64_MAX
 #define U64_MAX         U64(0xFFFFFFFF, 0xFFFFFFFF)
 #undef  I64_MAX
@@ -882,6 +1016,15 @@ static_inline u32 u64_tz_bits(u64 v) {
 #endif
 }
 
+/** Returns the number of 1-bits in value. */
+static_inline u32 u64_pop_count(u64 v) {
+    v = v - ((v >> 1) & U64(0x55555555, 0x55555555));
+    v = (v & U64(0x33333333, 0x33333333)) +
+        ((v >> 2) & U64(0x33333333, 0x33333333));
+    v = (v + (v >> 4)) & U64(0x0F0F0F0F, 0x0F0F0F0F);
+    return (u32)((v * U64(0x01010101, 0x01010101)) >> 56);
+}
+
 
 
 /*==============================================================================
@@ -931,6 +1074,205 @@ static_inline void u128_mul_add(u64 a, u64 b, u64 c, u64 *hi, u64 *lo) {
 
 
 
+/*==============================================================================
+ * CPU Feature Utils
+ * These functions are used to select SIMD kernels at run-time.
+ *============================================================================*/
+
+#if YYJSON_HAS_X86_DISPATCH
+
+/** Returns whether the CPU and OS support AVX2. */
+static_inline bool cpu_supports_avx2(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+}
+
+/** Returns whether the CPU and OS support AVX-512 Byte and Word. */
+static_inline bool cpu_supports_avx512bw(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f") != 0 &&
+           __builtin_cpu_supports("avx512bw") != 0;
+}
+
+#endif
+
+
+
+/*==============================================================================
+ * Thread Utils
+ * These functions are used by the multi-threaded reader and writer.
+ *============================================================================*/
+
+#if !YYJSON_DISABLE_READER || !YYJSON_DISABLE_WRITER
+
+#if YYJSON_HAS_THREADS
+
+/** A function running on a new thread. */
+typedef struct thread_task {
+    void (*func)(void *arg);
+    void *arg;
+#if YYJSON_HAS_WIN_THREADS
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+} thread_task;
+
+/** A mutual exclusion lock. */
+typedef struct thread_mutex {
+#if YYJSON_HAS_WIN_THREADS
+    CRITICAL_SECTION cs;
+#else
+    pthread_mutex_t mtx;
+#endif
+} thread_mutex;
+
+#if YYJSON_HAS_WIN_THREADS
+static DWORD WINAPI thread_entry(LPVOID ptr) {
+    thread_task *task = (thread_task *)ptr;
+    task->func(task->arg);
+    return 0;
+}
+#else
+static void *thread_entry(void *ptr) {
+    thread_task *task = (thread_task *)ptr;
+    task->func(task->arg);
+    return NULL;
+}
+#endif
+
+/** Runs the task on a new thread, returns false if the thread cannot be
+    created. */
+static bool thread_start(thread_task *task) {
+#if YYJSON_HAS_WIN_THREADS
+    task->handle = CreateThread(NULL, 0, thread_entry, (LPVOID)task, 0, NULL);
+    return task->handle != NULL;
+#else
+    return pthread_create(&task->handle, NULL, thread_entry, task) == 0;
+#endif
+}
+
+/** Waits for the task to finish. */
+static void thread_join(thread_task *task) {
+#if YYJSON_HAS_WIN_THREADS
+    WaitForSingleObject(task->handle, INFINITE);
+    CloseHandle(task->handle);
+#else
+    pthread_join(task->handle, NULL);
+#endif
+}
+
+static bool thread_mutex_init(thread_mutex *mtx) {
+#if YYJSON_HAS_WIN_THREADS
+    InitializeCriticalSection(&mtx->cs);
+    return true;
+#else
+    return pthread_mutex_init(&mtx->mtx, NULL) == 0;
+#endif
+}
+
+static void thread_mutex_destroy(thread_mutex *mtx) {
+#if YYJSON_HAS_WIN_THREADS
+    DeleteCriticalSection(&mtx->cs);
+#else
+    pthread_mutex_destroy(&mtx->mtx);
+#endif
+}
+
+static void thread_mutex_lock(thread_mutex *mtx) {
+#if YYJSON_HAS_WIN_THREADS
+    EnterCriticalSection(&mtx->cs);
+#else
+    pthread_mutex_lock(&mtx->mtx);
+#endif
+}
+
+static void thread_mutex_unlock(thread_mutex *mtx) {
+#if YYJSON_HAS_WIN_THREADS
+    LeaveCriticalSection(&mtx->cs);
+#else
+    pthread_mutex_unlock(&mtx->mtx);
+#endif
+}
+
+/** Returns the number of online processors, or 1 if unknown. */
+static usize thread_cpu_count(void) {
+#if YYJSON_HAS_WIN_THREADS
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors ? (usize)info.dwNumberOfProcessors : 1;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    long num = sysconf(_SC_NPROCESSORS_ONLN);
+    return num > 0 ? (usize)num : 1;
+#else
+    return 1;
+#endif
+}
+
+/** The context of an allocator with a lock. */
+typedef struct locked_alc_ctx {
+    yyjson_alc alc;
+    thread_mutex mtx;
+} locked_alc_ctx;
+
+static void *locked_malloc(void *ctx_ptr, usize size) {
+    locked_alc_ctx *ctx = (locked_alc_ctx *)ctx_ptr;
+    void *ptr;
+    thread_mutex_lock(&ctx->mtx);
+    ptr = ctx->alc.malloc_(ctx->alc.ctx, size);
+    thread_mutex_unlock(&ctx->mtx);
+    return ptr;
+}
+
+static void *locked_realloc(void *ctx_ptr, void *ptr,
+                            usize old_size, usize size) {
+    locked_alc_ctx *ctx = (locked_alc_ctx *)ctx_ptr;
+    thread_mutex_lock(&ctx->mtx);
+    ptr = ctx->alc.realloc_(ctx->alc.ctx, ptr, old_size, size);
+    thread_mutex_unlock(&ctx->mtx);
+    return ptr;
+}
+
+static void locked_free(void *ctx_ptr, void *ptr) {
+    locked_alc_ctx *ctx = (locked_alc_ctx *)ctx_ptr;
+    thread_mutex_lock(&ctx->mtx);
+    ctx->alc.free_(ctx->alc.ctx, ptr);
+    thread_mutex_unlock(&ctx->mtx);
+}
+
+#endif /* YYJSON_HAS_THREADS */
+
+/** Runs the function for each part, the first part runs on the calling
+    thread, the others run on new threads if possible. The `tasks` memory
+    holds `num` thread tasks followed by `num` bools. */
+static void thread_run_parts(void (*func)(void *), void *parts,
+                             usize part_size, usize num, void *tasks) {
+    u8 *part = (u8 *)parts;
+#if YYJSON_HAS_THREADS
+    thread_task *task = (thread_task *)tasks;
+    bool *started = (bool *)(void *)(task + num);
+    usize i;
+    for (i = 1; i < num; i++) {
+        task[i].func = func;
+        task[i].arg = (void *)(part + i * part_size);
+        started[i] = thread_start(&task[i]);
+    }
+    func((void *)part);
+    for (i = 1; i < num; i++) {
+        if (started[i]) thread_join(&task[i]);
+        else func((void *)(part + i * part_size));
+    }
+#else
+    usize i;
+    (void)tasks;
+    for (i = 0; i < num; i++) func((void *)(part + i * part_size));
+#endif
+}
+
+#endif /* !YYJSON_DISABLE_READER || !YYJSON_DISABLE_WRITER */
+
+
+
 /*==============================================================================
  * File Utils
  * These functions are used to read and write JSON files.
@@ -970,6 +1312,115 @@ static_inline usize fread_safe(void *buf, usize size, FILE *file) {
 #endif
 }
 
+#if YYJSON_HAS_MMAP
+
+/** Maps the regular file to memory with private copy-on-write pages, the
+    content is followed by at least `YYJSON_PADDING_SIZE` zero bytes:
+    the tail of the last file page is filled with zero by the system, and an
+    anonymous zero page follows if the tail is too short.
+    Returns false if the file cannot be mapped (e.g. empty file or pipe). */
+static bool mmap_file(const char *path, u8 **map, usize *map_len,
+                      usize *file_len) {
+    struct stat st;
+    usize page, len, map_size, file_size;
+    long page_size;
+    void *mem;
+    int fd;
+    
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return false;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+        (u64)st.st_size > (u64)(USIZE_MAX / 2)) {
+        close(fd);
+        return false;
+    }
+    page_size = sysconf(_SC_PAGESIZE);
+    page = page_size > 0 ? (usize)page_size : (usize)0x1000;
+    len = (usize)st.st_size;
+    file_size = size_align_up(len, page);
+    map_size = size_align_up(len + YYJSON_PADDING_SIZE, page);
+    
+    /* reserve the zeroed memory, then map the file pages over it */
+    mem = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    if (mmap(mem, file_size, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(mem, map_size);
+        close(fd);
+        return false;
+    }
+    close(fd);
+    *map = (u8 *)mem;
+    *map_len = map_size;
+    *file_len = len;
+    return true;
+}
+
+/** Maps the regular file to memory with read-only shared pages, the pages
+    are shared by all processes mapping the same file.
+    Returns false if the file cannot be mapped (e.g. empty file or pipe). */
+static bool mmap_file_shared(const char *path, u8 **map, usize *map_len) {
+    struct stat st;
+    void *mem;
+    int fd;
+    
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return false;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+        (u64)st.st_size > (u64)USIZE_MAX) {
+        close(fd);
+        return false;
+    }
+    mem = mmap(NULL, (usize)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) return false;
+    *map = (u8 *)mem;
+    *map_len = (usize)st.st_size;
+    return true;
+}
+
+/** The context of the allocator of a document read from a mapped file.
+    The mapping is released when the document frees its string pool, and
+    this context is released with the document. */
+typedef struct mmap_alc_ctx {
+    yyjson_alc alc;         /* the user allocator */
+    u8 *map;                /* the mapped memory */
+    usize map_len;          /* the mapped length */
+    void *doc;              /* the document, NULL while reading */
+} mmap_alc_ctx;
+
+static void *mmap_alc_malloc(void *ctx_ptr, usize size) {
+    mmap_alc_ctx *ctx = (mmap_alc_ctx *)ctx_ptr;
+    return ctx->alc.malloc_(ctx->alc.ctx, size);
+}
+
+static void *mmap_alc_realloc(void *ctx_ptr, void *ptr,
+                              usize old_size, usize size) {
+    mmap_alc_ctx *ctx = (mmap_alc_ctx *)ctx_ptr;
+    return ctx->alc.realloc_(ctx->alc.ctx, ptr, old_size, size);
+}
+
+static void mmap_alc_free(void *ctx_ptr, void *ptr) {
+    mmap_alc_ctx *ctx = (mmap_alc_ctx *)ctx_ptr;
+    yyjson_alc alc = ctx->alc;
+    if (ptr == (void *)ctx->map) {
+        munmap(ptr, ctx->map_len);
+        ctx->map = NULL;
+        return;
+    }
+    alc.free_(alc.ctx, ptr);
+    if (ptr == ctx->doc) {
+        if (ctx->map) munmap((void *)ctx->map, ctx->map_len);
+        alc.free_(alc.ctx, ctx_ptr);
+    }
+}
+
+#endif /* YYJSON_HAS_MMAP */
+
 
 
 /*==============================================================================
@@ -1896,114 +2347,767 @@ bool yyjson_locate_pos(const char *str, size_t len, size_t pos,
 
 
 
-#if !YYJSON_DISABLE_UTILS
-
 /*==============================================================================
- * JSON Pointer API (RFC 6901)
+ * JSON Document Key Index
+ *
+ * The key index is a hash table of the keys of the large objects in an
+ * immutable document, it's built by the reader with `YYJSON_READ_KEY_INDEX`.
+ * A single table is shared by all objects of the document, an entry is the
+ * offset of the object and the offset of the key (in values, to the root).
+ * The table uses open addressing with linear probing, the load factor is at
+ * most 0.5, and a key offset of 0 (the root) means an empty entry.
  *============================================================================*/
 
-/**
- Get a token from JSON pointer string.
- @param ptr [in,out]
-                in:  string that points to current token prefix `/`
-                out: string that points to next token prefix `/`, or string end
- @param end [in] end of the entire JSON Pointer string
- @param len [out] unescaped token length
- @param esc [out] number of escaped characters in this token
- @return head of the token, or NULL if syntax error
- */
-static_inline const char *ptr_next_token(const char **ptr, const char *end,
-                                         usize *len, usize *esc) {
-    const char *hdr = *ptr + 1;
-    const char *cur = hdr;
-    /* skip unescaped characters */
-    while (cur < end && *cur != '/' && *cur != '~') cur++;
-    if (likely(cur == end || *cur != '~')) {
-        /* no escaped characters, return */
-        *ptr = cur;
-        *len = (usize)(cur - hdr);
-        *esc = 0;
-        return hdr;
-    } else {
-        /* handle escaped characters */
-        usize esc_num = 0;
-        while (cur < end && *cur != '/') {
-            if (*cur++ == '~') {
-                if (cur == end || (*cur != '0' && *cur != '1')) {
-                    *ptr = cur - 1;
-                    return NULL;
-                }
-                esc_num++;
-            }
-        }
-        *ptr = cur;
-        *len = (usize)(cur - hdr) - esc_num;
-        *esc = esc_num;
-        return hdr;
+/* The minimum number of keys of an object to be indexed. */
+#define YYJSON_KEY_INDEX_MIN_LEN 32
+
+/** An entry of the key index. */
+typedef struct key_idx_ent {
+    u32 obj; /* offset of the object to the root */
+    u32 key; /* offset of the key to the root, 0 if the entry is empty */
+} key_idx_ent;
+
+/** The key index, the entries follow this header. */
+typedef struct key_idx {
+    usize mask; /* capacity of the entries minus 1 */
+} key_idx;
+
+/** Returns the hash of a key in an object. */
+static_inline usize key_idx_hash(const char *str, usize len, u64 obj) {
+    u64 h = ((u64)len << 32) ^ obj, v;
+    while (len >= 4) {
+        v = byte_load_4(str);
+        h = (h ^ v) * U64(0x9E3779B9, 0x7F4A7C15);
+        h ^= h >> 29;
+        str += 4;
+        len -= 4;
     }
+    v = 0;
+    while (len > 0) v = (v << 8) | (u8)str[--len];
+    h = (h ^ v) * U64(0xBF58476D, 0x1CE4E5B9);
+    return (usize)(h ^ (h >> 32));
 }
 
-/**
- Convert token string to index.
- @param cur [in]  token head
- @param len [in]  token length
- @param idx [out] the index number, or USIZE_MAX if token is '-'
- @return true if token is a valid array index
- */
-static_inline bool ptr_token_to_idx(const char *cur, usize len, usize *idx) {
-    const char *end = cur + len;
-    usize num = 0, add;
-    if (unlikely(len == 0 || len > USIZE_SAFE_DIG)) return false;
-    if (*cur == '0') {
-        if (unlikely(len > 1)) return false;
-        *idx = 0;
-        return true;
+/** Returns the entries of the key index. */
+static_inline key_idx_ent *key_idx_get_ents(key_idx *idx) {
+    return (key_idx_ent *)(void *)(idx + 1);
+}
+
+#if !YYJSON_DISABLE_READER
+
+/** Builds the key index of a document, returns false if memory allocation
+    failed. No index is built if there's no large object, or the document has
+    too many values for the 32-bit offsets. */
+static bool doc_build_key_idx(yyjson_doc *doc) {
+    yyjson_alc alc = doc->alc;
+    yyjson_val *root = doc->root, *val, *end, *key;
+    key_idx *idx;
+    key_idx_ent *ents;
+    usize num = 0, cap, len, i;
+    u32 obj;
+    
+    if (doc->val_read > (usize)U32_MAX) return true;
+    end = root + doc->val_read;
+    for (val = root; val < end; val++) {
+        len = unsafe_yyjson_get_len(val);
+        if (unsafe_yyjson_is_obj(val) && len >= YYJSON_KEY_INDEX_MIN_LEN) {
+            num += len;
+        }
     }
-    if (*cur == '-') {
-        if (unlikely(len > 1)) return false;
-        *idx = USIZE_MAX;
-        return true;
+    if (num == 0) return true;
+    
+    for (cap = YYJSON_KEY_INDEX_MIN_LEN; cap < num * 2; cap *= 2);
+    if (cap >= (USIZE_MAX - sizeof(key_idx)) / sizeof(key_idx_ent)) {
+        return false;
     }
-    for (; cur < end && (add = (usize)((u8)*cur - (u8)'0')) <= 9; cur++) {
-        num = num * 10 + add;
+    idx = (key_idx *)alc.malloc_(alc.ctx,
+                                 sizeof(key_idx) + cap * sizeof(key_idx_ent));
+    if (unlikely(!idx)) return false;
+    idx->mask = cap - 1;
+    ents = key_idx_get_ents(idx);
+    memset((void *)ents, 0, cap * sizeof(key_idx_ent));
+    
+    for (val = root; val < end; val++) {
+        len = unsafe_yyjson_get_len(val);
+        if (!unsafe_yyjson_is_obj(val) || len < YYJSON_KEY_INDEX_MIN_LEN) {
+            continue;
+        }
+        obj = (u32)(val - root);
+        for (key = val + 1; len > 0; len--) {
+            i = key_idx_hash(key->uni.str, unsafe_yyjson_get_len(key), obj);
+            for (i &= idx->mask; ents[i].key; i = (i + 1) & idx->mask) {
+                /* keep the first one of the duplicated keys */
+                if (ents[i].obj == obj && unsafe_yyjson_equals_strn(
+                    root + ents[i].key, key->uni.str,
+                    unsafe_yyjson_get_len(key))) break;
+            }
+            if (!ents[i].key) {
+                ents[i].obj = obj;
+                ents[i].key = (u32)(key - root);
+            }
+            key = unsafe_yyjson_get_next(key + 1);
+        }
     }
-    if (unlikely(num == 0 || cur < end)) return false;
-    *idx = num;
+    doc->key_idx = (void *)idx;
     return true;
 }
 
-/**
- Compare JSON key with token.
- @param key a string key (yyjson_val or yyjson_mut_val)
- @param token a JSON pointer token
- @param len unescaped token length
- @param esc number of escaped characters in this token
- @return true if `str` is equals to `token`
- */
-static_inline bool ptr_token_eq(void *key,
-                                const char *token, usize len, usize esc) {
-    yyjson_val *val = (yyjson_val *)key;
-    if (unsafe_yyjson_get_len(val) != len) return false;
-    if (likely(!esc)) {
-        return memcmp(val->uni.str, token, len) == 0;
-    } else {
-        const char *str = val->uni.str;
-        for (; len-- > 0; token++, str++) {
-            if (*token == '~') {
-                if (*str != (*++token == '0' ? '~' : '/')) return false;
-            } else {
-                if (*str != *token) return false;
-            }
+#endif /* YYJSON_DISABLE_READER */
+
+yyjson_val *yyjson_doc_obj_get(yyjson_doc *doc, yyjson_val *obj,
+                               const char *key) {
+    return yyjson_doc_obj_getn(doc, obj, key, key ? strlen(key) : 0);
+}
+
+yyjson_val *yyjson_doc_obj_getn(yyjson_doc *doc, yyjson_val *obj,
+                                const char *key, usize key_len) {
+    key_idx *idx;
+    key_idx_ent *ents;
+    yyjson_val *root;
+    usize i;
+    u32 ofs;
+    
+    if (!doc || !doc->key_idx || !key || !yyjson_is_obj(obj) ||
+        unsafe_yyjson_get_len(obj) < YYJSON_KEY_INDEX_MIN_LEN ||
+        obj < doc->root || obj >= doc->root + doc->val_read) {
+        return yyjson_obj_getn(obj, key, key_len);
+    }
+    idx = (key_idx *)doc->key_idx;
+    ents = key_idx_get_ents(idx);
+    root = doc->root;
+    ofs = (u32)(obj - root);
+    i = key_idx_hash(key, key_len, ofs);
+    for (i &= idx->mask; ents[i].key; i = (i + 1) & idx->mask) {
+        if (ents[i].obj == ofs &&
+            unsafe_yyjson_equals_strn(root + ents[i].key, key, key_len)) {
+            return root + ents[i].key + 1;
         }
-        return true;
     }
+    return NULL;
 }
 
-/**
- Get a value from array by token.
- @param arr   an array, should not be NULL or non-array type
- @param token a JSON pointer token
- @param len   unescaped token length
+
+
+/*==============================================================================
+ * Mutable JSON Object Index
+ *
+ * The object index is a hash table of the keys of the indexed objects in a
+ * mutable document. A single table is shared by all objects of the document,
+ * it's allocated from the value pool, and a new table is allocated when it's
+ * full (the old one is released with the pool).
+ *
+ * An entry holds the key and the previous key in the circular linked list,
+ * so a pair can be removed without a linear search. Each indexed object has a
+ * marker entry with a NULL key (an indexed array has one too, which holds its
+ * vector, see below). The table uses open addressing with linear
+ * probing, the load factor is at most 0.5, and the entries are deleted with
+ * backward shifting, so there's no tombstone.
+ *============================================================================*/
+
+/** An entry of the object index. */
+typedef struct obj_idx_ent {
+    yyjson_mut_val *obj; /* the object, NULL if the entry is empty */
+    yyjson_mut_val *key; /* the key, NULL for the marker of the object */
+    yyjson_mut_val *pre; /* the previous key, or the vector of an array */
+} obj_idx_ent;
+
+/** The object index, the entries follow this header. */
+typedef struct obj_idx {
+    usize mask; /* capacity of the entries minus 1 */
+    usize num; /* number of the used entries */
+} obj_idx;
+
+/** Returns the entries of the object index. */
+static_inline obj_idx_ent *obj_idx_get_ents(obj_idx *idx) {
+    return (obj_idx_ent *)(void *)(idx + 1);
+}
+
+/** Returns the position of the entry in the object index. */
+static_inline usize obj_idx_hash(obj_idx *idx, yyjson_mut_val *obj,
+                                 yyjson_mut_val *key) {
+    if (!key) return key_idx_hash(NULL, 0, (u64)(usize)obj) & idx->mask;
+    return key_idx_hash(key->uni.str, unsafe_yyjson_get_len(key),
+                        (u64)(usize)obj) & idx->mask;
+}
+
+/** Finds a key in an object, skips the key `skip`. */
+static_inline obj_idx_ent *obj_idx_find(obj_idx *idx, yyjson_mut_val *obj,
+                                        const char *key, usize key_len,
+                                        yyjson_mut_val *skip) {
+    obj_idx_ent *ents = obj_idx_get_ents(idx);
+    usize i = key_idx_hash(key, key_len, (u64)(usize)obj) & idx->mask;
+    for (; ents[i].obj; i = (i + 1) & idx->mask) {
+        if (ents[i].obj == obj && ents[i].key && ents[i].key != skip &&
+            unsafe_yyjson_equals_strn(ents[i].key, key, key_len)) {
+            return ents + i;
+        }
+    }
+    return NULL;
+}
+
+/** Finds the entry of a key (or the marker if key is NULL) of an object. */
+static_inline obj_idx_ent *obj_idx_find_ent(obj_idx *idx, yyjson_mut_val *obj,
+                                            yyjson_mut_val *key) {
+    obj_idx_ent *ents = obj_idx_get_ents(idx);
+    usize i = obj_idx_hash(idx, obj, key);
+    for (; ents[i].obj; i = (i + 1) & idx->mask) {
+        if (ents[i].obj == obj && ents[i].key == key) return ents + i;
+    }
+    return NULL;
+}
+
+/** Adds an entry, the table should have enough capacity. */
+static_inline void obj_idx_put(obj_idx *idx, yyjson_mut_val *obj,
+                               yyjson_mut_val *key, yyjson_mut_val *pre) {
+    obj_idx_ent *ents = obj_idx_get_ents(idx);
+    usize i = obj_idx_hash(idx, obj, key);
+    while (ents[i].obj) i = (i + 1) & idx->mask;
+    ents[i].obj = obj;
+    ents[i].key = key;
+    ents[i].pre = pre;
+    idx->num++;
+}
+
+/** Deletes an entry, moves the following entries back to fill the hole. */
+static_inline void obj_idx_del(obj_idx *idx, obj_idx_ent *ent) {
+    obj_idx_ent *ents = obj_idx_get_ents(idx);
+    usize hole = (usize)(ent - ents), i = hole, home;
+    while (true) {
+        i = (i + 1) & idx->mask;
+        if (!ents[i].obj) break;
+        home = obj_idx_hash(idx, ents[i].obj, ents[i].key);
+        /* move the entry if its home is not in (hole, i] cyclically */
+        if (((i - home) & idx->mask) >= ((i - hole) & idx->mask)) {
+            ents[hole] = ents[i];
+            hole = i;
+        }
+    }
+    ents[hole].obj = NULL;
+    idx->num--;
+}
+
+/** Returns the index of the document if the object is indexed. */
+static_inline obj_idx *obj_idx_of(yyjson_mut_doc *doc, yyjson_mut_val *obj) {
+    obj_idx *idx = doc ? (obj_idx *)doc->obj_idx : NULL;
+    if (idx && yyjson_mut_is_obj(obj) && obj_idx_find_ent(idx, obj, NULL)) {
+        return idx;
+    }
+    return NULL;
+}
+
+/** Ensures the capacity for `num` more entries, returns NULL if memory
+    allocation failed. */
+static obj_idx *obj_idx_reserve(yyjson_mut_doc *doc, usize num) {
+    obj_idx *idx = (obj_idx *)doc->obj_idx, *new_idx;
+    obj_idx_ent *ents;
+    usize cap, size, i, max = USIZE_MAX / sizeof(obj_idx_ent) / 4;
+    
+    if (idx && (idx->num + num) * 2 <= idx->mask + 1) return idx;
+    if (num > max || (idx && idx->num > max - num)) return NULL;
+    num += idx ? idx->num : 0;
+    for (cap = 16; cap < num * 2; cap *= 2);
+    
+    size = sizeof(obj_idx) + cap * sizeof(obj_idx_ent);
+    size = (size + sizeof(yyjson_mut_val) - 1) / sizeof(yyjson_mut_val);
+    new_idx = (obj_idx *)(void *)unsafe_yyjson_mut_val(doc, size);
+    if (unlikely(!new_idx)) return NULL;
+    new_idx->mask = cap - 1;
+    new_idx->num = 0;
+    memset((void *)obj_idx_get_ents(new_idx), 0, cap * sizeof(obj_idx_ent));
+    if (idx) {
+        ents = obj_idx_get_ents(idx);
+        for (i = 0; i <= idx->mask; i++) {
+            if (!ents[i].obj) continue;
+            obj_idx_put(new_idx, ents[i].obj, ents[i].key, ents[i].pre);
+        }
+    }
+    doc->obj_idx = (void *)new_idx;
+    return new_idx;
+}
+
+/** Links a pair after the key `pre` (or as the only pair if the object is
+    empty), and adds it to the index. The index should have enough capacity. */
+static_inline void obj_idx_link(obj_idx *idx, yyjson_mut_val *obj,
+                                yyjson_mut_val *pre, yyjson_mut_val *key,
+                                yyjson_mut_val *val) {
+    yyjson_mut_val *next;
+    usize len = unsafe_yyjson_get_len(obj);
+    key->next = val;
+    if (!len) {
+        val->next = key;
+        obj->uni.ptr = (void *)key;
+        obj_idx_put(idx, obj, key, key);
+    } else {
+        next = pre->next->next;
+        pre->next->next = key;
+        val->next = next;
+        if (obj->uni.ptr == (void *)pre) obj->uni.ptr = (void *)key;
+        obj_idx_put(idx, obj, key, pre);
+        obj_idx_find_ent(idx, obj, next)->pre = key;
+    }
+    unsafe_yyjson_set_len(obj, len + 1);
+}
+
+/** Unlinks a pair from the object and deletes it from the index. */
+static_inline void obj_idx_unlink(obj_idx *idx, yyjson_mut_val *obj,
+                                  obj_idx_ent *ent) {
+    yyjson_mut_val *key = ent->key, *pre = ent->pre, *next;
+    usize len = unsafe_yyjson_get_len(obj);
+    if (len > 1) {
+        next = key->next->next;
+        pre->next->next = next;
+        if (obj->uni.ptr == (void *)key) obj->uni.ptr = (void *)pre;
+        obj_idx_find_ent(idx, obj, next)->pre = pre;
+    }
+    obj_idx_del(idx, ent);
+    unsafe_yyjson_set_len(obj, len - 1);
+}
+
+bool yyjson_mut_doc_obj_index(yyjson_mut_doc *doc, yyjson_mut_val *obj) {
+    obj_idx *idx;
+    yyjson_mut_val *pre, *key;
+    usize len;
+    
+    if (!doc || !yyjson_mut_is_obj(obj)) return false;
+    if (obj_idx_of(doc, obj)) return true;
+    len = unsafe_yyjson_get_len(obj);
+    idx = obj_idx_reserve(doc, len + 1);
+    if (!idx) return false;
+    
+    obj_idx_put(idx, obj, NULL, NULL);
+    if (len) {
+        pre = (yyjson_mut_val *)obj->uni.ptr;
+        while (len-- > 0) {
+            key = pre->next->next;
+            obj_idx_put(idx, obj, key, pre);
+            pre = key;
+        }
+    }
+    return true;
+}
+
+bool yyjson_mut_doc_obj_is_indexed(yyjson_mut_doc *doc, yyjson_mut_val *obj) {
+    return obj_idx_of(doc, obj) != NULL;
+}
+
+yyjson_mut_val *yyjson_mut_doc_obj_get(yyjson_mut_doc *doc,
+                                       yyjson_mut_val *obj,
+                                       const char *key) {
+    return yyjson_mut_doc_obj_getn(doc, obj, key, key ? strlen(key) : 0);
+}
+
+yyjson_mut_val *yyjson_mut_doc_obj_getn(yyjson_mut_doc *doc,
+                                        yyjson_mut_val *obj,
+                                        const char *key, usize key_len) {
+    obj_idx *idx = obj_idx_of(doc, obj);
+    obj_idx_ent *ent;
+    if (!idx || !key) return yyjson_mut_obj_getn(obj, key, key_len);
+    ent = obj_idx_find(idx, obj, key, key_len, NULL);
+    return ent ? ent->key->next : NULL;
+}
+
+bool yyjson_mut_doc_obj_add(yyjson_mut_doc *doc, yyjson_mut_val *obj,
+                            yyjson_mut_val *key, yyjson_mut_val *val) {
+    obj_idx *idx = obj_idx_of(doc, obj);
+    if (!idx) return yyjson_mut_obj_add(obj, key, val);
+    if (!yyjson_mut_is_str(key) || !val) return false;
+    idx = obj_idx_reserve(doc, 1);
+    if (!idx) return false;
+    obj_idx_link(idx, obj, (yyjson_mut_val *)obj->uni.ptr, key, val);
+    return true;
+}
+
+bool yyjson_mut_doc_obj_put(yyjson_mut_doc *doc, yyjson_mut_val *obj,
+                            yyjson_mut_val *key, yyjson_mut_val *val) {
+    obj_idx *idx = obj_idx_of(doc, obj);
+    obj_idx_ent *ent;
+    yyjson_mut_val *cur;
+    usize key_len;
+    
+    if (!idx) return yyjson_mut_obj_put(obj, key, val);
+    if (!yyjson_mut_is_str(key)) return false;
+    key_len = unsafe_yyjson_get_len(key);
+    ent = obj_idx_find(idx, obj, key->uni.str, key_len, NULL);
+    if (!ent) {
+        if (!val) return true;
+        idx = obj_idx_reserve(doc, 1);
+        if (!idx) return false;
+        obj_idx_link(idx, obj, (yyjson_mut_val *)obj->uni.ptr, key, val);
+        return true;
+    }
+    
+    /* replace the value of the found key, remove the duplicated keys */
+    cur = ent->key;
+    if (val) {
+        val->next = cur->next->next;
+        cur->next = val;
+    } else {
+        obj_idx_unlink(idx, obj, ent);
+        cur = NULL;
+    }
+    while ((ent = obj_idx_find(idx, obj, key->uni.str, key_len, cur))) {
+        obj_idx_unlink(idx, obj, ent);
+    }
+    return true;
+}
+
+bool yyjson_mut_doc_obj_insert(yyjson_mut_doc *doc, yyjson_mut_val *obj,
+                               yyjson_mut_val *key, yyjson_mut_val *val,
+                               usize idx) {
+    obj_idx *oidx = obj_idx_of(doc, obj);
+    yyjson_mut_val *tail, *pre;
+    usize len, i;
+    
+    if (!oidx) return yyjson_mut_obj_insert(obj, key, val, idx);
+    len = unsafe_yyjson_get_len(obj);
+    if (!yyjson_mut_is_str(key) || !val || idx > len) return false;
+    oidx = obj_idx_reserve(doc, 1);
+    if (!oidx) return false;
+    
+    /* link the pair after the previous one, or after the tail if idx is 0 */
+    pre = tail = (yyjson_mut_val *)obj->uni.ptr;
+    if (idx < len) {
+        for (i = 0; i < idx; i++) pre = pre->next->next;
+    }
+    obj_idx_link(oidx, obj, pre, key, val);
+    if (idx < len) obj->uni.ptr = (void *)tail;
+    return true;
+}
+
+yyjson_mut_val *yyjson_mut_doc_obj_remove_key(yyjson_mut_doc *doc,
+                                              yyjson_mut_val *obj,
+                                              const char *key) {
+    if (!key) return NULL;
+    return yyjson_mut_doc_obj_remove_keyn(doc, obj, key, strlen(key));
+}
+
+yyjson_mut_val *yyjson_mut_doc_obj_remove_keyn(yyjson_mut_doc *doc,
+                                               yyjson_mut_val *obj,
+                                               const char *key,
+                                               usize key_len) {
+    obj_idx *idx = obj_idx_of(doc, obj);
+    obj_idx_ent *ent;
+    yyjson_mut_val *val = NULL;
+    
+    if (!idx) return yyjson_mut_obj_remove_keyn(obj, key, key_len);
+    if (!key) return NULL;
+    while ((ent = obj_idx_find(idx, obj, key, key_len, NULL))) {
+        if (!val) val = ent->key->next;
+        obj_idx_unlink(idx, obj, ent);
+    }
+    return val;
+}
+
+
+
+/*==============================================================================
+ * Mutable JSON Array Index
+ *
+ * An indexed array has a vector of its values, which is allocated from the
+ * value pool and held by the marker entry of the array in the object index.
+ * The values are still linked as usual, the vector is only used to find a
+ * value (and the previous one) by index.
+ *============================================================================*/
+
+/** The vector of an indexed array, the values follow this header. */
+typedef struct arr_idx {
+    usize cap; /* capacity of the values */
+} arr_idx;
+
+/** Returns the values of the vector. */
+static_inline yyjson_mut_val **arr_idx_get_vals(arr_idx *vec) {
+    return (yyjson_mut_val **)(void *)(vec + 1);
+}
+
+/** Returns the vector of the array if the array is indexed. */
+static_inline arr_idx *arr_idx_of(yyjson_mut_doc *doc, yyjson_mut_val *arr) {
+    obj_idx *idx = doc ? (obj_idx *)doc->obj_idx : NULL;
+    obj_idx_ent *ent;
+    if (!idx || !yyjson_mut_is_arr(arr)) return NULL;
+    ent = obj_idx_find_ent(idx, arr, NULL);
+    return ent ? (arr_idx *)(void *)ent->pre : NULL;
+}
+
+/** Allocates a vector with the values of the array. */
+static arr_idx *arr_idx_new(yyjson_mut_doc *doc, yyjson_mut_val *arr,
+                            usize cap) {
+    arr_idx *vec;
+    yyjson_mut_val **vals, *val;
+    usize len = unsafe_yyjson_get_len(arr), size;
+    
+    if (cap > (USIZE_MAX - sizeof(arr_idx)) / sizeof(yyjson_mut_val *) / 2) {
+        return NULL;
+    }
+    size = sizeof(arr_idx) + cap * sizeof(yyjson_mut_val *);
+    size = (size + sizeof(yyjson_mut_val) - 1) / sizeof(yyjson_mut_val);
+    vec = (arr_idx *)(void *)unsafe_yyjson_mut_val(doc, size);
+    if (unlikely(!vec)) return NULL;
+    vec->cap = cap;
+    vals = arr_idx_get_vals(vec);
+    if (len) {
+        val = (yyjson_mut_val *)arr->uni.ptr;
+        while (len-- > 0) {
+            val = val->next;
+            *vals++ = val;
+        }
+    }
+    return vec;
+}
+
+/** Ensures the capacity for `num` more values, returns NULL if memory
+    allocation failed. */
+static_inline arr_idx *arr_idx_reserve(yyjson_mut_doc *doc,
+                                       yyjson_mut_val *arr, arr_idx *vec,
+                                       usize num) {
+    usize len = unsafe_yyjson_get_len(arr), cap;
+    if (likely(vec->cap - len >= num)) return vec;
+    if (num > USIZE_MAX / 2 - len) return NULL;
+    cap = yyjson_max(len + num, vec->cap * 2);
+    vec = arr_idx_new(doc, arr, cap);
+    if (unlikely(!vec)) return NULL;
+    obj_idx_find_ent((obj_idx *)doc->obj_idx, arr, NULL)->pre =
+        (yyjson_mut_val *)(void *)vec;
+    return vec;
+}
+
+/** Returns the value before the index (the last one if idx is 0). */
+static_inline yyjson_mut_val *arr_idx_pre(yyjson_mut_val *arr, arr_idx *vec,
+                                          usize idx) {
+    if (idx) return arr_idx_get_vals(vec)[idx - 1];
+    return (yyjson_mut_val *)arr->uni.ptr;
+}
+
+bool yyjson_mut_doc_arr_index(yyjson_mut_doc *doc, yyjson_mut_val *arr) {
+    obj_idx *idx;
+    arr_idx *vec;
+    
+    if (!doc || !yyjson_mut_is_arr(arr)) return false;
+    if (arr_idx_of(doc, arr)) return true;
+    idx = obj_idx_reserve(doc, 1);
+    if (!idx) return false;
+    vec = arr_idx_new(doc, arr, yyjson_max(unsafe_yyjson_get_len(arr), 16));
+    if (!vec) return false;
+    obj_idx_put(idx, arr, NULL, (yyjson_mut_val *)(void *)vec);
+    return true;
+}
+
+bool yyjson_mut_doc_arr_is_indexed(yyjson_mut_doc *doc, yyjson_mut_val *arr) {
+    return arr_idx_of(doc, arr) != NULL;
+}
+
+yyjson_mut_val *yyjson_mut_doc_arr_get(yyjson_mut_doc *doc,
+                                       yyjson_mut_val *arr, usize idx) {
+    arr_idx *vec = arr_idx_of(doc, arr);
+    if (!vec) return yyjson_mut_arr_get(arr, idx);
+    if (idx >= unsafe_yyjson_get_len(arr)) return NULL;
+    return arr_idx_get_vals(vec)[idx];
+}
+
+bool yyjson_mut_doc_arr_insert(yyjson_mut_doc *doc, yyjson_mut_val *arr,
+                               yyjson_mut_val *val, usize idx) {
+    arr_idx *vec = arr_idx_of(doc, arr);
+    yyjson_mut_val **vals, *pre;
+    usize len;
+    
+    if (!vec) return yyjson_mut_arr_insert(arr, val, idx);
+    len = unsafe_yyjson_get_len(arr);
+    if (!val || idx > len) return false;
+    vec = arr_idx_reserve(doc, arr, vec, 1);
+    if (!vec) return false;
+    
+    if (len == 0) {
+        val->next = val;
+        arr->uni.ptr = val;
+    } else {
+        pre = arr_idx_pre(arr, vec, idx);
+        val->next = pre->next;
+        pre->next = val;
+        if (idx == len) arr->uni.ptr = val;
+    }
+    vals = arr_idx_get_vals(vec);
+    memmove((void *)(vals + idx + 1), (void *)(vals + idx),
+            (len - idx) * sizeof(yyjson_mut_val *));
+    vals[idx] = val;
+    unsafe_yyjson_set_len(arr, len + 1);
+    return true;
+}
+
+bool yyjson_mut_doc_arr_append(yyjson_mut_doc *doc, yyjson_mut_val *arr,
+                               yyjson_mut_val *val) {
+    if (!arr_idx_of(doc, arr)) return yyjson_mut_arr_append(arr, val);
+    return yyjson_mut_doc_arr_insert(doc, arr, val,
+                                     unsafe_yyjson_get_len(arr));
+}
+
+yyjson_mut_val *yyjson_mut_doc_arr_replace(yyjson_mut_doc *doc,
+                                           yyjson_mut_val *arr, usize idx,
+                                           yyjson_mut_val *val) {
+    arr_idx *vec = arr_idx_of(doc, arr);
+    yyjson_mut_val **vals, *pre, *old;
+    usize len;
+    
+    if (!vec) return yyjson_mut_arr_replace(arr, idx, val);
+    len = unsafe_yyjson_get_len(arr);
+    if (!val || idx >= len) return NULL;
+    vals = arr_idx_get_vals(vec);
+    old = vals[idx];
+    if (len == 1) {
+        val->next = val;
+    } else {
+        pre = arr_idx_pre(arr, vec, idx);
+        pre->next = val;
+        val->next = old->next;
+    }
+    if ((void *)old == arr->uni.ptr) arr->uni.ptr = val;
+    vals[idx] = val;
+    return old;
+}
+
+yyjson_mut_val *yyjson_mut_doc_arr_remove(yyjson_mut_doc *doc,
+                                          yyjson_mut_val *arr, usize idx) {
+    arr_idx *vec = arr_idx_of(doc, arr);
+    yyjson_mut_val *old;
+    
+    if (!vec) return yyjson_mut_arr_remove(arr, idx);
+    if (idx >= unsafe_yyjson_get_len(arr)) return NULL;
+    old = arr_idx_get_vals(vec)[idx];
+    yyjson_mut_doc_arr_remove_range(doc, arr, idx, 1);
+    return old;
+}
+
+bool yyjson_mut_doc_arr_remove_range(yyjson_mut_doc *doc, yyjson_mut_val *arr,
+                                     usize idx, usize num) {
+    arr_idx *vec = arr_idx_of(doc, arr);
+    yyjson_mut_val **vals, *pre;
+    usize len;
+    
+    if (!vec) return yyjson_mut_arr_remove_range(arr, idx, num);
+    len = unsafe_yyjson_get_len(arr);
+    if (idx > len || num > len - idx) return false;
+    if (num == 0) return true;
+    
+    vals = arr_idx_get_vals(vec);
+    if (num < len) {
+        pre = arr_idx_pre(arr, vec, idx);
+        pre->next = vals[idx + num - 1]->next;
+        if (idx + num == len) arr->uni.ptr = pre;
+    }
+    memmove((void *)(vals + idx), (void *)(vals + idx + num),
+            (len - idx - num) * sizeof(yyjson_mut_val *));
+    unsafe_yyjson_set_len(arr, len - num);
+    return true;
+}
+
+
+
+#if !YYJSON_DISABLE_UTILS
+
+/*==============================================================================
+ * JSON Pointer API (RFC 6901)
+ *============================================================================*/
+
+/**
+ Get a token from JSON pointer string.
+ @param ptr [in,out]
+                in:  string that points to current token prefix `/`
+                out: string that points to next token prefix `/`, or string end
+ @param end [in] end of the entire JSON Pointer string
+ @param len [out] unescaped token length
+ @param esc [out] number of escaped characters in this token
+ @return head of the token, or NULL if syntax error
+ */
+static_inline const char *ptr_next_token(const char **ptr, const char *end,
+                                         usize *len, usize *esc) {
+    const char *hdr = *ptr + 1;
+    const char *cur = hdr;
+    /* skip unescaped characters */
+    while (cur < end && *cur != '/' && *cur != '~') cur++;
+    if (likely(cur == end || *cur != '~')) {
+        /* no escaped characters, return */
+        *ptr = cur;
+        *len = (usize)(cur - hdr);
+        *esc = 0;
+        return hdr;
+    } else {
+        /* handle escaped characters */
+        usize esc_num = 0;
+        while (cur < end && *cur != '/') {
+            if (*cur++ == '~') {
+                if (cur == end || (*cur != '0' && *cur != '1')) {
+                    *ptr = cur - 1;
+                    return NULL;
+                }
+                esc_num++;
+            }
+        }
+        *ptr = cur;
+        *len = (usize)(cur - hdr) - esc_num;
+        *esc = esc_num;
+        return hdr;
+    }
+}
+
+/**
+ Convert token string to index.
+ @param cur [in]  token head
+ @param len [in]  token length
+ @param idx [out] the index number, or USIZE_MAX if token is '-'
+ @return true if token is a valid array index
+ */
+static_inline bool ptr_token_to_idx(const char *cur, usize len, usize *idx) {
+    const char *end = cur + len;
+    usize num = 0, add;
+    if (unlikely(len == 0 || len > USIZE_SAFE_DIG)) return false;
+    if (*cur == '0') {
+        if (unlikely(len > 1)) return false;
+        *idx = 0;
+        return true;
+    }
+    if (*cur == '-') {
+        if (unlikely(len > 1)) return false;
+        *idx = USIZE_MAX;
+        return true;
+    }
+    for (; cur < end && (add = (usize)((u8)*cur - (u8)'0')) <= 9; cur++) {
+        num = num * 10 + add;
+    }
+    if (unlikely(num == 0 || cur < end)) return false;
+    *idx = num;
+    return true;
+}
+
+/**
+ Compare JSON key with token.
+ @param key a string key (yyjson_val or yyjson_mut_val)
+ @param token a JSON pointer token
+ @param len unescaped token length
+ @param esc number of escaped characters in this token
+ @return true if `str` is equals to `token`
+ */
+static_inline bool ptr_token_eq(void *key,
+                                const char *token, usize len, usize esc) {
+    yyjson_val *val = (yyjson_val *)key;
+    if (unsafe_yyjson_get_len(val) != len) return false;
+    if (likely(!esc)) {
+        return memcmp(val->uni.str, token, len) == 0;
+    } else {
+        const char *str = val->uni.str;
+        for (; len-- > 0; token++, str++) {
+            if (*token == '~') {
+                if (*str != (*++token == '0' ? '~' : '/')) return false;
+            } else {
+                if (*str != *token) return false;
+            }
+        }
+        return true;
+    }
+}
+
+/**
+ Get a value from array by token.
+ @param arr   an array, should not be NULL or non-array type
+ @param token a JSON pointer token
+ @param len   unescaped token length
  @param esc   number of escaped characters in this token
  @return value at index, or NULL if token is not index or index is out of range
  */
@@ -3991,31 +5095,114 @@ static_noinline bool read_number_raw(u8 **ptr,
 #undef return_raw
 }
 
+#if YYJSON_HAS_SSE2
+
+/** Returns a bit mask of the non-whitespace characters in the 16-byte block. */
+static_inline u32 sse2_non_space_mask(__m128i v) {
+    __m128i m = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                     _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                     _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+    return (u32)_mm_movemask_epi8(m) ^ 0xFFFF;
+}
+
+#elif YYJSON_HAS_NEON
+
+/** Returns a nibble mask of the non-whitespace characters in the 16-byte
+    block, each byte is represented by 4 bits. */
+static_inline u64 neon_non_space_mask(uint8x16_t v) {
+    uint8x16_t m = vorrq_u8(
+        vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vceqq_u8(v, vdupq_n_u8('\t'))),
+        vorrq_u8(vceqq_u8(v, vdupq_n_u8('\n')), vceqq_u8(v, vdupq_n_u8('\r'))));
+    uint8x8_t n = vshrn_n_u16(vreinterpretq_u16_u8(vmvnq_u8(m)), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(n), 0);
+}
+
+#endif
+
 /**
- Skips spaces and comments as many as possible.
+ Skips whitespace characters in 16-byte blocks: ' ', '\\t', '\\n', '\\r'.
+ Returns the first non-whitespace position, or a position near `end` where
+ the scalar code should continue. It never reads beyond `end`.
  
- It will return false in these cases:
-    1. No character is skipped. The 'end' pointer is set as input cursor.
-    2. A multiline comment is not closed. The 'end' pointer is set as the head
-       of this comment block.
+ Pretty-printed JSON often has long runs of indentation and line breaks, a
+ block classification skips them much faster than the byte-by-byte loop.
  */
-static_noinline bool skip_spaces_and_comments(u8 **ptr) {
-    u8 *hdr = *ptr;
-    u8 *cur = *ptr;
-    u8 **end = ptr;
-    while (true) {
-        if (byte_match_2(cur, "/*")) {
-            hdr = cur;
-            cur += 2;
-            while (true) {
-                if (byte_match_2(cur, "*/")) {
-                    cur += 2;
-                    break;
-                }
-                if (*cur == 0) {
-                    *end = hdr;
-                    return false;
-                }
+static_inline u8 *skip_spaces_simd(u8 *cur, const u8 *end) {
+#if YYJSON_HAS_SSE2
+    u32 mask;
+    while (end - cur >= 16) {
+        mask = sse2_non_space_mask(
+            _mm_loadu_si128((const __m128i *)(const void *)cur));
+        if (mask) return cur + u64_tz_bits(mask);
+        cur += 16;
+    }
+#elif YYJSON_HAS_NEON
+    u64 mask;
+    while (end - cur >= 16) {
+        mask = neon_non_space_mask(vld1q_u8(cur));
+        if (mask) return cur + (u64_tz_bits(mask) >> 2);
+        cur += 16;
+    }
+#endif
+    return cur;
+}
+
+/**
+ Skips the indentation of pretty-printed JSON. Most indentations are a few
+ pairs of spaces, the branchy scalar loop is faster for them, so only the runs
+ longer than 32 bytes are handed over to the SIMD kernel.
+ */
+static_inline u8 *skip_indent(u8 *cur, const u8 *end) {
+    repeat16({
+        if (likely(byte_match_2(cur, "  "))) cur += 2;
+        else return cur;
+    })
+    return skip_spaces_simd(cur, end);
+}
+
+/** Skips whitespace characters as many as possible, runs longer than 16 bytes
+    are handed over to the SIMD kernel. */
+static_inline u8 *skip_spaces(u8 *cur, const u8 *end) {
+#if YYJSON_HAS_SIMD
+    repeat16({
+        if (likely(char_is_space(*cur))) cur++;
+        else return cur;
+    })
+    cur = skip_spaces_simd(cur, end);
+#endif
+    while (char_is_space(*cur)) cur++;
+    return cur;
+}
+
+/**
+ Skips spaces and comments as many as possible.
+ 
+ It will return false in these cases:
+    1. No character is skipped. The 'end' pointer is set as input cursor.
+    2. A multiline comment is not closed. The 'end' pointer is set as the head
+       of this comment block.
+ 
+ The `lst` is the end of input data, it is used to bound the SIMD kernels.
+ */
+static_noinline bool skip_spaces_and_comments(u8 **ptr, const u8 *lst) {
+    u8 *hdr = *ptr;
+    u8 *cur = *ptr;
+    u8 **end = ptr;
+    while (true) {
+        if (byte_match_2(cur, "/*")) {
+            hdr = cur;
+            cur += 2;
+            while (true) {
+                if (byte_match_2(cur, "*/")) {
+                    cur += 2;
+                    break;
+                }
+                if (*cur == 0) {
+                    *end = hdr;
+                    return false;
+                }
                 cur++;
             }
             continue;
@@ -4026,8 +5213,7 @@ static_noinline bool skip_spaces_and_comments(u8 **ptr) {
             continue;
         }
         if (char_is_space(*cur)) {
-            cur += 1;
-            while (char_is_space(*cur)) cur++;
+            cur = skip_spaces(cur + 1, lst);
             continue;
         }
         break;
@@ -4422,6 +5608,191 @@ static const f64 f64_pow10_table[] = {
     1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
 };
 
+/**
+ Convert a decimal number (sig * 10^exp) to IEEE-754 double number with the
+ Eisel-Lemire algorithm, using the 128-bit significand in pow10_sig_table.
+
+ This algorithm refers to:
+ Daniel Lemire, Number Parsing at a Gigabyte per Second.
+ https://arxiv.org/abs/2101.11408
+
+ @param sig The significand, should not be 0.
+ @param exp The exponent (base 10), should be in range
+    [POW10_SIG_TABLE_MIN_EXP, POW10_SIG_TABLE_MAX_EXP].
+ @param raw The raw value of the double number (without sign).
+ @return false if the result cannot be determined by the 128-bit pow10, or
+    the result is infinity, the caller should use the slow path.
+ */
+static_inline bool read_f64_eisel_lemire(u64 sig, i32 exp, u64 *raw) {
+    /*
+     The result value is exactly equal to (sig * 10^exp),
+     the exponent part (10^exp) can be converted to (sig2 * 2^exp2).
+     
+     The sig2 can be an infinite length number, only the highest 128 bits
+     is cached in the pow10_sig_table.
+     
+     Now we have these bits:
+     sig1 (normalized 64bit)        : aaaaaaaa
+     sig2 (higher 64bit)            : bbbbbbbb
+     sig2_ext (lower 64bit)         : cccccccc
+     sig2_cut (extra unknown bits)  : dddddddddddd....
+     
+     And the calculation process is:
+     ----------------------------------------
+             aaaaaaaa *
+             bbbbbbbbccccccccdddddddddddd....
+     ----------------------------------------
+     abababababababab +
+             acacacacacacacac +
+                     adadadadadadadadadad....
+     ----------------------------------------
+     [hi____][lo____] +
+             [hi2___][lo2___] +
+                     [unknown___________....]
+     ----------------------------------------
+     
+     The addition with carry may affect higher bits, but if there is a 0
+     in higher bits, the bits higher than 0 will not be affected.
+     
+     `lo2` + `unknown` may get a carry bit and may affect `hi2`, the max
+     value of `hi2` is 0xFFFFFFFFFFFFFFFE, so `hi2` will not overflow.
+     
+     `lo` + `hi2` may also get a carry bit and may affect `hi`, but only
+     the highest significant 53 bits of `hi` is needed. If there is a 0
+     in the lower bits of `hi`, then all the following bits can be dropped.
+     
+     To convert the result to IEEE-754 double number, we need to perform
+     correct rounding:
+     1. if bit 54 is 0, round down,
+     2. if bit 54 is 1 and any bit beyond bit 54 is 1, round up,
+     3. if bit 54 is 1 and all bits beyond bit 54 are 0, round to even,
+        as the extra bits is unknown, this case is handled only if the
+        pow10 is exact (no unknown bits).
+     */
+    
+    u64 sig1, sig2, sig2_ext, hi, lo, hi2, lo2, add, bits, half;
+    i32 exp2, shr;
+    u32 lz;
+    bool exact = false;
+    
+    /* convert (10^exp) to (sig2 * 2^exp2) */
+    pow10_table_get_sig(exp, &sig2, &sig2_ext);
+    pow10_table_get_exp(exp, &exp2);
+    
+    /* normalize and multiply */
+    lz = u64_lz_bits(sig);
+    sig1 = sig << lz;
+    exp2 -= (i32)lz;
+    u128_mul(sig1, sig2, &hi, &lo);
+    
+    /*
+     The `hi` is in range [0x4000000000000000, 0xFFFFFFFFFFFFFFFE],
+     To get normalized value, `hi` should be shifted to the left by 0 or 1.
+     
+     The highest significant 53 bits is used by IEEE-754 double number,
+     and the bit 54 is used to detect rounding direction. For subnormal
+     number, fewer bits are used, and the rounding bit is higher.
+     
+     The lowest (64 - 54 - 1) bits is used to check whether it contains 0.
+     */
+    bits = hi & (((u64)1 << (64 - 54 - 1)) - 1);
+    if (bits - 1 < (((u64)1 << (64 - 54 - 1)) - 2)) {
+        /*
+         (bits != 0 && bits != 0x1FF) => (bits - 1 < 0x1FF - 1)
+         The `bits` is not zero, so we don't need to check `round to even`
+         case. The `bits` contains bit `0`, so we can drop the extra bits
+         after `0`.
+         */
+        exact = true;
+        
+    } else {
+        /*
+         (bits == 0 || bits == 0x1FF)
+         The `bits` is filled with all `0` or all `1`, so we need to check
+         lower bits with another 64-bit multiplication.
+         */
+        u128_mul(sig1, sig2_ext, &hi2, &lo2);
+        
+        add = lo + hi2;
+        if (add + 1 > (u64)1) {
+            /*
+             (add != 0 && add != U64_MAX) => (add + 1 > 1)
+             The `add` is not zero, so we don't need to check `round to
+             even` case. The `add` contains bit `0`, so we can drop the
+             extra bits after `0`. The `hi` cannot be U64_MAX, so it will
+             not overflow.
+             */
+            hi += add < lo;
+            exact = true;
+            
+        } else if (exp >= POW10_SIG_TABLE_MIN_EXACT_EXP &&
+                   exp <= POW10_SIG_TABLE_MAX_EXACT_EXP) {
+            /*
+             The pow10 is exact, so the product (hi, add, lo2) is exact,
+             the result is halfway if bit 54 is 1 and all bits beyond it
+             are 0, it should be rounded down if bit 53 is 0 (even), so
+             the bit 54 is cleared. The result is a normal number here.
+             */
+            hi += add < lo;
+            lz = hi < ((u64)1 << 63);
+            half = (u64)1 << (64 - 54 - lz);
+            if (!add && !lo2 && (hi & ((half << 2) - 1)) == half) {
+                hi -= half;
+            }
+            exact = true;
+        }
+    }
+    if (!exact) return false;
+    
+    /* normalize, get the biased exponent (without rounding) */
+    lz = hi < ((u64)1 << 63);
+    hi <<= lz;
+    exp2 -= (i32)lz;
+    exp2 += 64 + F64_BITS - F64_SIG_FULL_BITS + F64_SIG_BITS + F64_EXP_BIAS;
+    
+    if (likely(exp2 > 0)) {
+        /* test the bit 54 and get rounding direction */
+        half = (u64)1 << (64 - 54);
+        hi += hi & half;
+        
+        /* test overflow */
+        if (hi < half) {
+            hi = ((u64)1 << 63);
+            exp2 += 1;
+        }
+        if (unlikely(exp2 >= (i32)(F64_EXP_MASK >> F64_SIG_BITS))) {
+            return false; /* infinity */
+        }
+        
+        /* This is a normal number, convert it to IEEE-754 format. */
+        hi >>= F64_BITS - F64_SIG_FULL_BITS;
+        *raw = ((u64)exp2 << F64_SIG_BITS) | (hi & F64_SIG_MASK);
+        return true;
+    }
+    
+    /*
+     This is a subnormal number, the rounding bit is higher than bit 54, and
+     it's not halfway as the bits after it contain 1. If the significand is
+     rounded up to 2^52, it's the minimum normal number.
+     */
+    shr = F64_BITS - F64_SIG_FULL_BITS + 1 - exp2;
+    if (unlikely(shr >= F64_BITS)) return false;
+    hi >>= shr - 1;
+    *raw = (hi + 1) >> 1;
+    return true;
+}
+
+/**
+ Convert a decimal number with cut digits to IEEE-754 double number with the
+ Eisel-Lemire algorithm. The exact value is in range (sig - 1, sig + 1), the
+ result is accepted if both bounds give the same double number.
+ */
+static_noinline bool read_f64_eisel_lemire_cut(u64 sig, i32 exp, u64 *raw) {
+    u64 raw2;
+    return read_f64_eisel_lemire(sig - 1, exp, raw) &&
+           read_f64_eisel_lemire(sig + 1, exp, &raw2) && *raw == raw2;
+}
+
 /**
  Read a JSON number.
  
@@ -4761,137 +6132,16 @@ digi_finish:
     /*
      Fast path 2:
      
-     To keep it simple, we only accept normal number here,
-     let the slow path to handle subnormal and infinity number.
+     Use the Eisel-Lemire algorithm, see `read_f64_eisel_lemire()`.
+     The long numbers with cut digits are rare, so they're not inlined.
      */
-    if (likely(!sig_cut &&
-               exp > -F64_MAX_DEC_EXP + 1 &&
-               exp < +F64_MAX_DEC_EXP - 20)) {
-        /*
-         The result value is exactly equal to (sig * 10^exp),
-         the exponent part (10^exp) can be converted to (sig2 * 2^exp2).
-         
-         The sig2 can be an infinite length number, only the highest 128 bits
-         is cached in the pow10_sig_table.
-         
-         Now we have these bits:
-         sig1 (normalized 64bit)        : aaaaaaaa
-         sig2 (higher 64bit)            : bbbbbbbb
-         sig2_ext (lower 64bit)         : cccccccc
-         sig2_cut (extra unknown bits)  : dddddddddddd....
-         
-         And the calculation process is:
-         ----------------------------------------
-                 aaaaaaaa *
-                 bbbbbbbbccccccccdddddddddddd....
-         ----------------------------------------
-         abababababababab +
-                 acacacacacacacac +
-                         adadadadadadadadadad....
-         ----------------------------------------
-         [hi____][lo____] +
-                 [hi2___][lo2___] +
-                         [unknown___________....]
-         ----------------------------------------
-         
-         The addition with carry may affect higher bits, but if there is a 0
-         in higher bits, the bits higher than 0 will not be affected.
-         
-         `lo2` + `unknown` may get a carry bit and may affect `hi2`, the max
-         value of `hi2` is 0xFFFFFFFFFFFFFFFE, so `hi2` will not overflow.
-         
-         `lo` + `hi2` may also get a carry bit and may affect `hi`, but only
-         the highest significant 53 bits of `hi` is needed. If there is a 0
-         in the lower bits of `hi`, then all the following bits can be dropped.
-         
-         To convert the result to IEEE-754 double number, we need to perform
-         correct rounding:
-         1. if bit 54 is 0, round down,
-         2. if bit 54 is 1 and any bit beyond bit 54 is 1, round up,
-         3. if bit 54 is 1 and all bits beyond bit 54 are 0, round to even,
-            as the extra bits is unknown, this case will not be handled here.
-         */
-        
+    {
         u64 raw;
-        u64 sig1, sig2, sig2_ext, hi, lo, hi2, lo2, add, bits;
-        i32 exp2;
-        u32 lz;
-        bool exact = false, carry, round_up;
-        
-        /* convert (10^exp) to (sig2 * 2^exp2) */
-        pow10_table_get_sig(exp, &sig2, &sig2_ext);
-        pow10_table_get_exp(exp, &exp2);
-        
-        /* normalize and multiply */
-        lz = u64_lz_bits(sig);
-        sig1 = sig << lz;
-        exp2 -= (i32)lz;
-        u128_mul(sig1, sig2, &hi, &lo);
-        
-        /*
-         The `hi` is in range [0x4000000000000000, 0xFFFFFFFFFFFFFFFE],
-         To get normalized value, `hi` should be shifted to the left by 0 or 1.
-         
-         The highest significant 53 bits is used by IEEE-754 double number,
-         and the bit 54 is used to detect rounding direction.
-         
-         The lowest (64 - 54 - 1) bits is used to check whether it contains 0.
-         */
-        bits = hi & (((u64)1 << (64 - 54 - 1)) - 1);
-        if (bits - 1 < (((u64)1 << (64 - 54 - 1)) - 2)) {
-            /*
-             (bits != 0 && bits != 0x1FF) => (bits - 1 < 0x1FF - 1)
-             The `bits` is not zero, so we don't need to check `round to even`
-             case. The `bits` contains bit `0`, so we can drop the extra bits
-             after `0`.
-             */
-            exact = true;
-            
-        } else {
-            /*
-             (bits == 0 || bits == 0x1FF)
-             The `bits` is filled with all `0` or all `1`, so we need to check
-             lower bits with another 64-bit multiplication.
-             */
-            u128_mul(sig1, sig2_ext, &hi2, &lo2);
-            
-            add = lo + hi2;
-            if (add + 1 > (u64)1) {
-                /*
-                 (add != 0 && add != U64_MAX) => (add + 1 > 1)
-                 The `add` is not zero, so we don't need to check `round to
-                 even` case. The `add` contains bit `0`, so we can drop the
-                 extra bits after `0`. The `hi` cannot be U64_MAX, so it will
-                 not overflow.
-                 */
-                carry = add < lo || add < hi2;
-                hi += carry;
-                exact = true;
-            }
-        }
-        
-        if (exact) {
-            /* normalize */
-            lz = hi < ((u64)1 << 63);
-            hi <<= lz;
-            exp2 -= (i32)lz;
-            exp2 += 64;
-            
-            /* test the bit 54 and get rounding direction */
-            round_up = (hi & ((u64)1 << (64 - 54))) > (u64)0;
-            hi += (round_up ? ((u64)1 << (64 - 54)) : (u64)0);
-            
-            /* test overflow */
-            if (hi < ((u64)1 << (64 - 54))) {
-                hi = ((u64)1 << 63);
-                exp2 += 1;
+        if (likely(!sig_cut)) {
+            if (likely(read_f64_eisel_lemire(sig, exp, &raw))) {
+                return_f64_bin(raw);
             }
-            
-            /* This is a normal number, convert it to IEEE-754 format. */
-            hi >>= F64_BITS - F64_SIG_FULL_BITS;
-            exp2 += F64_BITS - F64_SIG_FULL_BITS + F64_SIG_BITS;
-            exp2 += F64_EXP_BIAS;
-            raw = ((u64)exp2 << F64_SIG_BITS) | (hi & F64_SIG_MASK);
+        } else if (read_f64_eisel_lemire_cut(sig, exp, &raw)) {
             return_f64_bin(raw);
         }
     }
@@ -5235,6 +6485,278 @@ read_double:
 
 
 
+/*==============================================================================
+ * JSON String Scanner (SIMD)
+ *
+ * These functions are used by `read_string()` to skip or copy long runs of
+ * plain ASCII characters in blocks of 16, 32 or 64 bytes. A run is stopped by
+ * the same characters as `char_is_ascii_stop()`: '"', '\\', [0x00-0x1F] and
+ * [0x80-0xFF]. With a signed byte comparison, both the control characters and
+ * the non-ASCII bytes are less than 0x20, so only three compares are needed.
+ *
+ * The functions only process whole blocks and never read beyond `end`, the
+ * remaining bytes are handled by the scalar code in `read_string()`.
+ *============================================================================*/
+
+#if YYJSON_HAS_SSE2
+
+/** Returns a bit mask of the ASCII stop characters in the 16-byte block. */
+static_inline u32 sse2_ascii_stop_mask(__m128i v) {
+    __m128i quote = _mm_cmpeq_epi8(v, _mm_set1_epi8('"'));
+    __m128i slash = _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'));
+    __m128i ctrl = _mm_cmplt_epi8(v, _mm_set1_epi8(0x20));
+    return (u32)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(quote, slash),
+                                               ctrl));
+}
+
+/** Skips plain ASCII in 16-byte blocks, returns the new source position. */
+static_inline u8 *skip_ascii_sse2(u8 *src, const u8 *end) {
+    __m128i v;
+    u32 mask;
+    while (end - src >= 16) {
+        v = _mm_loadu_si128((const __m128i *)(const void *)src);
+        mask = sse2_ascii_stop_mask(v);
+        if (mask) return src + u64_tz_bits(mask);
+        src += 16;
+    }
+    return src;
+}
+
+/** Copies plain ASCII in 16-byte blocks, returns the copied length. */
+static_inline usize copy_ascii_sse2(u8 *dst, const u8 *src, const u8 *end) {
+    const u8 *hdr = src;
+    __m128i v;
+    while (end - src >= 16) {
+        v = _mm_loadu_si128((const __m128i *)(const void *)src);
+        if (sse2_ascii_stop_mask(v)) break;
+        _mm_storeu_si128((__m128i *)(void *)dst, v);
+        src += 16;
+        dst += 16;
+    }
+    return (usize)(src - hdr);
+}
+
+#endif
+
+#if YYJSON_HAS_X86_DISPATCH
+
+/** Skips plain ASCII in 32-byte blocks, returns the new source position. */
+static YYJSON_TARGET_AVX2 u8 *skip_ascii_avx2(u8 *src, const u8 *end) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i slash = _mm256_set1_epi8('\\');
+    const __m256i space = _mm256_set1_epi8(0x20);
+    __m256i v, m;
+    u32 mask;
+    while (end - src >= 32) {
+        v = _mm256_loadu_si256((const __m256i *)(const void *)src);
+        m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote),
+                                            _mm256_cmpeq_epi8(v, slash)),
+                            _mm256_cmpgt_epi8(space, v));
+        mask = (u32)_mm256_movemask_epi8(m);
+        if (mask) return src + u64_tz_bits(mask);
+        src += 32;
+    }
+    return skip_ascii_sse2(src, end);
+}
+
+/** Copies plain ASCII in 32-byte blocks, returns the copied length. */
+static YYJSON_TARGET_AVX2 usize copy_ascii_avx2(u8 *dst, const u8 *src,
+                                                const u8 *end) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i slash = _mm256_set1_epi8('\\');
+    const __m256i space = _mm256_set1_epi8(0x20);
+    const u8 *hdr = src;
+    __m256i v, m;
+    while (end - src >= 32) {
+        v = _mm256_loadu_si256((const __m256i *)(const void *)src);
+        m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote),
+                                            _mm256_cmpeq_epi8(v, slash)),
+                            _mm256_cmpgt_epi8(space, v));
+        if (_mm256_movemask_epi8(m)) break;
+        _mm256_storeu_si256((__m256i *)(void *)dst, v);
+        src += 32;
+        dst += 32;
+    }
+    return (usize)(src - hdr);
+}
+
+/** Skips plain ASCII in 64-byte blocks, returns the new source position. */
+static YYJSON_TARGET_AVX512 u8 *skip_ascii_avx512(u8 *src, const u8 *end) {
+    const __m512i quote = _mm512_set1_epi8('"');
+    const __m512i slash = _mm512_set1_epi8('\\');
+    const __m512i space = _mm512_set1_epi8(0x20);
+    __m512i v;
+    u64 mask;
+    while (end - src >= 64) {
+        v = _mm512_loadu_si512((const void *)src);
+        mask = (u64)(_mm512_cmpeq_epi8_mask(v, quote) |
+                     _mm512_cmpeq_epi8_mask(v, slash) |
+                     _mm512_cmplt_epi8_mask(v, space));
+        if (mask) return src + u64_tz_bits(mask);
+        src += 64;
+    }
+    return skip_ascii_sse2(src, end);
+}
+
+/** Copies plain ASCII in 64-byte blocks, returns the copied length. */
+static YYJSON_TARGET_AVX512 usize copy_ascii_avx512(u8 *dst, const u8 *src,
+                                                    const u8 *end) {
+    const __m512i quote = _mm512_set1_epi8('"');
+    const __m512i slash = _mm512_set1_epi8('\\');
+    const __m512i space = _mm512_set1_epi8(0x20);
+    const u8 *hdr = src;
+    __m512i v;
+    while (end - src >= 64) {
+        v = _mm512_loadu_si512((const void *)src);
+        if (_mm512_cmpeq_epi8_mask(v, quote) |
+            _mm512_cmpeq_epi8_mask(v, slash) |
+            _mm512_cmplt_epi8_mask(v, space)) break;
+        _mm512_storeu_si512((void *)dst, v);
+        src += 64;
+        dst += 64;
+    }
+    return (usize)(src - hdr);
+}
+
+static u8 *skip_ascii_sse2_func(u8 *src, const u8 *end) {
+    return skip_ascii_sse2(src, end);
+}
+
+static usize copy_ascii_sse2_func(u8 *dst, const u8 *src, const u8 *end) {
+    return copy_ascii_sse2(dst, src, end);
+}
+
+static u8 *skip_ascii_init(u8 *src, const u8 *end);
+static usize copy_ascii_init(u8 *dst, const u8 *src, const u8 *end);
+
+/**
+ The kernels selected at run-time. They start with a resolver which checks the
+ CPU features on the first call. Concurrent first calls may run the resolver
+ more than once, but they all store the same function pointers.
+ */
+static u8 *(*skip_ascii_func)(u8 *src, const u8 *end) = skip_ascii_init;
+static usize (*copy_ascii_func)(u8 *dst, const u8 *src,
+                                const u8 *end) = copy_ascii_init;
+
+static void string_scanner_init(void) {
+    if (cpu_supports_avx512bw()) {
+        skip_ascii_func = skip_ascii_avx512;
+        copy_ascii_func = copy_ascii_avx512;
+    } else if (cpu_supports_avx2()) {
+        skip_ascii_func = skip_ascii_avx2;
+        copy_ascii_func = copy_ascii_avx2;
+    } else {
+        skip_ascii_func = skip_ascii_sse2_func;
+        copy_ascii_func = copy_ascii_sse2_func;
+    }
+}
+
+static u8 *skip_ascii_init(u8 *src, const u8 *end) {
+    string_scanner_init();
+    return skip_ascii_func(src, end);
+}
+
+static usize copy_ascii_init(u8 *dst, const u8 *src, const u8 *end) {
+    string_scanner_init();
+    return copy_ascii_func(dst, src, end);
+}
+
+#endif
+
+#if YYJSON_HAS_NEON
+
+/**
+ Returns a nibble mask of the ASCII stop characters in the 16-byte block,
+ each byte is represented by 4 bits (NEON has no `movemask` instruction).
+ */
+static_inline u64 neon_ascii_stop_mask(uint8x16_t v) {
+    uint8x16_t quote = vceqq_u8(v, vdupq_n_u8('"'));
+    uint8x16_t slash = vceqq_u8(v, vdupq_n_u8('\\'));
+    uint8x16_t ctrl = vcltq_s8(vreinterpretq_s8_u8(v), vdupq_n_s8(0x20));
+    uint8x16_t m = vorrq_u8(vorrq_u8(quote, slash), ctrl);
+    uint8x8_t n = vshrn_n_u16(vreinterpretq_u16_u8(m), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(n), 0);
+}
+
+/** Skips plain ASCII in 16-byte blocks, returns the new source position. */
+static_inline u8 *skip_ascii_neon(u8 *src, const u8 *end) {
+    u64 mask;
+    while (end - src >= 16) {
+        mask = neon_ascii_stop_mask(vld1q_u8(src));
+        if (mask) return src + (u64_tz_bits(mask) >> 2);
+        src += 16;
+    }
+    return src;
+}
+
+/** Copies plain ASCII in 16-byte blocks, returns the copied length. */
+static_inline usize copy_ascii_neon(u8 *dst, const u8 *src, const u8 *end) {
+    const u8 *hdr = src;
+    uint8x16_t v;
+    while (end - src >= 16) {
+        v = vld1q_u8(src);
+        if (neon_ascii_stop_mask(v)) break;
+        vst1q_u8(dst, v);
+        src += 16;
+        dst += 16;
+    }
+    return (usize)(src - hdr);
+}
+
+#endif
+
+#if YYJSON_HAS_SIMD
+
+/**
+ Skips plain ASCII characters with the best available kernel.
+ Returns the position of the first stop character, or a position near `end`
+ where the scalar code should continue.
+ 
+ The first block is checked inline, most strings end here and do not need to
+ pay for the indirect call to the run-time selected kernel.
+ */
+static_inline u8 *skip_ascii_simd(u8 *src, const u8 *end) {
+#if YYJSON_HAS_SSE2
+    u32 mask;
+    if (end - src < 16) return src;
+    mask = sse2_ascii_stop_mask(
+        _mm_loadu_si128((const __m128i *)(const void *)src));
+    if (mask) return src + u64_tz_bits(mask);
+#   if YYJSON_HAS_X86_DISPATCH
+    return skip_ascii_func(src + 16, end);
+#   else
+    return skip_ascii_sse2(src + 16, end);
+#   endif
+#else
+    return skip_ascii_neon(src, end);
+#endif
+}
+
+/**
+ Copies plain ASCII characters with the best available kernel.
+ Returns the copied length, `dst` should not be after `src`.
+ */
+static_inline usize copy_ascii_simd(u8 *dst, const u8 *src, const u8 *end) {
+#if YYJSON_HAS_SSE2
+    __m128i v;
+    if (end - src < 16) return 0;
+    v = _mm_loadu_si128((const __m128i *)(const void *)src);
+    if (sse2_ascii_stop_mask(v)) return 0;
+    _mm_storeu_si128((__m128i *)(void *)dst, v);
+#   if YYJSON_HAS_X86_DISPATCH
+    return 16 + copy_ascii_func(dst + 16, src + 16, end);
+#   else
+    return 16 + copy_ascii_sse2(dst + 16, src + 16, end);
+#   endif
+#else
+    return copy_ascii_neon(dst, src, end);
+#endif
+}
+
+#endif
+
+
+
 /*==============================================================================
  * JSON String Reader
  *============================================================================*/
@@ -5390,6 +6912,9 @@ static_inline bool read_string(u8 **ptr,
     u8 *src = ++cur, *dst, *pos;
     u16 hi, lo;
     u32 uni, tmp;
+#if YYJSON_HAS_SIMD
+    usize len;
+#endif
     
 skip_ascii:
     /* Most strings have no escaped characters, so we can jump them quickly. */
@@ -5417,6 +6942,10 @@ skip_ascii_begin:
     
     repeat16_incr(expr_jump)
     src += 16;
+#if YYJSON_HAS_SIMD
+    /* This is a long string, skip the rest of the run in SIMD blocks. */
+    src = skip_ascii_simd(src, lst);
+#endif
     goto skip_ascii_begin;
     repeat16_incr(expr_stop)
     
@@ -5583,6 +7112,12 @@ copy_ascii:
     byte_move_16(dst, src);
     src += 16;
     dst += 16;
+#if YYJSON_HAS_SIMD
+    /* This is a long string, copy the rest of the run in SIMD blocks. */
+    len = copy_ascii_simd(dst, src, lst);
+    src += len;
+    dst += len;
+#endif
     goto copy_ascii;
     
     /*
@@ -5831,7 +7366,7 @@ doc_end:
     /* check invalid contents after json document */
     if (unlikely(cur < end) && !has_read_flag(STOP_WHEN_DONE)) {
         if (has_read_flag(ALLOW_COMMENTS)) {
-            if (!skip_spaces_and_comments(&cur)) {
+            if (!skip_spaces_and_comments(&cur, end)) {
                 if (byte_match_2(cur, "/*")) goto fail_comment;
             }
         } else {
@@ -5847,6 +7382,7 @@ doc_end:
     doc->dat_read = (usize)(cur - hdr);
     doc->val_read = 1;
     doc->str_pool = has_read_flag(INSITU) ? NULL : (char *)hdr;
+    doc->key_idx = NULL;
     return doc;
     
 fail_string:
@@ -6041,7 +7577,7 @@ arr_val_begin:
         goto fail_character_val;
     }
     if (has_read_flag(ALLOW_COMMENTS)) {
-        if (skip_spaces_and_comments(&cur)) goto arr_val_begin;
+        if (skip_spaces_and_comments(&cur, end)) goto arr_val_begin;
         if (byte_match_2(cur, "/*")) goto fail_comment;
     }
     goto fail_character_val;
@@ -6060,7 +7596,7 @@ arr_val_end:
         goto arr_val_end;
     }
     if (has_read_flag(ALLOW_COMMENTS)) {
-        if (skip_spaces_and_comments(&cur)) goto arr_val_end;
+        if (skip_spaces_and_comments(&cur, end)) goto arr_val_end;
         if (byte_match_2(cur, "/*")) goto fail_comment;
     }
     goto fail_character_arr_end;
@@ -6113,7 +7649,7 @@ obj_key_begin:
         goto obj_key_begin;
     }
     if (has_read_flag(ALLOW_COMMENTS)) {
-        if (skip_spaces_and_comments(&cur)) goto obj_key_begin;
+        if (skip_spaces_and_comments(&cur, end)) goto obj_key_begin;
         if (byte_match_2(cur, "/*")) goto fail_comment;
     }
     goto fail_character_obj_key;
@@ -6128,7 +7664,7 @@ obj_key_end:
         goto obj_key_end;
     }
     if (has_read_flag(ALLOW_COMMENTS)) {
-        if (skip_spaces_and_comments(&cur)) goto obj_key_end;
+        if (skip_spaces_and_comments(&cur, end)) goto obj_key_end;
         if (byte_match_2(cur, "/*")) goto fail_comment;
     }
     goto fail_character_obj_sep;
@@ -6187,7 +7723,7 @@ obj_val_begin:
         goto fail_character_val;
     }
     if (has_read_flag(ALLOW_COMMENTS)) {
-        if (skip_spaces_and_comments(&cur)) goto obj_val_begin;
+        if (skip_spaces_and_comments(&cur, end)) goto obj_val_begin;
         if (byte_match_2(cur, "/*")) goto fail_comment;
     }
     goto fail_character_val;
@@ -6206,7 +7742,7 @@ obj_val_end:
         goto obj_val_end;
     }
     if (has_read_flag(ALLOW_COMMENTS)) {
-        if (skip_spaces_and_comments(&cur)) goto obj_val_end;
+        if (skip_spaces_and_comments(&cur, end)) goto obj_val_end;
         if (byte_match_2(cur, "/*")) goto fail_comment;
     }
     goto fail_character_obj_end;
@@ -6230,7 +7766,7 @@ doc_end:
     /* check invalid contents after json document */
     if (unlikely(cur < end) && !has_read_flag(STOP_WHEN_DONE)) {
         if (has_read_flag(ALLOW_COMMENTS)) {
-            skip_spaces_and_comments(&cur);
+            skip_spaces_and_comments(&cur, end);
             if (byte_match_2(cur, "/*")) goto fail_comment;
         } else {
             while (char_is_space(*cur)) cur++;
@@ -6245,6 +7781,7 @@ doc_end:
     doc->dat_read = (usize)(cur - hdr);
     doc->val_read = (usize)((val - doc->root) + 1);
     doc->str_pool = has_read_flag(INSITU) ? NULL : (char *)hdr;
+    doc->key_idx = NULL;
     return doc;
     
 fail_string:
@@ -6398,7 +7935,9 @@ arr_begin:
     if (*cur == '\n') cur++;
     
 arr_val_begin:
-#if YYJSON_IS_REAL_GCC
+#if YYJSON_HAS_SIMD
+    cur = skip_indent(cur, end);
+#elif YYJSON_IS_REAL_GCC
     while (true) repeat16({
         if (byte_match_2(cur, "  ")) cur += 2;
         else break;
@@ -6459,7 +7998,7 @@ arr_val_begin:
         goto fail_trailing_comma;
     }
     if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
+        cur = skip_spaces(cur + 1, end);
         goto arr_val_begin;
     }
     if (has_read_flag(ALLOW_INF_AND_NAN) &&
@@ -6470,7 +8009,7 @@ arr_val_begin:
         goto fail_character_val;
     }
     if (has_read_flag(ALLOW_COMMENTS)) {
-        if (skip_spaces_and_comments(&cur)) goto arr_val_begin;
+        if (skip_spaces_and_comments(&cur, end)) goto arr_val_begin;
         if (byte_match_2(cur, "/*")) goto fail_comment;
     }
     goto fail_character_val;
@@ -6489,11 +8028,11 @@ arr_val_end:
         goto arr_end;
     }
     if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
+        cur = skip_spaces(cur + 1, end);
         goto arr_val_end;
     }
     if (has_read_flag(ALLOW_COMMENTS)) {
-        if (skip_spaces_and_comments(&cur)) goto arr_val_end;
+        if (skip_spaces_and_comments(&cur, end)) goto arr_val_end;
         if (byte_match_2(cur, "/*")) goto fail_comment;
     }
     goto fail_character_arr_end;
@@ -6530,7 +8069,9 @@ obj_begin:
     if (*cur == '\n') cur++;
     
 obj_key_begin:
-#if YYJSON_IS_REAL_GCC
+#if YYJSON_HAS_SIMD
+    cur = skip_indent(cur, end);
+#elif YYJSON_IS_REAL_GCC
     while (true) repeat16({
         if (byte_match_2(cur, "  ")) cur += 2;
         else break;
@@ -6555,11 +8096,11 @@ obj_key_begin:
         goto fail_trailing_comma;
     }
     if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
+        cur = skip_spaces(cur + 1, end);
         goto obj_key_begin;
     }
     if (has_read_flag(ALLOW_COMMENTS)) {
-        if (skip_spaces_and_comments(&cur)) goto obj_key_begin;
+        if (skip_spaces_and_comments(&cur, end)) goto obj_key_begin;
         if (byte_match_2(cur, "/*")) goto fail_comment;
     }
     goto fail_character_obj_key;
@@ -6574,11 +8115,11 @@ obj_key_end:
         goto obj_val_begin;
     }
     if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
+        cur = skip_spaces(cur + 1, end);
         goto obj_key_end;
     }
     if (has_read_flag(ALLOW_COMMENTS)) {
-        if (skip_spaces_and_comments(&cur)) goto obj_key_end;
+        if (skip_spaces_and_comments(&cur, end)) goto obj_key_end;
         if (byte_match_2(cur, "/*")) goto fail_comment;
     }
     goto fail_character_obj_sep;
@@ -6626,7 +8167,7 @@ obj_val_begin:
         goto fail_literal_null;
     }
     if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
+        cur = skip_spaces(cur + 1, end);
         goto obj_val_begin;
     }
     if (has_read_flag(ALLOW_INF_AND_NAN) &&
@@ -6637,7 +8178,7 @@ obj_val_begin:
         goto fail_character_val;
     }
     if (has_read_flag(ALLOW_COMMENTS)) {
-        if (skip_spaces_and_comments(&cur)) goto obj_val_begin;
+        if (skip_spaces_and_comments(&cur, end)) goto obj_val_begin;
         if (byte_match_2(cur, "/*")) goto fail_comment;
     }
     goto fail_character_val;
@@ -6656,11 +8197,11 @@ obj_val_end:
         goto obj_end;
     }
     if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
+        cur = skip_spaces(cur + 1, end);
         goto obj_val_end;
     }
     if (has_read_flag(ALLOW_COMMENTS)) {
-        if (skip_spaces_and_comments(&cur)) goto obj_val_end;
+        if (skip_spaces_and_comments(&cur, end)) goto obj_val_end;
         if (byte_match_2(cur, "/*")) goto fail_comment;
     }
     goto fail_character_obj_end;
@@ -6685,10 +8226,10 @@ doc_end:
     /* check invalid contents after json document */
     if (unlikely(cur < end) && !has_read_flag(STOP_WHEN_DONE)) {
         if (has_read_flag(ALLOW_COMMENTS)) {
-            skip_spaces_and_comments(&cur);
+            skip_spaces_and_comments(&cur, end);
             if (byte_match_2(cur, "/*")) goto fail_comment;
         } else {
-            while (char_is_space(*cur)) cur++;
+            cur = skip_spaces(cur, end);
         }
         if (unlikely(cur < end)) goto fail_garbage;
     }
@@ -6700,6 +8241,7 @@ doc_end:
     doc->dat_read = (usize)(cur - hdr);
     doc->val_read = (usize)((val - val_hdr)) - hdr_len + 1;
     doc->str_pool = has_read_flag(INSITU) ? NULL : (char *)hdr;
+    doc->key_idx = NULL;
     return doc;
     
 fail_string:
@@ -6750,309 +8292,4879 @@ fail_garbage:
 
 
 /*==============================================================================
- * JSON Reader Entrance
+ * JSON Reader Implementation (Structural Index)
+ *
+ * An alternative reader engine, enabled by `YYJSON_READ_STRUCTURAL_INDEX`.
+ *
+ * Stage 1 classifies the input in 64-byte blocks and builds an index of the
+ * structural positions: the operators `{}[]:,`, the opening quote of strings,
+ * and the first byte of literals and numbers. The quote and escape masks are
+ * resolved with bit manipulation, so the scanner has no data-dependent branch.
+ *
+ * Stage 2 walks the index and builds the same value tape as the FSM readers
+ * above, the string and number readers are shared with them.
+ *
+ * The index is built chunk by chunk, so the memory overhead is bounded and the
+ * scanned data is still in cache when stage 2 visits it. A chunk never exposes
+ * an unclosed string to stage 2: the in-situ string reader may write to the
+ * string content, which must not happen before the content has been scanned.
  *============================================================================*/
 
-yyjson_doc *yyjson_read_opts(char *dat,
-                             usize len,
-                             yyjson_read_flag flg,
-                             const yyjson_alc *alc_ptr,
-                             yyjson_read_err *err) {
+/** Maximum bytes scanned by stage 1 at a time, should be a multiple of 64. */
+#define YYJSON_READER_INDEX_CHUNK_SIZE 0x4000
+
+/** Character masks of a 64-byte block, each bit represents a byte. */
+typedef struct idx_masks {
+    u64 bs; /* backslash */
+    u64 qt; /* quote */
+    u64 ws; /* whitespace */
+    u64 op; /* operator: {}[]:, */
+} idx_masks;
+
+/** Stage 1 state of the structural index reader. */
+typedef struct idx_scan {
+    u8 *hdr;        /* head of input data, indexes are offsets from it */
+    u8 *cur;        /* next byte to scan */
+    u8 *end;        /* end of input data */
+    u32 *buf;       /* index buffer */
+    u32 *pos;       /* next index for stage 2 */
+    u32 *tail;      /* end of the indexes for stage 2 */
+    u32 held;       /* the held back opening quote of an unclosed string */
+    bool has_held;  /* whether `held` is valid */
+    u64 in_str;     /* all bits set if the scanned data ended inside a string */
+    u64 escaped;    /* 1 if the next byte is escaped by a backslash */
+    u64 in_tok;     /* 1 if the scanned data ended inside a literal/number */
+} idx_scan;
+
+#if YYJSON_HAS_NEON && (defined(__aarch64__) || defined(_M_ARM64))
+/** Converts four NEON comparison results to a 64-bit mask. */
+static_inline u64 neon_movemask_64(uint8x16_t m0, uint8x16_t m1,
+                                   uint8x16_t m2, uint8x16_t m3) {
+    static const u8 bits[16] = {
+        0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+        0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80
+    };
+    uint8x16_t b = vld1q_u8(bits);
+    uint8x16_t s0 = vpaddq_u8(vandq_u8(m0, b), vandq_u8(m1, b));
+    uint8x16_t s1 = vpaddq_u8(vandq_u8(m2, b), vandq_u8(m3, b));
+    s0 = vpaddq_u8(s0, s1);
+    s0 = vpaddq_u8(s0, s0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(s0), 0);
+}
+#endif
+
+/** Classifies the characters of a 64-byte block. */
+static_inline void idx_classify(const u8 *src, idx_masks *m) {
+#if YYJSON_HAS_SSE2
+    int i;
+    m->bs = m->qt = m->ws = m->op = 0;
+    for (i = 0; i < 4; i++) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(const void *)(src + i * 16));
+        __m128i l = _mm_or_si128(v, _mm_set1_epi8(0x20)); /* '[' -> '{' */
+        __m128i ws = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                         _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                         _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+        __m128i op = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(l, _mm_set1_epi8('{')),
+                         _mm_cmpeq_epi8(l, _mm_set1_epi8('}'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')),
+                         _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+        __m128i bs = _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'));
+        __m128i qt = _mm_cmpeq_epi8(v, _mm_set1_epi8('"'));
+        m->bs |= (u64)(u32)_mm_movemask_epi8(bs) << (i * 16);
+        m->qt |= (u64)(u32)_mm_movemask_epi8(qt) << (i * 16);
+        m->ws |= (u64)(u32)_mm_movemask_epi8(ws) << (i * 16);
+        m->op |= (u64)(u32)_mm_movemask_epi8(op) << (i * 16);
+    }
+#elif YYJSON_HAS_NEON && (defined(__aarch64__) || defined(_M_ARM64))
+    uint8x16_t v[4], bs[4], qt[4], ws[4], op[4];
+    int i;
+    for (i = 0; i < 4; i++) {
+        uint8x16_t l;
+        v[i] = vld1q_u8(src + i * 16);
+        l = vorrq_u8(v[i], vdupq_n_u8(0x20)); /* '[' -> '{' */
+        bs[i] = vceqq_u8(v[i], vdupq_n_u8('\\'));
+        qt[i] = vceqq_u8(v[i], vdupq_n_u8('"'));
+        ws[i] = vorrq_u8(
+            vorrq_u8(vceqq_u8(v[i], vdupq_n_u8(' ')),
+                     vceqq_u8(v[i], vdupq_n_u8('\t'))),
+            vorrq_u8(vceqq_u8(v[i], vdupq_n_u8('\n')),
+                     vceqq_u8(v[i], vdupq_n_u8('\r'))));
+        op[i] = vorrq_u8(
+            vorrq_u8(vceqq_u8(l, vdupq_n_u8('{')),
+                     vceqq_u8(l, vdupq_n_u8('}'))),
+            vorrq_u8(vceqq_u8(v[i], vdupq_n_u8(':')),
+                     vceqq_u8(v[i], vdupq_n_u8(','))));
+    }
+    m->bs = neon_movemask_64(bs[0], bs[1], bs[2], bs[3]);
+    m->qt = neon_movemask_64(qt[0], qt[1], qt[2], qt[3]);
+    m->ws = neon_movemask_64(ws[0], ws[1], ws[2], ws[3]);
+    m->op = neon_movemask_64(op[0], op[1], op[2], op[3]);
+#else
+    int i;
+    m->bs = m->qt = m->ws = m->op = 0;
+    for (i = 0; i < 64; i++) {
+        u8 c = src[i];
+        u64 bit = (u64)1 << i;
+        if (c == '\\') m->bs |= bit;
+        else if (c == '"') m->qt |= bit;
+        else if (char_is_space(c)) m->ws |= bit;
+        else if (c == ':' || c == ',' ||
+                 (c | 0x20) == '{' || (c | 0x20) == '}') m->op |= bit;
+    }
+#endif
+}
+
+/**
+ Returns the mask of the characters escaped by a backslash.
+ An escaped backslash does not escape the next character, the odd length
+ backslash runs are found with a carry-propagating subtraction.
+ See: https://github.com/simdjson/simdjson (escape scanner)
+ */
+static_inline u64 idx_find_escaped(u64 bs, u64 *next_escaped) {
+    const u64 odd_bits = U64(0xAAAAAAAA, 0xAAAAAAAA);
+    u64 escaped = *next_escaped;
+    u64 potential, maybe, codes;
+    if (!bs) {
+        *next_escaped = 0;
+        return escaped;
+    }
+    potential = bs & ~escaped; /* a backslash escaped by carry is not code */
+    maybe = potential << 1;
+    codes = ((maybe | odd_bits) - potential) ^ odd_bits;
+    *next_escaped = (codes & bs) >> 63;
+    return codes ^ (bs | escaped);
+}
+
+/** Returns the prefix xor of the bits, the bit `i` of the result is the xor of
+    the bits `0..i` of the input. */
+static_inline u64 idx_prefix_xor(u64 v) {
+    v ^= v << 1;
+    v ^= v << 2;
+    v ^= v << 4;
+    v ^= v << 8;
+    v ^= v << 16;
+    v ^= v << 32;
+    return v;
+}
+
+/** Scans a 64-byte block, appends the structural indexes to `out`.
+    The `valid` is the mask of the bytes belong to the input data. */
+static_inline u32 *idx_scan_block(idx_scan *st, const u8 *src, u32 ofs,
+                                  u64 valid, u32 *out) {
+    idx_masks m;
+    u64 escaped, in_str, open_qt, close_qt, outside, op, tok, bits;
+    
+    idx_classify(src, &m);
+    escaped = idx_find_escaped(m.bs, &st->escaped);
+    m.qt &= ~escaped;
+    
+    /* the quotes toggle the string state, the opening quote is inside */
+    in_str = idx_prefix_xor(m.qt) ^ st->in_str;
+    st->in_str = (u64)((i64)in_str >> 63);
+    open_qt = m.qt & in_str;
+    close_qt = m.qt & ~in_str;
+    outside = ~(in_str | close_qt);
+    
+    /* literals and numbers are runs of the other characters */
+    op = m.op & outside;
+    tok = outside & ~(m.ws | m.op);
+    bits = tok & ~((tok << 1) | st->in_tok);
+    st->in_tok = tok >> 63;
+    bits = (bits | op | open_qt) & valid;
+    
+    /* write 8 indexes at a time without a data-dependent branch, the buffer
+       has enough slack for the extra writes */
+    if (bits) {
+        u32 *next = out + u64_pop_count(bits);
+        u64 top = (u64)1 << 63; /* avoid zero input for `u64_tz_bits()` */
+        do {
+            out[0] = ofs + u64_tz_bits(bits | top); bits &= bits - 1;
+            out[1] = ofs + u64_tz_bits(bits | top); bits &= bits - 1;
+            out[2] = ofs + u64_tz_bits(bits | top); bits &= bits - 1;
+            out[3] = ofs + u64_tz_bits(bits | top); bits &= bits - 1;
+            out[4] = ofs + u64_tz_bits(bits | top); bits &= bits - 1;
+            out[5] = ofs + u64_tz_bits(bits | top); bits &= bits - 1;
+            out[6] = ofs + u64_tz_bits(bits | top); bits &= bits - 1;
+            out[7] = ofs + u64_tz_bits(bits | top); bits &= bits - 1;
+            out += 8;
+        } while (bits);
+        out = next;
+    }
+    return out;
+}
+
+/**
+ Runs stage 1 on the next chunk, makes the new indexes available to stage 2.
+ Returns false if all data has been scanned and no index is available.
+ */
+static_noinline bool idx_refill(idx_scan *st) {
+    u8 *cur = st->cur;
+    u8 *end = st->end;
+    u8 *lim;
+    u32 *out;
+    u8 tmp[64];
+    usize len;
+    
+    do {
+        out = st->buf;
+        if (st->has_held) *out++ = st->held;
+        len = (usize)(end - cur);
+        lim = cur + yyjson_min(len, YYJSON_READER_INDEX_CHUNK_SIZE);
+        while (lim - cur >= 64) {
+            out = idx_scan_block(st, cur, (u32)(cur - st->hdr), U64_MAX, out);
+            cur += 64;
+        }
+        if (cur < lim) {
+            /* the last block, copy it to avoid reading beyond the end */
+            len = (usize)(lim - cur);
+            memset(tmp, 0, sizeof(tmp));
+            memcpy(tmp, cur, len);
+            out = idx_scan_block(st, tmp, (u32)(cur - st->hdr),
+                                 ((u64)1 << len) - 1, out);
+            cur = lim;
+        }
+        /* hold back the opening quote until the string is fully scanned */
+        st->has_held = st->in_str && cur < end;
+        if (st->has_held) st->held = *--out;
+    } while (out == st->buf && cur < end);
+    
+    st->cur = cur;
+    st->pos = st->buf;
+    st->tail = out;
+    return out != st->buf;
+}
+
+/** Read JSON document with the structural index (accept all style, except
+    comments). */
+static_noinline yyjson_doc *read_root_index(u8 *hdr,
+                                            u8 *cur,
+                                            u8 *end,
+                                            yyjson_alc alc,
+                                            yyjson_read_flag flg,
+                                            yyjson_read_err *err) {
     
 #define return_err(_pos, _code, _msg) do { \
-    err->pos = (usize)(_pos); \
-    err->msg = _msg; \
-    err->code = YYJSON_READ_ERROR_##_code; \
-    if (!has_read_flag(INSITU) && hdr) alc.free_(alc.ctx, (void *)hdr); \
-    return NULL; \
-} while (false)
+    if (is_truncated_end(hdr, _pos, end, YYJSON_READ_ERROR_##_code, flg)) { \
+        err->pos = (usize)(end - hdr); \
+        err->code = YYJSON_READ_ERROR_UNEXPECTED_END; \
+        err->msg = "unexpected end of data"; \
+    } else { \
+        err->pos = (usize)(_pos - hdr); \
+        err->code = YYJSON_READ_ERROR_##_code; \
+        err->msg = _msg; \
+    } \
+    if (val_hdr) alc.free_(alc.ctx, (void *)val_hdr); \
+    if (idx.buf) alc.free_(alc.ctx, (void *)idx.buf); \
+    return NULL; \
+} while (false)
+    
+#define val_incr() do { \
+    val++; \
+    if (unlikely(val >= val_end)) { \
+        usize alc_old = alc_len; \
+        usize val_ofs = (usize)(val - val_hdr); \
+        usize ctn_ofs = (usize)(ctn - val_hdr); \
+        alc_len += alc_len / 2; \
+        if ((sizeof(usize) < 8) && (alc_len >= alc_max)) goto fail_alloc; \
+        val_tmp = (yyjson_val *)alc.realloc_(alc.ctx, (void *)val_hdr, \
+            alc_old * sizeof(yyjson_val), \
+            alc_len * sizeof(yyjson_val)); \
+        if ((!val_tmp)) goto fail_alloc; \
+        val = val_tmp + val_ofs; \
+        ctn = val_tmp + ctn_ofs; \
+        val_hdr = val_tmp; \
+        val_end = val_tmp + (alc_len - 2); \
+    } \
+} while (false)
+    
+/* move `cur` to the next structural position, or `end` if there's none */
+#define idx_next() do { \
+    if (unlikely(idx_pos == idx_tail)) { \
+        if (idx_refill(&idx)) { \
+            idx_pos = idx.pos; \
+            idx_tail = idx.tail; \
+        } \
+    } \
+    cur = likely(idx_pos < idx_tail) ? hdr + *idx_pos++ : end; \
+} while (false)
+    
+/* move `cur` to the next structural position after a scalar value, only
+   whitespace is allowed between them */
+#define idx_next_after_val(_fail) do { \
+    u8 *val_end_pos = cur; \
+    idx_next(); \
+    if (unlikely(val_end_pos != cur)) { \
+        val_end_pos = skip_spaces(val_end_pos, end); \
+        if (val_end_pos != cur) { \
+            cur = val_end_pos; \
+            goto _fail; \
+        } \
+    } \
+} while (false)
+    
+    usize dat_len; /* data length in bytes, hint for allocator */
+    usize hdr_len; /* value count used by yyjson_doc */
+    usize alc_len; /* value count allocated */
+    usize alc_max; /* maximum value count for allocator */
+    usize ctn_len; /* the number of elements in current container */
+    usize idx_len; /* index count allocated */
+    yyjson_val *val_hdr; /* the head of allocated values */
+    yyjson_val *val_end; /* the end of allocated values */
+    yyjson_val *val_tmp; /* temporary pointer for realloc */
+    yyjson_val *val; /* current JSON value */
+    yyjson_val *ctn; /* current container */
+    yyjson_val *ctn_parent; /* parent of current container */
+    yyjson_doc *doc; /* the JSON document, equals to val_hdr */
+    const char *msg; /* error message */
+    idx_scan idx; /* the structural index */
+    u32 *idx_pos; /* next structural index */
+    u32 *idx_tail; /* end of the structural indexes */
+    
+    bool raw; /* read number as raw */
+    bool inv; /* allow invalid unicode */
+    u8 *raw_end; /* raw end for null-terminator */
+    u8 **pre; /* previous raw end pointer */
+    
+    /* the index buffer is allocated first, so the values can grow in place
+       with the pool allocator */
+    memset(&idx, 0, sizeof(idx));
+    idx.hdr = hdr;
+    idx.cur = cur;
+    idx.end = end;
+    idx_len = yyjson_min((usize)(end - cur), YYJSON_READER_INDEX_CHUNK_SIZE);
+    idx_len += 64 + 1 + 8; /* last block, held back index, write slack */
+    val_hdr = NULL;
+    idx.buf = (u32 *)alc.malloc_(alc.ctx, idx_len * sizeof(u32));
+    if (unlikely(!idx.buf)) goto fail_alloc;
+    idx_pos = idx_tail = idx.buf;
+    
+    dat_len = has_read_flag(STOP_WHEN_DONE) ? 256 : (usize)(end - cur);
+    hdr_len = sizeof(yyjson_doc) / sizeof(yyjson_val);
+    hdr_len += (sizeof(yyjson_doc) % sizeof(yyjson_val)) > 0;
+    alc_max = USIZE_MAX / sizeof(yyjson_val);
+    alc_len = hdr_len + (dat_len / YYJSON_READER_ESTIMATED_MINIFY_RATIO) + 4;
+    alc_len = yyjson_min(alc_len, alc_max);
+    
+    val_hdr = (yyjson_val *)alc.malloc_(alc.ctx, alc_len * sizeof(yyjson_val));
+    if (unlikely(!val_hdr)) goto fail_alloc;
+    val_end = val_hdr + (alc_len - 2); /* padding for key-value pair reading */
+    val = val_hdr + hdr_len;
+    ctn = val;
+    ctn_len = 0;
+    raw = has_read_flag(NUMBER_AS_RAW) || has_read_flag(BIGNUM_AS_RAW);
+    inv = has_read_flag(ALLOW_INVALID_UNICODE) != 0;
+    raw_end = NULL;
+    pre = raw ? &raw_end : NULL;
+    
+    idx_next(); /* the root container */
+    if (*cur == '{') {
+        ctn->tag = YYJSON_TYPE_OBJ;
+        ctn->uni.ofs = 0;
+        goto obj_key_begin;
+    } else {
+        ctn->tag = YYJSON_TYPE_ARR;
+        ctn->uni.ofs = 0;
+        goto arr_val_begin;
+    }
+    
+arr_begin:
+    /* save current container */
+    ctn->tag = (((u64)ctn_len + 1) << YYJSON_TAG_BIT) |
+               (ctn->tag & YYJSON_TAG_MASK);
+    
+    /* create a new array value, save parent container offset */
+    val_incr();
+    val->tag = YYJSON_TYPE_ARR;
+    val->uni.ofs = (usize)((u8 *)val - (u8 *)ctn);
+    
+    /* push the new array value as current container */
+    ctn = val;
+    ctn_len = 0;
+    
+arr_val_begin:
+    idx_next();
+    if (*cur == '{') goto obj_begin;
+    if (*cur == '[') goto arr_begin;
+    if (char_is_number(*cur)) {
+        val_incr();
+        ctn_len++;
+        if (likely(read_number(&cur, pre, flg, val, &msg))) goto arr_val_end;
+        goto fail_number;
+    }
+    if (*cur == '"') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_string(&cur, end, inv, val, &msg))) goto arr_val_end;
+        goto fail_string;
+    }
+    if (*cur == 't') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_true(&cur, val))) goto arr_val_end;
+        goto fail_literal_true;
+    }
+    if (*cur == 'f') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_false(&cur, val))) goto arr_val_end;
+        goto fail_literal_false;
+    }
+    if (*cur == 'n') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_null(&cur, val))) goto arr_val_end;
+        if (has_read_flag(ALLOW_INF_AND_NAN)) {
+            if (read_nan(false, &cur, pre, flg, val)) goto arr_val_end;
+        }
+        goto fail_literal_null;
+    }
+    if (*cur == ']') {
+        cur++;
+        if (likely(ctn_len == 0)) goto arr_end;
+        if (has_read_flag(ALLOW_TRAILING_COMMAS)) goto arr_end;
+        while (*cur != ',') cur--;
+        goto fail_trailing_comma;
+    }
+    if (has_read_flag(ALLOW_INF_AND_NAN) &&
+        (*cur == 'i' || *cur == 'I' || *cur == 'N')) {
+        val_incr();
+        ctn_len++;
+        if (read_inf_or_nan(false, &cur, pre, flg, val)) goto arr_val_end;
+        goto fail_character_val;
+    }
+    goto fail_character_val;
+    
+arr_val_end:
+    idx_next_after_val(fail_character_arr_end);
+arr_val_sep:
+    if (*cur == ',') goto arr_val_begin;
+    if (*cur == ']') {
+        cur++;
+        goto arr_end;
+    }
+    goto fail_character_arr_end;
+    
+arr_end:
+    /* get parent container */
+    ctn_parent = (yyjson_val *)(void *)((u8 *)ctn - ctn->uni.ofs);
+    
+    /* save the next sibling value offset */
+    ctn->uni.ofs = (usize)((u8 *)val - (u8 *)ctn) + sizeof(yyjson_val);
+    ctn->tag = ((ctn_len) << YYJSON_TAG_BIT) | YYJSON_TYPE_ARR;
+    if (unlikely(ctn == ctn_parent)) goto doc_end;
+    
+    /* pop parent as current container */
+    ctn = ctn_parent;
+    ctn_len = (usize)(ctn->tag >> YYJSON_TAG_BIT);
+    idx_next();
+    if ((ctn->tag & YYJSON_TYPE_MASK) == YYJSON_TYPE_OBJ) {
+        goto obj_val_sep;
+    } else {
+        goto arr_val_sep;
+    }
+    
+obj_begin:
+    /* push container */
+    ctn->tag = (((u64)ctn_len + 1) << YYJSON_TAG_BIT) |
+               (ctn->tag & YYJSON_TAG_MASK);
+    val_incr();
+    val->tag = YYJSON_TYPE_OBJ;
+    /* offset to the parent */
+    val->uni.ofs = (usize)((u8 *)val - (u8 *)ctn);
+    ctn = val;
+    ctn_len = 0;
+    
+obj_key_begin:
+    idx_next();
+    if (likely(*cur == '"')) {
+        val_incr();
+        ctn_len++;
+        if (likely(read_string(&cur, end, inv, val, &msg))) goto obj_key_end;
+        goto fail_string;
+    }
+    if (likely(*cur == '}')) {
+        cur++;
+        if (likely(ctn_len == 0)) goto obj_end;
+        if (has_read_flag(ALLOW_TRAILING_COMMAS)) goto obj_end;
+        while (*cur != ',') cur--;
+        goto fail_trailing_comma;
+    }
+    goto fail_character_obj_key;
+    
+obj_key_end:
+    idx_next_after_val(fail_character_obj_sep);
+    if (likely(*cur == ':')) goto obj_val_begin;
+    goto fail_character_obj_sep;
+    
+obj_val_begin:
+    idx_next();
+    if (*cur == '"') {
+        val++;
+        ctn_len++;
+        if (likely(read_string(&cur, end, inv, val, &msg))) goto obj_val_end;
+        goto fail_string;
+    }
+    if (char_is_number(*cur)) {
+        val++;
+        ctn_len++;
+        if (likely(read_number(&cur, pre, flg, val, &msg))) goto obj_val_end;
+        goto fail_number;
+    }
+    if (*cur == '{') goto obj_begin;
+    if (*cur == '[') goto arr_begin;
+    if (*cur == 't') {
+        val++;
+        ctn_len++;
+        if (likely(read_true(&cur, val))) goto obj_val_end;
+        goto fail_literal_true;
+    }
+    if (*cur == 'f') {
+        val++;
+        ctn_len++;
+        if (likely(read_false(&cur, val))) goto obj_val_end;
+        goto fail_literal_false;
+    }
+    if (*cur == 'n') {
+        val++;
+        ctn_len++;
+        if (likely(read_null(&cur, val))) goto obj_val_end;
+        if (has_read_flag(ALLOW_INF_AND_NAN)) {
+            if (read_nan(false, &cur, pre, flg, val)) goto obj_val_end;
+        }
+        goto fail_literal_null;
+    }
+    if (has_read_flag(ALLOW_INF_AND_NAN) &&
+        (*cur == 'i' || *cur == 'I' || *cur == 'N')) {
+        val++;
+        ctn_len++;
+        if (read_inf_or_nan(false, &cur, pre, flg, val)) goto obj_val_end;
+        goto fail_character_val;
+    }
+    goto fail_character_val;
+    
+obj_val_end:
+    idx_next_after_val(fail_character_obj_end);
+obj_val_sep:
+    if (likely(*cur == ',')) goto obj_key_begin;
+    if (likely(*cur == '}')) {
+        cur++;
+        goto obj_end;
+    }
+    goto fail_character_obj_end;
+    
+obj_end:
+    /* pop container */
+    ctn_parent = (yyjson_val *)(void *)((u8 *)ctn - ctn->uni.ofs);
+    /* point to the next value */
+    ctn->uni.ofs = (usize)((u8 *)val - (u8 *)ctn) + sizeof(yyjson_val);
+    ctn->tag = (ctn_len << (YYJSON_TAG_BIT - 1)) | YYJSON_TYPE_OBJ;
+    if (unlikely(ctn == ctn_parent)) goto doc_end;
+    ctn = ctn_parent;
+    ctn_len = (usize)(ctn->tag >> YYJSON_TAG_BIT);
+    idx_next();
+    if ((ctn->tag & YYJSON_TYPE_MASK) == YYJSON_TYPE_OBJ) {
+        goto obj_val_sep;
+    } else {
+        goto arr_val_sep;
+    }
+    
+doc_end:
+    /* check invalid contents after json document, any non-whitespace
+       character is indexed */
+    if (!has_read_flag(STOP_WHEN_DONE)) {
+        idx_next();
+        if (unlikely(cur < end)) goto fail_garbage;
+    }
+    
+    alc.free_(alc.ctx, (void *)idx.buf);
+    if (pre && *pre) **pre = '\0';
+    doc = (yyjson_doc *)val_hdr;
+    doc->root = val_hdr + hdr_len;
+    doc->alc = alc;
+    doc->dat_read = (usize)(cur - hdr);
+    doc->val_read = (usize)((val - doc->root) + 1);
+    doc->str_pool = has_read_flag(INSITU) ? NULL : (char *)hdr;
+    doc->key_idx = NULL;
+    return doc;
+    
+fail_string:
+    return_err(cur, INVALID_STRING, msg);
+fail_number:
+    return_err(cur, INVALID_NUMBER, msg);
+fail_alloc:
+    return_err(cur, MEMORY_ALLOCATION,
+               "memory allocation failed");
+fail_trailing_comma:
+    return_err(cur, JSON_STRUCTURE,
+               "trailing comma is not allowed");
+fail_literal_true:
+    return_err(cur, LITERAL,
+               "invalid literal, expected a valid literal such as 'true'");
+fail_literal_false:
+    return_err(cur, LITERAL,
+               "invalid literal, expected a valid literal such as 'false'");
+fail_literal_null:
+    return_err(cur, LITERAL,
+               "invalid literal, expected a valid literal such as 'null'");
+fail_character_val:
+    return_err(cur, UNEXPECTED_CHARACTER,
+               "unexpected character, expected a valid JSON value");
+fail_character_arr_end:
+    return_err(cur, UNEXPECTED_CHARACTER,
+               "unexpected character, expected a comma or a closing bracket");
+fail_character_obj_key:
+    return_err(cur, UNEXPECTED_CHARACTER,
+               "unexpected character, expected a string for object key");
+fail_character_obj_sep:
+    return_err(cur, UNEXPECTED_CHARACTER,
+               "unexpected character, expected a colon after object key");
+fail_character_obj_end:
+    return_err(cur, UNEXPECTED_CHARACTER,
+               "unexpected character, expected a comma or a closing brace");
+fail_garbage:
+    return_err(cur, UNEXPECTED_CONTENT,
+               "unexpected content after document");
+    
+#undef idx_next_after_val
+#undef idx_next
+#undef val_incr
+#undef return_err
+}
+
+
+
+
+/*==============================================================================
+ * JSON Reader Entrance
+ *============================================================================*/
+
+/** Replaces the error message if the data is not encoded in UTF-8. */
+static_inline void read_err_encoding(const u8 *hdr, usize len,
+                                     yyjson_read_err *err) {
+    /* RFC 8259: JSON text MUST be encoded using UTF-8 */
+    if (err->pos == 0 && err->code != YYJSON_READ_ERROR_MEMORY_ALLOCATION) {
+        if ((hdr[0] == 0xEF && hdr[1] == 0xBB && hdr[2] == 0xBF)) {
+            err->msg = "byte order mark (BOM) is not supported";
+        } else if (len >= 4 &&
+                   ((hdr[0] == 0x00 && hdr[1] == 0x00 &&
+                     hdr[2] == 0xFE && hdr[3] == 0xFF) ||
+                    (hdr[0] == 0xFF && hdr[1] == 0xFE &&
+                     hdr[2] == 0x00 && hdr[3] == 0x00))) {
+            err->msg = "UTF-32 encoding is not supported";
+        } else if (len >= 2 &&
+                   ((hdr[0] == 0xFE && hdr[1] == 0xFF) ||
+                    (hdr[0] == 0xFF && hdr[1] == 0xFE))) {
+            err->msg = "UTF-16 encoding is not supported";
+        }
+    }
+}
+
+/** Builds the key index of a document if it's required by the flag, the
+    document is freed if memory allocation failed. */
+static_inline yyjson_doc *read_key_idx(yyjson_doc *doc, yyjson_read_flag flg,
+                                       yyjson_read_err *err) {
+    if (!doc || !has_read_flag(KEY_INDEX) || doc_build_key_idx(doc)) {
+        return doc;
+    }
+    yyjson_doc_free(doc);
+    err->pos = 0;
+    err->msg = "memory allocation failed";
+    err->code = YYJSON_READ_ERROR_MEMORY_ALLOCATION;
+    return NULL;
+}
+
+yyjson_doc *yyjson_read_opts(char *dat,
+                             usize len,
+                             yyjson_read_flag flg,
+                             const yyjson_alc *alc_ptr,
+                             yyjson_read_err *err) {
+    
+#define return_err(_pos, _code, _msg) do { \
+    err->pos = (usize)(_pos); \
+    err->msg = _msg; \
+    err->code = YYJSON_READ_ERROR_##_code; \
+    if (!has_read_flag(INSITU) && hdr) alc.free_(alc.ctx, (void *)hdr); \
+    return NULL; \
+} while (false)
+    
+    yyjson_read_err dummy_err;
+    yyjson_alc alc;
+    yyjson_doc *doc;
+    u8 *hdr = NULL, *end, *cur;
+    
+    /* validate input parameters */
+    if (!err) err = &dummy_err;
+    if (likely(!alc_ptr)) {
+        alc = YYJSON_DEFAULT_ALC;
+    } else {
+        alc = *alc_ptr;
+    }
+    if (unlikely(!dat)) {
+        return_err(0, INVALID_PARAMETER, "input data is NULL");
+    }
+    if (unlikely(!len)) {
+        return_err(0, INVALID_PARAMETER, "input length is 0");
+    }
+    
+    /* add 4-byte zero padding for input data if necessary */
+    if (has_read_flag(INSITU)) {
+        hdr = (u8 *)dat;
+        end = (u8 *)dat + len;
+        cur = (u8 *)dat;
+    } else {
+        if (unlikely(len >= USIZE_MAX - YYJSON_PADDING_SIZE)) {
+            return_err(0, MEMORY_ALLOCATION, "memory allocation failed");
+        }
+        hdr = (u8 *)alc.malloc_(alc.ctx, len + YYJSON_PADDING_SIZE);
+        if (unlikely(!hdr)) {
+            return_err(0, MEMORY_ALLOCATION, "memory allocation failed");
+        }
+        end = hdr + len;
+        cur = hdr;
+        memcpy(hdr, dat, len);
+        memset(end, 0, YYJSON_PADDING_SIZE);
+    }
+    
+    /* skip empty contents before json document */
+    if (unlikely(char_is_space_or_comment(*cur))) {
+        if (has_read_flag(ALLOW_COMMENTS)) {
+            if (!skip_spaces_and_comments(&cur, end)) {
+                return_err(cur - hdr, INVALID_COMMENT,
+                           "unclosed multiline comment");
+            }
+        } else {
+            if (likely(char_is_space(*cur))) {
+                while (char_is_space(*++cur));
+            }
+        }
+        if (unlikely(cur >= end)) {
+            return_err(0, EMPTY_CONTENT, "input data is empty");
+        }
+    }
+    
+    /* read json document */
+    if (likely(char_is_container(*cur))) {
+        if (has_read_flag(STRUCTURAL_INDEX) && !has_read_flag(ALLOW_COMMENTS) &&
+            (u64)(end - hdr) <= (u64)U32_MAX) {
+            doc = read_root_index(hdr, cur, end, alc, flg, err);
+        } else if (char_is_space(cur[1]) && char_is_space(cur[2])) {
+            doc = read_root_pretty(hdr, cur, end, alc, flg, err);
+        } else {
+            doc = read_root_minify(hdr, cur, end, alc, flg, err);
+        }
+    } else {
+        doc = read_root_single(hdr, cur, end, alc, flg, err);
+    }
+    
+    /* check result */
+    if (likely(doc)) {
+        memset(err, 0, sizeof(yyjson_read_err));
+        return read_key_idx(doc, flg, err);
+    } else {
+        read_err_encoding(hdr, len, err);
+        if (!has_read_flag(INSITU)) alc.free_(alc.ctx, (void *)hdr);
+    }
+    return doc;
+    
+#undef return_err
+}
+
+yyjson_doc *yyjson_read_file(const char *path,
+                             yyjson_read_flag flg,
+                             const yyjson_alc *alc_ptr,
+                             yyjson_read_err *err) {
+#define return_err(_code, _msg) do { \
+    err->pos = 0; \
+    err->msg = _msg; \
+    err->code = YYJSON_READ_ERROR_##_code; \
+    return NULL; \
+} while (false)
+    
+    yyjson_read_err dummy_err;
+    yyjson_doc *doc;
+    FILE *file;
+#if YYJSON_HAS_MMAP
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    yyjson_alc map_alc;
+    mmap_alc_ctx *ctx;
+    u8 *map;
+    usize map_len, len;
+#endif
+    
+    if (!err) err = &dummy_err;
+    if (unlikely(!path)) return_err(INVALID_PARAMETER, "input path is NULL");
+    
+#if YYJSON_HAS_MMAP
+    /* read the mapped file in place, fall back to reading it into memory if
+       it cannot be mapped */
+    if (has_read_flag(MMAP) && mmap_file(path, &map, &map_len, &len)) {
+        ctx = (mmap_alc_ctx *)alc.malloc_(alc.ctx, sizeof(mmap_alc_ctx));
+        if (unlikely(!ctx)) {
+            munmap((void *)map, map_len);
+            return_err(MEMORY_ALLOCATION, "fail to alloc memory");
+        }
+        ctx->alc = alc;
+        ctx->map = map;
+        ctx->map_len = map_len;
+        ctx->doc = NULL;
+        map_alc.malloc_ = mmap_alc_malloc;
+        map_alc.realloc_ = mmap_alc_realloc;
+        map_alc.free_ = mmap_alc_free;
+        map_alc.ctx = (void *)ctx;
+        flg |= YYJSON_READ_INSITU;
+        doc = yyjson_read_opts((char *)map, len, flg, &map_alc, err);
+        if (doc) {
+            ctx->doc = (void *)doc;
+            doc->str_pool = (char *)map;
+        } else {
+            munmap((void *)map, map_len);
+            alc.free_(alc.ctx, (void *)ctx);
+        }
+        return doc;
+    }
+#endif
+    
+    file = fopen_readonly(path);
+    if (unlikely(!file)) return_err(FILE_OPEN, "file opening failed");
+    
+    doc = yyjson_read_fp(file, flg, alc_ptr, err);
+    fclose(file);
+    return doc;
+    
+#undef return_err
+}
+
+yyjson_doc *yyjson_read_fp(FILE *file,
+                           yyjson_read_flag flg,
+                           const yyjson_alc *alc_ptr,
+                           yyjson_read_err *err) {
+#define return_err(_code, _msg) do { \
+    err->pos = 0; \
+    err->msg = _msg; \
+    err->code = YYJSON_READ_ERROR_##_code; \
+    if (buf) alc.free_(alc.ctx, buf); \
+    return NULL; \
+} while (false)
+    
+    yyjson_read_err dummy_err;
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    yyjson_doc *doc;
+    
+    long file_size = 0, file_pos;
+    void *buf = NULL;
+    usize buf_size = 0;
+    
+    /* validate input parameters */
+    if (!err) err = &dummy_err;
+    if (unlikely(!file)) return_err(INVALID_PARAMETER, "input file is NULL");
+    
+    /* get current position */
+    file_pos = ftell(file);
+    if (file_pos != -1) {
+        /* get total file size, may fail */
+        if (fseek(file, 0, SEEK_END) == 0) file_size = ftell(file);
+        /* reset to original position, may fail */
+        if (fseek(file, file_pos, SEEK_SET) != 0) file_size = 0;
+        /* get file size from current postion to end */
+        if (file_size > 0) file_size -= file_pos;
+    }
+    
+    /* read file */
+    if (file_size > 0) {
+        /* read the entire file in one call */
+        buf_size = (usize)file_size + YYJSON_PADDING_SIZE;
+        buf = alc.malloc_(alc.ctx, buf_size);
+        if (buf == NULL) {
+            return_err(MEMORY_ALLOCATION, "fail to alloc memory");
+        }
+        if (fread_safe(buf, (usize)file_size, file) != (usize)file_size) {
+            return_err(FILE_READ, "file reading failed");
+        }
+    } else {
+        /* failed to get file size, read it as a stream */
+        usize chunk_min = (usize)64;
+        usize chunk_max = (usize)512 * 1024 * 1024;
+        usize chunk_now = chunk_min;
+        usize read_size;
+        void *tmp;
+        
+        buf_size = YYJSON_PADDING_SIZE;
+        while (true) {
+            if (buf_size + chunk_now < buf_size) { /* overflow */
+                return_err(MEMORY_ALLOCATION, "fail to alloc memory");
+            }
+            buf_size += chunk_now;
+            if (!buf) {
+                buf = alc.malloc_(alc.ctx, buf_size);
+                if (!buf) return_err(MEMORY_ALLOCATION, "fail to alloc memory");
+            } else {
+                tmp = alc.realloc_(alc.ctx, buf, buf_size - chunk_now, buf_size);
+                if (!tmp) return_err(MEMORY_ALLOCATION, "fail to alloc memory");
+                buf = tmp;
+            }
+            tmp = ((u8 *)buf) + buf_size - YYJSON_PADDING_SIZE - chunk_now;
+            read_size = fread_safe(tmp, chunk_now, file);
+            file_size += (long)read_size;
+            if (read_size != chunk_now) break;
+            
+            chunk_now *= 2;
+            if (chunk_now > chunk_max) chunk_now = chunk_max;
+        }
+    }
+    
+    /* read JSON */
+    memset((u8 *)buf + file_size, 0, YYJSON_PADDING_SIZE);
+    flg |= YYJSON_READ_INSITU;
+    doc = yyjson_read_opts((char *)buf, (usize)file_size, flg, &alc, err);
+    if (doc) {
+        doc->str_pool = (char *)buf;
+        return doc;
+    } else {
+        alc.free_(alc.ctx, buf);
+        return NULL;
+    }
+    
+#undef return_err
+}
+
+const char *yyjson_read_number(const char *dat,
+                               yyjson_val *val,
+                               yyjson_read_flag flg,
+                               const yyjson_alc *alc,
+                               yyjson_read_err *err) {
+#define return_err(_pos, _code, _msg) do { \
+    err->pos = _pos > hdr ? (usize)(_pos - hdr) : 0; \
+    err->msg = _msg; \
+    err->code = YYJSON_READ_ERROR_##_code; \
+    return NULL; \
+} while (false)
+    
+    u8 *hdr = constcast(u8 *)dat, *cur = hdr;
+    bool raw; /* read number as raw */
+    u8 *raw_end; /* raw end for null-terminator */
+    u8 **pre; /* previous raw end pointer */
+    const char *msg;
+    yyjson_read_err dummy_err;
+    
+#if !YYJSON_HAS_IEEE_754 || YYJSON_DISABLE_FAST_FP_CONV
+    u8 buf[128];
+    usize dat_len;
+#endif
+    
+    if (!err) err = &dummy_err;
+    if (unlikely(!dat)) {
+        return_err(cur, INVALID_PARAMETER, "input data is NULL");
+    }
+    if (unlikely(!val)) {
+        return_err(cur, INVALID_PARAMETER, "output value is NULL");
+    }
+    
+#if !YYJSON_HAS_IEEE_754 || YYJSON_DISABLE_FAST_FP_CONV
+    if (!alc) alc = &YYJSON_DEFAULT_ALC;
+    dat_len = strlen(dat);
+    if (dat_len < sizeof(buf)) {
+        memcpy(buf, dat, dat_len + 1);
+        hdr = buf;
+        cur = hdr;
+    } else {
+        hdr = (u8 *)alc->malloc_(alc->ctx, dat_len + 1);
+        cur = hdr;
+        if (unlikely(!hdr)) {
+            return_err(cur, MEMORY_ALLOCATION, "memory allocation failed");
+        }
+        memcpy(hdr, dat, dat_len + 1);
+    }
+    hdr[dat_len] = 0;
+#endif
+    
+    raw = (flg & (YYJSON_READ_NUMBER_AS_RAW | YYJSON_READ_BIGNUM_AS_RAW)) != 0;
+    raw_end = NULL;
+    pre = raw ? &raw_end : NULL;
+    
+#if !YYJSON_HAS_IEEE_754 || YYJSON_DISABLE_FAST_FP_CONV
+    if (!read_number(&cur, pre, flg, val, &msg)) {
+        if (dat_len >= sizeof(buf)) alc->free_(alc->ctx, hdr);
+        return_err(cur, INVALID_NUMBER, msg);
+    }
+    if (dat_len >= sizeof(buf)) alc->free_(alc->ctx, hdr);
+    if (yyjson_is_raw(val)) val->uni.str = dat;
+    return dat + (cur - hdr);
+#else
+    if (!read_number(&cur, pre, flg, val, &msg)) {
+        return_err(cur, INVALID_NUMBER, msg);
+    }
+    return (const char *)cur;
+#endif
+    
+#undef return_err
+}
+
+
+
+/*==============================================================================
+ * JSON Reader (Multi-threaded)
+ *
+ * A large document with a container root is split into parts at the commas of
+ * the root container, the parts are read concurrently, then the values are
+ * stitched into one document. The commas are found without reading the whole
+ * document sequentially:
+ *
+ * 1. Each thread summarizes a range of the data: the parity of quotes and the
+ *    change of bracket depth, for both cases of the range beginning inside or
+ *    outside of a string.
+ * 2. The calling thread resolves the string state and the bracket depth at the
+ *    beginning of each range, then each thread finds the first root-level comma
+ *    after the beginning of its range as the split point.
+ * 3. Each thread reads the values between its split point and the next one.
+ *
+ * The summary assumes valid JSON, the split points may be wrong for invalid
+ * JSON. However, if all parts are read successfully and each part ends exactly
+ * at the next split point, the whole data is valid JSON and the result is the
+ * same as the single-threaded reader. Otherwise the data is read again with
+ * the single-threaded reader to report the error. This is not possible for
+ * in-situ reading, which reports the first error of the parts instead.
+ *
+ * A thread only writes to the data of its own part (in-situ strings and raw
+ * number terminators), the terminator of the last raw number of each part is
+ * written after all threads have finished. The SIMD kernels of the string
+ * reader may load a few bytes beyond the part, these bytes are never used.
+ *============================================================================*/
+
+/** Character masks of a 64-byte block, each bit represents a byte. */
+typedef struct par_masks {
+    u64 bs; /* backslash */
+    u64 qt; /* quote */
+    u64 op; /* opening bracket: [{ */
+    u64 cl; /* closing bracket: ]} */
+    u64 cm; /* comma */
+} par_masks;
+
+/** The context shared by all parts. */
+typedef struct par_ctx {
+    u8 *hdr;            /* head of the data to be read */
+    u8 *end;            /* end of the data to be read */
+    const u8 *src;      /* head of the input data, same as `hdr` if in-situ */
+    yyjson_alc alc;     /* allocator for the parts, should be thread-safe */
+    yyjson_read_flag flg;
+    bool is_obj;        /* whether the root is an object */
+} par_ctx;
+
+/** A part of the root container. */
+typedef struct par_part {
+    par_ctx *ctx;
+    usize idx;          /* index of this part */
+    
+    /* phase 1: summarize the range */
+    u8 *rng_beg;        /* beginning of the range */
+    u8 *rng_end;        /* end of the range */
+    bool odd_qt;        /* the range has an odd number of quotes */
+    i64 dep_out;        /* depth change if the range begins outside string */
+    i64 dep_in;         /* depth change if the range begins inside string */
+    
+    /* phase 2: find the split point */
+    bool in_str;        /* whether the range begins inside string */
+    i64 depth;          /* the depth at the beginning of the range */
+    u8 *split;          /* the first root-level comma after `rng_beg` */
+    u8 *close;          /* the root's closing bracket before `split` */
+    
+    /* phase 3: read the values */
+    u8 *lim;            /* the split point of the next part, or NULL */
+    u8 *cur;            /* the position where reading stopped */
+    u8 *raw_end;        /* the pending raw number terminator */
+    yyjson_val *val_hdr; /* the root placeholder followed by the values */
+    yyjson_val *dst;    /* phase 4: the destination of the values */
+    usize val_num;      /* the number of values, excluding the placeholder */
+    usize ctn_len;      /* the number of elements in root (keys and values) */
+    bool closed;        /* whether the root container is closed */
+    bool ok;            /* whether the part is read successfully */
+    yyjson_read_err err;
+} par_part;
+
+/** Classifies the characters of a 64-byte block. */
+static_inline void par_classify(const u8 *src, par_masks *m) {
+#if YYJSON_HAS_SSE2
+    int i;
+    m->bs = m->qt = m->op = m->cl = m->cm = 0;
+    for (i = 0; i < 4; i++) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(const void *)(src + i * 16));
+        __m128i l = _mm_or_si128(v, _mm_set1_epi8(0x20)); /* '[' -> '{' */
+        __m128i bs = _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'));
+        __m128i qt = _mm_cmpeq_epi8(v, _mm_set1_epi8('"'));
+        __m128i op = _mm_cmpeq_epi8(l, _mm_set1_epi8('{'));
+        __m128i cl = _mm_cmpeq_epi8(l, _mm_set1_epi8('}'));
+        __m128i cm = _mm_cmpeq_epi8(v, _mm_set1_epi8(','));
+        m->bs |= (u64)(u32)_mm_movemask_epi8(bs) << (i * 16);
+        m->qt |= (u64)(u32)_mm_movemask_epi8(qt) << (i * 16);
+        m->op |= (u64)(u32)_mm_movemask_epi8(op) << (i * 16);
+        m->cl |= (u64)(u32)_mm_movemask_epi8(cl) << (i * 16);
+        m->cm |= (u64)(u32)_mm_movemask_epi8(cm) << (i * 16);
+    }
+#elif YYJSON_HAS_NEON && (defined(__aarch64__) || defined(_M_ARM64))
+    uint8x16_t bs[4], qt[4], op[4], cl[4], cm[4];
+    int i;
+    for (i = 0; i < 4; i++) {
+        uint8x16_t v = vld1q_u8(src + i * 16);
+        uint8x16_t l = vorrq_u8(v, vdupq_n_u8(0x20)); /* '[' -> '{' */
+        bs[i] = vceqq_u8(v, vdupq_n_u8('\\'));
+        qt[i] = vceqq_u8(v, vdupq_n_u8('"'));
+        op[i] = vceqq_u8(l, vdupq_n_u8('{'));
+        cl[i] = vceqq_u8(l, vdupq_n_u8('}'));
+        cm[i] = vceqq_u8(v, vdupq_n_u8(','));
+    }
+    m->bs = neon_movemask_64(bs[0], bs[1], bs[2], bs[3]);
+    m->qt = neon_movemask_64(qt[0], qt[1], qt[2], qt[3]);
+    m->op = neon_movemask_64(op[0], op[1], op[2], op[3]);
+    m->cl = neon_movemask_64(cl[0], cl[1], cl[2], cl[3]);
+    m->cm = neon_movemask_64(cm[0], cm[1], cm[2], cm[3]);
+#else
+    int i;
+    m->bs = m->qt = m->op = m->cl = m->cm = 0;
+    for (i = 0; i < 64; i++) {
+        u8 c = src[i];
+        u64 bit = (u64)1 << i;
+        if (c == '\\') m->bs |= bit;
+        else if (c == '"') m->qt |= bit;
+        else if (c == ',') m->cm |= bit;
+        else if ((c | 0x20) == '{') m->op |= bit;
+        else if ((c | 0x20) == '}') m->cl |= bit;
+    }
+#endif
+}
+
+/** Classifies a block of at most 64 bytes, the bytes beyond `end` are not
+    read and have no mask bit set. */
+static_inline void par_classify_tail(const u8 *src, const u8 *end,
+                                     par_masks *m) {
+    u8 tmp[64];
+    if (end - src >= 64) {
+        par_classify(src, m);
+    } else {
+        memset(tmp, 0, sizeof(tmp));
+        memcpy(tmp, src, (usize)(end - src));
+        par_classify(tmp, m);
+    }
+}
+
+/** Returns 1 if the character at `cur` is escaped by the preceding
+    backslashes. */
+static_inline u64 par_escape_carry(const u8 *hdr, const u8 *cur) {
+    const u8 *pos = cur;
+    while (pos > hdr && pos[-1] == '\\') pos--;
+    return (u64)((cur - pos) & 1);
+}
+
+/** Phase 1: copies the range from the input data if necessary, and
+    summarizes the quotes and brackets of the range. */
+static void read_parallel_scan(void *ptr) {
+    par_part *part = (par_part *)ptr;
+    par_ctx *ctx = part->ctx;
+    const u8 *cur = ctx->src + (part->rng_beg - ctx->hdr);
+    const u8 *end = ctx->src + (part->rng_end - ctx->hdr);
+    u64 esc, str, str_carry = 0;
+    i64 dep_out = 0, dep_in = 0;
+    par_masks m;
+    
+    if (ctx->src != ctx->hdr) {
+        memcpy(part->rng_beg, cur, (usize)(end - cur));
+    }
+    esc = par_escape_carry(ctx->src, cur);
+    for (; cur < end; cur += 64) {
+        par_classify_tail(cur, end, &m);
+        m.qt &= ~idx_find_escaped(m.bs, &esc);
+        str = idx_prefix_xor(m.qt) ^ str_carry;
+        str_carry = (u64)((i64)str >> 63);
+        if (m.op | m.cl) {
+            dep_out += (i64)u64_pop_count(m.op & ~str);
+            dep_out -= (i64)u64_pop_count(m.cl & ~str);
+            dep_in += (i64)u64_pop_count(m.op & str);
+            dep_in -= (i64)u64_pop_count(m.cl & str);
+        }
+    }
+    part->odd_qt = str_carry != 0;
+    part->dep_out = dep_out;
+    part->dep_in = dep_in;
+}
+
+/** Phase 2: finds the first root-level comma from the beginning of the range,
+    or the closing bracket of the root if it's before the comma. */
+static void read_parallel_split(void *ptr) {
+    par_part *part = (par_part *)ptr;
+    u8 *hdr = part->ctx->hdr;
+    u8 *end = part->ctx->end;
+    u8 *cur = part->rng_beg;
+    i64 depth = part->depth;
+    u64 esc, str, str_carry, op, cl, cm, bits, bit;
+    par_masks m;
+    
+    part->split = NULL;
+    part->close = NULL;
+    if (depth <= 0) return;
+    esc = par_escape_carry(hdr, cur);
+    str_carry = part->in_str ? U64_MAX : 0;
+    for (; cur < end; cur += 64) {
+        par_classify_tail(cur, end, &m);
+        m.qt &= ~idx_find_escaped(m.bs, &esc);
+        str = idx_prefix_xor(m.qt) ^ str_carry;
+        str_carry = (u64)((i64)str >> 63);
+        op = m.op & ~str;
+        cl = m.cl & ~str;
+        cm = m.cm & ~str;
+        if ((cm | cl) && depth <= (i64)u64_pop_count(cl) + 1) {
+            /* the depth may reach 1 or 0 in this block, check one by one */
+            bits = op | cl | cm;
+            while (bits) {
+                bit = bits & (~bits + 1);
+                if (op & bit) {
+                    depth++;
+                } else if (cl & bit) {
+                    if (--depth == 0) {
+                        part->close = cur + u64_tz_bits(bit);
+                        return;
+                    }
+                } else if (depth == 1) {
+                    part->split = cur + u64_tz_bits(bit);
+                    return;
+                }
+                bits ^= bit;
+            }
+        } else {
+            depth += (i64)u64_pop_count(op) - (i64)u64_pop_count(cl);
+        }
+    }
+}
+
+/** Phase 3: reads the values of the part into its own value buffer. The part
+    begins after its split point (or the root's opening bracket for the first
+    part), and ends at the next split point or the root's closing bracket. */
+static void read_parallel_part(void *ptr) {
+    
+#define return_err(_pos, _code, _msg) do { \
+    if (is_truncated_end(hdr, _pos, end, YYJSON_READ_ERROR_##_code, flg)) { \
+        part->err.pos = (usize)(end - hdr); \
+        part->err.code = YYJSON_READ_ERROR_UNEXPECTED_END; \
+        part->err.msg = "unexpected end of data"; \
+    } else { \
+        part->err.pos = (usize)(_pos - hdr); \
+        part->err.code = YYJSON_READ_ERROR_##_code; \
+        part->err.msg = _msg; \
+    } \
+    if (val_hdr) alc.free_(alc.ctx, (void *)val_hdr); \
+    part->val_hdr = NULL; \
+    return; \
+} while (false)
+    
+#define val_incr() do { \
+    val++; \
+    if (unlikely(val >= val_end)) { \
+        usize alc_old = alc_len; \
+        usize val_ofs = (usize)(val - val_hdr); \
+        usize ctn_ofs = (usize)(ctn - val_hdr); \
+        alc_len += alc_len / 2; \
+        if ((sizeof(usize) < 8) && (alc_len >= alc_max)) goto fail_alloc; \
+        val_tmp = (yyjson_val *)alc.realloc_(alc.ctx, (void *)val_hdr, \
+            alc_old * sizeof(yyjson_val), \
+            alc_len * sizeof(yyjson_val)); \
+        if ((!val_tmp)) goto fail_alloc; \
+        val = val_tmp + val_ofs; \
+        ctn = val_tmp + ctn_ofs; \
+        val_hdr = val_tmp; \
+        val_end = val_tmp + (alc_len - 2); \
+    } \
+} while (false)
+    
+    par_part *part = (par_part *)ptr;
+    u8 *hdr = part->ctx->hdr;
+    u8 *end = part->ctx->end;
+    u8 *cur; /* current position */
+    u8 *lim; /* the next split point, or NULL */
+    yyjson_alc alc = part->ctx->alc;
+    yyjson_read_flag flg = part->ctx->flg;
+    
+    usize dat_len; /* data length in bytes, hint for allocator */
+    usize alc_len; /* value count allocated */
+    usize alc_max; /* maximum value count for allocator */
+    usize ctn_len; /* the number of elements in current container */
+    usize ctn_ini; /* the initial number of elements in root */
+    yyjson_val *val_hdr; /* the head of allocated values */
+    yyjson_val *val_end; /* the end of allocated values */
+    yyjson_val *val_tmp; /* temporary pointer for realloc */
+    yyjson_val *val; /* current JSON value */
+    yyjson_val *ctn; /* current container */
+    yyjson_val *ctn_parent; /* parent of current container */
+    const char *msg; /* error message */
+    
+    bool raw; /* read number as raw */
+    bool inv; /* allow invalid unicode */
+    u8 *raw_end; /* raw end for null-terminator */
+    u8 **pre; /* previous raw end pointer */
+    
+    lim = part->lim;
+    if (part->idx == 0) {
+        cur = part->rng_beg;
+        ctn_ini = 0;
+    } else {
+        /* empty part: no split point, or the same as the next part */
+        if (!part->split || part->split == lim) {
+            part->ok = true;
+            return;
+        }
+        cur = part->split + 1;
+        ctn_ini = part->ctx->is_obj ? 2 : 1; /* for trailing comma check */
+    }
+    
+    dat_len = (usize)((lim ? lim : end) - cur);
+    alc_max = USIZE_MAX / sizeof(yyjson_val);
+    alc_len = 1 + (dat_len / YYJSON_READER_ESTIMATED_MINIFY_RATIO) + 4;
+    alc_len = yyjson_min(alc_len, alc_max);
+    
+    val_hdr = (yyjson_val *)alc.malloc_(alc.ctx, alc_len * sizeof(yyjson_val));
+    if (unlikely(!val_hdr)) goto fail_alloc;
+    val_end = val_hdr + (alc_len - 2); /* padding for key-value pair reading */
+    val = val_hdr;
+    ctn = val;
+    ctn_len = ctn_ini;
+    raw = has_read_flag(NUMBER_AS_RAW) || has_read_flag(BIGNUM_AS_RAW);
+    inv = has_read_flag(ALLOW_INVALID_UNICODE) != 0;
+    raw_end = NULL;
+    pre = raw ? &raw_end : NULL;
+    
+    ctn->uni.ofs = 0;
+    if (part->ctx->is_obj) {
+        ctn->tag = YYJSON_TYPE_OBJ;
+        goto obj_key_begin;
+    } else {
+        ctn->tag = YYJSON_TYPE_ARR;
+        goto arr_val_begin;
+    }
+    
+arr_begin:
+    /* save current container */
+    ctn->tag = (((u64)ctn_len + 1) << YYJSON_TAG_BIT) |
+               (ctn->tag & YYJSON_TAG_MASK);
+    
+    /* create a new array value, save parent container offset */
+    val_incr();
+    val->tag = YYJSON_TYPE_ARR;
+    val->uni.ofs = (usize)((u8 *)val - (u8 *)ctn);
+    
+    /* push the new array value as current container */
+    ctn = val;
+    ctn_len = 0;
+    
+arr_val_begin:
+    if (*cur == '{') {
+        cur++;
+        goto obj_begin;
+    }
+    if (*cur == '[') {
+        cur++;
+        goto arr_begin;
+    }
+    if (char_is_number(*cur)) {
+        val_incr();
+        ctn_len++;
+        if (likely(read_number(&cur, pre, flg, val, &msg))) goto arr_val_end;
+        goto fail_number;
+    }
+    if (*cur == '"') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_string(&cur, end, inv, val, &msg))) goto arr_val_end;
+        goto fail_string;
+    }
+    if (*cur == 't') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_true(&cur, val))) goto arr_val_end;
+        goto fail_literal_true;
+    }
+    if (*cur == 'f') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_false(&cur, val))) goto arr_val_end;
+        goto fail_literal_false;
+    }
+    if (*cur == 'n') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_null(&cur, val))) goto arr_val_end;
+        if (has_read_flag(ALLOW_INF_AND_NAN)) {
+            if (read_nan(false, &cur, pre, flg, val)) goto arr_val_end;
+        }
+        goto fail_literal_null;
+    }
+    if (*cur == ']') {
+        cur++;
+        if (likely(ctn_len == 0)) goto arr_end;
+        if (has_read_flag(ALLOW_TRAILING_COMMAS)) goto arr_end;
+        while (*cur != ',') cur--;
+        goto fail_trailing_comma;
+    }
+    if (char_is_space(*cur)) {
+        cur = skip_spaces(cur + 1, end);
+        goto arr_val_begin;
+    }
+    if (has_read_flag(ALLOW_INF_AND_NAN) &&
+        (*cur == 'i' || *cur == 'I' || *cur == 'N')) {
+        val_incr();
+        ctn_len++;
+        if (read_inf_or_nan(false, &cur, pre, flg, val)) goto arr_val_end;
+        goto fail_character_val;
+    }
+    goto fail_character_val;
+    
+arr_val_end:
+    if (*cur == ',') {
+        if (unlikely(ctn == val_hdr) && cur >= lim && lim) goto part_end;
+        cur++;
+        goto arr_val_begin;
+    }
+    if (*cur == ']') {
+        cur++;
+        goto arr_end;
+    }
+    if (char_is_space(*cur)) {
+        cur = skip_spaces(cur + 1, end);
+        goto arr_val_end;
+    }
+    goto fail_character_arr_end;
+    
+arr_end:
+    /* get parent container */
+    ctn_parent = (yyjson_val *)(void *)((u8 *)ctn - ctn->uni.ofs);
+    
+    /* save the next sibling value offset */
+    ctn->uni.ofs = (usize)((u8 *)val - (u8 *)ctn) + sizeof(yyjson_val);
+    ctn->tag = ((ctn_len) << YYJSON_TAG_BIT) | YYJSON_TYPE_ARR;
+    if (unlikely(ctn == ctn_parent)) goto part_end;
+    
+    /* pop parent as current container */
+    ctn = ctn_parent;
+    ctn_len = (usize)(ctn->tag >> YYJSON_TAG_BIT);
+    if ((ctn->tag & YYJSON_TYPE_MASK) == YYJSON_TYPE_OBJ) {
+        goto obj_val_end;
+    } else {
+        goto arr_val_end;
+    }
+    
+obj_begin:
+    /* push container */
+    ctn->tag = (((u64)ctn_len + 1) << YYJSON_TAG_BIT) |
+               (ctn->tag & YYJSON_TAG_MASK);
+    val_incr();
+    val->tag = YYJSON_TYPE_OBJ;
+    /* offset to the parent */
+    val->uni.ofs = (usize)((u8 *)val - (u8 *)ctn);
+    ctn = val;
+    ctn_len = 0;
+    
+obj_key_begin:
+    if (likely(*cur == '"')) {
+        val_incr();
+        ctn_len++;
+        if (likely(read_string(&cur, end, inv, val, &msg))) goto obj_key_end;
+        goto fail_string;
+    }
+    if (likely(*cur == '}')) {
+        cur++;
+        if (likely(ctn_len == 0)) goto obj_end;
+        if (has_read_flag(ALLOW_TRAILING_COMMAS)) goto obj_end;
+        while (*cur != ',') cur--;
+        goto fail_trailing_comma;
+    }
+    if (char_is_space(*cur)) {
+        cur = skip_spaces(cur + 1, end);
+        goto obj_key_begin;
+    }
+    goto fail_character_obj_key;
+    
+obj_key_end:
+    if (*cur == ':') {
+        cur++;
+        goto obj_val_begin;
+    }
+    if (char_is_space(*cur)) {
+        cur = skip_spaces(cur + 1, end);
+        goto obj_key_end;
+    }
+    goto fail_character_obj_sep;
+    
+obj_val_begin:
+    if (*cur == '"') {
+        val++;
+        ctn_len++;
+        if (likely(read_string(&cur, end, inv, val, &msg))) goto obj_val_end;
+        goto fail_string;
+    }
+    if (char_is_number(*cur)) {
+        val++;
+        ctn_len++;
+        if (likely(read_number(&cur, pre, flg, val, &msg))) goto obj_val_end;
+        goto fail_number;
+    }
+    if (*cur == '{') {
+        cur++;
+        goto obj_begin;
+    }
+    if (*cur == '[') {
+        cur++;
+        goto arr_begin;
+    }
+    if (*cur == 't') {
+        val++;
+        ctn_len++;
+        if (likely(read_true(&cur, val))) goto obj_val_end;
+        goto fail_literal_true;
+    }
+    if (*cur == 'f') {
+        val++;
+        ctn_len++;
+        if (likely(read_false(&cur, val))) goto obj_val_end;
+        goto fail_literal_false;
+    }
+    if (*cur == 'n') {
+        val++;
+        ctn_len++;
+        if (likely(read_null(&cur, val))) goto obj_val_end;
+        if (has_read_flag(ALLOW_INF_AND_NAN)) {
+            if (read_nan(false, &cur, pre, flg, val)) goto obj_val_end;
+        }
+        goto fail_literal_null;
+    }
+    if (char_is_space(*cur)) {
+        cur = skip_spaces(cur + 1, end);
+        goto obj_val_begin;
+    }
+    if (has_read_flag(ALLOW_INF_AND_NAN) &&
+        (*cur == 'i' || *cur == 'I' || *cur == 'N')) {
+        val++;
+        ctn_len++;
+        if (read_inf_or_nan(false, &cur, pre, flg, val)) goto obj_val_end;
+        goto fail_character_val;
+    }
+    goto fail_character_val;
+    
+obj_val_end:
+    if (likely(*cur == ',')) {
+        if (unlikely(ctn == val_hdr) && cur >= lim && lim) goto part_end;
+        cur++;
+        goto obj_key_begin;
+    }
+    if (likely(*cur == '}')) {
+        cur++;
+        goto obj_end;
+    }
+    if (char_is_space(*cur)) {
+        cur = skip_spaces(cur + 1, end);
+        goto obj_val_end;
+    }
+    goto fail_character_obj_end;
+    
+obj_end:
+    /* pop container */
+    ctn_parent = (yyjson_val *)(void *)((u8 *)ctn - ctn->uni.ofs);
+    /* point to the next value */
+    ctn->uni.ofs = (usize)((u8 *)val - (u8 *)ctn) + sizeof(yyjson_val);
+    ctn->tag = (ctn_len << (YYJSON_TAG_BIT - 1)) | YYJSON_TYPE_OBJ;
+    if (unlikely(ctn == ctn_parent)) goto part_end;
+    ctn = ctn_parent;
+    ctn_len = (usize)(ctn->tag >> YYJSON_TAG_BIT);
+    if ((ctn->tag & YYJSON_TYPE_MASK) == YYJSON_TYPE_OBJ) {
+        goto obj_val_end;
+    } else {
+        goto arr_val_end;
+    }
+    
+part_end:
+    /* the part should end at the next split point, or the end of root; the
+       next split point may be invalid if there are contents after root */
+    part->closed = (val_hdr->uni.ofs != 0);
+    if (unlikely(!part->closed && cur != lim)) goto fail_split;
+    part->cur = cur;
+    part->raw_end = (pre && *pre) ? *pre : NULL;
+    part->val_hdr = val_hdr;
+    part->val_num = (usize)(val - val_hdr);
+    part->ctn_len = ctn_len - ctn_ini;
+    part->ok = true;
+    return;
+    
+fail_string:
+    return_err(cur, INVALID_STRING, msg);
+fail_number:
+    return_err(cur, INVALID_NUMBER, msg);
+fail_alloc:
+    return_err(cur, MEMORY_ALLOCATION,
+               "memory allocation failed");
+fail_trailing_comma:
+    return_err(cur, JSON_STRUCTURE,
+               "trailing comma is not allowed");
+fail_literal_true:
+    return_err(cur, LITERAL,
+               "invalid literal, expected a valid literal such as 'true'");
+fail_literal_false:
+    return_err(cur, LITERAL,
+               "invalid literal, expected a valid literal such as 'false'");
+fail_literal_null:
+    return_err(cur, LITERAL,
+               "invalid literal, expected a valid literal such as 'null'");
+fail_character_val:
+    return_err(cur, UNEXPECTED_CHARACTER,
+               "unexpected character, expected a valid JSON value");
+fail_character_arr_end:
+    return_err(cur, UNEXPECTED_CHARACTER,
+               "unexpected character, expected a comma or a closing bracket");
+fail_character_obj_key:
+    return_err(cur, UNEXPECTED_CHARACTER,
+               "unexpected character, expected a string for object key");
+fail_character_obj_sep:
+    return_err(cur, UNEXPECTED_CHARACTER,
+               "unexpected character, expected a colon after object key");
+fail_character_obj_end:
+    return_err(cur, UNEXPECTED_CHARACTER,
+               "unexpected character, expected a comma or a closing brace");
+fail_split:
+    return_err(cur, JSON_STRUCTURE,
+               "unexpected structure, the document cannot be split");
+    
+#undef val_incr
+#undef return_err
+}
+
+/** Phase 4: copies the values of the part to the document, and frees the
+    value buffer of the part. */
+static void read_parallel_copy(void *ptr) {
+    par_part *part = (par_part *)ptr;
+    yyjson_alc alc = part->ctx->alc;
+    if (!part->val_hdr) return;
+    memcpy((void *)part->dst, (void *)(part->val_hdr + 1),
+           part->val_num * sizeof(yyjson_val));
+    alc.free_(alc.ctx, (void *)part->val_hdr);
+    part->val_hdr = NULL;
+}
+
+yyjson_doc *yyjson_read_parallel(char *dat,
+                                 usize len,
+                                 yyjson_read_flag flg,
+                                 const yyjson_alc *alc_ptr,
+                                 usize nthreads,
+                                 yyjson_read_err *err) {
+    
+#define return_err(_pos, _code, _msg) do { \
+    err->pos = (usize)(_pos - hdr); \
+    err->code = YYJSON_READ_ERROR_##_code; \
+    err->msg = _msg; \
+    goto fail; \
+} while (false)
+    
+    yyjson_read_err dummy_err;
+    yyjson_alc alc;
+    yyjson_doc *doc = NULL;
+    u8 *hdr = NULL, *end, *cur;
+    usize num, i, hdr_len, val_num, ctn_len;
+    par_ctx ctx;
+    par_part *parts = NULL;
+    void *mem = NULL;
+    usize mem_len;
+    yyjson_val *val_hdr, *val, *root;
+    bool in_str;
+    i64 depth;
+#if YYJSON_HAS_THREADS
+    locked_alc_ctx locked;
+    bool has_lock = false;
+#endif
+    
+    /* use the single-threaded reader if it's not worth splitting */
+    if (!nthreads) {
+#if YYJSON_HAS_THREADS
+        nthreads = thread_cpu_count();
+#else
+        nthreads = 1;
+#endif
+    }
+    num = yyjson_min(nthreads, len / YYJSON_READER_PARALLEL_MIN_SIZE);
+    if (!dat || num <= 1 || has_read_flag(ALLOW_COMMENTS)) {
+        return yyjson_read_opts(dat, len, flg, alc_ptr, err);
+    }
+    cur = (u8 *)dat;
+    end = (u8 *)dat + len;
+    while (cur < end && char_is_space(*cur)) cur++;
+    if (cur == end || !char_is_container(*cur)) {
+        return yyjson_read_opts(dat, len, flg, alc_ptr, err);
+    }
+    
+    if (!err) err = &dummy_err;
+    alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    memset(&ctx, 0, sizeof(ctx));
+    
+    /* add 4-byte zero padding for input data if necessary */
+    if (has_read_flag(INSITU)) {
+        hdr = (u8 *)dat;
+    } else {
+        if (unlikely(len >= USIZE_MAX - YYJSON_PADDING_SIZE)) goto fail_alloc;
+        hdr = (u8 *)alc.malloc_(alc.ctx, len + YYJSON_PADDING_SIZE);
+        if (unlikely(!hdr)) goto fail_alloc;
+        memcpy(hdr, dat, (usize)(cur - (u8 *)dat) + 1);
+        memset(hdr + len, 0, YYJSON_PADDING_SIZE);
+    }
+    cur = hdr + (cur - (u8 *)dat);
+    end = hdr + len;
+    
+    /* the parts, and the thread tasks of the parts */
+    mem_len = num * sizeof(par_part);
+#if YYJSON_HAS_THREADS
+    mem_len += num * (sizeof(thread_task) + sizeof(bool));
+#endif
+    mem = alc.malloc_(alc.ctx, mem_len);
+    if (unlikely(!mem)) goto fail_alloc;
+    memset(mem, 0, mem_len);
+    parts = (par_part *)mem;
+    
+    /* the user allocator may not be thread-safe */
+    ctx.hdr = hdr;
+    ctx.end = end;
+    ctx.src = (const u8 *)dat;
+    ctx.alc = alc;
+    ctx.flg = flg;
+    ctx.is_obj = *cur == '{';
+#if YYJSON_HAS_THREADS
+    if (alc_ptr) {
+        if (unlikely(!thread_mutex_init(&locked.mtx))) goto fail_alloc;
+        has_lock = true;
+        locked.alc = alc;
+        ctx.alc.malloc_ = locked_malloc;
+        ctx.alc.realloc_ = locked_realloc;
+        ctx.alc.free_ = locked_free;
+        ctx.alc.ctx = (void *)&locked;
+    }
+#endif
+    
+    /* phase 1: summarize the ranges */
+    cur++;
+    for (i = 0; i < num; i++) {
+        parts[i].ctx = &ctx;
+        parts[i].idx = i;
+        parts[i].rng_beg = cur + (usize)(end - cur) / num * i;
+        parts[i].rng_end = cur + (usize)(end - cur) / num * (i + 1);
+    }
+    parts[num - 1].rng_end = end;
+    thread_run_parts(read_parallel_scan, parts, sizeof(par_part), num,
+                      parts + num);
+    
+    /* phase 2: resolve the state of each range, find the split points */
+    in_str = false;
+    depth = 1;
+    for (i = 0; i < num; i++) {
+        parts[i].in_str = in_str;
+        parts[i].depth = depth;
+        if (depth <= 0) continue; /* the root is closed, ignore the rest */
+        depth += in_str ? parts[i].dep_in : parts[i].dep_out;
+        in_str ^= parts[i].odd_qt;
+    }
+    thread_run_parts(read_parallel_split, parts, sizeof(par_part), num,
+                      parts + num);
+    
+    /* ignore the split points after the root's closing bracket */
+    for (i = 0; i < num && !parts[i].close; i++) {}
+    if (i < num) {
+        cur = parts[i].close;
+        for (i = 0; i < num; i++) {
+            if (parts[i].split && parts[i].split > cur) parts[i].split = NULL;
+        }
+    }
+    
+    /* phase 3: read the parts */
+    for (i = 0; i + 1 < num; i++) parts[i].lim = parts[i + 1].split;
+    thread_run_parts(read_parallel_part, parts, sizeof(par_part), num,
+                      parts + num);
+    
+    /* check the parts until the root is closed, ignore the parts after it */
+    val_num = 0;
+    ctn_len = 0;
+    cur = NULL;
+    for (i = 0; i < num; i++) {
+        if (cur) {
+            if (parts[i].val_hdr) alc.free_(alc.ctx, (void *)parts[i].val_hdr);
+            parts[i].val_hdr = NULL;
+            continue;
+        }
+        if (!parts[i].ok) {
+            *err = parts[i].err;
+            goto fail;
+        }
+        if (!parts[i].val_hdr) continue; /* empty part */
+        if (parts[i].raw_end) *parts[i].raw_end = '\0';
+        if (parts[i].closed) cur = parts[i].cur;
+        val_num += parts[i].val_num;
+        ctn_len += parts[i].ctn_len;
+    }
+    if (unlikely(!cur)) {
+        return_err(end, UNEXPECTED_END, "unexpected end of data");
+    }
+    
+    /* phase 4: copy the values of the parts into the document */
+    hdr_len = sizeof(yyjson_doc) / sizeof(yyjson_val);
+    hdr_len += (sizeof(yyjson_doc) % sizeof(yyjson_val)) > 0;
+    if (unlikely(val_num >= USIZE_MAX / sizeof(yyjson_val) - hdr_len - 1)) {
+        goto fail_alloc;
+    }
+    val_hdr = (yyjson_val *)alc.malloc_(alc.ctx,
+        (hdr_len + 1 + val_num) * sizeof(yyjson_val));
+    if (unlikely(!val_hdr)) goto fail_alloc;
+    doc = (yyjson_doc *)val_hdr;
+    root = val_hdr + hdr_len;
+    val = root + 1;
+    for (i = 0; i < num; i++) {
+        parts[i].dst = val;
+        if (parts[i].val_hdr) val += parts[i].val_num;
+    }
+    thread_run_parts(read_parallel_copy, parts, sizeof(par_part), num,
+                      parts + num);
+    
+    if (ctx.is_obj) {
+        root->tag = ((u64)ctn_len << (YYJSON_TAG_BIT - 1)) | YYJSON_TYPE_OBJ;
+    } else {
+        root->tag = ((u64)ctn_len << YYJSON_TAG_BIT) | YYJSON_TYPE_ARR;
+    }
+    root->uni.ofs = (val_num + 1) * sizeof(yyjson_val);
+    doc->root = root;
+    doc->alc = alc;
+    doc->val_read = val_num + 1;
+    doc->str_pool = has_read_flag(INSITU) ? NULL : (char *)hdr;
+    doc->key_idx = NULL;
+    
+    /* check invalid contents after json document */
+    if (unlikely(cur < end) && !has_read_flag(STOP_WHEN_DONE)) {
+        while (char_is_space(*cur)) cur++;
+        if (unlikely(cur < end)) {
+            return_err(cur, UNEXPECTED_CONTENT,
+                       "unexpected content after document");
+        }
+    }
+    doc->dat_read = (usize)(cur - hdr);
+    
+#if YYJSON_HAS_THREADS
+    if (has_lock) thread_mutex_destroy(&locked.mtx);
+#endif
+    alc.free_(alc.ctx, mem);
+    memset(err, 0, sizeof(yyjson_read_err));
+    return read_key_idx(doc, flg, err);
+    
+fail_alloc:
+    err->pos = 0;
+    err->code = YYJSON_READ_ERROR_MEMORY_ALLOCATION;
+    err->msg = "memory allocation failed";
+fail:
+    if (doc) alc.free_(alc.ctx, (void *)doc);
+    for (i = 0; parts && i < num; i++) {
+        if (parts[i].val_hdr) alc.free_(alc.ctx, (void *)parts[i].val_hdr);
+    }
+#if YYJSON_HAS_THREADS
+    if (has_lock) thread_mutex_destroy(&locked.mtx);
+#endif
+    if (mem) alc.free_(alc.ctx, mem);
+    if (has_read_flag(INSITU)) return NULL;
+    if (hdr) alc.free_(alc.ctx, (void *)hdr);
+    /* read again to report the same error as the single-threaded reader */
+    return yyjson_read_opts(dat, len, flg, alc_ptr, err);
+    
+#undef return_err
+}
+
+
+
+/*==============================================================================
+ * JSON Reader (Incremental)
+ *
+ * The incremental reader appends each chunk to its own buffer (with zero
+ * padding), then continues the FSM from the saved state. The FSM is the same
+ * as the pretty reader, the zero padding stops the reading at the end of the
+ * buffer, and these cases are handled specially before the end of input:
+ *
+ * - If an error is caused by the end of the buffer (see `is_truncated_end()`),
+ *   the FSM saves the last state and reads the token again with more data.
+ * - A number or literal that ends at the end of the buffer may continue in the
+ *   next chunk, so it's read again with more data.
+ * - A string is read again only if its closing quote is found, the searched
+ *   position is saved, so a long string is not scanned for each chunk.
+ * - A comment is skipped only if it's closed in the buffer.
+ *
+ * The container stack is held by the values like the other readers, so it's
+ * kept in the value buffer across calls. If the data buffer is moved when it
+ * grows, the string pointers of the values are moved to the new buffer.
+ *============================================================================*/
+
+/** The states where the incremental reader resumes. */
+typedef enum incr_label {
+    INCR_DOC_BEGIN,
+    INCR_ARR_VAL_BEGIN,
+    INCR_ARR_VAL_END,
+    INCR_OBJ_KEY_BEGIN,
+    INCR_OBJ_KEY_END,
+    INCR_OBJ_VAL_BEGIN,
+    INCR_OBJ_VAL_END,
+    INCR_FINISHED
+} incr_label;
+
+struct yyjson_incr_state {
+    yyjson_alc alc;         /* allocator for the buffers */
+    yyjson_read_flag flg;   /* read flags */
+    incr_label label;       /* the state to resume */
+    u8 *hdr;                /* data buffer, followed by zero padding */
+    usize len;              /* data length in the buffer */
+    usize cap;              /* data buffer capacity, excluding padding */
+    usize cur;              /* offset of the next token to read */
+    usize scan;             /* offset of the next byte to scan in string */
+    yyjson_val *val_hdr;    /* the head of allocated values */
+    usize alc_len;          /* value count allocated */
+    usize val;              /* index of current value */
+    usize ctn;              /* index of current container */
+    usize ctn_len;          /* the number of elements in current container */
+    u8 *raw_end;            /* raw end for null-terminator */
+};
+
+/** Returns whether the closing quote of the string at `cur` is in the buffer.
+    The search continues from `scan` if it's inside the string, and `scan` is
+    set to the position where the search stopped. */
+static_inline bool incr_string_ready(u8 *cur, u8 **scan, u8 *end) {
+    u8 *pos = *scan > cur ? *scan : cur + 1;
+    u8 *qt, *bs;
+    while (pos < end) {
+        qt = (u8 *)memchr((void *)pos, '"', (usize)(end - pos));
+        if (!qt) break;
+        /* the quote is escaped if it follows an odd number of backslashes,
+           the opening quote stops the backward search */
+        for (bs = qt; bs[-1] == '\\'; bs--);
+        if (((qt - bs) & 1) == 0) {
+            *scan = qt;
+            return true;
+        }
+        pos = qt + 1;
+    }
+    *scan = end;
+    return false;
+}
+
+/** Returns whether a number or literal read before `cur` is complete, it may
+    continue in the next chunk if it's followed by letters or digits until the
+    end of the buffer, such as `-Inf` in `-Infin`. */
+static_inline bool incr_token_end(u8 *cur, u8 *end) {
+    for (; cur < end; cur++) {
+        u8 c = *cur;
+        if ((u8)(c - '0') >= 10 && (u8)((c | 0x20) - 'a') >= 26 &&
+            c != '+' && c != '-' && c != '.') break;
+    }
+    return cur < end;
+}
+
+/** Returns the last quote in range [beg, end) that is not escaped, or `hdr`
+    if there's no such quote. The strings start before this quote are closed
+    in the buffer, as a quote that is not escaped ends the string. */
+static_inline u8 *incr_last_quote(u8 *hdr, u8 *beg, u8 *end) {
+    u8 *cur, *bs;
+    for (cur = end; cur > beg; ) {
+        if (*--cur != '"') continue;
+        for (bs = cur; bs > hdr && bs[-1] == '\\'; bs--);
+        if (((cur - bs) & 1) == 0) return cur;
+    }
+    return hdr;
+}
+
+/** Skips spaces and comments in the buffer. Returns false if the buffer ends
+    before the next token, `cur` is set to the beginning of the unclosed
+    comment in this case. */
+static_inline bool incr_skip_spaces(u8 **ptr, u8 *end, yyjson_read_flag flg) {
+    u8 *cur = *ptr;
+    u8 *tmp;
+    while (true) {
+        if (char_is_space(*cur)) {
+            cur = skip_spaces(cur + 1, end);
+            continue;
+        }
+        if (*cur == '/' && has_read_flag(ALLOW_COMMENTS)) {
+            if (cur + 1 >= end) break;
+            if (cur[1] == '*') {
+                for (tmp = cur + 2; tmp + 1 < end; tmp++) {
+                    if (byte_match_2(tmp, "*/") || *tmp == '\0') break;
+                }
+                if (tmp + 1 >= end) break;
+                if (*tmp == '\0') {
+                    *ptr = cur; /* unclosed comment, reported by caller */
+                    return true;
+                }
+                cur = tmp + 2;
+                continue;
+            }
+            if (cur[1] == '/') {
+                for (tmp = cur + 2; tmp < end; tmp++) {
+                    if (char_is_line_end(*tmp)) break;
+                }
+                if (tmp >= end) break;
+                cur = tmp;
+                continue;
+            }
+        }
+        *ptr = cur;
+        return cur < end;
+    }
+    *ptr = cur;
+    return false;
+}
+
+/** Appends the data to the buffer, moves the string pointers of the values if
+    the buffer is moved. */
+static bool incr_append(yyjson_incr_state *state, const u8 *dat, usize len) {
+    yyjson_alc alc = state->alc;
+    usize cap = state->cap, hdr_len, i, ofs, adr;
+    u8 *hdr, *old = state->hdr;
+    yyjson_val *val;
+    
+    if (len > cap - state->len) {
+        if (unlikely(len >= USIZE_MAX - YYJSON_PADDING_SIZE - state->len)) {
+            return false;
+        }
+        cap = yyjson_max(cap, YYJSON_READER_INCR_BUF_INIT_SIZE);
+        while (cap < state->len + len) {
+            cap = (cap < (USIZE_MAX - YYJSON_PADDING_SIZE) / 2) ?
+                  cap * 2 : state->len + len;
+        }
+        if (!old) {
+            hdr = (u8 *)alc.malloc_(alc.ctx, cap + YYJSON_PADDING_SIZE);
+        } else {
+            hdr = (u8 *)alc.realloc_(alc.ctx, (void *)old,
+                                     state->cap + YYJSON_PADDING_SIZE,
+                                     cap + YYJSON_PADDING_SIZE);
+        }
+        if (unlikely(!hdr)) return false;
+        if (old && hdr != old) {
+            /* move the string pointers of the values to the new buffer,
+               the old buffer is freed, so only the addresses are used */
+            ofs = (usize)(void *)hdr - (usize)(void *)old;
+            if (state->label != INCR_DOC_BEGIN) {
+                hdr_len = sizeof(yyjson_doc) / sizeof(yyjson_val);
+                hdr_len += (sizeof(yyjson_doc) % sizeof(yyjson_val)) > 0;
+                for (i = hdr_len; i <= state->val; i++) {
+                    val = state->val_hdr + i;
+                    if (unsafe_yyjson_is_str(val) ||
+                        unsafe_yyjson_is_raw(val)) {
+                        adr = (usize)(const void *)val->uni.str + ofs;
+                        val->uni.str = (const char *)(void *)adr;
+                    }
+                }
+            }
+            if (state->raw_end) {
+                adr = (usize)(void *)state->raw_end + ofs;
+                state->raw_end = (u8 *)(void *)adr;
+            }
+        }
+        state->hdr = hdr;
+        state->cap = cap;
+    }
+    memcpy(state->hdr + state->len, dat, len);
+    state->len += len;
+    memset(state->hdr + state->len, 0, YYJSON_PADDING_SIZE);
+    return true;
+}
+
+yyjson_incr_state *yyjson_incr_new(yyjson_read_flag flg,
+                                   const yyjson_alc *alc_ptr) {
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    yyjson_incr_state *state;
+    state = (yyjson_incr_state *)alc.malloc_(alc.ctx, sizeof(*state));
+    if (unlikely(!state)) return NULL;
+    memset((void *)state, 0, sizeof(*state));
+    state->alc = alc;
+    state->flg = flg & ~YYJSON_READ_INSITU; /* always read in own buffer */
+    state->label = INCR_DOC_BEGIN;
+    return state;
+}
+
+void yyjson_incr_free(yyjson_incr_state *state) {
+    yyjson_alc alc;
+    if (!state) return;
+    alc = state->alc;
+    if (state->hdr) alc.free_(alc.ctx, (void *)state->hdr);
+    if (state->val_hdr) alc.free_(alc.ctx, (void *)state->val_hdr);
+    alc.free_(alc.ctx, (void *)state);
+}
+
+yyjson_doc *yyjson_incr_read(yyjson_incr_state *state,
+                             const char *dat,
+                             usize len,
+                             yyjson_read_err *err) {
+    
+#define return_err(_pos, _code, _msg) do { \
+    if (is_truncated_end(hdr, _pos, end, YYJSON_READ_ERROR_##_code, flg)) { \
+        if (!fin) goto retry; \
+        return_err_at(end, UNEXPECTED_END, "unexpected end of data"); \
+    } \
+    return_err_at(_pos, _code, _msg); \
+} while (false)
+    
+#define return_err_at(_pos, _code, _msg) do { \
+    err->pos = (usize)(_pos - hdr); \
+    err->code = YYJSON_READ_ERROR_##_code; \
+    err->msg = _msg; \
+    read_err_encoding(hdr, state->len, err); \
+    state->val_hdr = val_hdr; \
+    state->label = INCR_FINISHED; \
+    return NULL; \
+} while (false)
+    
+#define save_label(_lbl) do { \
+    lbl = _lbl; \
+    lbl_cur = cur; \
+    lbl_val = (usize)(val - val_hdr); \
+    lbl_len = ctn_len; \
+    lbl_raw = raw_end; \
+} while (false)
+    
+#define val_incr() do { \
+    val++; \
+    if (unlikely(val >= val_end)) { \
+        usize alc_old = alc_len; \
+        usize val_ofs = (usize)(val - val_hdr); \
+        usize ctn_ofs = (usize)(ctn - val_hdr); \
+        alc_len += alc_len / 2; \
+        if ((sizeof(usize) < 8) && (alc_len >= alc_max)) goto fail_alloc; \
+        val_tmp = (yyjson_val *)alc.realloc_(alc.ctx, (void *)val_hdr, \
+            alc_old * sizeof(yyjson_val), \
+            alc_len * sizeof(yyjson_val)); \
+        if ((!val_tmp)) goto fail_alloc; \
+        val = val_tmp + val_ofs; \
+        ctn = val_tmp + ctn_ofs; \
+        val_hdr = val_tmp; \
+        val_end = val_tmp + (alc_len - 2); \
+    } \
+} while (false)
+    
+    yyjson_read_err dummy_err;
+    yyjson_alc alc;
+    yyjson_read_flag flg;
+    incr_label lbl; /* the state to resume if the data is not enough */
+    u8 *lbl_cur; /* position of the state to resume */
+    usize lbl_val; /* value index of the state to resume */
+    usize lbl_len; /* container length of the state to resume */
+    u8 *lbl_raw; /* raw end of the state to resume */
+    bool fin; /* whether this is the end of input */
+    u8 *hdr; /* the head of data buffer */
+    u8 *end; /* the end of data in buffer */
+    u8 *cur; /* current position */
+    u8 *scan; /* the position to continue searching for the string end */
+    u8 *qte; /* the strings start before it are closed in the buffer */
+    u8 *skip; /* the position after spaces and comments */
+    
+    usize hdr_len; /* value count used by yyjson_doc */
+    usize alc_len; /* value count allocated */
+    usize alc_max; /* maximum value count for allocator */
+    usize ctn_len; /* the number of elements in current container */
+    yyjson_val *val_hdr; /* the head of allocated values */
+    yyjson_val *val_end; /* the end of allocated values */
+    yyjson_val *val_tmp; /* temporary pointer for realloc */
+    yyjson_val *val; /* current JSON value */
+    yyjson_val *ctn; /* current container */
+    yyjson_val *ctn_parent; /* parent of current container */
+    yyjson_doc *doc; /* the JSON document, equals to val_hdr */
+    const char *msg; /* error message */
+    
+    bool raw; /* read number as raw */
+    bool inv; /* allow invalid unicode */
+    u8 *raw_end; /* raw end for null-terminator */
+    u8 **pre; /* previous raw end pointer */
+    
+    /* validate input parameters */
+    if (!err) err = &dummy_err;
+    if (unlikely(!state)) {
+        err->pos = 0;
+        err->code = YYJSON_READ_ERROR_INVALID_PARAMETER;
+        err->msg = "input state is NULL";
+        return NULL;
+    }
+    if (unlikely(state->label == INCR_FINISHED)) {
+        err->pos = 0;
+        err->code = YYJSON_READ_ERROR_INVALID_PARAMETER;
+        err->msg = "incremental reading is finished";
+        return NULL;
+    }
+    
+    /* append the data, or finish the input if there's no data */
+    alc = state->alc;
+    flg = state->flg;
+    fin = !dat || !len;
+    if (!fin) {
+        if (unlikely(!incr_append(state, (const u8 *)dat, len))) {
+            err->pos = 0;
+            err->code = YYJSON_READ_ERROR_MEMORY_ALLOCATION;
+            err->msg = "memory allocation failed";
+            state->label = INCR_FINISHED;
+            return NULL;
+        }
+    } else if (unlikely(!state->len)) {
+        err->pos = 0;
+        err->code = YYJSON_READ_ERROR_INVALID_PARAMETER;
+        err->msg = "input length is 0";
+        state->label = INCR_FINISHED;
+        return NULL;
+    }
+    
+    /* restore the state */
+    hdr = state->hdr;
+    end = hdr + state->len;
+    cur = hdr + state->cur;
+    scan = hdr + state->scan;
+    qte = incr_last_quote(hdr, scan > cur ? scan : cur, end);
+    hdr_len = sizeof(yyjson_doc) / sizeof(yyjson_val);
+    hdr_len += (sizeof(yyjson_doc) % sizeof(yyjson_val)) > 0;
+    alc_max = USIZE_MAX / sizeof(yyjson_val);
+    val_hdr = state->val_hdr;
+    if (!val_hdr) {
+        alc_len = hdr_len + (len / YYJSON_READER_ESTIMATED_MINIFY_RATIO) + 4;
+        alc_len = yyjson_min(alc_len, alc_max);
+        val_hdr = (yyjson_val *)alc.malloc_(alc.ctx,
+                                            alc_len * sizeof(yyjson_val));
+        if (unlikely(!val_hdr)) goto fail_alloc;
+        state->val_hdr = val_hdr;
+        state->alc_len = alc_len;
+        state->val = hdr_len;
+        state->ctn = hdr_len;
+    }
+    alc_len = state->alc_len;
+    val_end = val_hdr + (alc_len - 2); /* padding for key-value pair reading */
+    val = val_hdr + state->val;
+    ctn = val_hdr + state->ctn;
+    ctn_len = state->ctn_len;
+    raw = has_read_flag(NUMBER_AS_RAW) || has_read_flag(BIGNUM_AS_RAW);
+    inv = has_read_flag(ALLOW_INVALID_UNICODE) != 0;
+    raw_end = state->raw_end;
+    pre = raw ? &raw_end : NULL;
+    
+    switch (state->label) {
+        case INCR_ARR_VAL_BEGIN: goto arr_val_begin;
+        case INCR_ARR_VAL_END: goto arr_val_end;
+        case INCR_OBJ_KEY_BEGIN: goto obj_key_begin;
+        case INCR_OBJ_KEY_END: goto obj_key_end;
+        case INCR_OBJ_VAL_BEGIN: goto obj_val_begin;
+        case INCR_OBJ_VAL_END: goto obj_val_end;
+        case INCR_DOC_BEGIN: goto doc_begin;
+        case INCR_FINISHED: goto doc_begin;
+    }
+    
+doc_begin:
+    save_label(INCR_DOC_BEGIN);
+    if (!incr_skip_spaces(&cur, end, flg) && !fin) goto more;
+    /* the encoding is checked with the first 4 bytes if the reading fails */
+    if (!fin && end - hdr < 4 && (*hdr == 0x00 || *hdr >= 0x80)) goto more;
+    
+    /* the contents before the root value are complete, read them again in
+       the same way as `yyjson_read_opts()` */
+    cur = hdr;
+    if (unlikely(char_is_space_or_comment(*cur))) {
+        if (has_read_flag(ALLOW_COMMENTS)) {
+            if (!skip_spaces_and_comments(&cur, end)) {
+                return_err_at(cur, INVALID_COMMENT,
+                              "unclosed multiline comment");
+            }
+        } else {
+            if (likely(char_is_space(*cur))) {
+                while (char_is_space(*++cur));
+            }
+        }
+        if (unlikely(cur >= end)) {
+            return_err_at(hdr, EMPTY_CONTENT, "input data is empty");
+        }
+    }
+    if (char_is_container(*cur)) {
+        ctn->uni.ofs = 0;
+        if (*cur++ == '{') {
+            ctn->tag = YYJSON_TYPE_OBJ;
+            goto obj_key_begin;
+        } else {
+            ctn->tag = YYJSON_TYPE_ARR;
+            goto arr_val_begin;
+        }
+    }
+    
+    /* single value root */
+    if (char_is_number(*cur)) {
+        if (likely(read_number(&cur, pre, flg, val, &msg))) goto doc_tok_end;
+        goto fail_number;
+    }
+    if (*cur == '"') {
+        if (!fin && cur >= qte && !incr_string_ready(cur, &scan, end)) {
+            goto more;
+        }
+        if (likely(read_string(&cur, end, inv, val, &msg))) goto doc_end;
+        goto fail_string;
+    }
+    if (*cur == 't') {
+        if (likely(read_true(&cur, val))) goto doc_tok_end;
+        goto fail_literal_true;
+    }
+    if (*cur == 'f') {
+        if (likely(read_false(&cur, val))) goto doc_tok_end;
+        goto fail_literal_false;
+    }
+    if (*cur == 'n') {
+        if (likely(read_null(&cur, val))) goto doc_tok_end;
+        if (has_read_flag(ALLOW_INF_AND_NAN)) {
+            if (read_nan(false, &cur, pre, flg, val)) goto doc_tok_end;
+        }
+        goto fail_literal_null;
+    }
+    if (has_read_flag(ALLOW_INF_AND_NAN)) {
+        if (read_inf_or_nan(false, &cur, pre, flg, val)) goto doc_tok_end;
+    }
+    goto fail_character_root;
+    
+arr_begin:
+    /* save current container */
+    ctn->tag = (((u64)ctn_len + 1) << YYJSON_TAG_BIT) |
+               (ctn->tag & YYJSON_TAG_MASK);
+    
+    /* create a new array value, save parent container offset */
+    val_incr();
+    val->tag = YYJSON_TYPE_ARR;
+    val->uni.ofs = (usize)((u8 *)val - (u8 *)ctn);
+    
+    /* push the new array value as current container */
+    ctn = val;
+    ctn_len = 0;
+    
+arr_val_begin:
+    save_label(INCR_ARR_VAL_BEGIN);
+    if (*cur == '{') {
+        cur++;
+        goto obj_begin;
+    }
+    if (*cur == '[') {
+        cur++;
+        goto arr_begin;
+    }
+    if (char_is_number(*cur)) {
+        val_incr();
+        ctn_len++;
+        if (likely(read_number(&cur, pre, flg, val, &msg))) goto arr_tok_end;
+        goto fail_number;
+    }
+    if (*cur == '"') {
+        if (!fin && cur >= qte && !incr_string_ready(cur, &scan, end)) {
+            goto more;
+        }
+        val_incr();
+        ctn_len++;
+        if (likely(read_string(&cur, end, inv, val, &msg))) goto arr_val_end;
+        goto fail_string;
+    }
+    if (*cur == 't') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_true(&cur, val))) goto arr_tok_end;
+        goto fail_literal_true;
+    }
+    if (*cur == 'f') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_false(&cur, val))) goto arr_tok_end;
+        goto fail_literal_false;
+    }
+    if (*cur == 'n') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_null(&cur, val))) goto arr_tok_end;
+        if (has_read_flag(ALLOW_INF_AND_NAN)) {
+            if (read_nan(false, &cur, pre, flg, val)) goto arr_tok_end;
+        }
+        goto fail_literal_null;
+    }
+    if (*cur == ']') {
+        cur++;
+        if (likely(ctn_len == 0)) goto arr_end;
+        if (has_read_flag(ALLOW_TRAILING_COMMAS)) goto arr_end;
+        while (*cur != ',') cur--;
+        goto fail_trailing_comma;
+    }
+    if (char_is_space(*cur)) {
+        cur = skip_spaces(cur + 1, end);
+        goto arr_val_begin;
+    }
+    if (has_read_flag(ALLOW_INF_AND_NAN) &&
+        (*cur == 'i' || *cur == 'I' || *cur == 'N')) {
+        val_incr();
+        ctn_len++;
+        if (read_inf_or_nan(false, &cur, pre, flg, val)) goto arr_tok_end;
+        goto fail_character_val;
+    }
+    if (has_read_flag(ALLOW_COMMENTS)) {
+        skip = cur;
+        if (!fin && !incr_skip_spaces(&skip, end, flg)) goto more;
+        if (skip_spaces_and_comments(&cur, end)) goto arr_val_begin;
+        if (byte_match_2(cur, "/*")) goto fail_comment;
+    }
+    goto fail_character_val;
+    
+arr_tok_end:
+    /* the number or literal may continue in the next chunk */
+    if (!fin && unlikely(!incr_token_end(cur, end))) goto retry;
+    
+arr_val_end:
+    save_label(INCR_ARR_VAL_END);
+    if (*cur == ',') {
+        cur++;
+        goto arr_val_begin;
+    }
+    if (*cur == ']') {
+        cur++;
+        goto arr_end;
+    }
+    if (char_is_space(*cur)) {
+        cur = skip_spaces(cur + 1, end);
+        goto arr_val_end;
+    }
+    if (has_read_flag(ALLOW_COMMENTS)) {
+        skip = cur;
+        if (!fin && !incr_skip_spaces(&skip, end, flg)) goto more;
+        if (skip_spaces_and_comments(&cur, end)) goto arr_val_end;
+        if (byte_match_2(cur, "/*")) goto fail_comment;
+    }
+    goto fail_character_arr_end;
+    
+arr_end:
+    /* get parent container */
+    ctn_parent = (yyjson_val *)(void *)((u8 *)ctn - ctn->uni.ofs);
+    
+    /* save the next sibling value offset */
+    ctn->uni.ofs = (usize)((u8 *)val - (u8 *)ctn) + sizeof(yyjson_val);
+    ctn->tag = ((ctn_len) << YYJSON_TAG_BIT) | YYJSON_TYPE_ARR;
+    if (unlikely(ctn == ctn_parent)) goto doc_end;
+    
+    /* pop parent as current container */
+    ctn = ctn_parent;
+    ctn_len = (usize)(ctn->tag >> YYJSON_TAG_BIT);
+    if ((ctn->tag & YYJSON_TYPE_MASK) == YYJSON_TYPE_OBJ) {
+        goto obj_val_end;
+    } else {
+        goto arr_val_end;
+    }
+    
+obj_begin:
+    /* push container */
+    ctn->tag = (((u64)ctn_len + 1) << YYJSON_TAG_BIT) |
+               (ctn->tag & YYJSON_TAG_MASK);
+    val_incr();
+    val->tag = YYJSON_TYPE_OBJ;
+    /* offset to the parent */
+    val->uni.ofs = (usize)((u8 *)val - (u8 *)ctn);
+    ctn = val;
+    ctn_len = 0;
+    
+obj_key_begin:
+    save_label(INCR_OBJ_KEY_BEGIN);
+    if (likely(*cur == '"')) {
+        if (!fin && cur >= qte && !incr_string_ready(cur, &scan, end)) {
+            goto more;
+        }
+        val_incr();
+        ctn_len++;
+        if (likely(read_string(&cur, end, inv, val, &msg))) goto obj_key_end;
+        goto fail_string;
+    }
+    if (likely(*cur == '}')) {
+        cur++;
+        if (likely(ctn_len == 0)) goto obj_end;
+        if (has_read_flag(ALLOW_TRAILING_COMMAS)) goto obj_end;
+        while (*cur != ',') cur--;
+        goto fail_trailing_comma;
+    }
+    if (char_is_space(*cur)) {
+        cur = skip_spaces(cur + 1, end);
+        goto obj_key_begin;
+    }
+    if (has_read_flag(ALLOW_COMMENTS)) {
+        skip = cur;
+        if (!fin && !incr_skip_spaces(&skip, end, flg)) goto more;
+        if (skip_spaces_and_comments(&cur, end)) goto obj_key_begin;
+        if (byte_match_2(cur, "/*")) goto fail_comment;
+    }
+    goto fail_character_obj_key;
+    
+obj_key_end:
+    save_label(INCR_OBJ_KEY_END);
+    if (*cur == ':') {
+        cur++;
+        goto obj_val_begin;
+    }
+    if (char_is_space(*cur)) {
+        cur = skip_spaces(cur + 1, end);
+        goto obj_key_end;
+    }
+    if (has_read_flag(ALLOW_COMMENTS)) {
+        skip = cur;
+        if (!fin && !incr_skip_spaces(&skip, end, flg)) goto more;
+        if (skip_spaces_and_comments(&cur, end)) goto obj_key_end;
+        if (byte_match_2(cur, "/*")) goto fail_comment;
+    }
+    goto fail_character_obj_sep;
+    
+obj_val_begin:
+    save_label(INCR_OBJ_VAL_BEGIN);
+    if (*cur == '"') {
+        if (!fin && cur >= qte && !incr_string_ready(cur, &scan, end)) {
+            goto more;
+        }
+        val++;
+        ctn_len++;
+        if (likely(read_string(&cur, end, inv, val, &msg))) goto obj_val_end;
+        goto fail_string;
+    }
+    if (char_is_number(*cur)) {
+        val++;
+        ctn_len++;
+        if (likely(read_number(&cur, pre, flg, val, &msg))) goto obj_tok_end;
+        goto fail_number;
+    }
+    if (*cur == '{') {
+        cur++;
+        goto obj_begin;
+    }
+    if (*cur == '[') {
+        cur++;
+        goto arr_begin;
+    }
+    if (*cur == 't') {
+        val++;
+        ctn_len++;
+        if (likely(read_true(&cur, val))) goto obj_tok_end;
+        goto fail_literal_true;
+    }
+    if (*cur == 'f') {
+        val++;
+        ctn_len++;
+        if (likely(read_false(&cur, val))) goto obj_tok_end;
+        goto fail_literal_false;
+    }
+    if (*cur == 'n') {
+        val++;
+        ctn_len++;
+        if (likely(read_null(&cur, val))) goto obj_tok_end;
+        if (has_read_flag(ALLOW_INF_AND_NAN)) {
+            if (read_nan(false, &cur, pre, flg, val)) goto obj_tok_end;
+        }
+        goto fail_literal_null;
+    }
+    if (char_is_space(*cur)) {
+        cur = skip_spaces(cur + 1, end);
+        goto obj_val_begin;
+    }
+    if (has_read_flag(ALLOW_INF_AND_NAN) &&
+        (*cur == 'i' || *cur == 'I' || *cur == 'N')) {
+        val++;
+        ctn_len++;
+        if (read_inf_or_nan(false, &cur, pre, flg, val)) goto obj_tok_end;
+        goto fail_character_val;
+    }
+    if (has_read_flag(ALLOW_COMMENTS)) {
+        skip = cur;
+        if (!fin && !incr_skip_spaces(&skip, end, flg)) goto more;
+        if (skip_spaces_and_comments(&cur, end)) goto obj_val_begin;
+        if (byte_match_2(cur, "/*")) goto fail_comment;
+    }
+    goto fail_character_val;
+    
+obj_tok_end:
+    /* the number or literal may continue in the next chunk */
+    if (!fin && unlikely(!incr_token_end(cur, end))) goto retry;
+    
+obj_val_end:
+    save_label(INCR_OBJ_VAL_END);
+    if (likely(*cur == ',')) {
+        cur++;
+        goto obj_key_begin;
+    }
+    if (likely(*cur == '}')) {
+        cur++;
+        goto obj_end;
+    }
+    if (char_is_space(*cur)) {
+        cur = skip_spaces(cur + 1, end);
+        goto obj_val_end;
+    }
+    if (has_read_flag(ALLOW_COMMENTS)) {
+        skip = cur;
+        if (!fin && !incr_skip_spaces(&skip, end, flg)) goto more;
+        if (skip_spaces_and_comments(&cur, end)) goto obj_val_end;
+        if (byte_match_2(cur, "/*")) goto fail_comment;
+    }
+    goto fail_character_obj_end;
+    
+obj_end:
+    /* pop container */
+    ctn_parent = (yyjson_val *)(void *)((u8 *)ctn - ctn->uni.ofs);
+    /* point to the next value */
+    ctn->uni.ofs = (usize)((u8 *)val - (u8 *)ctn) + sizeof(yyjson_val);
+    ctn->tag = (ctn_len << (YYJSON_TAG_BIT - 1)) | YYJSON_TYPE_OBJ;
+    if (unlikely(ctn == ctn_parent)) goto doc_end;
+    ctn = ctn_parent;
+    ctn_len = (usize)(ctn->tag >> YYJSON_TAG_BIT);
+    if ((ctn->tag & YYJSON_TYPE_MASK) == YYJSON_TYPE_OBJ) {
+        goto obj_val_end;
+    } else {
+        goto arr_val_end;
+    }
+    
+doc_tok_end:
+    /* the number or literal may continue in the next chunk */
+    if (!fin && unlikely(!incr_token_end(cur, end))) goto retry;
+    
+doc_end:
+    /* check invalid contents after json document, the document is returned
+       as soon as the root value is complete, so only the data in the buffer
+       is checked before the end of input */
+    if (unlikely(cur < end) && !has_read_flag(STOP_WHEN_DONE)) {
+        if (!fin) {
+            if (incr_skip_spaces(&cur, end, flg)) {
+                if (has_read_flag(ALLOW_COMMENTS) &&
+                    byte_match_2(cur, "/*")) goto fail_comment;
+                goto fail_garbage;
+            }
+        } else if (has_read_flag(ALLOW_COMMENTS)) {
+            skip_spaces_and_comments(&cur, end);
+            if (byte_match_2(cur, "/*")) goto fail_comment;
+        } else {
+            cur = skip_spaces(cur, end);
+        }
+        if (unlikely(fin && cur < end)) goto fail_garbage;
+    }
+    
+    if (pre && *pre) **pre = '\0';
+    doc = (yyjson_doc *)val_hdr;
+    doc->root = val_hdr + hdr_len;
+    doc->alc = alc;
+    doc->dat_read = (usize)(cur - hdr);
+    doc->val_read = (usize)((val - val_hdr)) - hdr_len + 1;
+    doc->str_pool = (char *)hdr;
+    doc->key_idx = NULL;
+    
+    /* the buffers are owned by the document now */
+    state->hdr = NULL;
+    state->val_hdr = NULL;
+    state->label = INCR_FINISHED;
+    memset(err, 0, sizeof(yyjson_read_err));
+    return doc;
+    
+retry:
+    /* the error may be caused by the incomplete data, read it again from the
+       beginning of current state when more data arrives */
+    cur = lbl_cur;
+    val = val_hdr + lbl_val;
+    ctn_len = lbl_len;
+    raw_end = lbl_raw;
+    
+more:
+    /* save the state and wait for more data */
+    state->label = lbl;
+    state->cur = (usize)(cur - hdr);
+    state->scan = (usize)(scan - hdr);
+    state->val_hdr = val_hdr;
+    state->alc_len = alc_len;
+    state->val = (usize)(val - val_hdr);
+    state->ctn = (usize)(ctn - val_hdr);
+    state->ctn_len = ctn_len;
+    state->raw_end = raw_end;
+    err->pos = state->len;
+    err->code = YYJSON_READ_ERROR_MORE;
+    err->msg = "more data is required";
+    return NULL;
+    
+fail_string:
+    return_err(cur, INVALID_STRING, msg);
+fail_number:
+    return_err(cur, INVALID_NUMBER, msg);
+fail_alloc:
+    return_err_at(cur, MEMORY_ALLOCATION,
+                  "memory allocation failed");
+fail_trailing_comma:
+    return_err(cur, JSON_STRUCTURE,
+               "trailing comma is not allowed");
+fail_literal_true:
+    return_err(cur, LITERAL,
+               "invalid literal, expected a valid literal such as 'true'");
+fail_literal_false:
+    return_err(cur, LITERAL,
+               "invalid literal, expected a valid literal such as 'false'");
+fail_literal_null:
+    return_err(cur, LITERAL,
+               "invalid literal, expected a valid literal such as 'null'");
+fail_character_root:
+    return_err(cur, UNEXPECTED_CHARACTER,
+               "unexpected character, expected a valid root value");
+fail_character_val:
+    return_err(cur, UNEXPECTED_CHARACTER,
+               "unexpected character, expected a valid JSON value");
+fail_character_arr_end:
+    return_err(cur, UNEXPECTED_CHARACTER,
+               "unexpected character, expected a comma or a closing bracket");
+fail_character_obj_key:
+    return_err(cur, UNEXPECTED_CHARACTER,
+               "unexpected character, expected a string for object key");
+fail_character_obj_sep:
+    return_err(cur, UNEXPECTED_CHARACTER,
+               "unexpected character, expected a colon after object key");
+fail_character_obj_end:
+    return_err(cur, UNEXPECTED_CHARACTER,
+               "unexpected character, expected a comma or a closing brace");
+fail_comment:
+    return_err(cur, INVALID_COMMENT,
+               "unclosed multiline comment");
+fail_garbage:
+    return_err(cur, UNEXPECTED_CONTENT,
+               "unexpected content after document");
+    
+#undef val_incr
+#undef save_label
+#undef return_err_at
+#undef return_err
+}
+
+
+
+/*==============================================================================
+ * JSON Reader (Lines)
+ *
+ * The lines reader reads newline-delimited JSON (NDJSON, JSON Lines), each
+ * line is a document. A line is copied into a slot with zero padding and read
+ * in place, and the document is allocated with a pool allocator on the rest
+ * of the slot. The slot size is determined by the line length with
+ * `yyjson_read_max_memory_usage()`, so reading a line never allocates memory,
+ * and the slot is reused for the following lines until a longer line comes.
+ *
+ * A batch of lines is loaded into the slots on the calling thread, then the
+ * slots are split into ranges by data size and read on multiple threads, as
+ * the slots don't share any memory.
+ *============================================================================*/
+
+/** A line and the memory to read it. */
+typedef struct lines_slot {
+    u8 *buf;                /* line with padding, followed by the pool memory */
+    usize cap;              /* buffer size */
+    usize len;              /* line length */
+    usize pos;              /* line position in input */
+    bool loaded;            /* line is loaded, or memory allocation failed */
+    yyjson_doc *doc;        /* the document, NULL if failed */
+    yyjson_read_err err;    /* the error information */
+} lines_slot;
+
+/** A range of slots read on one thread. */
+typedef struct lines_part {
+    yyjson_lines_reader *rd;
+    usize beg;
+    usize end;
+} lines_part;
+
+struct yyjson_lines_reader {
+    yyjson_alc alc;         /* allocator of the reader */
+    yyjson_read_flag flg;   /* read flags */
+    const u8 *dat;          /* input data, or the stream buffer */
+    usize len;              /* data length */
+    usize cur;              /* offset of the next line in data */
+    usize ofs;              /* input position of the data head */
+    FILE *file;             /* input stream, NULL for the data in memory */
+    usize cap;              /* stream buffer size */
+    bool eof;               /* no more data in stream */
+    yyjson_read_code code;  /* stream error code, not reported yet */
+    const char *msg;        /* stream error message */
+    lines_slot *slots;      /* the slots */
+    usize slot_num;         /* number of the slots */
+    void *parts;            /* the parts and thread tasks */
+    usize part_num;         /* number of the parts */
+};
+
+/** Reads more data from the stream, the unread data is moved to the head of
+    the buffer first. Returns false if no more data is read. */
+static bool lines_fill(yyjson_lines_reader *rd) {
+    yyjson_alc alc = rd->alc;
+    usize len = rd->len - rd->cur, read_size;
+    u8 *buf = constcast(u8 *)rd->dat;
+    
+    if (rd->eof) return false;
+    if (rd->cur) {
+        memmove(buf, buf + rd->cur, len);
+        rd->ofs += rd->cur;
+        rd->cur = 0;
+        rd->len = len;
+    }
+    if (len == rd->cap) {
+        /* the line is longer than the buffer */
+        if (unlikely(rd->cap > USIZE_MAX / 2)) goto fail_alloc;
+        buf = (u8 *)alc.realloc_(alc.ctx, buf, rd->cap, rd->cap * 2);
+        if (unlikely(!buf)) goto fail_alloc;
+        rd->dat = buf;
+        rd->cap *= 2;
+    }
+    read_size = fread_safe(buf + len, rd->cap - len, rd->file);
+    rd->len += read_size;
+    if (read_size == 0) {
+        rd->eof = true;
+        if (ferror(rd->file)) {
+            rd->code = YYJSON_READ_ERROR_FILE_READ;
+            rd->msg = "file reading failed";
+        }
+        return false;
+    }
+    return true;
+    
+fail_alloc:
+    rd->eof = true;
+    rd->code = YYJSON_READ_ERROR_MEMORY_ALLOCATION;
+    rd->msg = "memory allocation failed";
+    return false;
+}
+
+/** Gets the next line without the line feed, returns false if there's no more
+    line. The last line may not end with a line feed. */
+static bool lines_next(yyjson_lines_reader *rd,
+                       const u8 **ptr, usize *len, usize *pos) {
+    const u8 *cur, *end, *eol;
+    if (!rd->file && rd->cur == rd->len) return false;
+    while (true) {
+        cur = rd->dat + rd->cur;
+        end = rd->dat + rd->len;
+        eol = (const u8 *)memchr((const void *)cur, '\n', (usize)(end - cur));
+        if (eol || !rd->file || !lines_fill(rd)) break;
+    }
+    if (!eol) {
+        /* the data may be moved by the last filling */
+        cur = rd->dat + rd->cur;
+        end = rd->dat + rd->len;
+        if (cur == end) return false;
+        eol = end;
+    }
+    *ptr = cur;
+    *len = (usize)(eol - cur);
+    *pos = rd->ofs + rd->cur;
+    rd->cur = (usize)(eol - rd->dat) + (eol < end);
+    return true;
+}
+
+/** Copies the line into the slot, the slot grows if it's too small. */
+static void lines_load(yyjson_lines_reader *rd, lines_slot *slot,
+                       const u8 *ptr, usize len, usize pos) {
+    yyjson_alc alc = rd->alc;
+    usize mem, cap;
+    
+    slot->len = len;
+    slot->pos = pos;
+    slot->doc = NULL;
+    slot->loaded = false;
+    mem = yyjson_read_max_memory_usage(len, rd->flg);
+    cap = len + YYJSON_PADDING_SIZE + mem;
+    if (unlikely(!mem || cap < mem)) goto fail_alloc;
+    if (slot->cap < cap) {
+        /* leave some space for a little longer line */
+        if (cap < USIZE_MAX / 3 * 2) cap += cap / 2;
+        if (slot->buf) alc.free_(alc.ctx, (void *)slot->buf);
+        slot->buf = (u8 *)alc.malloc_(alc.ctx, cap);
+        slot->cap = slot->buf ? cap : 0;
+        if (unlikely(!slot->buf)) goto fail_alloc;
+    }
+    memcpy(slot->buf, ptr, len);
+    memset(slot->buf + len, 0, YYJSON_PADDING_SIZE);
+    slot->loaded = true;
+    return;
+    
+fail_alloc:
+    slot->err.pos = pos;
+    slot->err.code = YYJSON_READ_ERROR_MEMORY_ALLOCATION;
+    slot->err.msg = "memory allocation failed";
+}
+
+/** Reads the lines in a range of slots. */
+static void lines_read_part(void *ptr) {
+    lines_part *part = (lines_part *)ptr;
+    lines_slot *slot = part->rd->slots + part->beg;
+    lines_slot *end = part->rd->slots + part->end;
+    yyjson_read_flag flg = part->rd->flg;
+    yyjson_alc alc;
+    usize hdr;
+    
+    for (; slot < end; slot++) {
+        if (!slot->loaded) continue;
+        hdr = slot->len + YYJSON_PADDING_SIZE;
+        yyjson_alc_pool_init(&alc, slot->buf + hdr, slot->cap - hdr);
+        slot->doc = yyjson_read_opts((char *)slot->buf, slot->len, flg,
+                                     &alc, &slot->err);
+        if (!slot->doc) slot->err.pos += slot->pos;
+    }
+}
+
+/** Reads the loaded slots with at most `nthreads` threads, each thread reads
+    a range of slots with about the same data size. */
+static void lines_read_slots(yyjson_lines_reader *rd, usize num,
+                             usize size, usize nthreads) {
+    yyjson_alc alc = rd->alc;
+    lines_part one, *parts;
+    usize i, k, acc, mem_len;
+    void *mem;
+    
+#if YYJSON_HAS_THREADS
+    if (!nthreads) nthreads = thread_cpu_count();
+    nthreads = yyjson_min(nthreads, size / YYJSON_READER_LINES_MIN_SIZE);
+    nthreads = yyjson_min(nthreads, num);
+    mem_len = sizeof(lines_part) + sizeof(thread_task) + sizeof(bool);
+#else
+    nthreads = 1;
+    mem_len = sizeof(lines_part);
+#endif
+    if (nthreads > 1 && rd->part_num < nthreads) {
+        /* the parts are reused in the following batches */
+        mem = alc.malloc_(alc.ctx, nthreads * mem_len);
+        if (mem) {
+            if (rd->parts) alc.free_(alc.ctx, rd->parts);
+            rd->parts = mem;
+            rd->part_num = nthreads;
+        } else {
+            nthreads = 1;
+        }
+    }
+    if (nthreads <= 1) {
+        one.rd = rd;
+        one.beg = 0;
+        one.end = num;
+        lines_read_part((void *)&one);
+        return;
+    }
+    
+    parts = (lines_part *)rd->parts;
+    for (i = 0, k = 0, acc = 0; k < nthreads; k++) {
+        parts[k].rd = rd;
+        parts[k].beg = i;
+        while (i < num && (k + 1 == nthreads ||
+                           acc < size / nthreads * (k + 1))) {
+            acc += rd->slots[i++].len;
+        }
+        parts[k].end = i;
+    }
+    thread_run_parts(lines_read_part, parts, sizeof(lines_part),
+                     nthreads, (void *)(parts + nthreads));
+}
+
+yyjson_lines_reader *yyjson_lines_new(const char *dat,
+                                      usize len,
+                                      yyjson_read_flag flg,
+                                      const yyjson_alc *alc_ptr) {
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    yyjson_lines_reader *rd;
+    
+    if (unlikely(!dat && len)) return NULL;
+    rd = (yyjson_lines_reader *)alc.malloc_(alc.ctx, sizeof(*rd));
+    if (unlikely(!rd)) return NULL;
+    memset((void *)rd, 0, sizeof(*rd));
+    rd->alc = alc;
+    rd->flg = flg | YYJSON_READ_INSITU; /* the lines are copied */
+    /* the arena is sized for the documents only, without the key index */
+    rd->flg &= ~(YYJSON_READ_STOP_WHEN_DONE | YYJSON_READ_KEY_INDEX);
+    rd->dat = (const u8 *)dat;
+    rd->len = len;
+    return rd;
+}
+
+yyjson_lines_reader *yyjson_lines_new_fp(FILE *file,
+                                         yyjson_read_flag flg,
+                                         const yyjson_alc *alc_ptr) {
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    yyjson_lines_reader *rd;
+    u8 *buf;
+    
+    if (unlikely(!file)) return NULL;
+    buf = (u8 *)alc.malloc_(alc.ctx, YYJSON_READER_LINES_BUF_INIT_SIZE);
+    if (unlikely(!buf)) return NULL;
+    rd = yyjson_lines_new((const char *)buf, 0, flg, &alc);
+    if (unlikely(!rd)) {
+        alc.free_(alc.ctx, (void *)buf);
+        return NULL;
+    }
+    rd->file = file;
+    rd->cap = YYJSON_READER_LINES_BUF_INIT_SIZE;
+    return rd;
+}
+
+usize yyjson_lines_read_batch(yyjson_lines_reader *rd,
+                              yyjson_doc **docs,
+                              yyjson_read_err *errs,
+                              usize count,
+                              usize nthreads) {
+    yyjson_alc alc;
+    lines_slot *slot, *slots;
+    const u8 *ptr;
+    usize num, ret, len, pos, i, size;
+    
+    if (unlikely(!rd || !docs || !count)) return 0;
+    alc = rd->alc;
+    
+    /* the slots are reused in the following batches */
+    if (rd->slot_num < count) {
+        size = count * sizeof(lines_slot);
+        if (unlikely(size / sizeof(lines_slot) != count)) return 0;
+        if (!rd->slots) {
+            slots = (lines_slot *)alc.malloc_(alc.ctx, size);
+        } else {
+            slots = (lines_slot *)alc.realloc_(alc.ctx, (void *)rd->slots,
+                                               rd->slot_num * sizeof(*slots),
+                                               size);
+        }
+        if (unlikely(!slots)) return 0;
+        memset((void *)(slots + rd->slot_num), 0,
+               (count - rd->slot_num) * sizeof(lines_slot));
+        rd->slots = slots;
+        rd->slot_num = count;
+    }
+    
+    for (ret = 0; ret == 0; ) {
+        /* load the lines on the calling thread, blank lines are skipped */
+        for (num = 0, size = 0; num < count; ) {
+            if (!lines_next(rd, &ptr, &len, &pos)) break;
+            for (i = 0; i < len && char_is_space(ptr[i]); i++);
+            if (i == len) continue;
+            lines_load(rd, &rd->slots[num++], ptr, len, pos);
+            size += len;
+        }
+        if (num == 0 && !rd->code) break;
+        lines_read_slots(rd, num, size, nthreads);
+        
+        /* collect the results, lines with only comments are skipped */
+        for (i = 0; i < num; i++) {
+            slot = &rd->slots[i];
+            if (!slot->doc &&
+                slot->err.code == YYJSON_READ_ERROR_EMPTY_CONTENT) continue;
+            docs[ret] = slot->doc;
+            if (errs) errs[ret] = slot->err;
+            ret++;
+        }
+        
+        /* the stream error is reported after the lines before it */
+        if (rd->code && ret < count) {
+            docs[ret] = NULL;
+            if (errs) {
+                errs[ret].pos = rd->ofs + rd->len;
+                errs[ret].code = rd->code;
+                errs[ret].msg = rd->msg;
+            }
+            rd->code = YYJSON_READ_SUCCESS;
+            ret++;
+        }
+    }
+    return ret;
+}
+
+yyjson_doc *yyjson_lines_read(yyjson_lines_reader *rd, yyjson_read_err *err) {
+    yyjson_read_err dummy_err;
+    yyjson_doc *doc = NULL;
+    
+    if (!err) err = &dummy_err;
+    memset(err, 0, sizeof(yyjson_read_err));
+    if (unlikely(!rd)) {
+        err->code = YYJSON_READ_ERROR_INVALID_PARAMETER;
+        err->msg = "input reader is NULL";
+        return NULL;
+    }
+    yyjson_lines_read_batch(rd, &doc, err, 1, 1);
+    return doc;
+}
+
+void yyjson_lines_free(yyjson_lines_reader *rd) {
+    yyjson_alc alc;
+    usize i;
+    
+    if (!rd) return;
+    alc = rd->alc;
+    for (i = 0; i < rd->slot_num; i++) {
+        if (rd->slots[i].buf) alc.free_(alc.ctx, (void *)rd->slots[i].buf);
+    }
+    if (rd->slots) alc.free_(alc.ctx, (void *)rd->slots);
+    if (rd->parts) alc.free_(alc.ctx, rd->parts);
+    if (rd->file) alc.free_(alc.ctx, constcast(void *)rd->dat);
+    alc.free_(alc.ctx, (void *)rd);
+}
+
+
+
+/*==============================================================================
+ * JSON Reader (Lazy)
+ *
+ * The lazy reader validates the structure of the document (brackets, commas,
+ * colons, closed strings and literals), but doesn't build the values. A lazy
+ * value is a position in the data, the strings and numbers are decoded only
+ * when they're accessed, and the content of the values is validated then.
+ *
+ * The data is never modified, the decoded strings and numbers are written to
+ * a buffer with the same layout as the data: a value is decoded at the same
+ * offset as its raw text, so the decoded values never overlap.
+ *
+ * A container is skipped with the block classifier of the multi-threaded
+ * reader, which finds the matching closing bracket outside strings 64 bytes
+ * at a time.
+ *============================================================================*/
+
+struct yyjson_lazy_doc {
+    yyjson_alc alc;         /* allocator of the document */
+    yyjson_read_flag flg;   /* read flags */
+    u8 *hdr;                /* head of the data, with padding */
+    u8 *end;                /* end of the data */
+    u8 *root;               /* the root value */
+    u8 *buf;                /* buffer for decoded values, NULL before used */
+};
+
+/** Match a character of a number or literal token: [0-9a-zA-Z+-.]. */
+static_inline bool lazy_char_is_token(u8 c) {
+    return char_is_number(c) || (u8)((c | 0x20) - 'a') < 26 ||
+           c == '+' || c == '.';
+}
+
+/** Skips a number or literal token. */
+static_inline u8 *lazy_skip_token(u8 *cur) {
+    while (lazy_char_is_token(*cur)) cur++;
+    return cur;
+}
+
+/** Skips a string, `cur` should be the opening quote. Returns the position
+    after the closing quote, or NULL if the string is not closed. The `esc` is
+    set to true if the string has an escape sequence. */
+static_inline u8 *lazy_skip_str(u8 *cur, const u8 *end, bool *esc) {
+    u8 *lim;
+    cur++;
+    while (true) {
+        /* the padding zero is a stop character */
+        lim = cur + 16;
+        while (cur < lim && !char_is_ascii_stop(*cur)) cur++;
+        if (cur == lim) {
+#if YYJSON_HAS_SIMD
+            cur = skip_ascii_simd(cur, end);
+#endif
+            continue;
+        }
+        if (*cur == '"') return cur + 1;
+        if (*cur == '\\') {
+            *esc = true;
+            cur += 2;
+            continue;
+        }
+        if (cur >= end) return NULL;
+        cur++;
+    }
+}
+
+/** Skips spaces and comments (if allowed). Returns false if a multi-line
+    comment is not closed, `ptr` is set to the head of the comment. */
+static_inline bool lazy_skip_ws(u8 **ptr, const u8 *end,
+                                yyjson_read_flag flg) {
+    u8 *cur = skip_spaces(*ptr, end);
+    if (has_read_flag(ALLOW_COMMENTS) && *cur == '/') {
+        skip_spaces_and_comments(&cur, end);
+        if (byte_match_2(cur, "/*")) {
+            *ptr = cur;
+            return false;
+        }
+    }
+    *ptr = cur;
+    return true;
+}
+
+/** Skips a container of a validated document, `cur` should be the opening
+    bracket. Returns the position after the closing bracket. */
+static_noinline u8 *lazy_skip_ctn(u8 *cur, const u8 *end,
+                                  yyjson_read_flag flg) {
+    u64 esc = 0, str, str_carry = 0, op, cl, bits, bit;
+    i64 depth = 0;
+    bool tmp;
+    par_masks m;
+    
+    if (has_read_flag(ALLOW_COMMENTS)) {
+        /* comments may contain brackets and quotes, skip them one by one */
+        while (true) {
+            if (*cur == '"') {
+                cur = lazy_skip_str(cur, end, &tmp);
+            } else if (*cur == '/') {
+                lazy_skip_ws(&cur, end, flg);
+            } else if (*cur == '[' || *cur == '{') {
+                depth++;
+                cur++;
+            } else if (*cur == ']' || *cur == '}') {
+                if (--depth == 0) return cur + 1;
+                cur++;
+            } else {
+                cur++;
+            }
+        }
+    }
+    
+    for (; cur < end; cur += 64) {
+        par_classify_tail(cur, end, &m);
+        m.qt &= ~idx_find_escaped(m.bs, &esc);
+        str = idx_prefix_xor(m.qt) ^ str_carry;
+        str_carry = (u64)((i64)str >> 63);
+        op = m.op & ~str;
+        cl = m.cl & ~str;
+        if (cl && depth <= (i64)u64_pop_count(cl)) {
+            /* the depth may reach 0 in this block, check one by one */
+            bits = op | cl;
+            while (bits) {
+                bit = bits & (~bits + 1);
+                if (op & bit) depth++;
+                else if (--depth == 0) return cur + u64_tz_bits(bit) + 1;
+                bits ^= bit;
+            }
+        } else {
+            depth += (i64)u64_pop_count(op) - (i64)u64_pop_count(cl);
+        }
+    }
+    return constcast(u8 *)end;
+}
+
+/** Skips a value of a validated document. */
+static_inline u8 *lazy_skip_val(u8 *cur, const u8 *end,
+                                yyjson_read_flag flg) {
+    bool esc;
+    if (*cur == '"') return lazy_skip_str(cur, end, &esc);
+    if (*cur == '[' || *cur == '{') return lazy_skip_ctn(cur, end, flg);
+    return lazy_skip_token(cur);
+}
+
+/** Returns the first element of a container, or NULL if it's empty. */
+static_inline u8 *lazy_ctn_first(yyjson_lazy_doc *doc, u8 *cur) {
+    cur++;
+    lazy_skip_ws(&cur, doc->end, doc->flg);
+    return (*cur == ']' || *cur == '}') ? NULL : cur;
+}
+
+/** Returns the element after the value ending at `cur`, or NULL if the
+    container is closed. */
+static_inline u8 *lazy_ctn_next(yyjson_lazy_doc *doc, u8 *cur) {
+    lazy_skip_ws(&cur, doc->end, doc->flg);
+    if (*cur == ',') {
+        cur++;
+        lazy_skip_ws(&cur, doc->end, doc->flg);
+    }
+    return (*cur == ']' || *cur == '}') ? NULL : cur;
+}
+
+/** Returns the value of the key of an object member. */
+static_inline u8 *lazy_key_to_val(yyjson_lazy_doc *doc, u8 *cur) {
+    bool esc;
+    cur = lazy_skip_str(cur, doc->end, &esc);
+    lazy_skip_ws(&cur, doc->end, doc->flg);
+    cur++; /* colon */
+    lazy_skip_ws(&cur, doc->end, doc->flg);
+    return cur;
+}
+
+/** Decodes a string or number token, the raw text `[cur, nxt)` is copied to
+    `dst` and decoded in place, `lst` is the end of the `dst` buffer followed
+    by the padding. On error, the `err->pos` is the offset to `cur`. */
+static_inline bool lazy_decode_to(u8 *cur, u8 *nxt, u8 *dst, u8 *lst,
+                                  yyjson_read_flag flg, yyjson_val *val,
+                                  yyjson_read_err *err) {
+    usize len = (usize)(nxt - cur);
+    u8 *pos = dst, *pre = NULL;
+    bool inv;
+    
+    memcpy(dst, cur, len);
+    if (*cur == '"') {
+        inv = has_read_flag(ALLOW_INVALID_UNICODE) != 0;
+        if (likely(read_string(&pos, lst, inv, val, &err->msg))) return true;
+        err->code = YYJSON_READ_ERROR_INVALID_STRING;
+    } else {
+        /* the character after a token is never a part of other values */
+        dst[len] = '\0';
+        if (!read_number(&pos, &pre, flg, val, &err->msg)) {
+            err->code = YYJSON_READ_ERROR_INVALID_NUMBER;
+        } else if (likely(pos == dst + len)) {
+            return true;
+        } else {
+            err->code = YYJSON_READ_ERROR_UNEXPECTED_CHARACTER;
+            err->msg = "unexpected character after number";
+        }
+    }
+    err->pos = (usize)(pos - dst);
+    return false;
+}
+
+/** Decodes a scalar value into the buffer, returns false if the value is
+    invalid or memory allocation failed. */
+static bool lazy_decode(yyjson_lazy_doc *doc, u8 *cur, yyjson_val *val) {
+    yyjson_alc alc = doc->alc;
+    usize len = (usize)(doc->end - doc->hdr);
+    yyjson_read_err err;
+    u8 *nxt;
+    bool esc;
+    
+    if (*cur == 't') return read_true(&cur, val);
+    if (*cur == 'f') return read_false(&cur, val);
+    if (*cur == 'n' && read_null(&cur, val)) return true;
+    
+    if (!doc->buf) {
+        doc->buf = (u8 *)alc.malloc_(alc.ctx, len + YYJSON_PADDING_SIZE);
+        if (unlikely(!doc->buf)) return false;
+        memset(doc->buf + len, 0, YYJSON_PADDING_SIZE);
+    }
+    if (*cur == '"') nxt = lazy_skip_str(cur, doc->end, &esc);
+    else nxt = lazy_skip_token(cur);
+    return lazy_decode_to(cur, nxt, doc->buf + (cur - doc->hdr),
+                          doc->buf + len, doc->flg, val, &err);
+}
+
+/** Validates the structure of the document, and finds the root value. */
+static bool lazy_validate(yyjson_lazy_doc *doc, yyjson_read_err *err) {
+    
+#define return_err(_pos, _code, _msg) do { \
+    err->pos = (usize)((_pos) - hdr); \
+    err->code = YYJSON_READ_ERROR_##_code; \
+    err->msg = _msg; \
+    goto fail; \
+} while (false)
+    
+#define return_err_end(_code, _msg) do { \
+    if (cur >= end) return_err(end, UNEXPECTED_END, "unexpected end of data"); \
+    return_err(cur, _code, _msg); \
+} while (false)
+    
+#define skip_ws() do { \
+    if (unlikely(!lazy_skip_ws(&cur, end, flg))) { \
+        return_err(cur, INVALID_COMMENT, "unclosed multiline comment"); \
+    } \
+} while (false)
+    
+    u8 *hdr = doc->hdr, *end = doc->end, *cur = hdr, *tmp;
+    yyjson_read_flag flg = doc->flg;
+    yyjson_alc alc = doc->alc;
+    u8 stk_buf[64], *stk = stk_buf; /* the opening brackets */
+    usize dep = 0, cap = sizeof(stk_buf);
+    bool esc;
+    
+    skip_ws();
+    if (unlikely(cur >= end)) {
+        return_err(hdr, EMPTY_CONTENT, "input data is empty");
+    }
+    doc->root = cur;
+    
+val_begin:
+    if (*cur == '"') {
+        tmp = lazy_skip_str(cur, end, &esc);
+        if (unlikely(!tmp)) return_err(end, UNEXPECTED_END, "unclosed string");
+        cur = tmp;
+        goto val_end;
+    }
+    if (*cur == '[' || *cur == '{') {
+        if (unlikely(dep == cap)) {
+            if (unlikely(cap > USIZE_MAX / 2)) goto fail_alloc;
+            tmp = (u8 *)alc.malloc_(alc.ctx, cap * 2);
+            if (unlikely(!tmp)) goto fail_alloc;
+            memcpy(tmp, stk, cap);
+            if (stk != stk_buf) alc.free_(alc.ctx, (void *)stk);
+            stk = tmp;
+            cap *= 2;
+        }
+        stk[dep++] = *cur++;
+        skip_ws();
+        if (*cur == stk[dep - 1] + 2) { /* '[' + 2 is ']', '{' + 2 is '}' */
+            dep--;
+            cur++;
+            goto val_end;
+        }
+        if (stk[dep - 1] == '{') goto key_begin;
+        goto val_begin;
+    }
+    if (*cur == 't') {
+        if (unlikely(!byte_match_4(cur, "true"))) goto fail_literal;
+        cur += 4;
+        goto val_end;
+    }
+    if (*cur == 'f') {
+        if (unlikely(!byte_match_4(cur + 1, "alse"))) goto fail_literal;
+        cur += 5;
+        goto val_end;
+    }
+    if (*cur == 'n' && byte_match_4(cur, "null")) {
+        cur += 4;
+        goto val_end;
+    }
+    if (char_is_number(*cur) || (has_read_flag(ALLOW_INF_AND_NAN) &&
+        ((*cur | 0x20) == 'i' || (*cur | 0x20) == 'n' || *cur == '+'))) {
+        cur = lazy_skip_token(cur);
+        goto val_end;
+    }
+    if (*cur == 'n') goto fail_literal;
+    return_err_end(UNEXPECTED_CHARACTER,
+                   "unexpected character, expected a JSON value");
+    
+key_begin:
+    if (unlikely(*cur != '"')) {
+        return_err_end(UNEXPECTED_CHARACTER,
+                       "unexpected character, expected a string for key");
+    }
+    tmp = lazy_skip_str(cur, end, &esc);
+    if (unlikely(!tmp)) return_err(end, UNEXPECTED_END, "unclosed string");
+    cur = tmp;
+    skip_ws();
+    if (unlikely(*cur != ':')) {
+        return_err_end(UNEXPECTED_CHARACTER,
+                       "unexpected character, expected a colon after key");
+    }
+    cur++;
+    skip_ws();
+    goto val_begin;
+    
+val_end:
+    if (dep == 0) goto doc_end;
+    skip_ws();
+    if (*cur == ',') {
+        cur++;
+        skip_ws();
+        if (has_read_flag(ALLOW_TRAILING_COMMAS) &&
+            *cur == stk[dep - 1] + 2) {
+            dep--;
+            cur++;
+            goto val_end;
+        }
+        if (stk[dep - 1] == '{') goto key_begin;
+        goto val_begin;
+    }
+    if (*cur == stk[dep - 1] + 2) {
+        dep--;
+        cur++;
+        goto val_end;
+    }
+    if (stk[dep - 1] == '[') {
+        return_err_end(UNEXPECTED_CHARACTER,
+               "unexpected character, expected a comma or a closing bracket");
+    }
+    return_err_end(UNEXPECTED_CHARACTER,
+               "unexpected character, expected a comma or a closing brace");
+    
+doc_end:
+    if (!has_read_flag(STOP_WHEN_DONE)) {
+        skip_ws();
+        if (unlikely(cur < end)) {
+            return_err(cur, UNEXPECTED_CONTENT,
+                       "unexpected content after document");
+        }
+    }
+    if (stk != stk_buf) alc.free_(alc.ctx, (void *)stk);
+    return true;
+    
+fail_literal:
+    return_err_end(LITERAL, "invalid literal");
+    
+fail_alloc:
+    return_err(hdr, MEMORY_ALLOCATION, "memory allocation failed");
+    
+fail:
+    if (stk != stk_buf) alc.free_(alc.ctx, (void *)stk);
+    return false;
+    
+#undef skip_ws
+#undef return_err_end
+#undef return_err
+}
+
+yyjson_lazy_doc *yyjson_lazy_read(const char *dat,
+                                  usize len,
+                                  yyjson_read_flag flg,
+                                  const yyjson_alc *alc_ptr,
+                                  yyjson_read_err *err) {
+    
+#define return_err(_pos, _code, _msg) do { \
+    err->pos = (usize)(_pos); \
+    err->msg = _msg; \
+    err->code = YYJSON_READ_ERROR_##_code; \
+    return NULL; \
+} while (false)
+    
+    yyjson_read_err dummy_err;
+    yyjson_alc alc;
+    yyjson_lazy_doc *doc;
+    usize size = sizeof(yyjson_lazy_doc);
+    
+    if (!err) err = &dummy_err;
+    if (unlikely(!dat)) return_err(0, INVALID_PARAMETER, "input data is NULL");
+    if (unlikely(!len)) return_err(0, INVALID_PARAMETER, "input length is 0");
+    
+    alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    if (!has_read_flag(INSITU)) {
+        if (unlikely(len >= USIZE_MAX - YYJSON_PADDING_SIZE - size)) {
+            return_err(0, MEMORY_ALLOCATION, "memory allocation failed");
+        }
+        size += len + YYJSON_PADDING_SIZE;
+    }
+    doc = (yyjson_lazy_doc *)alc.malloc_(alc.ctx, size);
+    if (unlikely(!doc)) {
+        return_err(0, MEMORY_ALLOCATION, "memory allocation failed");
+    }
+    doc->alc = alc;
+    doc->flg = flg;
+    doc->buf = NULL;
+    if (has_read_flag(INSITU)) {
+        doc->hdr = constcast(u8 *)dat;
+    } else {
+        /* the data is copied after the document */
+        doc->hdr = (u8 *)(void *)(doc + 1);
+        memcpy(doc->hdr, dat, len);
+        memset(doc->hdr + len, 0, YYJSON_PADDING_SIZE);
+    }
+    doc->end = doc->hdr + len;
+    
+    if (unlikely(!lazy_validate(doc, err))) {
+        read_err_encoding(doc->hdr, len, err);
+        alc.free_(alc.ctx, (void *)doc);
+        return NULL;
+    }
+    memset(err, 0, sizeof(yyjson_read_err));
+    return doc;
+    
+#undef return_err
+}
+
+void yyjson_lazy_doc_free(yyjson_lazy_doc *doc) {
+    yyjson_alc alc;
+    if (!doc) return;
+    alc = doc->alc;
+    if (doc->buf) alc.free_(alc.ctx, (void *)doc->buf);
+    alc.free_(alc.ctx, (void *)doc);
+}
+
+yyjson_lazy_val yyjson_lazy_doc_get_root(yyjson_lazy_doc *doc) {
+    yyjson_lazy_val val;
+    val.doc = doc;
+    val.cur = doc ? (const char *)doc->root : NULL;
+    return val;
+}
+
+yyjson_type yyjson_lazy_get_type(yyjson_lazy_val val) {
+    u8 c;
+    if (!val.cur) return YYJSON_TYPE_NONE;
+    c = *(const u8 *)val.cur;
+    if (c == '{') return YYJSON_TYPE_OBJ;
+    if (c == '[') return YYJSON_TYPE_ARR;
+    if (c == '"') return YYJSON_TYPE_STR;
+    if (c == 't' || c == 'f') return YYJSON_TYPE_BOOL;
+    if (c == 'n' && val.cur[1] == 'u') return YYJSON_TYPE_NULL;
+    if (val.doc->flg & YYJSON_READ_NUMBER_AS_RAW) return YYJSON_TYPE_RAW;
+    return YYJSON_TYPE_NUM;
+}
+
+bool yyjson_lazy_get_val(yyjson_lazy_val val, yyjson_val *out) {
+    yyjson_type type = yyjson_lazy_get_type(val);
+    if (!out) return false;
+    out->tag = YYJSON_TYPE_NONE;
+    out->uni.u64 = 0;
+    if (type == YYJSON_TYPE_NONE ||
+        type == YYJSON_TYPE_ARR || type == YYJSON_TYPE_OBJ) return false;
+    if (lazy_decode(val.doc, constcast(u8 *)val.cur, out)) return true;
+    out->tag = YYJSON_TYPE_NONE;
+    out->uni.u64 = 0;
+    return false;
+}
+
+yyjson_doc *yyjson_lazy_get_doc(yyjson_lazy_val val,
+                                const yyjson_alc *alc,
+                                yyjson_read_err *err) {
+    yyjson_read_err dummy_err;
+    yyjson_lazy_doc *doc = val.doc;
+    yyjson_read_flag flg;
+    yyjson_doc *ret;
+    u8 *cur, *end;
+    
+    if (!err) err = &dummy_err;
+    if (unlikely(!val.cur)) {
+        memset(err, 0, sizeof(yyjson_read_err));
+        err->code = YYJSON_READ_ERROR_INVALID_PARAMETER;
+        err->msg = "input value is NULL";
+        return NULL;
+    }
+    cur = constcast(u8 *)val.cur;
+    end = lazy_skip_val(cur, doc->end, doc->flg);
+    flg = doc->flg & ~(YYJSON_READ_INSITU | YYJSON_READ_STOP_WHEN_DONE);
+    ret = yyjson_read_opts((char *)cur, (usize)(end - cur), flg, alc, err);
+    if (!ret) err->pos += (usize)(cur - doc->hdr);
+    return ret;
+}
+
+yyjson_lazy_val yyjson_lazy_arr_get(yyjson_lazy_val arr, usize idx) {
+    yyjson_lazy_val val;
+    yyjson_lazy_doc *doc = arr.doc;
+    u8 *cur = NULL;
+    
+    if (yyjson_lazy_get_type(arr) == YYJSON_TYPE_ARR) {
+        cur = lazy_ctn_first(doc, constcast(u8 *)arr.cur);
+        for (; cur && idx; idx--) {
+            cur = lazy_skip_val(cur, doc->end, doc->flg);
+            cur = lazy_ctn_next(doc, cur);
+        }
+    }
+    val.doc = cur ? doc : NULL;
+    val.cur = (const char *)cur;
+    return val;
+}
+
+yyjson_lazy_val yyjson_lazy_obj_get(yyjson_lazy_val obj, const char *key) {
+    return yyjson_lazy_obj_getn(obj, key, key ? strlen(key) : 0);
+}
+
+yyjson_lazy_val yyjson_lazy_obj_getn(yyjson_lazy_val obj,
+                                     const char *key,
+                                     usize key_len) {
+    yyjson_lazy_val val;
+    yyjson_lazy_doc *doc = obj.doc;
+    yyjson_val str;
+    u8 *cur = NULL, *tmp;
+    bool esc, match;
+    
+    if (key && yyjson_lazy_get_type(obj) == YYJSON_TYPE_OBJ) {
+        cur = lazy_ctn_first(doc, constcast(u8 *)obj.cur);
+        while (cur) {
+            esc = false;
+            tmp = lazy_skip_str(cur, doc->end, &esc);
+            if (likely(!esc)) {
+                match = (usize)(tmp - cur) == key_len + 2 &&
+                        memcmp(cur + 1, key, key_len) == 0;
+            } else {
+                /* the key has escape sequences, decode it first */
+                match = lazy_decode(doc, cur, &str) &&
+                        unsafe_yyjson_get_len(&str) == key_len &&
+                        memcmp(str.uni.str, key, key_len) == 0;
+            }
+            cur = lazy_key_to_val(doc, cur);
+            if (match) break;
+            cur = lazy_skip_val(cur, doc->end, doc->flg);
+            cur = lazy_ctn_next(doc, cur);
+        }
+    }
+    val.doc = cur ? doc : NULL;
+    val.cur = (const char *)cur;
+    return val;
+}
+
+bool yyjson_lazy_iter_init(yyjson_lazy_val ctn, yyjson_lazy_iter *iter) {
+    yyjson_type type = yyjson_lazy_get_type(ctn);
+    if (!iter) return false;
+    iter->doc = ctn.doc;
+    iter->cur = NULL;
+    iter->skip = false;
+    if (type != YYJSON_TYPE_ARR && type != YYJSON_TYPE_OBJ) return false;
+    iter->cur = (const char *)lazy_ctn_first(ctn.doc, constcast(u8 *)ctn.cur);
+    return true;
+}
+
+/** Moves the iterator to the next element, the value returned last time is
+    skipped here, so it's not scanned if the iteration stops. */
+static_inline u8 *lazy_iter_next(yyjson_lazy_iter *iter) {
+    yyjson_lazy_doc *doc = iter->doc;
+    u8 *cur = constcast(u8 *)iter->cur;
+    if (cur && iter->skip) {
+        cur = lazy_skip_val(cur, doc->end, doc->flg);
+        cur = lazy_ctn_next(doc, cur);
+        iter->cur = (const char *)cur;
+    }
+    return cur;
+}
+
+bool yyjson_lazy_arr_next(yyjson_lazy_iter *iter, yyjson_lazy_val *val) {
+    u8 *cur;
+    if (!iter || !(cur = lazy_iter_next(iter))) return false;
+    iter->skip = true;
+    if (val) {
+        val->doc = iter->doc;
+        val->cur = (const char *)cur;
+    }
+    return true;
+}
+
+bool yyjson_lazy_obj_next(yyjson_lazy_iter *iter,
+                          yyjson_lazy_val *key,
+                          yyjson_lazy_val *val) {
+    u8 *cur;
+    if (!iter || !(cur = lazy_iter_next(iter)) || *cur != '"') return false;
+    if (key) {
+        key->doc = iter->doc;
+        key->cur = (const char *)cur;
+    }
+    cur = lazy_key_to_val(iter->doc, cur);
+    iter->cur = (const char *)cur;
+    iter->skip = true;
+    if (val) {
+        val->doc = iter->doc;
+        val->cur = (const char *)cur;
+    }
+    return true;
+}
+
+
+
+#if !YYJSON_DISABLE_UTILS
+
+/*==============================================================================
+ * JSON Reader (Select)
+ *
+ * The selective reader validates the document with the lazy reader, then
+ * walks down the document with a list of JSON Pointers, and builds only the
+ * selected values (and their parent containers) into a regular document.
+ * The other values are skipped without being decoded.
+ *
+ * Each level of the walk has a list of the pointers whose tokens match the
+ * path so far. The walk is recursive, but it goes down only while a pointer
+ * has more tokens, a selected value is built with an explicit stack.
+ *
+ * The selected strings are copied into a compact string pool, so the memory
+ * usage is proportional to the selected values instead of the whole data.
+ *============================================================================*/
+
+/** A JSON Pointer being matched, `cur` is the prefix `/` of the next token. */
+typedef struct sel_ptr {
+    const char *cur;        /* the next token */
+    const char *end;        /* end of the pointer */
+} sel_ptr;
+
+/** The selective reader context. */
+typedef struct sel_ctx {
+    yyjson_lazy_doc *lazy;  /* the validated lazy document */
+    yyjson_val *val_hdr;    /* values, the first values are the doc header */
+    usize val_num;          /* number of values, including the header */
+    usize val_cap;          /* capacity of values */
+    u8 *str_hdr;            /* string pool, the strings are saved as offsets */
+    usize str_len;          /* used bytes of string pool */
+    usize str_cap;          /* capacity of string pool */
+    usize ptr_num;          /* number of pointers */
+    yyjson_read_err *err;   /* error information */
+} sel_ctx;
+
+/** Sets the error of the selective reader at a position of the data. */
+static_noinline bool sel_err(sel_ctx *ctx, u8 *pos,
+                             yyjson_read_code code, const char *msg) {
+    ctx->err->pos = (usize)(pos - ctx->lazy->hdr);
+    ctx->err->code = code;
+    ctx->err->msg = msg;
+    return false;
+}
+
+/** Adds a value, returns NULL if memory allocation failed. The value is
+    valid until the next value is added. */
+static_inline yyjson_val *sel_val_add(sel_ctx *ctx, u8 *cur) {
+    yyjson_alc alc = ctx->lazy->alc;
+    usize cap = ctx->val_cap;
+    yyjson_val *tmp;
+    
+    if (unlikely(ctx->val_num == cap)) {
+        cap += cap / 2;
+        if (unlikely(cap >= USIZE_MAX / sizeof(yyjson_val))) goto fail_alloc;
+        tmp = (yyjson_val *)alc.realloc_(alc.ctx, (void *)ctx->val_hdr,
+                                         ctx->val_cap * sizeof(yyjson_val),
+                                         cap * sizeof(yyjson_val));
+        if (unlikely(!tmp)) goto fail_alloc;
+        ctx->val_hdr = tmp;
+        ctx->val_cap = cap;
+    }
+    return ctx->val_hdr + ctx->val_num++;
+    
+fail_alloc:
+    sel_err(ctx, cur, YYJSON_READ_ERROR_MEMORY_ALLOCATION,
+            "memory allocation failed");
+    return NULL;
+}
+
+/** Reads a scalar value and moves `ptr` to the end of it. The string is
+    decoded into the string pool, and saved as an offset in the pool. */
+static bool sel_read_scalar(sel_ctx *ctx, u8 **ptr) {
+    yyjson_lazy_doc *lazy = ctx->lazy;
+    yyjson_alc alc = lazy->alc;
+    yyjson_val *val;
+    usize len, cap;
+    u8 *cur = *ptr, *nxt, *dst, *tmp;
+    bool esc;
+    
+    if (!(val = sel_val_add(ctx, cur))) return false;
+    if (*cur == 't' && read_true(ptr, val)) return true;
+    if (*cur == 'f' && read_false(ptr, val)) return true;
+    if (*cur == 'n' && read_null(ptr, val)) return true;
+    
+    if (*cur == '"') nxt = lazy_skip_str(cur, lazy->end, &esc);
+    else nxt = lazy_skip_token(cur);
+    len = (usize)(nxt - cur);
+    
+    /* reserve the raw text, a null-terminator and the padding */
+    if (unlikely(ctx->str_cap - ctx->str_len <= len + YYJSON_PADDING_SIZE)) {
+        cap = ctx->str_cap + ctx->str_cap / 2;
+        if (cap - ctx->str_len <= len + YYJSON_PADDING_SIZE) {
+            cap = ctx->str_len + len + YYJSON_PADDING_SIZE + 1;
+        }
+        if (!ctx->str_hdr) {
+            tmp = (u8 *)alc.malloc_(alc.ctx, cap);
+        } else {
+            tmp = (u8 *)alc.realloc_(alc.ctx, (void *)ctx->str_hdr,
+                                     ctx->str_cap, cap);
+        }
+        if (unlikely(!tmp)) {
+            return sel_err(ctx, cur, YYJSON_READ_ERROR_MEMORY_ALLOCATION,
+                           "memory allocation failed");
+        }
+        ctx->str_hdr = tmp;
+        ctx->str_cap = cap;
+    }
+    dst = ctx->str_hdr + ctx->str_len;
+    memset(dst + len, 0, YYJSON_PADDING_SIZE);
+    
+    if (unlikely(!lazy_decode_to(cur, nxt, dst, dst + len,
+                                 lazy->flg, val, ctx->err))) {
+        ctx->err->pos += (usize)(cur - lazy->hdr);
+        return false;
+    }
+    if (unsafe_yyjson_is_str(val) || unsafe_yyjson_is_raw(val)) {
+        val->uni.ofs = (usize)((const u8 *)val->uni.str - ctx->str_hdr);
+        ctx->str_len = val->uni.ofs + unsafe_yyjson_get_len(val) + 1;
+    }
+    *ptr = nxt;
+    return true;
+}
+
+/** Reads a value and all of its children, moves `ptr` to the end of it.
+    While a container is being read, its `ofs` is the number of values to
+    its parent container, and the number of its children is saved in tag. */
+static bool sel_read_val(sel_ctx *ctx, u8 **ptr) {
+    yyjson_lazy_doc *lazy = ctx->lazy;
+    yyjson_read_flag flg = lazy->flg;
+    yyjson_val *val;
+    usize ctn = 0, len, ofs;
+    u8 *cur = *ptr;
+    bool in_ctn = false;
+    
+    while (true) {
+        if (*cur == '[' || *cur == '{') {
+            if (in_ctn) ctx->val_hdr[ctn].tag += (u64)1 << YYJSON_TAG_BIT;
+            if (!(val = sel_val_add(ctx, cur))) return false;
+            val->tag = *cur == '[' ? YYJSON_TYPE_ARR : YYJSON_TYPE_OBJ;
+            val->uni.ofs = in_ctn ? ctx->val_num - 1 - ctn : 0;
+            ctn = ctx->val_num - 1;
+            in_ctn = true;
+            cur++;
+        } else if (*cur == ']' || *cur == '}') {
+            val = ctx->val_hdr + ctn;
+            len = (usize)(val->tag >> YYJSON_TAG_BIT);
+            if (*cur == '}') len /= 2;
+            ofs = val->uni.ofs;
+            val->tag = ((u64)len << YYJSON_TAG_BIT) |
+                       (val->tag & YYJSON_TAG_MASK);
+            val->uni.ofs = (ctx->val_num - ctn) * sizeof(yyjson_val);
+            cur++;
+            if (ofs == 0) break;
+            ctn -= ofs;
+        } else if (*cur == ',' || *cur == ':') {
+            cur++;
+        } else {
+            if (in_ctn) ctx->val_hdr[ctn].tag += (u64)1 << YYJSON_TAG_BIT;
+            if (!sel_read_scalar(ctx, &cur)) return false;
+            if (!in_ctn) break;
+        }
+        lazy_skip_ws(&cur, lazy->end, flg);
+    }
+    *ptr = cur;
+    return true;
+}
+
+/** Reads the members of a container matched by the pointers, moves `ptr` to
+    the end of it. The number of the read members is returned in `num`. */
+static bool sel_read_ctn(sel_ctx *ctx, u8 **ptr,
+                         sel_ptr *ptrs, usize ptr_num, usize *num) {
+    yyjson_lazy_doc *lazy = ctx->lazy;
+    yyjson_read_flag flg = lazy->flg;
+    yyjson_val *val, key;
+    sel_ptr *sub = ptrs + ctx->ptr_num;
+    usize ctn, len = 0, idx = 0, pend = 0, sub_num, sub_len;
+    usize val_num, str_len, tok_len = 0, tok_esc = 0, tok_idx, i;
+    u8 *cur = *ptr, *tmp = NULL;
+    const char *tok, *tok_cur;
+    bool is_obj = *cur == '{', esc = false, full;
+    
+    key.tag = 0;
+    key.uni.u64 = 0;
+    if (!(val = sel_val_add(ctx, cur))) return false;
+    val->tag = is_obj ? YYJSON_TYPE_OBJ : YYJSON_TYPE_ARR;
+    ctn = ctx->val_num - 1;
+    cur++;
+    
+    while (true) {
+        lazy_skip_ws(&cur, lazy->end, flg);
+        if (*cur == ',') {
+            cur++;
+            lazy_skip_ws(&cur, lazy->end, flg);
+        }
+        if (*cur == ']' || *cur == '}') break;
+        
+        /* the values added for this member, removed if it's not selected */
+        val_num = ctx->val_num;
+        str_len = ctx->str_len;
+        if (is_obj) {
+            esc = false;
+            tmp = lazy_skip_str(cur, lazy->end, &esc);
+            if (likely(!esc)) {
+                key.tag = ((u64)(tmp - cur - 2) << YYJSON_TAG_BIT) |
+                          YYJSON_TYPE_STR;
+                key.uni.str = (const char *)cur + 1;
+            } else {
+                /* the key has escape sequences, decode it first */
+                tmp = cur;
+                if (!sel_read_scalar(ctx, &tmp)) return false;
+                key = ctx->val_hdr[ctx->val_num - 1];
+                key.uni.str = (const char *)ctx->str_hdr + key.uni.ofs;
+            }
+            tmp = cur;
+            cur = lazy_key_to_val(lazy, cur);
+        }
+        
+        /* match the next token of the pointers */
+        full = false;
+        sub_num = 0;
+        for (i = 0; i < ptr_num && !full; i++) {
+            tok_cur = ptrs[i].cur;
+            tok = ptr_next_token(&tok_cur, ptrs[i].end, &tok_len, &tok_esc);
+            if (is_obj) {
+                if (!ptr_token_eq(&key, tok, tok_len, tok_esc)) continue;
+            } else if (!(tok_len == 1 && *tok == '*')) {
+                if (!ptr_token_to_idx(tok, tok_len, &tok_idx) ||
+                    tok_idx != idx) continue;
+            }
+            if (tok_cur == ptrs[i].end) {
+                full = true;
+            } else {
+                sub[sub_num].cur = tok_cur;
+                sub[sub_num].end = ptrs[i].end;
+                sub_num++;
+            }
+        }
+        if (!full && (!sub_num || (*cur != '[' && *cur != '{'))) {
+            /* not selected, skip it */
+            ctx->val_num = val_num;
+            ctx->str_len = str_len;
+            cur = lazy_skip_val(cur, lazy->end, flg);
+            idx++;
+            pend++;
+            continue;
+        }
+        
+        if (is_obj) {
+            if (!esc && !sel_read_scalar(ctx, &tmp)) return false;
+        } else {
+            /* the skipped elements before it are null, to keep the index */
+            for (i = 0; i < pend; i++) {
+                if (!(val = sel_val_add(ctx, cur))) return false;
+                val->tag = YYJSON_TYPE_NULL;
+                val->uni.u64 = 0;
+            }
+        }
+        if (full) {
+            if (!sel_read_val(ctx, &cur)) return false;
+        } else {
+            if (!sel_read_ctn(ctx, &cur, sub, sub_num, &sub_len)) return false;
+            if (!sub_len) {
+                /* nothing is selected in this container, remove it */
+                ctx->val_num = val_num;
+                ctx->str_len = str_len;
+                idx++;
+                pend++;
+                continue;
+            }
+        }
+        len += is_obj ? 1 : pend + 1;
+        idx++;
+        pend = 0;
+    }
+    
+    val = ctx->val_hdr + ctn;
+    val->tag |= (u64)len << YYJSON_TAG_BIT;
+    val->uni.ofs = (ctx->val_num - ctn) * sizeof(yyjson_val);
+    *ptr = cur + 1;
+    *num = len;
+    return true;
+}
+
+yyjson_doc *yyjson_read_select(const char *dat,
+                               usize len,
+                               const char *const *ptrs,
+                               usize ptr_num,
+                               yyjson_read_flag flg,
+                               const yyjson_alc *alc_ptr,
+                               yyjson_read_err *err) {
+    
+#define return_err(_code, _msg) do { \
+    err->pos = 0; \
+    err->msg = _msg; \
+    err->code = YYJSON_READ_ERROR_##_code; \
+    goto fail; \
+} while (false)
     
     yyjson_read_err dummy_err;
     yyjson_alc alc;
     yyjson_doc *doc;
-    u8 *hdr = NULL, *end, *cur;
-    
-    /* validate input parameters */
+    yyjson_val *val, *val_end;
+    sel_ctx ctx;
+    sel_ptr *sel = NULL;
+    usize i, hdr_len, dep, dep_max = 0, tok_len, tok_esc, num;
+    const char *cur, *end;
+    u8 *ptr;
+    bool full = false, ok;
+    
+    memset(&ctx, 0, sizeof(ctx));
     if (!err) err = &dummy_err;
-    if (likely(!alc_ptr)) {
-        alc = YYJSON_DEFAULT_ALC;
-    } else {
-        alc = *alc_ptr;
+    alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    if (unlikely(!ptrs && ptr_num)) {
+        return_err(INVALID_PARAMETER, "input pointers is NULL");
+    }
+    
+    /* validate the pointers, and get the max number of tokens */
+    for (i = 0; i < ptr_num; i++) {
+        cur = ptrs[i];
+        if (unlikely(!cur)) return_err(INVALID_PARAMETER, "pointer is NULL");
+        end = cur + strlen(cur);
+        if (cur == end) full = true;
+        if (unlikely(cur < end && *cur != '/')) {
+            return_err(INVALID_PARAMETER, "invalid JSON pointer");
+        }
+        for (dep = 0; cur < end; dep++) {
+            if (!ptr_next_token(&cur, end, &tok_len, &tok_esc)) {
+                return_err(INVALID_PARAMETER, "invalid JSON pointer");
+            }
+        }
+        dep_max = yyjson_max(dep_max, dep);
     }
-    if (unlikely(!dat)) {
-        return_err(0, INVALID_PARAMETER, "input data is NULL");
+    
+    ctx.lazy = yyjson_lazy_read(dat, len, flg, &alc, err);
+    if (!ctx.lazy) return NULL;
+    ctx.err = err;
+    ctx.ptr_num = ptr_num;
+    
+    /* the pointers of each level of the walk */
+    if (ptr_num && !full) {
+        if (unlikely(dep_max >= USIZE_MAX / sizeof(sel_ptr) / ptr_num)) {
+            return_err(MEMORY_ALLOCATION, "memory allocation failed");
+        }
+        sel = (sel_ptr *)alc.malloc_(alc.ctx,
+                                     ptr_num * dep_max * sizeof(sel_ptr));
+        if (unlikely(!sel)) {
+            return_err(MEMORY_ALLOCATION, "memory allocation failed");
+        }
+        for (i = 0; i < ptr_num; i++) {
+            sel[i].cur = ptrs[i];
+            sel[i].end = ptrs[i] + strlen(ptrs[i]);
+        }
     }
-    if (unlikely(!len)) {
-        return_err(0, INVALID_PARAMETER, "input length is 0");
+    
+    hdr_len = sizeof(yyjson_doc) / sizeof(yyjson_val);
+    hdr_len += (sizeof(yyjson_doc) % sizeof(yyjson_val)) > 0;
+    ctx.val_cap = hdr_len + 64;
+    ctx.val_num = hdr_len;
+    ctx.val_hdr = (yyjson_val *)alc.malloc_(alc.ctx,
+                                            ctx.val_cap * sizeof(yyjson_val));
+    if (unlikely(!ctx.val_hdr)) {
+        return_err(MEMORY_ALLOCATION, "memory allocation failed");
+    }
+    
+    /* the root is always read, with the selected members if it's a container,
+       an empty pointer selects the whole document */
+    ptr = ctx.lazy->root;
+    if (!full && (*ptr == '[' || *ptr == '{')) {
+        ok = sel_read_ctn(&ctx, &ptr, sel, ptr_num, &num);
+    } else {
+        ok = sel_read_val(&ctx, &ptr);
     }
+    if (!ok) goto fail;
     
-    /* add 4-byte zero padding for input data if necessary */
-    if (has_read_flag(INSITU)) {
-        hdr = (u8 *)dat;
-        end = (u8 *)dat + len;
-        cur = (u8 *)dat;
+    /* the strings are saved as offsets, convert them to pointers */
+    val = ctx.val_hdr + hdr_len;
+    val_end = ctx.val_hdr + ctx.val_num;
+    for (; val < val_end; val++) {
+        if (unsafe_yyjson_is_str(val) || unsafe_yyjson_is_raw(val)) {
+            val->uni.str = (const char *)ctx.str_hdr + val->uni.ofs;
+        }
+    }
+    
+    doc = (yyjson_doc *)ctx.val_hdr;
+    doc->root = ctx.val_hdr + hdr_len;
+    doc->alc = alc;
+    doc->dat_read = has_read_flag(STOP_WHEN_DONE) ?
+                    (usize)(ptr - ctx.lazy->hdr) : len;
+    doc->val_read = ctx.val_num - hdr_len;
+    doc->str_pool = (char *)ctx.str_hdr;
+    doc->key_idx = NULL;
+    if (sel) alc.free_(alc.ctx, (void *)sel);
+    yyjson_lazy_doc_free(ctx.lazy);
+    memset(err, 0, sizeof(yyjson_read_err));
+    return read_key_idx(doc, flg, err);
+    
+fail:
+    if (sel) alc.free_(alc.ctx, (void *)sel);
+    if (ctx.val_hdr) alc.free_(alc.ctx, (void *)ctx.val_hdr);
+    if (ctx.str_hdr) alc.free_(alc.ctx, (void *)ctx.str_hdr);
+    yyjson_lazy_doc_free(ctx.lazy);
+    return NULL;
+    
+#undef return_err
+}
+
+#endif /* YYJSON_DISABLE_UTILS */
+
+
+
+/*==============================================================================
+ * JSON Compact Document
+ *
+ * A compact document stores each value in a 64-bit word, the lower 8 bits are
+ * the tag (type and subtype), and the higher 56 bits are the payload:
+ *
+ *     null, bool: unused.
+ *     number:     the value, or an extended word if it doesn't fit in 56 bits
+ *                 (a real number fits if the lower 8 bits of it are zero).
+ *     string:     offset in the string pool (32 bits) and length (24 bits),
+ *                 or the length, with the offset in an extended word.
+ *     container:  number of words of the container (32 bits) and number of
+ *                 elements (24 bits), or the number of words, with the number
+ *                 of elements in an extended word.
+ *
+ * A value with an extended word has the COMPACT_EXT bit in the tag (one of the
+ * reserved bits). The values are stored in pre-order as in the immutable
+ * document, the strings are null-terminated in the string pool, and the keys
+ * and short strings with the same content are stored only once.
+ *============================================================================*/
+
+/* The tag bit of a value with an extended word. */
+#define COMPACT_EXT ((u8)0x20)
+
+/* The maximum length of a string to be deduplicated. */
+#define COMPACT_DEDUP_MAX_LEN 64
+
+/* The maximum length of a string and number of elements in a word. */
+#define COMPACT_LEN_MAX ((usize)0xFFFFFF)
+
+struct yyjson_compact_doc {
+    yyjson_alc alc;     /* allocator of the document */
+    u64 *vals;          /* the values */
+    usize val_num;      /* number of words of the values */
+    char *strs;         /* the string pool */
+    usize str_len;      /* length of the string pool */
+    usize size;         /* memory size of the document */
+    u8 *map;            /* the mapped snapshot file, nullable */
+    usize map_len;      /* length of the mapped file */
+};
+
+/** An open container while copying a document. */
+typedef struct compact_ctn {
+    usize pos; /* position of the container in the output */
+    const void *end; /* end of the container in the input */
+} compact_ctn;
+
+/** A deduplicated string while copying a document. */
+typedef struct compact_str {
+    usize ofs; /* offset in the string pool plus 1, 0 if the entry is empty */
+    usize len; /* length of the string */
+} compact_str;
+
+/** Returns whether the tag is a container (array or object). */
+static_inline bool compact_is_ctn(u8 tag) {
+    u8 mask = YYJSON_TYPE_ARR & YYJSON_TYPE_OBJ;
+    return (tag & mask) == mask;
+}
+
+/** Returns the number of words of the value. */
+static_inline usize compact_size(const u64 *cur) {
+    u8 tag = (u8)*cur;
+    if (compact_is_ctn(tag)) {
+        if (tag & COMPACT_EXT) return (usize)(*cur >> 8);
+        return (usize)((*cur >> 8) & U32_MAX);
+    }
+    return (tag & COMPACT_EXT) ? 2 : 1;
+}
+
+/** Returns the length of a string, or the number of elements. */
+static_inline usize compact_len(const u64 *cur) {
+    u8 tag = (u8)*cur;
+    if (compact_is_ctn(tag)) {
+        if (tag & COMPACT_EXT) return (usize)cur[1];
     } else {
-        if (unlikely(len >= USIZE_MAX - YYJSON_PADDING_SIZE)) {
-            return_err(0, MEMORY_ALLOCATION, "memory allocation failed");
+        if (tag & COMPACT_EXT) return (usize)(*cur >> 8);
+    }
+    return (usize)(*cur >> 40);
+}
+
+/** Returns the string of a string or raw value. */
+static_inline const char *compact_str_of(yyjson_compact_doc *doc,
+                                         const u64 *cur) {
+    if ((u8)*cur & COMPACT_EXT) return doc->strs + (usize)cur[1];
+    return doc->strs + (usize)((*cur >> 8) & U32_MAX);
+}
+
+/** Returns the raw 64 bits of a number. */
+static_inline u64 compact_num_of(const u64 *cur) {
+    u8 tag = (u8)*cur;
+    u64 num = *cur >> 8;
+    if (tag & COMPACT_EXT) return cur[1];
+    if ((tag & YYJSON_SUBTYPE_MASK) == YYJSON_SUBTYPE_REAL) return num << 8;
+    if ((tag & YYJSON_SUBTYPE_MASK) == YYJSON_SUBTYPE_SINT &&
+        (num >> 55)) return num | U64(0xFF000000, 0x00000000);
+    return num;
+}
+
+/** Returns whether a number fits in the payload of a word. */
+static_inline bool compact_num_fits(yyjson_val *val) {
+    u64 num = val->uni.u64;
+    switch (unsafe_yyjson_get_subtype(val)) {
+        case YYJSON_SUBTYPE_UINT: return (num >> 56) == 0;
+        case YYJSON_SUBTYPE_SINT: num += U64(0x00800000, 0x00000000);
+                                  return (num >> 56) == 0;
+        default: return (num & 0xFF) == 0;
+    }
+}
+
+/** Returns whether a value of the input document takes an extended word. */
+static_inline bool compact_is_ext(yyjson_val *val, bool big_pool) {
+    usize len;
+    switch (unsafe_yyjson_get_type(val)) {
+        case YYJSON_TYPE_NUM:
+            return !compact_num_fits(val);
+        case YYJSON_TYPE_STR:
+        case YYJSON_TYPE_RAW:
+            return big_pool || unsafe_yyjson_get_len(val) > COMPACT_LEN_MAX;
+        case YYJSON_TYPE_ARR:
+        case YYJSON_TYPE_OBJ:
+            /* a value takes at most 2 words */
+            len = (usize)(unsafe_yyjson_get_next(val) - val);
+            return unsafe_yyjson_get_len(val) > COMPACT_LEN_MAX ||
+                   len > (usize)U32_MAX / 2;
+        default:
+            return false;
+    }
+}
+
+/** Pushes an open container to the stack, returns false if memory allocation
+    failed. */
+static_inline bool compact_push(const yyjson_alc *alc, compact_ctn **stk,
+                                usize *num, usize *cap, usize pos,
+                                const void *end) {
+    compact_ctn *tmp;
+    usize new_cap;
+    if (unlikely(*num == *cap)) {
+        new_cap = *cap ? *cap * 2 : 64;
+        if (new_cap > USIZE_MAX / sizeof(compact_ctn)) return false;
+        tmp = (compact_ctn *)alc->realloc_(alc->ctx, (void *)*stk,
+                                           *cap * sizeof(compact_ctn),
+                                           new_cap * sizeof(compact_ctn));
+        if (unlikely(!tmp)) return false;
+        *stk = tmp;
+        *cap = new_cap;
+    }
+    (*stk)[*num].pos = pos;
+    (*stk)[*num].end = end;
+    (*num)++;
+    return true;
+}
+
+/** Adds a string to the string pool of the compact document, the short
+    strings are deduplicated with the hash table (if it's not NULL). */
+static_inline usize compact_add_str(yyjson_compact_doc *doc,
+                                    compact_str *tab, usize mask,
+                                    const char *str, usize len) {
+    usize i, ofs = doc->str_len;
+    if (tab && len <= COMPACT_DEDUP_MAX_LEN) {
+        i = key_idx_hash(str, len, 0) & mask;
+        for (; tab[i].ofs; i = (i + 1) & mask) {
+            if (tab[i].len == len &&
+                memcmp(doc->strs + tab[i].ofs - 1, str, len) == 0) {
+                return tab[i].ofs - 1;
+            }
         }
-        hdr = (u8 *)alc.malloc_(alc.ctx, len + YYJSON_PADDING_SIZE);
-        if (unlikely(!hdr)) {
-            return_err(0, MEMORY_ALLOCATION, "memory allocation failed");
+        tab[i].ofs = ofs + 1;
+        tab[i].len = len;
+    }
+    memcpy(doc->strs + ofs, str, len);
+    doc->strs[ofs + len] = '\0';
+    doc->str_len = ofs + len + 1;
+    return ofs;
+}
+
+yyjson_compact_doc *yyjson_doc_compact_copy(yyjson_doc *doc,
+                                            const yyjson_alc *alc_ptr) {
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    yyjson_compact_doc *cdoc = NULL, *tmp;
+    yyjson_val *val, *end;
+    compact_ctn *stk = NULL;
+    compact_str *tab = NULL;
+    usize val_num, str_sum = 0, str_num = 0, dup_num = 0, ext_num = 0;
+    usize stk_num = 0, stk_cap = 0, hdr_size, size, cap = 0, pos, len, ofs;
+    bool big_pool;
+    u64 *out;
+    u8 tag;
+    
+    if (!doc || !doc->root) return NULL;
+    val = doc->root;
+    end = unsafe_yyjson_get_next(val);
+    val_num = (usize)(end - val);
+    
+    /* get the size of the string pool and the number of the words */
+    for (; val < end; val++) {
+        if (unsafe_yyjson_is_str(val) || unsafe_yyjson_is_raw(val)) {
+            len = unsafe_yyjson_get_len(val);
+            str_sum += len + 1;
+            if (len <= COMPACT_LEN_MAX) str_num++;
+            if (len <= COMPACT_DEDUP_MAX_LEN) dup_num++;
         }
-        end = hdr + len;
-        cur = hdr;
-        memcpy(hdr, dat, len);
-        memset(end, 0, YYJSON_PADDING_SIZE);
+        ext_num += compact_is_ext(val, false);
+    }
+    big_pool = str_sum > (usize)U32_MAX;
+    if (big_pool) ext_num += str_num;
+    
+    /* create the document, the string pool is shrunk after copying */
+    hdr_size = size_align_up(sizeof(yyjson_compact_doc), sizeof(u64));
+    if (val_num > (USIZE_MAX - hdr_size) / sizeof(u64) / 2) return NULL;
+    val_num += ext_num;
+    size = hdr_size + val_num * sizeof(u64);
+    if (str_sum > USIZE_MAX - size) return NULL;
+    cdoc = (yyjson_compact_doc *)alc.malloc_(alc.ctx, size + str_sum);
+    if (!cdoc) return NULL;
+    cdoc->alc = alc;
+    cdoc->vals = (u64 *)(void *)((u8 *)cdoc + hdr_size);
+    cdoc->val_num = val_num;
+    cdoc->strs = (char *)cdoc + size;
+    cdoc->str_len = 0;
+    cdoc->map = NULL;
+    cdoc->map_len = 0;
+    
+    /* create the hash table to deduplicate short strings */
+    if (dup_num > 1) {
+        for (cap = 16; cap < dup_num * 2; cap *= 2);
+        tab = (compact_str *)alc.malloc_(alc.ctx, cap * sizeof(compact_str));
+        if (tab) memset((void *)tab, 0, cap * sizeof(compact_str));
+    }
+    
+    /* copy the values, close the containers at their end */
+    out = cdoc->vals;
+    for (val = doc->root; ; val++) {
+        while (stk_num && (const void *)val == stk[stk_num - 1].end) {
+            pos = stk[--stk_num].pos;
+            cdoc->vals[pos] |= (u64)((usize)(out - cdoc->vals) - pos) << 8;
+        }
+        if (val == end) break;
+        tag = unsafe_yyjson_get_tag(val);
+        len = unsafe_yyjson_get_len(val);
+        if (compact_is_ext(val, big_pool)) tag |= COMPACT_EXT;
+        switch (unsafe_yyjson_get_type(val)) {
+            case YYJSON_TYPE_NUM:
+                if (tag & COMPACT_EXT) {
+                    *out++ = tag;
+                    *out++ = val->uni.u64;
+                } else if (unsafe_yyjson_is_real(val)) {
+                    *out++ = val->uni.u64 | tag;
+                } else {
+                    *out++ = (val->uni.u64 << 8) | tag;
+                }
+                break;
+            case YYJSON_TYPE_STR:
+            case YYJSON_TYPE_RAW:
+                ofs = compact_add_str(cdoc, tab, cap - 1, val->uni.str, len);
+                if (tag & COMPACT_EXT) {
+                    *out++ = ((u64)len << 8) | tag;
+                    *out++ = (u64)ofs;
+                } else {
+                    *out++ = ((u64)len << 40) | ((u64)ofs << 8) | tag;
+                }
+                break;
+            case YYJSON_TYPE_ARR:
+            case YYJSON_TYPE_OBJ:
+                pos = (usize)(out - cdoc->vals);
+                if (!compact_push(&alc, &stk, &stk_num, &stk_cap, pos,
+                                  (const void *)unsafe_yyjson_get_next(val))) {
+                    goto fail;
+                }
+                if (tag & COMPACT_EXT) {
+                    *out++ = tag;
+                    *out++ = (u64)len;
+                } else {
+                    *out++ = ((u64)len << 40) | tag;
+                }
+                break;
+            default:
+                *out++ = tag;
+                break;
+        }
+    }
+    if (tab) alc.free_(alc.ctx, (void *)tab);
+    if (stk) alc.free_(alc.ctx, (void *)stk);
+    
+    /* shrink the string pool */
+    cdoc->size = size + cdoc->str_len;
+    if (cdoc->str_len < str_sum) {
+        tmp = (yyjson_compact_doc *)alc.realloc_(alc.ctx, (void *)cdoc,
+                                                 size + str_sum, cdoc->size);
+        if (tmp) {
+            cdoc = tmp;
+            cdoc->vals = (u64 *)(void *)((u8 *)cdoc + hdr_size);
+            cdoc->strs = (char *)cdoc + size;
+        } else {
+            cdoc->size = size + str_sum;
+        }
+    }
+    return cdoc;
+    
+fail:
+    if (tab) alc.free_(alc.ctx, (void *)tab);
+    if (stk) alc.free_(alc.ctx, (void *)stk);
+    alc.free_(alc.ctx, (void *)cdoc);
+    return NULL;
+}
+
+yyjson_compact_doc *yyjson_compact_read(const char *dat, usize len,
+                                        yyjson_read_flag flg,
+                                        const yyjson_alc *alc,
+                                        yyjson_read_err *err) {
+    yyjson_read_err dummy_err;
+    yyjson_compact_doc *cdoc;
+    yyjson_doc *doc;
+    
+    if (!err) err = &dummy_err;
+    flg &= ~(YYJSON_READ_INSITU | YYJSON_READ_KEY_INDEX);
+    doc = yyjson_read_opts(constcast(char *)dat, len, flg, alc, err);
+    if (!doc) return NULL;
+    cdoc = yyjson_doc_compact_copy(doc, alc);
+    yyjson_doc_free(doc);
+    if (!cdoc) {
+        err->pos = 0;
+        err->msg = "memory allocation failed";
+        err->code = YYJSON_READ_ERROR_MEMORY_ALLOCATION;
+    }
+    return cdoc;
+}
+
+void yyjson_compact_doc_free(yyjson_compact_doc *doc) {
+    if (doc) {
+        yyjson_alc alc = doc->alc;
+#if YYJSON_HAS_MMAP
+        if (doc->map) munmap((void *)doc->map, doc->map_len);
+#endif
+        alc.free_(alc.ctx, (void *)doc);
+    }
+}
+
+yyjson_compact_val yyjson_compact_doc_get_root(yyjson_compact_doc *doc) {
+    yyjson_compact_val val;
+    val.doc = doc;
+    val.cur = doc ? doc->vals : NULL;
+    return val;
+}
+
+usize yyjson_compact_doc_get_size(yyjson_compact_doc *doc) {
+    return doc ? doc->size : 0;
+}
+
+yyjson_type yyjson_compact_get_type(yyjson_compact_val val) {
+    if (!val.doc || !val.cur) return YYJSON_TYPE_NONE;
+    return (yyjson_type)((u8)*val.cur & YYJSON_TYPE_MASK);
+}
+
+usize yyjson_compact_get_len(yyjson_compact_val val) {
+    switch (yyjson_compact_get_type(val)) {
+        case YYJSON_TYPE_STR:
+        case YYJSON_TYPE_RAW:
+        case YYJSON_TYPE_ARR:
+        case YYJSON_TYPE_OBJ:
+            return compact_len(val.cur);
+        default:
+            return 0;
+    }
+}
+
+bool yyjson_compact_get_val(yyjson_compact_val val, yyjson_val *out) {
+    yyjson_type type = yyjson_compact_get_type(val);
+    u8 tag;
+    if (!out || type == YYJSON_TYPE_NONE || compact_is_ctn(type)) {
+        return false;
+    }
+    tag = (u8)(*val.cur & (YYJSON_TYPE_MASK | YYJSON_SUBTYPE_MASK));
+    out->tag = tag;
+    out->uni.u64 = 0;
+    if (type == YYJSON_TYPE_STR || type == YYJSON_TYPE_RAW) {
+        out->tag |= (u64)compact_len(val.cur) << YYJSON_TAG_BIT;
+        out->uni.str = compact_str_of(val.doc, val.cur);
+    } else if (type == YYJSON_TYPE_NUM) {
+        out->uni.u64 = compact_num_of(val.cur);
+    }
+    return true;
+}
+
+yyjson_doc *yyjson_compact_get_doc(yyjson_compact_val val,
+                                   const yyjson_alc *alc_ptr) {
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    yyjson_doc *doc;
+    yyjson_val *out;
+    compact_ctn *stk = NULL;
+    const u64 *cur, *end;
+    usize val_num = 0, str_sum = 0, stk_num = 0, stk_cap = 0, hdr_size, len;
+    usize pos;
+    char *str;
+    u8 tag;
+    
+    if (yyjson_compact_get_type(val) == YYJSON_TYPE_NONE) return NULL;
+    
+    /* get the number of values and the size of the string pool */
+    end = val.cur + compact_size(val.cur);
+    for (cur = val.cur; cur < end; val_num++) {
+        tag = (u8)*cur;
+        if ((tag & YYJSON_TYPE_MASK) == YYJSON_TYPE_STR ||
+            (tag & YYJSON_TYPE_MASK) == YYJSON_TYPE_RAW) {
+            str_sum += compact_len(cur) + 1;
+        }
+        cur += compact_is_ctn(tag) ? 1 + !!(tag & COMPACT_EXT) :
+                                     compact_size(cur);
     }
     
-    /* skip empty contents before json document */
-    if (unlikely(char_is_space_or_comment(*cur))) {
-        if (has_read_flag(ALLOW_COMMENTS)) {
-            if (!skip_spaces_and_comments(&cur)) {
-                return_err(cur - hdr, INVALID_COMMENT,
-                           "unclosed multiline comment");
-            }
-        } else {
-            if (likely(char_is_space(*cur))) {
-                while (char_is_space(*++cur));
-            }
+    /* create the document and the string pool */
+    hdr_size = size_align_up(sizeof(yyjson_doc), sizeof(yyjson_val));
+    if (val_num > (USIZE_MAX - hdr_size) / sizeof(yyjson_val)) return NULL;
+    doc = (yyjson_doc *)alc.malloc_(alc.ctx,
+                                    hdr_size + val_num * sizeof(yyjson_val));
+    if (!doc) return NULL;
+    memset(doc, 0, sizeof(yyjson_doc));
+    doc->root = (yyjson_val *)(void *)((u8 *)doc + hdr_size);
+    doc->alc = alc;
+    doc->val_read = val_num;
+    str = (char *)alc.malloc_(alc.ctx, str_sum ? str_sum : 1);
+    if (!str) goto fail;
+    doc->str_pool = str;
+    
+    /* copy the values, close the containers at their end */
+    out = doc->root;
+    for (cur = val.cur; ; out++) {
+        while (stk_num && (const void *)cur == stk[stk_num - 1].end) {
+            pos = stk[--stk_num].pos;
+            doc->root[pos].uni.ofs = ((usize)(out - doc->root) - pos) *
+                                     sizeof(yyjson_val);
         }
-        if (unlikely(cur >= end)) {
-            return_err(0, EMPTY_CONTENT, "input data is empty");
+        if (cur == end) break;
+        tag = (u8)*cur;
+        out->tag = tag & (YYJSON_TYPE_MASK | YYJSON_SUBTYPE_MASK);
+        out->uni.u64 = 0;
+        switch (tag & YYJSON_TYPE_MASK) {
+            case YYJSON_TYPE_NUM:
+                out->uni.u64 = compact_num_of(cur);
+                break;
+            case YYJSON_TYPE_STR:
+            case YYJSON_TYPE_RAW:
+                len = compact_len(cur);
+                memcpy(str, compact_str_of(val.doc, cur), len);
+                str[len] = '\0';
+                out->tag |= (u64)len << YYJSON_TAG_BIT;
+                out->uni.str = str;
+                str += len + 1;
+                break;
+            case YYJSON_TYPE_ARR:
+            case YYJSON_TYPE_OBJ:
+                out->tag |= (u64)compact_len(cur) << YYJSON_TAG_BIT;
+                if (!compact_push(&alc, &stk, &stk_num, &stk_cap,
+                                  (usize)(out - doc->root),
+                                  (const void *)(cur + compact_size(cur)))) {
+                    goto fail;
+                }
+                cur += 1 + !!(tag & COMPACT_EXT);
+                continue;
+            default:
+                break;
         }
+        cur += compact_size(cur);
     }
+    if (stk) alc.free_(alc.ctx, (void *)stk);
+    doc->dat_read = 0;
+    return doc;
     
-    /* read json document */
-    if (likely(char_is_container(*cur))) {
-        if (char_is_space(cur[1]) && char_is_space(cur[2])) {
-            doc = read_root_pretty(hdr, cur, end, alc, flg, err);
-        } else {
-            doc = read_root_minify(hdr, cur, end, alc, flg, err);
+fail:
+    if (stk) alc.free_(alc.ctx, (void *)stk);
+    yyjson_doc_free(doc);
+    return NULL;
+}
+
+yyjson_compact_val yyjson_compact_arr_get(yyjson_compact_val arr,
+                                          usize idx) {
+    yyjson_compact_iter iter;
+    yyjson_compact_val val;
+    if (yyjson_compact_get_type(arr) == YYJSON_TYPE_ARR &&
+        yyjson_compact_iter_init(arr, &iter)) {
+        while (yyjson_compact_arr_next(&iter, &val)) {
+            if (idx-- == 0) return val;
         }
-    } else {
-        doc = read_root_single(hdr, cur, end, alc, flg, err);
     }
-    
-    /* check result */
-    if (likely(doc)) {
-        memset(err, 0, sizeof(yyjson_read_err));
-    } else {
-        /* RFC 8259: JSON text MUST be encoded using UTF-8 */
-        if (err->pos == 0 && err->code != YYJSON_READ_ERROR_MEMORY_ALLOCATION) {
-            if ((hdr[0] == 0xEF && hdr[1] == 0xBB && hdr[2] == 0xBF)) {
-                err->msg = "byte order mark (BOM) is not supported";
-            } else if (len >= 4 &&
-                       ((hdr[0] == 0x00 && hdr[1] == 0x00 &&
-                         hdr[2] == 0xFE && hdr[3] == 0xFF) ||
-                        (hdr[0] == 0xFF && hdr[1] == 0xFE &&
-                         hdr[2] == 0x00 && hdr[3] == 0x00))) {
-                err->msg = "UTF-32 encoding is not supported";
-            } else if (len >= 2 &&
-                       ((hdr[0] == 0xFE && hdr[1] == 0xFF) ||
-                        (hdr[0] == 0xFF && hdr[1] == 0xFE))) {
-                err->msg = "UTF-16 encoding is not supported";
+    val.doc = NULL;
+    val.cur = NULL;
+    return val;
+}
+
+yyjson_compact_val yyjson_compact_obj_get(yyjson_compact_val obj,
+                                          const char *key) {
+    return yyjson_compact_obj_getn(obj, key, key ? strlen(key) : 0);
+}
+
+yyjson_compact_val yyjson_compact_obj_getn(yyjson_compact_val obj,
+                                           const char *key, usize key_len) {
+    yyjson_compact_iter iter;
+    yyjson_compact_val k, v;
+    if (key && yyjson_compact_get_type(obj) == YYJSON_TYPE_OBJ &&
+        yyjson_compact_iter_init(obj, &iter)) {
+        while (yyjson_compact_obj_next(&iter, &k, &v)) {
+            if (compact_len(k.cur) == key_len &&
+                memcmp(compact_str_of(k.doc, k.cur), key, key_len) == 0) {
+                return v;
             }
         }
-        if (!has_read_flag(INSITU)) alc.free_(alc.ctx, (void *)hdr);
     }
-    return doc;
-    
-#undef return_err
+    v.doc = NULL;
+    v.cur = NULL;
+    return v;
 }
 
-yyjson_doc *yyjson_read_file(const char *path,
-                             yyjson_read_flag flg,
-                             const yyjson_alc *alc_ptr,
-                             yyjson_read_err *err) {
+bool yyjson_compact_iter_init(yyjson_compact_val ctn,
+                              yyjson_compact_iter *iter) {
+    yyjson_type type = yyjson_compact_get_type(ctn);
+    if (!iter) return false;
+    if (type != YYJSON_TYPE_ARR && type != YYJSON_TYPE_OBJ) {
+        memset(iter, 0, sizeof(yyjson_compact_iter));
+        return false;
+    }
+    iter->doc = ctn.doc;
+    iter->cur = ctn.cur + 1 + !!((u8)*ctn.cur & COMPACT_EXT);
+    iter->idx = 0;
+    iter->max = compact_len(ctn.cur);
+    return true;
+}
+
+bool yyjson_compact_arr_next(yyjson_compact_iter *iter,
+                             yyjson_compact_val *val) {
+    if (!iter || !val || iter->idx >= iter->max) return false;
+    val->doc = iter->doc;
+    val->cur = iter->cur;
+    iter->cur += compact_size(iter->cur);
+    iter->idx++;
+    return true;
+}
+
+bool yyjson_compact_obj_next(yyjson_compact_iter *iter,
+                             yyjson_compact_val *key,
+                             yyjson_compact_val *val) {
+    if (!iter || !key || !val || iter->idx >= iter->max) return false;
+    key->doc = iter->doc;
+    key->cur = iter->cur;
+    val->doc = iter->doc;
+    val->cur = iter->cur + compact_size(iter->cur);
+    iter->cur = val->cur + compact_size(val->cur);
+    iter->idx++;
+    return true;
+}
+
+
+
+/*==============================================================================
+ * JSON Binary Snapshot
+ *
+ * A binary snapshot is a compact document saved to a file:
+ *
+ *     magic:    "yyjsonC1", the format and its version (8 bytes).
+ *     endian:   BINARY_ENDIAN in the byte order of the writer (8 bytes).
+ *     val_num:  number of words of the values (8 bytes).
+ *     str_len:  length of the string pool (8 bytes).
+ *     vals:     the values (val_num * 8 bytes).
+ *     strs:     the string pool (str_len bytes).
+ *
+ * The compact document holds no pointers, so a snapshot can be mapped
+ * read-only and used in place, and the pages of the file are shared by all
+ * processes that map it.
+ *============================================================================*/
+
+/* The header size of a binary snapshot. */
+#define BINARY_HDR_SIZE 32
+
+/* The byte order mark of a binary snapshot. */
+#define BINARY_ENDIAN U64(0x01020304, 0x05060708)
+
+/* The magic number of a binary snapshot. */
+static const char binary_magic[8] = { 'y', 'y', 'j', 's', 'o', 'n', 'C', '1' };
+
+bool yyjson_compact_doc_save_binary(yyjson_compact_doc *doc,
+                                    const char *path,
+                                    yyjson_write_err *err) {
 #define return_err(_code, _msg) do { \
-    err->pos = 0; \
     err->msg = _msg; \
-    err->code = YYJSON_READ_ERROR_##_code; \
-    return NULL; \
+    err->code = YYJSON_WRITE_ERROR_##_code; \
+    if (file) fclose(file); \
+    return false; \
 } while (false)
     
-    yyjson_read_err dummy_err;
-    yyjson_doc *doc;
-    FILE *file;
+    yyjson_write_err dummy_err;
+    FILE *file = NULL;
+    u64 hdr[4];
     
     if (!err) err = &dummy_err;
+    if (unlikely(!doc)) return_err(INVALID_PARAMETER, "input doc is NULL");
     if (unlikely(!path)) return_err(INVALID_PARAMETER, "input path is NULL");
     
-    file = fopen_readonly(path);
+    memcpy((void *)hdr, binary_magic, sizeof(binary_magic));
+    hdr[1] = BINARY_ENDIAN;
+    hdr[2] = (u64)doc->val_num;
+    hdr[3] = (u64)doc->str_len;
+    file = fopen_writeonly(path);
     if (unlikely(!file)) return_err(FILE_OPEN, "file opening failed");
-    
-    doc = yyjson_read_fp(file, flg, alc_ptr, err);
-    fclose(file);
-    return doc;
+    if (fwrite((void *)hdr, BINARY_HDR_SIZE, 1, file) != 1 ||
+        fwrite((void *)doc->vals, sizeof(u64), doc->val_num, file) !=
+            doc->val_num ||
+        (doc->str_len && fwrite(doc->strs, doc->str_len, 1, file) != 1)) {
+        return_err(FILE_WRITE, "file writing failed");
+    }
+    if (fclose(file) != 0) {
+        file = NULL;
+        return_err(FILE_WRITE, "file closing failed");
+    }
+    err->msg = NULL;
+    err->code = YYJSON_WRITE_SUCCESS;
+    return true;
     
 #undef return_err
 }
 
-yyjson_doc *yyjson_read_fp(FILE *file,
-                           yyjson_read_flag flg,
-                           const yyjson_alc *alc_ptr,
-                           yyjson_read_err *err) {
-#define return_err(_code, _msg) do { \
-    err->pos = 0; \
-    err->msg = _msg; \
-    err->code = YYJSON_READ_ERROR_##_code; \
-    if (buf) alc.free_(alc.ctx, buf); \
-    return NULL; \
-} while (false)
-    
-    yyjson_read_err dummy_err;
-    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
-    yyjson_doc *doc;
-    
-    long file_size = 0, file_pos;
-    void *buf = NULL;
-    usize buf_size = 0;
+bool yyjson_doc_save_binary(yyjson_doc *doc, const char *path,
+                            const yyjson_alc *alc, yyjson_write_err *err) {
+    yyjson_write_err dummy_err;
+    yyjson_compact_doc *cdoc;
+    bool suc;
     
-    /* validate input parameters */
     if (!err) err = &dummy_err;
-    if (unlikely(!file)) return_err(INVALID_PARAMETER, "input file is NULL");
-    
-    /* get current position */
-    file_pos = ftell(file);
-    if (file_pos != -1) {
-        /* get total file size, may fail */
-        if (fseek(file, 0, SEEK_END) == 0) file_size = ftell(file);
-        /* reset to original position, may fail */
-        if (fseek(file, file_pos, SEEK_SET) != 0) file_size = 0;
-        /* get file size from current postion to end */
-        if (file_size > 0) file_size -= file_pos;
-    }
-    
-    /* read file */
-    if (file_size > 0) {
-        /* read the entire file in one call */
-        buf_size = (usize)file_size + YYJSON_PADDING_SIZE;
-        buf = alc.malloc_(alc.ctx, buf_size);
-        if (buf == NULL) {
-            return_err(MEMORY_ALLOCATION, "fail to alloc memory");
-        }
-        if (fread_safe(buf, (usize)file_size, file) != (usize)file_size) {
-            return_err(FILE_READ, "file reading failed");
-        }
-    } else {
-        /* failed to get file size, read it as a stream */
-        usize chunk_min = (usize)64;
-        usize chunk_max = (usize)512 * 1024 * 1024;
-        usize chunk_now = chunk_min;
-        usize read_size;
-        void *tmp;
-        
-        buf_size = YYJSON_PADDING_SIZE;
-        while (true) {
-            if (buf_size + chunk_now < buf_size) { /* overflow */
-                return_err(MEMORY_ALLOCATION, "fail to alloc memory");
-            }
-            buf_size += chunk_now;
-            if (!buf) {
-                buf = alc.malloc_(alc.ctx, buf_size);
-                if (!buf) return_err(MEMORY_ALLOCATION, "fail to alloc memory");
-            } else {
-                tmp = alc.realloc_(alc.ctx, buf, buf_size - chunk_now, buf_size);
-                if (!tmp) return_err(MEMORY_ALLOCATION, "fail to alloc memory");
-                buf = tmp;
-            }
-            tmp = ((u8 *)buf) + buf_size - YYJSON_PADDING_SIZE - chunk_now;
-            read_size = fread_safe(tmp, chunk_now, file);
-            file_size += (long)read_size;
-            if (read_size != chunk_now) break;
-            
-            chunk_now *= 2;
-            if (chunk_now > chunk_max) chunk_now = chunk_max;
-        }
+    if (unlikely(!doc || !doc->root)) {
+        err->msg = "input doc is NULL";
+        err->code = YYJSON_WRITE_ERROR_INVALID_PARAMETER;
+        return false;
     }
-    
-    /* read JSON */
-    memset((u8 *)buf + file_size, 0, YYJSON_PADDING_SIZE);
-    flg |= YYJSON_READ_INSITU;
-    doc = yyjson_read_opts((char *)buf, (usize)file_size, flg, &alc, err);
-    if (doc) {
-        doc->str_pool = (char *)buf;
-        return doc;
-    } else {
-        alc.free_(alc.ctx, buf);
-        return NULL;
+    cdoc = yyjson_doc_compact_copy(doc, alc);
+    if (unlikely(!cdoc)) {
+        err->msg = "memory allocation failed";
+        err->code = YYJSON_WRITE_ERROR_MEMORY_ALLOCATION;
+        return false;
     }
-    
-#undef return_err
+    suc = yyjson_compact_doc_save_binary(cdoc, path, err);
+    yyjson_compact_doc_free(cdoc);
+    return suc;
 }
 
-const char *yyjson_read_number(const char *dat,
-                               yyjson_val *val,
-                               yyjson_read_flag flg,
-                               const yyjson_alc *alc,
-                               yyjson_read_err *err) {
-#define return_err(_pos, _code, _msg) do { \
-    err->pos = _pos > hdr ? (usize)(_pos - hdr) : 0; \
+yyjson_compact_doc *yyjson_compact_load_binary(const char *path,
+                                               yyjson_read_flag flg,
+                                               const yyjson_alc *alc_ptr,
+                                               yyjson_read_err *err) {
+#define return_err(_code, _msg) do { \
+    err->pos = 0; \
     err->msg = _msg; \
     err->code = YYJSON_READ_ERROR_##_code; \
-    return NULL; \
+    goto fail; \
 } while (false)
     
-    u8 *hdr = constcast(u8 *)dat, *cur = hdr;
-    bool raw; /* read number as raw */
-    u8 *raw_end; /* raw end for null-terminator */
-    u8 **pre; /* previous raw end pointer */
-    const char *msg;
     yyjson_read_err dummy_err;
-    
-#if !YYJSON_HAS_IEEE_754 || YYJSON_DISABLE_FAST_FP_CONV
-    u8 buf[128];
-    usize dat_len;
-#endif
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    yyjson_compact_doc *doc = NULL;
+    FILE *file = NULL;
+    u8 *dat = NULL, *map = NULL;
+    usize len = 0, map_len = 0, hdr_size;
+    long file_size = 0;
+    u64 hdr[4];
     
     if (!err) err = &dummy_err;
-    if (unlikely(!dat)) {
-        return_err(cur, INVALID_PARAMETER, "input data is NULL");
-    }
-    if (unlikely(!val)) {
-        return_err(cur, INVALID_PARAMETER, "output value is NULL");
-    }
-    
-#if !YYJSON_HAS_IEEE_754 || YYJSON_DISABLE_FAST_FP_CONV
-    if (!alc) alc = &YYJSON_DEFAULT_ALC;
-    dat_len = strlen(dat);
-    if (dat_len < sizeof(buf)) {
-        memcpy(buf, dat, dat_len + 1);
-        hdr = buf;
-        cur = hdr;
-    } else {
-        hdr = (u8 *)alc->malloc_(alc->ctx, dat_len + 1);
-        cur = hdr;
-        if (unlikely(!hdr)) {
-            return_err(cur, MEMORY_ALLOCATION, "memory allocation failed");
+    if (unlikely(!path)) return_err(INVALID_PARAMETER, "input path is NULL");
+    hdr_size = size_align_up(sizeof(yyjson_compact_doc), sizeof(u64));
+    
+#if YYJSON_HAS_MMAP
+    /* use the mapped file in place, fall back to reading it into memory if
+       it cannot be mapped */
+    if (has_read_flag(MMAP) && mmap_file_shared(path, &map, &map_len)) {
+        doc = (yyjson_compact_doc *)alc.malloc_(alc.ctx, hdr_size);
+        if (unlikely(!doc)) {
+            return_err(MEMORY_ALLOCATION, "memory allocation failed");
         }
-        memcpy(hdr, dat, dat_len + 1);
+        doc->map = map;
+        doc->map_len = map_len;
+        dat = map;
+        len = map_len;
     }
-    hdr[dat_len] = 0;
+#else
+    (void)flg;
 #endif
     
-    raw = (flg & (YYJSON_READ_NUMBER_AS_RAW | YYJSON_READ_BIGNUM_AS_RAW)) != 0;
-    raw_end = NULL;
-    pre = raw ? &raw_end : NULL;
-    
-#if !YYJSON_HAS_IEEE_754 || YYJSON_DISABLE_FAST_FP_CONV
-    if (!read_number(&cur, pre, flg, val, &msg)) {
-        if (dat_len >= sizeof(buf)) alc->free_(alc->ctx, hdr);
-        return_err(cur, INVALID_NUMBER, msg);
+    if (!doc) {
+        file = fopen_readonly(path);
+        if (unlikely(!file)) return_err(FILE_OPEN, "file opening failed");
+        if (fseek(file, 0, SEEK_END) != 0 ||
+            (file_size = ftell(file)) < 0 ||
+            fseek(file, 0, SEEK_SET) != 0) {
+            return_err(FILE_READ, "file reading failed");
+        }
+        if (unlikely((u64)file_size > (u64)(USIZE_MAX - hdr_size))) {
+            return_err(MEMORY_ALLOCATION, "memory allocation failed");
+        }
+        len = (usize)file_size;
+        doc = (yyjson_compact_doc *)alc.malloc_(alc.ctx, hdr_size + len);
+        if (unlikely(!doc)) {
+            return_err(MEMORY_ALLOCATION, "memory allocation failed");
+        }
+        doc->map = NULL;
+        doc->map_len = 0;
+        dat = (u8 *)doc + hdr_size;
+        if (len && fread_safe((void *)dat, len, file) != len) {
+            return_err(FILE_READ, "file reading failed");
+        }
+        fclose(file);
+        file = NULL;
     }
-    if (dat_len >= sizeof(buf)) alc->free_(alc->ctx, hdr);
-    if (yyjson_is_raw(val)) val->uni.str = dat;
-    return dat + (cur - hdr);
-#else
-    if (!read_number(&cur, pre, flg, val, &msg)) {
-        return_err(cur, INVALID_NUMBER, msg);
+    
+    /* validate the header, the values are trusted */
+    if (unlikely(len < BINARY_HDR_SIZE)) {
+        return_err(UNEXPECTED_END, "binary snapshot is truncated");
     }
-    return (const char *)cur;
+    memcpy((void *)hdr, (void *)dat, BINARY_HDR_SIZE);
+    if (unlikely(memcmp((void *)hdr, binary_magic, sizeof(binary_magic)))) {
+        return_err(UNEXPECTED_CONTENT, "invalid binary snapshot header");
+    }
+    if (unlikely(hdr[1] != BINARY_ENDIAN)) {
+        return_err(UNEXPECTED_CONTENT, "binary snapshot byte order mismatch");
+    }
+    len -= BINARY_HDR_SIZE;
+    if (unlikely(hdr[2] > (u64)(len / sizeof(u64)) ||
+                 hdr[3] > (u64)(len - (usize)hdr[2] * sizeof(u64)))) {
+        return_err(UNEXPECTED_END, "binary snapshot is truncated");
+    }
+    if (unlikely(hdr[3] != (u64)(len - (usize)hdr[2] * sizeof(u64)))) {
+        return_err(UNEXPECTED_CONTENT, "unexpected content after snapshot");
+    }
+    
+    doc->alc = alc;
+    doc->vals = (u64 *)(void *)(dat + BINARY_HDR_SIZE);
+    doc->val_num = (usize)hdr[2];
+    doc->strs = (char *)(dat + BINARY_HDR_SIZE) + doc->val_num * sizeof(u64);
+    doc->str_len = (usize)hdr[3];
+    doc->size = hdr_size + BINARY_HDR_SIZE + len;
+    if (unlikely(!doc->val_num || compact_size(doc->vals) != doc->val_num ||
+                 (doc->str_len && doc->strs[doc->str_len - 1] != '\0'))) {
+        return_err(UNEXPECTED_CONTENT, "invalid binary snapshot");
+    }
+    memset(err, 0, sizeof(yyjson_read_err));
+    return doc;
+    
+fail:
+    if (file) fclose(file);
+#if YYJSON_HAS_MMAP
+    if (map) munmap((void *)map, map_len);
 #endif
+    if (doc) alc.free_(alc.ctx, (void *)doc);
+    return NULL;
     
 #undef return_err
 }
 
+
 #endif /* YYJSON_DISABLE_READER */
 
 
@@ -8608,6 +14720,194 @@ static_inline u8 *write_string_noesc(u8 *cur, const u8 *str, usize str_len) {
     return cur;
 }
 
+/*
+ The SIMD kernels below are used by `write_string()` to copy long runs of
+ characters which don't need escaping in blocks of 16, 32 or 64 bytes. A run
+ is stopped by '"', '\\', [0x00-0x1F], [0x80-0xFF] and the `extra` character,
+ which is '/' if the encode table escapes it, or '"' otherwise. Non-ASCII bytes
+ stop the run because they need UTF-8 validation or unicode escaping, they are
+ less than 0x20 with a signed byte comparison, so no extra compare is needed.
+ 
+ Each block is stored before it's checked, the bytes after the stop character
+ are overwritten later. The kernels only load whole blocks and never read
+ beyond `end`, the remaining bytes are handled by the table lookup loop.
+ */
+
+#if YYJSON_HAS_SSE2
+
+/** Returns a bit mask of the characters to be escaped in the 16-byte block. */
+static_inline u32 sse2_escape_mask(__m128i v, __m128i extra) {
+    __m128i quote = _mm_cmpeq_epi8(v, _mm_set1_epi8('"'));
+    __m128i slash = _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'));
+    __m128i ctrl = _mm_cmplt_epi8(v, _mm_set1_epi8(0x20));
+    __m128i other = _mm_cmpeq_epi8(v, extra);
+    return (u32)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(quote, slash),
+                                               _mm_or_si128(ctrl, other)));
+}
+
+/** Copies the characters which don't need escaping in 16-byte blocks,
+    returns the copied length. */
+static_inline usize copy_noesc_sse2(u8 *dst, const u8 *src, const u8 *end,
+                                    u8 extra) {
+    const __m128i ext = _mm_set1_epi8((char)extra);
+    const u8 *hdr = src;
+    __m128i v;
+    u32 mask;
+    while (end - src >= 16) {
+        v = _mm_loadu_si128((const __m128i *)(const void *)src);
+        _mm_storeu_si128((__m128i *)(void *)dst, v);
+        mask = sse2_escape_mask(v, ext);
+        if (mask) return (usize)(src - hdr) + u64_tz_bits(mask);
+        src += 16;
+        dst += 16;
+    }
+    return (usize)(src - hdr);
+}
+
+#endif
+
+#if YYJSON_HAS_X86_DISPATCH
+
+/** Copies the characters which don't need escaping in 32-byte blocks,
+    returns the copied length. */
+static YYJSON_TARGET_AVX2 usize copy_noesc_avx2(u8 *dst, const u8 *src,
+                                                const u8 *end, u8 extra) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i slash = _mm256_set1_epi8('\\');
+    const __m256i space = _mm256_set1_epi8(0x20);
+    const __m256i ext = _mm256_set1_epi8((char)extra);
+    const u8 *hdr = src;
+    __m256i v, m;
+    u32 mask;
+    while (end - src >= 32) {
+        v = _mm256_loadu_si256((const __m256i *)(const void *)src);
+        _mm256_storeu_si256((__m256i *)(void *)dst, v);
+        m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote),
+                                            _mm256_cmpeq_epi8(v, slash)),
+                            _mm256_or_si256(_mm256_cmpgt_epi8(space, v),
+                                            _mm256_cmpeq_epi8(v, ext)));
+        mask = (u32)_mm256_movemask_epi8(m);
+        if (mask) return (usize)(src - hdr) + u64_tz_bits(mask);
+        src += 32;
+        dst += 32;
+    }
+    return (usize)(src - hdr) + copy_noesc_sse2(dst, src, end, extra);
+}
+
+/** Copies the characters which don't need escaping in 64-byte blocks,
+    returns the copied length. */
+static YYJSON_TARGET_AVX512 usize copy_noesc_avx512(u8 *dst, const u8 *src,
+                                                    const u8 *end, u8 extra) {
+    const __m512i quote = _mm512_set1_epi8('"');
+    const __m512i slash = _mm512_set1_epi8('\\');
+    const __m512i space = _mm512_set1_epi8(0x20);
+    const __m512i ext = _mm512_set1_epi8((char)extra);
+    const u8 *hdr = src;
+    __m512i v;
+    u64 mask;
+    while (end - src >= 64) {
+        v = _mm512_loadu_si512((const void *)src);
+        _mm512_storeu_si512((void *)dst, v);
+        mask = (u64)(_mm512_cmpeq_epi8_mask(v, quote) |
+                     _mm512_cmpeq_epi8_mask(v, slash) |
+                     _mm512_cmplt_epi8_mask(v, space) |
+                     _mm512_cmpeq_epi8_mask(v, ext));
+        if (mask) return (usize)(src - hdr) + u64_tz_bits(mask);
+        src += 64;
+        dst += 64;
+    }
+    return (usize)(src - hdr) + copy_noesc_sse2(dst, src, end, extra);
+}
+
+static usize copy_noesc_sse2_func(u8 *dst, const u8 *src, const u8 *end,
+                                  u8 extra) {
+    return copy_noesc_sse2(dst, src, end, extra);
+}
+
+static usize copy_noesc_init(u8 *dst, const u8 *src, const u8 *end,
+                             u8 extra);
+
+/** The kernel selected at run-time, see `copy_ascii_func` in the reader. */
+static usize (*copy_noesc_func)(u8 *dst, const u8 *src, const u8 *end,
+                                u8 extra) = copy_noesc_init;
+
+static usize copy_noesc_init(u8 *dst, const u8 *src, const u8 *end,
+                             u8 extra) {
+    if (cpu_supports_avx512bw()) {
+        copy_noesc_func = copy_noesc_avx512;
+    } else if (cpu_supports_avx2()) {
+        copy_noesc_func = copy_noesc_avx2;
+    } else {
+        copy_noesc_func = copy_noesc_sse2_func;
+    }
+    return copy_noesc_func(dst, src, end, extra);
+}
+
+#endif
+
+#if YYJSON_HAS_NEON
+
+/** Copies the characters which don't need escaping in 16-byte blocks,
+    returns the copied length. */
+static_inline usize copy_noesc_neon(u8 *dst, const u8 *src, const u8 *end,
+                                    u8 extra) {
+    const uint8x16_t ext = vdupq_n_u8(extra);
+    const u8 *hdr = src;
+    uint8x16_t v, m;
+    uint8x8_t n;
+    u64 mask;
+    while (end - src >= 16) {
+        v = vld1q_u8(src);
+        vst1q_u8(dst, v);
+        m = vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')),
+                              vceqq_u8(v, vdupq_n_u8('\\'))),
+                     vorrq_u8(vcltq_s8(vreinterpretq_s8_u8(v),
+                                       vdupq_n_s8(0x20)),
+                              vceqq_u8(v, ext)));
+        /* nibble mask, each byte is represented by 4 bits */
+        n = vshrn_n_u16(vreinterpretq_u16_u8(m), 4);
+        mask = vget_lane_u64(vreinterpret_u64_u8(n), 0);
+        if (mask) return (usize)(src - hdr) + (u64_tz_bits(mask) >> 2);
+        src += 16;
+        dst += 16;
+    }
+    return (usize)(src - hdr);
+}
+
+#endif
+
+#if YYJSON_HAS_SIMD
+
+/**
+ Copies the characters which don't need escaping with the best available
+ kernel, returns the copied length. The output buffer should have at least
+ as many bytes as the input.
+ 
+ The first block is checked inline, most strings are short and do not need to
+ pay for the indirect call to the run-time selected kernel.
+ */
+static_inline usize copy_noesc_simd(u8 *dst, const u8 *src, const u8 *end,
+                                    u8 extra) {
+#if YYJSON_HAS_SSE2
+    __m128i v;
+    u32 mask;
+    if (end - src < 16) return 0;
+    v = _mm_loadu_si128((const __m128i *)(const void *)src);
+    _mm_storeu_si128((__m128i *)(void *)dst, v);
+    mask = sse2_escape_mask(v, _mm_set1_epi8((char)extra));
+    if (mask) return u64_tz_bits(mask);
+#   if YYJSON_HAS_X86_DISPATCH
+    return 16 + copy_noesc_func(dst + 16, src + 16, end, extra);
+#   else
+    return 16 + copy_noesc_sse2(dst + 16, src + 16, end, extra);
+#   endif
+#else
+    return copy_noesc_neon(dst, src, end, extra);
+#endif
+}
+
+#endif
+
 /**
  Write UTF-8 string (requires len * 6 + 2 bytes buffer).
  @param cur Buffer cursor.
@@ -8700,9 +15000,19 @@ static_inline u8 *write_string(u8 *cur, bool esc, bool inv,
     
     const u8 *src = str;
     const u8 *end = str + str_len;
+#if YYJSON_HAS_SIMD
+    const u8 extra = enc_table['/'] ? '/' : '"';
+    usize len;
+#endif
     *cur++ = '"';
     
 copy_ascii:
+#if YYJSON_HAS_SIMD
+    /* copy long runs in SIMD blocks, the rest is handled by the table */
+    len = copy_noesc_simd(cur, src, end, extra);
+    cur += len;
+    src += len;
+#endif
     /*
      Copy continuous ASCII, loop unrolling, same as the following code:
      
@@ -8926,55 +15236,580 @@ static_inline u8 *write_bool(u8 *cur, bool val) {
     } else {
         byte_copy_8(cur, &v0);
     }
-    return cur + 5 - val;
-}
-
-/** Write indent (requires level x 4 bytes buffer).
-    Param spaces should not larger than 4. */
-static_inline u8 *write_indent(u8 *cur, usize level, usize spaces) {
-    while (level-- > 0) {
-        byte_copy_4(cur, "    ");
-        cur += spaces;
+    return cur + 5 - val;
+}
+
+/** Write indent (requires level x 4 bytes buffer).
+    Param spaces should not larger than 4. */
+static_inline u8 *write_indent(u8 *cur, usize level, usize spaces) {
+    while (level-- > 0) {
+        byte_copy_4(cur, "    ");
+        cur += spaces;
+    }
+    return cur;
+}
+
+/** Write data to file pointer. */
+static bool write_dat_to_fp(FILE *fp, u8 *dat, usize len,
+                            yyjson_write_err *err) {
+    if (fwrite(dat, len, 1, fp) != 1) {
+        err->msg = "file writing failed";
+        err->code = YYJSON_WRITE_ERROR_FILE_WRITE;
+        return false;
+    }
+    return true;
+}
+
+/** Write data to file. */
+static bool write_dat_to_file(const char *path, u8 *dat, usize len,
+                              yyjson_write_err *err) {
+    
+#define return_err(_code, _msg) do { \
+    err->msg = _msg; \
+    err->code = YYJSON_WRITE_ERROR_##_code; \
+    if (file) fclose(file); \
+    return false; \
+} while (false)
+    
+    FILE *file = fopen_writeonly(path);
+    if (file == NULL) {
+        return_err(FILE_OPEN, "file opening failed");
+    }
+    if (fwrite(dat, len, 1, file) != 1) {
+        return_err(FILE_WRITE, "file writing failed");
+    }
+    if (fclose(file) != 0) {
+        file = NULL;
+        return_err(FILE_WRITE, "file closing failed");
+    }
+    return true;
+    
+#undef return_err
+}
+
+#if YYJSON_HAS_FD_WRITE
+/** Write data to file descriptor, the callback of the `_fd` writers. */
+static bool write_dat_to_fd(void *ctx, const char *dat, usize len) {
+    int fd = *(int *)ctx;
+    while (len > 0) {
+        /* the length of each call is limited to fit in int */
+        usize num = yyjson_min(len, (usize)0x40000000);
+#if defined(_WIN32)
+        int ret = _write(fd, dat, (unsigned int)num);
+#else
+        ssize_t ret = write(fd, dat, num);
+        if (ret < 0 && errno == EINTR) continue;
+#endif
+        if (ret <= 0) return false;
+        dat += ret;
+        len -= (usize)ret;
+    }
+    return true;
+}
+#endif
+
+/** The output of the streaming writer. */
+typedef struct write_sink {
+    yyjson_write_fn fn;     /* the output callback */
+    void *ctx;              /* the context of the callback */
+    usize buf_size;         /* the buffer size */
+} write_sink;
+
+/* The number of bytes kept in the buffer when the buffer is flushed, the
+   writer may rewrite the separator after the last value (2 bytes at most). */
+#define WRITE_SINK_KEEP_LEN 2
+
+/** Flush the buffer of the streaming writer except the last few bytes.
+    Returns false if the callback fails. */
+static_noinline bool write_sink_flush(write_sink *sink, u8 *hdr, u8 **cur) {
+    usize len = (usize)(*cur - hdr);
+    if (len <= WRITE_SINK_KEEP_LEN) return true;
+    len -= WRITE_SINK_KEEP_LEN;
+    if (!sink->fn(sink->ctx, (const char *)hdr, len)) return false;
+    memmove((void *)hdr, (void *)(hdr + len), WRITE_SINK_KEEP_LEN);
+    *cur = hdr + WRITE_SINK_KEEP_LEN;
+    return true;
+}
+
+/** Initialize the streaming writer, returns false if the callback is NULL. */
+static_inline bool write_sink_init(write_sink *sink, yyjson_write_fn fn,
+                                   void *ctx, usize buf_size,
+                                   yyjson_write_err *err) {
+    if (unlikely(!fn)) {
+        err->msg = "input callback is NULL";
+        err->code = YYJSON_WRITE_ERROR_INVALID_PARAMETER;
+        return false;
+    }
+    sink->fn = fn;
+    sink->ctx = ctx;
+    sink->buf_size = buf_size ? buf_size : YYJSON_WRITER_STREAM_BUF_SIZE;
+    sink->buf_size = yyjson_max(sink->buf_size, 64);
+    return true;
+}
+
+/** Flush the rest of the output and free the buffer of the streaming writer.
+    Returns false if the writer or the callback fails. */
+static_inline bool write_sink_end(write_sink *sink, u8 *dat, usize len,
+                                  const yyjson_alc *alc,
+                                  yyjson_write_err *err) {
+    bool suc;
+    if (unlikely(!dat)) return false;
+    suc = !len || sink->fn(sink->ctx, (const char *)dat, len);
+    alc->free_(alc->ctx, dat);
+    if (unlikely(!suc)) {
+        err->msg = "file writing failed";
+        err->code = YYJSON_WRITE_ERROR_FILE_WRITE;
+    }
+    return suc;
+}
+
+/** The reusable buffer of `yyjson_write_buf()`. It's used as the allocator of
+    the writers, so the output buffer is the caller's buffer, which is grown
+    only if it's too small and is kept by the caller on error. */
+typedef struct write_buf_ctx {
+    yyjson_alc alc;     /* the allocator of the buffer */
+    u8 *buf;            /* the buffer, or NULL */
+    usize size;         /* the buffer size */
+} write_buf_ctx;
+
+static void *write_buf_realloc(void *ctx_ptr, void *ptr,
+                               usize old_size, usize size) {
+    write_buf_ctx *ctx = (write_buf_ctx *)ctx_ptr;
+    void *tmp;
+    (void)ptr;
+    (void)old_size;
+    if (size <= ctx->size) return (void *)ctx->buf;
+    if (ctx->buf) {
+        tmp = ctx->alc.realloc_(ctx->alc.ctx, ctx->buf, ctx->size, size);
+    } else {
+        tmp = ctx->alc.malloc_(ctx->alc.ctx, size);
+    }
+    if (unlikely(!tmp)) return NULL;
+    ctx->buf = (u8 *)tmp;
+    ctx->size = size;
+    return tmp;
+}
+
+static void *write_buf_malloc(void *ctx_ptr, usize size) {
+    return write_buf_realloc(ctx_ptr, NULL, 0, size);
+}
+
+static void write_buf_free(void *ctx_ptr, void *ptr) {
+    /* the buffer is owned by the caller */
+    (void)ctx_ptr;
+    (void)ptr;
+}
+
+/** Initialize the allocator of the reusable buffer.
+    Returns false if the input is invalid. */
+static_inline bool write_buf_init(write_buf_ctx *ctx, yyjson_alc *alc,
+                                  char **buf, usize *buf_size,
+                                  const yyjson_alc *alc_ptr,
+                                  yyjson_write_err *err) {
+    if (unlikely(!buf || !buf_size)) {
+        err->msg = "input buffer is NULL";
+        err->code = YYJSON_WRITE_ERROR_INVALID_PARAMETER;
+        return false;
+    }
+    ctx->alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    ctx->buf = (u8 *)*buf;
+    ctx->size = *buf ? *buf_size : 0;
+    alc->malloc_ = write_buf_malloc;
+    alc->realloc_ = write_buf_realloc;
+    alc->free_ = write_buf_free;
+    alc->ctx = (void *)ctx;
+    return true;
+}
+
+
+
+/*==============================================================================
+ * JSON Canonical Writer (RFC 8785)
+ *
+ * The JSON Canonicalization Scheme (JCS) writes JSON without whitespace, the
+ * members of each object are sorted by the UTF-16 code units of the keys, the
+ * numbers are written in the format of ECMAScript, and the strings are escaped
+ * only where it's required.
+ *
+ * The values are not moved: when an object begins, its keys are pushed to a
+ * scratch stack and sorted there, and they're popped when the object ends, so
+ * the scratch memory is reused by all objects, and it's bounded by the keys of
+ * the objects on the current path. The immutable and mutable values share the
+ * layout of `tag` and `uni`, only the ways to find the children differ, so the
+ * same writer is used for both.
+ *============================================================================*/
+
+/** A container on the stack of the canonical writer. */
+typedef struct canon_frame {
+    void *val;      /* the current value (array) */
+    usize key_ofs;  /* the offset of the sorted keys in the scratch (object) */
+    usize idx;      /* the index of the current value or key */
+    usize len;      /* the number of values or keys */
+    bool is_obj;    /* whether the container is an object */
+} canon_frame;
+
+/** Returns the first value of a non-empty array, or the first key of a
+    non-empty object. */
+static_inline void *canon_first(void *ctn, bool mut) {
+    yyjson_mut_val *last;
+    if (mut) {
+        /* the last value of an array or the last key of an object */
+        last = (yyjson_mut_val *)((yyjson_mut_val *)ctn)->uni.ptr;
+        if (unsafe_yyjson_is_obj(ctn)) last = last->next;
+        return (void *)last->next;
+    }
+    return (void *)((yyjson_val *)ctn + 1);
+}
+
+/** Returns the next sibling of a value in an array, or the next key of a
+    value in an object. */
+static_inline void *canon_next(void *val, bool mut) {
+    if (mut) return (void *)((yyjson_mut_val *)val)->next;
+    return (void *)unsafe_yyjson_get_next((yyjson_val *)val);
+}
+
+/** Returns the value of a key in an object. */
+static_inline void *canon_key_val(void *key, bool mut) {
+    if (mut) return (void *)((yyjson_mut_val *)key)->next;
+    return (void *)((yyjson_val *)key + 1);
+}
+
+/** Compares two keys by UTF-16 code units. The order of the UTF-8 bytes is
+    the order of the code points, it differs from the order of the UTF-16 code
+    units only when a character in U+E000..U+FFFF (lead byte 0xEE or 0xEF) is
+    compared with a character above U+FFFF (lead byte 0xF0..0xF4), which is
+    encoded as surrogates (less than 0xE000) in UTF-16. */
+static_inline int canon_key_cmp(void *lhs, void *rhs) {
+    const u8 *str1 = (const u8 *)unsafe_yyjson_get_str(lhs);
+    const u8 *str2 = (const u8 *)unsafe_yyjson_get_str(rhs);
+    usize len1 = unsafe_yyjson_get_len(lhs);
+    usize len2 = unsafe_yyjson_get_len(rhs);
+    usize i, len = yyjson_min(len1, len2);
+    u8 c1, c2;
+    
+    for (i = 0; i < len; i++) {
+        c1 = str1[i];
+        c2 = str2[i];
+        if (c1 == c2) continue;
+        if (c1 >= 0xF0 && (c2 == 0xEE || c2 == 0xEF)) return -1;
+        if (c2 >= 0xF0 && (c1 == 0xEE || c1 == 0xEF)) return 1;
+        return c1 < c2 ? -1 : 1;
+    }
+    return len1 < len2 ? -1 : (len1 > len2);
+}
+
+/** Sorts the keys with a stable merge sort, so the duplicated keys are kept
+    in order. The `tmp` is a temporary buffer with the same length. */
+static void canon_sort_keys(void **keys, void **tmp, usize len) {
+    void **src = keys, **dst = tmp, **swap, *key;
+    usize i, j, run, lo, mid, hi, l, r, k;
+    const usize min_run = 8;
+    
+    /* insertion sort for the short runs */
+    for (lo = 0; lo < len; lo += min_run) {
+        hi = yyjson_min(lo + min_run, len);
+        for (i = lo + 1; i < hi; i++) {
+            key = src[i];
+            for (j = i; j > lo && canon_key_cmp(src[j - 1], key) > 0; j--) {
+                src[j] = src[j - 1];
+            }
+            src[j] = key;
+        }
+    }
+    
+    /* merge the runs bottom-up */
+    for (run = min_run; run < len; run *= 2) {
+        for (lo = 0; lo < len; lo += run * 2) {
+            mid = yyjson_min(lo + run, len);
+            hi = yyjson_min(lo + run * 2, len);
+            l = lo;
+            r = mid;
+            k = lo;
+            while (l < mid && r < hi) {
+                if (canon_key_cmp(src[r], src[l]) < 0) dst[k++] = src[r++];
+                else dst[k++] = src[l++];
+            }
+            while (l < mid) dst[k++] = src[l++];
+            while (r < hi) dst[k++] = src[r++];
+        }
+        swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != keys) memcpy((void *)keys, (void *)src, len * sizeof(void *));
+}
+
+/** Write a string of the canonical writer, only '"', '\\' and the control
+    characters are escaped, with lowercase hex digits. Returns NULL if the
+    string has invalid UTF-8 encoding. */
+static_inline u8 *write_string_canonical(u8 *cur, const u8 *str, usize len) {
+    u8 *hdr = cur, *ptr;
+    cur = write_string(cur, false, false, str, len, enc_table_cpy);
+    if (unlikely(!cur)) return NULL;
+    if (unlikely((usize)(cur - hdr) != len + 2)) {
+        /* lowercase the hex digits, e.g. "\u001F" -> "\u001f" */
+        for (ptr = hdr + 1; ptr < cur - 1; ptr++) {
+            if (*ptr != '\\') continue;
+            if (ptr[1] == 'u') {
+                if (ptr[5] >= 'A') ptr[5] = (u8)(ptr[5] | 0x20);
+                ptr += 5;
+            } else {
+                ptr++;
+            }
+        }
+    }
+    return cur;
+}
+
+/** Write a number of the canonical writer in the format of ECMAScript
+    `Number.prototype.toString()` (requires 40 bytes buffer). The integers
+    beyond 2^53 are written as doubles. Returns NULL on inf or nan. */
+static_inline u8 *write_number_canonical(u8 *cur, void *val) {
+    u64 raw = ((yyjson_val *)val)->uni.u64;
+    u64 tag = ((yyjson_val *)val)->tag;
+    u64 abs;
+    u8 *end, *exp;
+    bool sign;
+    
+    if (!(tag & YYJSON_SUBTYPE_REAL)) {
+        sign = (tag & YYJSON_SUBTYPE_SINT) && (i64)raw < 0;
+        abs = sign ? ~raw + 1 : raw;
+        if (abs <= ((u64)1 << F64_SIG_FULL_BITS)) {
+            *cur = '-';
+            return write_u64(abs, cur + sign);
+        }
+        raw = f64_to_raw(unsafe_yyjson_u64_to_f64(abs));
+        raw |= (u64)sign << (F64_BITS - 1);
+    }
+    
+    /* -0.0 is written as 0 */
+    if ((raw << 1) == 0) {
+        *cur = '0';
+        return cur + 1;
+    }
+    if (unlikely((raw & F64_EXP_MASK) == F64_EXP_MASK)) return NULL;
+    
+    /* remove ".0" of integers, add '+' to positive exponents */
+    end = write_f64_raw(cur, raw, 0);
+    if (end[-2] == '.' && end[-1] == '0') return end - 2;
+    for (exp = end - 1; exp > cur && *exp != 'e'; exp--) {}
+    if (*exp == 'e' && exp[1] != '-') {
+        memmove((void *)(exp + 2), (void *)(exp + 1), (usize)(end - exp - 1));
+        exp[1] = '+';
+        end++;
+    }
+    return end;
+}
+
+/** Write a value with the canonical format. The `root` is a `yyjson_val` or
+    a `yyjson_mut_val` (if `mut` is true), the `val_num` is used to estimate
+    the output size. */
+static u8 *yyjson_write_canonical(void *root,
+                                  bool mut,
+                                  usize val_num,
+                                  yyjson_write_flag flg,
+                                  const yyjson_alc alc,
+                                  write_sink *sink,
+                                  usize *dat_len,
+                                  yyjson_write_err *err) {
+    
+#define return_err(_code, _msg) do { \
+    *dat_len = 0; \
+    err->code = YYJSON_WRITE_ERROR_##_code; \
+    err->msg = _msg; \
+    if (hdr) alc.free_(alc.ctx, hdr); \
+    if (frames) alc.free_(alc.ctx, (void *)frames); \
+    if (keys) alc.free_(alc.ctx, (void *)keys); \
+    return NULL; \
+} while (false)
+    
+#define incr_len(_len) do { \
+    ext_len = (usize)(_len); \
+    if (unlikely(cur + ext_len >= end) && sink) { \
+        if (unlikely(!write_sink_flush(sink, hdr, &cur))) goto fail_sink; \
+    } \
+    if (unlikely(cur + ext_len >= end)) { \
+        usize cur_pos = (usize)(cur - hdr); \
+        alc_inc = yyjson_max(alc_len / 2, ext_len); \
+        if ((sizeof(usize) < 8) && size_add_is_overflow(alc_len, alc_inc)) \
+            goto fail_alloc; \
+        tmp = (u8 *)alc.realloc_(alc.ctx, hdr, alc_len, alc_len + alc_inc); \
+        if (unlikely(!tmp)) goto fail_alloc; \
+        alc_len += alc_inc; \
+        cur = tmp + cur_pos; \
+        end = tmp + alc_len; \
+        hdr = tmp; \
+    } \
+} while (false)
+    
+#define check_str_len(_len) do { \
+    if ((sizeof(usize) < 8) && (_len >= (USIZE_MAX - 16) / 6)) \
+        goto fail_alloc; \
+} while (false)
+    
+    void *val, *key, *mem;
+    yyjson_type val_type;
+    u8 *hdr = NULL, *cur, *end, *tmp;
+    canon_frame *frames = NULL, *frame;
+    void **keys = NULL;
+    usize frame_num = 0, frame_cap = 0, key_num = 0, key_cap = 0;
+    usize alc_len, alc_inc, ext_len, str_len, len, cap, i;
+    const u8 *str_ptr;
+    bool is_obj, newline = has_write_flag(NEWLINE_AT_END) != 0;
+    
+    alc_len = val_num * YYJSON_WRITER_ESTIMATED_MINIFY_RATIO + 64;
+    if (sink) alc_len = sink->buf_size;
+    hdr = (u8 *)alc.malloc_(alc.ctx, alc_len);
+    if (!hdr) goto fail_alloc;
+    cur = hdr;
+    end = hdr + alc_len;
+    val = root;
+    
+val_begin:
+    val_type = unsafe_yyjson_get_type(val);
+    if (val_type == YYJSON_TYPE_STR) {
+        str_len = unsafe_yyjson_get_len(val);
+        str_ptr = (const u8 *)unsafe_yyjson_get_str(val);
+        check_str_len(str_len);
+        incr_len(str_len * 6 + 16);
+        cur = write_string_canonical(cur, str_ptr, str_len);
+        if (unlikely(!cur)) goto fail_str;
+        goto val_end;
+    }
+    if (val_type == YYJSON_TYPE_NUM) {
+        incr_len(FP_BUF_LEN);
+        cur = write_number_canonical(cur, val);
+        if (unlikely(!cur)) goto fail_num;
+        goto val_end;
+    }
+    if ((val_type & (YYJSON_TYPE_ARR & YYJSON_TYPE_OBJ)) ==
+                    (YYJSON_TYPE_ARR & YYJSON_TYPE_OBJ)) {
+        len = unsafe_yyjson_get_len(val);
+        is_obj = (val_type == YYJSON_TYPE_OBJ);
+        incr_len(16);
+        *cur++ = (u8)('[' | ((u8)is_obj << 5));
+        if (unlikely(len == 0)) {
+            *cur++ = (u8)(']' | ((u8)is_obj << 5));
+            goto val_end;
+        }
+    
+        /* push a frame for the container */
+        if (unlikely(frame_num == frame_cap)) {
+            cap = frame_cap * 2 + 16;
+            mem = frames ? alc.realloc_(alc.ctx, (void *)frames,
+                                        frame_cap * sizeof(canon_frame),
+                                        cap * sizeof(canon_frame))
+                         : alc.malloc_(alc.ctx, cap * sizeof(canon_frame));
+            if (unlikely(!mem)) goto fail_alloc;
+            frames = (canon_frame *)mem;
+            frame_cap = cap;
+        }
+        frame = &frames[frame_num++];
+        frame->is_obj = is_obj;
+        frame->idx = 0;
+        frame->len = len;
+        if (!is_obj) {
+            frame->val = val = canon_first(val, mut);
+            goto val_begin;
+        }
+    
+        /* push the keys, the space after them is used to sort the keys */
+        if (unlikely(key_cap - key_num < len * 2)) {
+            cap = yyjson_max(key_cap + key_cap / 2, key_num + len * 2);
+            if ((sizeof(usize) < 8) && (cap >= USIZE_MAX / sizeof(void *)))
+                goto fail_alloc;
+            mem = keys ? alc.realloc_(alc.ctx, (void *)keys,
+                                      key_cap * sizeof(void *),
+                                      cap * sizeof(void *))
+                       : alc.malloc_(alc.ctx, cap * sizeof(void *));
+            if (unlikely(!mem)) goto fail_alloc;
+            keys = (void **)mem;
+            key_cap = cap;
+        }
+        frame->key_ofs = key_num;
+        key = canon_first(val, mut);
+        for (i = 0; i < len; i++) {
+            keys[key_num + i] = key;
+            key = canon_next(canon_key_val(key, mut), mut);
+        }
+        canon_sort_keys(keys + key_num, keys + key_num + len, len);
+        key_num += len;
+        goto key_begin;
+    }
+    if (val_type == YYJSON_TYPE_BOOL) {
+        incr_len(16);
+        cur = write_bool(cur, unsafe_yyjson_get_bool(val));
+        goto val_end;
+    }
+    if (val_type == YYJSON_TYPE_NULL) {
+        incr_len(16);
+        cur = write_null(cur);
+        goto val_end;
     }
-    return cur;
-}
-
-/** Write data to file pointer. */
-static bool write_dat_to_fp(FILE *fp, u8 *dat, usize len,
-                            yyjson_write_err *err) {
-    if (fwrite(dat, len, 1, fp) != 1) {
-        err->msg = "file writing failed";
-        err->code = YYJSON_WRITE_ERROR_FILE_WRITE;
-        return false;
+    if (val_type == YYJSON_TYPE_RAW) {
+        str_len = unsafe_yyjson_get_len(val);
+        str_ptr = (const u8 *)unsafe_yyjson_get_str(val);
+        check_str_len(str_len);
+        incr_len(str_len + 2);
+        cur = write_raw(cur, str_ptr, str_len);
+        goto val_end;
     }
-    return true;
-}
-
-/** Write data to file. */
-static bool write_dat_to_file(const char *path, u8 *dat, usize len,
-                              yyjson_write_err *err) {
+    goto fail_type;
     
-#define return_err(_code, _msg) do { \
-    err->msg = _msg; \
-    err->code = YYJSON_WRITE_ERROR_##_code; \
-    if (file) fclose(file); \
-    return false; \
-} while (false)
+key_begin:
+    key = keys[frame->key_ofs + frame->idx];
+    str_len = unsafe_yyjson_get_len(key);
+    str_ptr = (const u8 *)unsafe_yyjson_get_str(key);
+    check_str_len(str_len);
+    incr_len(str_len * 6 + 16);
+    cur = write_string_canonical(cur, str_ptr, str_len);
+    if (unlikely(!cur)) goto fail_str;
+    *cur++ = ':';
+    val = canon_key_val(key, mut);
+    goto val_begin;
     
-    FILE *file = fopen_writeonly(path);
-    if (file == NULL) {
-        return_err(FILE_OPEN, "file opening failed");
-    }
-    if (fwrite(dat, len, 1, file) != 1) {
-        return_err(FILE_WRITE, "file writing failed");
+val_end:
+    if (unlikely(frame_num == 0)) goto doc_end;
+    frame = &frames[frame_num - 1];
+    incr_len(2);
+    if (unlikely(++frame->idx == frame->len)) {
+        /* pop the container and its keys */
+        *cur++ = (u8)(']' | ((u8)frame->is_obj << 5));
+        if (frame->is_obj) key_num = frame->key_ofs;
+        frame_num--;
+        goto val_end;
     }
-    if (fclose(file) != 0) {
-        file = NULL;
-        return_err(FILE_WRITE, "file closing failed");
+    *cur++ = ',';
+    if (frame->is_obj) goto key_begin;
+    frame->val = val = canon_next(frame->val, mut);
+    goto val_begin;
+    
+doc_end:
+    if (newline) {
+        incr_len(2);
+        *cur++ = '\n';
     }
-    return true;
+    if (frames) alc.free_(alc.ctx, (void *)frames);
+    if (keys) alc.free_(alc.ctx, (void *)keys);
+    *cur = '\0';
+    *dat_len = (usize)(cur - hdr);
+    memset(err, 0, sizeof(yyjson_write_err));
+    return hdr;
+    
+fail_alloc:
+    return_err(MEMORY_ALLOCATION, "memory allocation failed");
+fail_type:
+    return_err(INVALID_VALUE_TYPE, "invalid JSON value type");
+fail_num:
+    return_err(NAN_OR_INF, "nan or inf number is not allowed");
+fail_str:
+    return_err(INVALID_STRING, "invalid utf-8 encoding in string");
+fail_sink:
+    return_err(FILE_WRITE, "file writing failed");
     
 #undef return_err
+#undef incr_len
+#undef check_str_len
 }
 
 
@@ -9110,10 +15945,15 @@ fail_str:
 }
 
 /** Write JSON document minify.
-    The root of this document should be a non-empty container. */
+    The root of this document should be a non-empty container. If the `part`
+    is not NULL, only `part_len` values of the root from `part` are written
+    (keys are counted), see `write_parallel_part()`. */
 static_inline u8 *yyjson_write_minify(const yyjson_val *root,
+                                      const yyjson_val *part,
+                                      usize part_len,
                                       const yyjson_write_flag flg,
                                       const yyjson_alc alc,
+                                      write_sink *sink,
                                       usize *dat_len,
                                       yyjson_write_err *err) {
     
@@ -9127,6 +15967,9 @@ static_inline u8 *yyjson_write_minify(const yyjson_val *root,
     
 #define incr_len(_len) do { \
     ext_len = (usize)(_len); \
+    if (unlikely((u8 *)(cur + ext_len) >= (u8 *)ctx) && sink) { \
+        if (unlikely(!write_sink_flush(sink, hdr, &cur))) goto fail_sink; \
+    } \
     if (unlikely((u8 *)(cur + ext_len) >= (u8 *)ctx)) { \
         usize ctx_pos = (usize)((u8 *)ctx - hdr); \
         usize cur_pos = (usize)(cur - hdr); \
@@ -9167,7 +16010,14 @@ static_inline u8 *yyjson_write_minify(const yyjson_val *root,
     bool newline = has_write_flag(NEWLINE_AT_END) != 0;
     
     alc_len = root->uni.ofs / sizeof(yyjson_val);
+    if (part) {
+        /* scale the estimate of the root by the values in this part */
+        val = constcast(yyjson_val *)root;
+        alc_len /= unsafe_yyjson_get_len(val) << (u8)unsafe_yyjson_is_obj(val);
+        alc_len *= part_len;
+    }
     alc_len = alc_len * YYJSON_WRITER_ESTIMATED_MINIFY_RATIO + 64;
+    if (sink) alc_len = sink->buf_size;
     alc_len = size_align_up(alc_len, sizeof(yyjson_write_ctx));
     hdr = (u8 *)alc.malloc_(alc.ctx, alc_len);
     if (!hdr) goto fail_alloc;
@@ -9182,6 +16032,11 @@ doc_begin:
     ctn_len = unsafe_yyjson_get_len(val) << (u8)ctn_obj;
     *cur++ = (u8)('[' | ((u8)ctn_obj << 5));
     val++;
+    if (part) {
+        /* write a part of the children, see `write_parallel_part()` */
+        val = constcast(yyjson_val *)part;
+        ctn_len = part_len;
+    }
     
 val_begin:
     val_type = unsafe_yyjson_get_type(val);
@@ -9289,6 +16144,8 @@ fail_num:
     return_err(NAN_OR_INF, "nan or inf number is not allowed");
 fail_str:
     return_err(INVALID_STRING, "invalid utf-8 encoding in string");
+fail_sink:
+    return_err(FILE_WRITE, "file writing failed");
     
 #undef return_err
 #undef incr_len
@@ -9296,10 +16153,15 @@ fail_str:
 }
 
 /** Write JSON document pretty.
-    The root of this document should be a non-empty container. */
+    The root of this document should be a non-empty container. If the `part`
+    is not NULL, only `part_len` values of the root from `part` are written
+    (keys are counted), see `write_parallel_part()`. */
 static_inline u8 *yyjson_write_pretty(const yyjson_val *root,
+                                      const yyjson_val *part,
+                                      usize part_len,
                                       const yyjson_write_flag flg,
                                       const yyjson_alc alc,
+                                      write_sink *sink,
                                       usize *dat_len,
                                       yyjson_write_err *err) {
     
@@ -9313,6 +16175,9 @@ static_inline u8 *yyjson_write_pretty(const yyjson_val *root,
     
 #define incr_len(_len) do { \
     ext_len = (usize)(_len); \
+    if (unlikely((u8 *)(cur + ext_len) >= (u8 *)ctx) && sink) { \
+        if (unlikely(!write_sink_flush(sink, hdr, &cur))) goto fail_sink; \
+    } \
     if (unlikely((u8 *)(cur + ext_len) >= (u8 *)ctx)) { \
         usize ctx_pos = (usize)((u8 *)ctx - hdr); \
         usize cur_pos = (usize)(cur - hdr); \
@@ -9354,7 +16219,14 @@ static_inline u8 *yyjson_write_pretty(const yyjson_val *root,
     bool newline = has_write_flag(NEWLINE_AT_END) != 0;
     
     alc_len = root->uni.ofs / sizeof(yyjson_val);
+    if (part) {
+        /* scale the estimate of the root by the values in this part */
+        val = constcast(yyjson_val *)root;
+        alc_len /= unsafe_yyjson_get_len(val) << (u8)unsafe_yyjson_is_obj(val);
+        alc_len *= part_len;
+    }
     alc_len = alc_len * YYJSON_WRITER_ESTIMATED_PRETTY_RATIO + 64;
+    if (sink) alc_len = sink->buf_size;
     alc_len = size_align_up(alc_len, sizeof(yyjson_write_ctx));
     hdr = (u8 *)alc.malloc_(alc.ctx, alc_len);
     if (!hdr) goto fail_alloc;
@@ -9371,6 +16243,11 @@ doc_begin:
     *cur++ = '\n';
     val++;
     level = 1;
+    if (part) {
+        /* write a part of the children, see `write_parallel_part()` */
+        val = constcast(yyjson_val *)part;
+        ctn_len = part_len;
+    }
     
 val_begin:
     val_type = unsafe_yyjson_get_type(val);
@@ -9501,17 +16378,22 @@ fail_num:
     return_err(NAN_OR_INF, "nan or inf number is not allowed");
 fail_str:
     return_err(INVALID_STRING, "invalid utf-8 encoding in string");
+fail_sink:
+    return_err(FILE_WRITE, "file writing failed");
     
 #undef return_err
 #undef incr_len
 #undef check_str_len
 }
 
-char *yyjson_val_write_opts(const yyjson_val *val,
-                            yyjson_write_flag flg,
-                            const yyjson_alc *alc_ptr,
-                            usize *dat_len,
-                            yyjson_write_err *err) {
+/** Write a value with options. If the sink is not NULL, the output is flushed
+    to the sink when the buffer is full, and the rest is returned. */
+static u8 *yyjson_val_write_impl(const yyjson_val *val,
+                                 yyjson_write_flag flg,
+                                 const yyjson_alc *alc_ptr,
+                                 write_sink *sink,
+                                 usize *dat_len,
+                                 yyjson_write_err *err) {
     yyjson_write_err dummy_err;
     usize dummy_dat_len;
     yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
@@ -9527,15 +16409,32 @@ char *yyjson_val_write_opts(const yyjson_val *val,
         return NULL;
     }
     
+    if (has_write_flag(CANONICAL)) {
+        return yyjson_write_canonical((void *)root, false,
+                                      unsafe_yyjson_is_ctn(root) ?
+                                      root->uni.ofs / sizeof(yyjson_val) : 1,
+                                      flg, alc, sink, dat_len, err);
+    }
     if (!unsafe_yyjson_is_ctn(root) || unsafe_yyjson_get_len(root) == 0) {
-        return (char *)yyjson_write_single(root, flg, alc, dat_len, err);
+        return yyjson_write_single(root, flg, alc, dat_len, err);
     } else if (flg & (YYJSON_WRITE_PRETTY | YYJSON_WRITE_PRETTY_TWO_SPACES)) {
-        return (char *)yyjson_write_pretty(root, flg, alc, dat_len, err);
+        return yyjson_write_pretty(root, NULL, 0, flg, alc, sink,
+                                   dat_len, err);
     } else {
-        return (char *)yyjson_write_minify(root, flg, alc, dat_len, err);
+        return yyjson_write_minify(root, NULL, 0, flg, alc, sink,
+                                   dat_len, err);
     }
 }
 
+char *yyjson_val_write_opts(const yyjson_val *val,
+                            yyjson_write_flag flg,
+                            const yyjson_alc *alc_ptr,
+                            usize *dat_len,
+                            yyjson_write_err *err) {
+    return (char *)yyjson_val_write_impl(val, flg, alc_ptr, NULL,
+                                         dat_len, err);
+}
+
 char *yyjson_write_opts(const yyjson_doc *doc,
                         yyjson_write_flag flg,
                         const yyjson_alc *alc_ptr,
@@ -9545,6 +16444,41 @@ char *yyjson_write_opts(const yyjson_doc *doc,
     return yyjson_val_write_opts(root, flg, alc_ptr, dat_len, err);
 }
 
+bool yyjson_val_write_buf(char **buf,
+                          usize *buf_size,
+                          const yyjson_val *val,
+                          yyjson_write_flag flg,
+                          const yyjson_alc *alc_ptr,
+                          usize *dat_len,
+                          yyjson_write_err *err) {
+    yyjson_write_err dummy_err;
+    write_buf_ctx ctx;
+    yyjson_alc alc;
+    u8 *dat;
+    
+    err = err ? err : &dummy_err;
+    if (unlikely(!write_buf_init(&ctx, &alc, buf, buf_size, alc_ptr, err))) {
+        if (dat_len) *dat_len = 0;
+        return false;
+    }
+    dat = yyjson_val_write_impl(val, flg, &alc, NULL, dat_len, err);
+    *buf = (char *)ctx.buf;
+    *buf_size = ctx.size;
+    return dat != NULL;
+}
+
+bool yyjson_write_buf(char **buf,
+                      usize *buf_size,
+                      const yyjson_doc *doc,
+                      yyjson_write_flag flg,
+                      const yyjson_alc *alc_ptr,
+                      usize *dat_len,
+                      yyjson_write_err *err) {
+    yyjson_val *root = doc ? doc->root : NULL;
+    return yyjson_val_write_buf(buf, buf_size, root, flg, alc_ptr,
+                                dat_len, err);
+}
+
 bool yyjson_val_write_file(const char *path,
                            const yyjson_val *val,
                            yyjson_write_flag flg,
@@ -9556,63 +16490,405 @@ bool yyjson_val_write_file(const char *path,
     yyjson_val *root = constcast(yyjson_val *)val;
     bool suc;
     
-    alc_ptr = alc_ptr ? alc_ptr : &YYJSON_DEFAULT_ALC;
-    err = err ? err : &dummy_err;
-    if (unlikely(!path || !*path)) {
-        err->msg = "input path is invalid";
-        err->code = YYJSON_READ_ERROR_INVALID_PARAMETER;
-        return false;
+    alc_ptr = alc_ptr ? alc_ptr : &YYJSON_DEFAULT_ALC;
+    err = err ? err : &dummy_err;
+    if (unlikely(!path || !*path)) {
+        err->msg = "input path is invalid";
+        err->code = YYJSON_READ_ERROR_INVALID_PARAMETER;
+        return false;
+    }
+    
+    dat = (u8 *)yyjson_val_write_opts(root, flg, alc_ptr, &dat_len, err);
+    if (unlikely(!dat)) return false;
+    suc = write_dat_to_file(path, dat, dat_len, err);
+    alc_ptr->free_(alc_ptr->ctx, dat);
+    return suc;
+}
+
+bool yyjson_val_write_fp(FILE *fp,
+                         const yyjson_val *val,
+                         yyjson_write_flag flg,
+                         const yyjson_alc *alc_ptr,
+                         yyjson_write_err *err) {
+    yyjson_write_err dummy_err;
+    u8 *dat;
+    usize dat_len = 0;
+    yyjson_val *root = constcast(yyjson_val *)val;
+    bool suc;
+    
+    alc_ptr = alc_ptr ? alc_ptr : &YYJSON_DEFAULT_ALC;
+    err = err ? err : &dummy_err;
+    if (unlikely(!fp)) {
+        err->msg = "input fp is invalid";
+        err->code = YYJSON_READ_ERROR_INVALID_PARAMETER;
+        return false;
+    }
+    
+    dat = (u8 *)yyjson_val_write_opts(root, flg, alc_ptr, &dat_len, err);
+    if (unlikely(!dat)) return false;
+    suc = write_dat_to_fp(fp, dat, dat_len, err);
+    alc_ptr->free_(alc_ptr->ctx, dat);
+    return suc;
+}
+
+bool yyjson_write_file(const char *path,
+                       const yyjson_doc *doc,
+                       yyjson_write_flag flg,
+                       const yyjson_alc *alc_ptr,
+                       yyjson_write_err *err) {
+    yyjson_val *root = doc ? doc->root : NULL;
+    return yyjson_val_write_file(path, root, flg, alc_ptr, err);
+}
+
+bool yyjson_write_fp(FILE *fp,
+                    const yyjson_doc *doc,
+                    yyjson_write_flag flg,
+                     const yyjson_alc *alc_ptr,
+                    yyjson_write_err *err) {
+    yyjson_val *root = doc ? doc->root : NULL;
+    return yyjson_val_write_fp(fp, root, flg, alc_ptr, err);
+}
+
+bool yyjson_val_write_stream(yyjson_write_fn fn,
+                             void *ctx,
+                             const yyjson_val *val,
+                             yyjson_write_flag flg,
+                             usize buf_size,
+                             const yyjson_alc *alc_ptr,
+                             yyjson_write_err *err) {
+    yyjson_write_err dummy_err;
+    write_sink sink;
+    u8 *dat;
+    usize dat_len = 0;
+    
+    alc_ptr = alc_ptr ? alc_ptr : &YYJSON_DEFAULT_ALC;
+    err = err ? err : &dummy_err;
+    if (unlikely(!write_sink_init(&sink, fn, ctx, buf_size, err))) {
+        return false;
+    }
+    dat = yyjson_val_write_impl(val, flg, alc_ptr, &sink, &dat_len, err);
+    return write_sink_end(&sink, dat, dat_len, alc_ptr, err);
+}
+
+bool yyjson_write_stream(yyjson_write_fn fn,
+                         void *ctx,
+                         const yyjson_doc *doc,
+                         yyjson_write_flag flg,
+                         usize buf_size,
+                         const yyjson_alc *alc_ptr,
+                         yyjson_write_err *err) {
+    yyjson_val *root = doc ? doc->root : NULL;
+    return yyjson_val_write_stream(fn, ctx, root, flg, buf_size, alc_ptr, err);
+}
+
+bool yyjson_val_write_fd(int fd,
+                         const yyjson_val *val,
+                         yyjson_write_flag flg,
+                         const yyjson_alc *alc_ptr,
+                         yyjson_write_err *err) {
+    yyjson_write_err dummy_err;
+    err = err ? err : &dummy_err;
+    if (unlikely(fd < 0)) {
+        err->msg = "input fd is invalid";
+        err->code = YYJSON_WRITE_ERROR_INVALID_PARAMETER;
+        return false;
+    }
+#if YYJSON_HAS_FD_WRITE
+    return yyjson_val_write_stream(write_dat_to_fd, (void *)&fd, val, flg, 0,
+                                   alc_ptr, err);
+#else
+    (void)val;
+    (void)flg;
+    (void)alc_ptr;
+    err->msg = "file descriptor is not supported";
+    err->code = YYJSON_WRITE_ERROR_FILE_WRITE;
+    return false;
+#endif
+}
+
+bool yyjson_write_fd(int fd,
+                     const yyjson_doc *doc,
+                     yyjson_write_flag flg,
+                     const yyjson_alc *alc_ptr,
+                     yyjson_write_err *err) {
+    yyjson_val *root = doc ? doc->root : NULL;
+    return yyjson_val_write_fd(fd, root, flg, alc_ptr, err);
+}
+
+
+
+/*==============================================================================
+ * JSON Writer (Multi-threaded)
+ *
+ * The children of a large root container are split into parts with about the
+ * same number of values, the boundaries are found in the tape with
+ * `unsafe_yyjson_get_next()`. Each part is written into its own buffer by the
+ * minify or pretty writer as the children of a root container, so the
+ * indentation is the same as the single-threaded writer. Then the brackets
+ * between the parts are replaced with the separators, for example:
+ *
+ *     part 0: "[\n    1,\n    2\n]"  ->  "[\n    1,\n    2,\n"
+ *     part 1: "[\n    3,\n    4\n]"  ->  "    3,\n    4\n]"
+ *
+ * The parts are joined into one buffer concurrently, or passed to the
+ * callback in order.
+ *============================================================================*/
+
+/** A part of the children of the root container. */
+typedef struct write_par_part {
+    const yyjson_val *root; /* the root container */
+    const yyjson_val *val;  /* the first value of this part */
+    usize len;              /* the number of values, keys are counted */
+    yyjson_write_flag flg;  /* the write flags without NEWLINE_AT_END */
+    yyjson_alc alc;         /* the allocator, with a lock if necessary */
+    u8 *hdr;                /* the output buffer, NULL on error */
+    u8 *dat;                /* the output of this part in the buffer */
+    usize dat_len;          /* the output length of this part */
+    u8 *dst;                /* the destination in the joined buffer */
+    yyjson_write_err err;   /* the error of this part */
+} write_par_part;
+
+/** Phase 1: write the values of a part into its own buffer. */
+static void write_parallel_part(void *ptr) {
+    write_par_part *part = (write_par_part *)ptr;
+    yyjson_write_flag flg = part->flg;
+    if (flg & (YYJSON_WRITE_PRETTY | YYJSON_WRITE_PRETTY_TWO_SPACES)) {
+        part->hdr = yyjson_write_pretty(part->root, part->val, part->len,
+                                        flg, part->alc, NULL,
+                                        &part->dat_len, &part->err);
+    } else {
+        part->hdr = yyjson_write_minify(part->root, part->val, part->len,
+                                        flg, part->alc, NULL,
+                                        &part->dat_len, &part->err);
+    }
+}
+
+/** Phase 2: copy the output of a part into the joined buffer. */
+static void write_parallel_copy(void *ptr) {
+    write_par_part *part = (write_par_part *)ptr;
+    memcpy((void *)part->dst, (void *)part->dat, part->dat_len);
+}
+
+/** Write the root container with multiple threads. If the `fn` is NULL, the
+    parts are joined into a new buffer returned in `dat`, otherwise the parts
+    are passed to the callback. Returns false if an error occurs. */
+static bool write_parallel_impl(yyjson_val *root,
+                                yyjson_write_flag flg,
+                                const yyjson_alc *alc_ptr,
+                                usize nthreads,
+                                yyjson_write_fn fn,
+                                void *fn_ctx,
+                                u8 **dat,
+                                usize *dat_len,
+                                yyjson_write_err *err) {
+    
+#define return_err(_code, _msg) do { \
+    err->code = YYJSON_WRITE_ERROR_##_code; \
+    err->msg = _msg; \
+    goto fail; \
+} while (false)
+    
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    write_par_part *parts = NULL, *part;
+    void *mem = NULL;
+    usize mem_len, num, val_num = 0, step, root_len, i, idx, ofs, sep_len;
+    yyjson_val *val;
+    bool is_obj, newline, pretty;
+    u8 *end;
+#if YYJSON_HAS_THREADS
+    locked_alc_ctx locked;
+    bool has_lock = false;
+#endif
+    
+    /* use the single-threaded writer if it's not worth splitting */
+    if (!nthreads) {
+#if YYJSON_HAS_THREADS
+        nthreads = thread_cpu_count();
+#else
+        nthreads = 1;
+#endif
+    }
+    num = 0;
+    /* the canonical writer sorts the keys, it's not split into parts */
+    if (root && unsafe_yyjson_is_ctn(root) && !has_write_flag(CANONICAL)) {
+        val_num = root->uni.ofs / sizeof(yyjson_val);
+        num = yyjson_min(nthreads, val_num / YYJSON_WRITER_PARALLEL_MIN_NUM);
+        num = yyjson_min(num, unsafe_yyjson_get_len(root));
+    }
+    if (num <= 1) {
+        if (fn) {
+            return yyjson_val_write_stream(fn, fn_ctx, root, flg, 0,
+                                           alc_ptr, err);
+        }
+        *dat = yyjson_val_write_impl(root, flg, alc_ptr, NULL, dat_len, err);
+        return *dat != NULL;
+    }
+    
+    /* the parts, and the thread tasks of the parts */
+    mem_len = num * sizeof(write_par_part);
+#if YYJSON_HAS_THREADS
+    mem_len += num * (sizeof(thread_task) + sizeof(bool));
+#endif
+    mem = alc.malloc_(alc.ctx, mem_len);
+    if (unlikely(!mem)) {
+        return_err(MEMORY_ALLOCATION, "memory allocation failed");
+    }
+    memset(mem, 0, mem_len);
+    parts = (write_par_part *)mem;
+    
+    /* the user allocator may not be thread-safe */
+    parts[0].alc = alc;
+#if YYJSON_HAS_THREADS
+    if (alc_ptr) {
+        if (unlikely(!thread_mutex_init(&locked.mtx))) {
+            return_err(MEMORY_ALLOCATION, "memory allocation failed");
+        }
+        has_lock = true;
+        locked.alc = alc;
+        parts[0].alc.malloc_ = locked_malloc;
+        parts[0].alc.realloc_ = locked_realloc;
+        parts[0].alc.free_ = locked_free;
+        parts[0].alc.ctx = (void *)&locked;
+    }
+#endif
+    
+    /* split the children at about the same number of values */
+    is_obj = unsafe_yyjson_is_obj(root);
+    root_len = unsafe_yyjson_get_len(root);
+    step = val_num / num;
+    val = root + 1;
+    parts[0].val = val;
+    for (i = 0, idx = 0, ofs = 0; i < root_len; i++) {
+        val = unsafe_yyjson_get_next(val + is_obj);
+        if ((usize)(val - root) >= step * (idx + 1) &&
+            idx + 1 < num && i + 1 < root_len) {
+            parts[idx].len = (i + 1 - ofs) << is_obj;
+            parts[++idx].val = val;
+            ofs = i + 1;
+        }
+    }
+    parts[idx].len = (root_len - ofs) << is_obj;
+    num = idx + 1;
+    
+    /* phase 1: write the parts */
+    for (i = 0; i < num; i++) {
+        parts[i].root = root;
+        parts[i].flg = flg & ~YYJSON_WRITE_NEWLINE_AT_END;
+        parts[i].alc = parts[0].alc;
+    }
+    thread_run_parts(write_parallel_part, parts, sizeof(write_par_part), num,
+                     (void *)(parts + num));
+    for (i = 0; i < num; i++) {
+        if (unlikely(!parts[i].hdr)) {
+            *err = parts[i].err;
+            goto fail;
+        }
+    }
+    
+    /* replace the brackets between the parts with the separators */
+    pretty = (flg & (YYJSON_WRITE_PRETTY |
+                     YYJSON_WRITE_PRETTY_TWO_SPACES)) != 0;
+    newline = has_write_flag(NEWLINE_AT_END) != 0;
+    sep_len = pretty ? 2 : 1;
+    for (i = 0; i < num; i++) {
+        part = &parts[i];
+        end = part->hdr + part->dat_len;
+        if (i + 1 < num) {
+            /* "\n]" to ",\n" (pretty), or "]" to "," (minify) */
+            *(end - sep_len) = ',';
+            if (pretty) *(end - 1) = '\n';
+        } else if (newline) {
+            *end++ = '\n';
+        }
+        part->dat = part->hdr + (i ? sep_len : 0);
+        part->dat_len = (usize)(end - part->dat);
     }
     
-    dat = (u8 *)yyjson_val_write_opts(root, flg, alc_ptr, &dat_len, err);
-    if (unlikely(!dat)) return false;
-    suc = write_dat_to_file(path, dat, dat_len, err);
-    alc_ptr->free_(alc_ptr->ctx, dat);
-    return suc;
-}
-
-bool yyjson_val_write_fp(FILE *fp,
-                         const yyjson_val *val,
-                         yyjson_write_flag flg,
-                         const yyjson_alc *alc_ptr,
-                         yyjson_write_err *err) {
-    yyjson_write_err dummy_err;
-    u8 *dat;
-    usize dat_len = 0;
-    yyjson_val *root = constcast(yyjson_val *)val;
-    bool suc;
+    if (fn) {
+        /* phase 2: pass the parts to the callback in order */
+        for (i = 0; i < num; i++) {
+            if (unlikely(!fn(fn_ctx, (const char *)parts[i].dat,
+                             parts[i].dat_len))) {
+                return_err(FILE_WRITE, "file writing failed");
+            }
+        }
+    } else {
+        /* phase 2: join the parts concurrently */
+        *dat_len = 0;
+        for (i = 0; i < num; i++) *dat_len += parts[i].dat_len;
+        *dat = (u8 *)alc.malloc_(alc.ctx, *dat_len + 1);
+        if (unlikely(!*dat)) {
+            return_err(MEMORY_ALLOCATION, "memory allocation failed");
+        }
+        for (i = 0, ofs = 0; i < num; i++) {
+            parts[i].dst = *dat + ofs;
+            ofs += parts[i].dat_len;
+        }
+        thread_run_parts(write_parallel_copy, parts, sizeof(write_par_part),
+                         num, (void *)(parts + num));
+        (*dat)[*dat_len] = '\0';
+    }
     
-    alc_ptr = alc_ptr ? alc_ptr : &YYJSON_DEFAULT_ALC;
-    err = err ? err : &dummy_err;
-    if (unlikely(!fp)) {
-        err->msg = "input fp is invalid";
-        err->code = YYJSON_READ_ERROR_INVALID_PARAMETER;
-        return false;
+    for (i = 0; i < num; i++) alc.free_(alc.ctx, parts[i].hdr);
+#if YYJSON_HAS_THREADS
+    if (has_lock) thread_mutex_destroy(&locked.mtx);
+#endif
+    alc.free_(alc.ctx, mem);
+    memset(err, 0, sizeof(yyjson_write_err));
+    return true;
+    
+fail:
+    if (parts) {
+        for (i = 0; i < num; i++) {
+            if (parts[i].hdr) alc.free_(alc.ctx, parts[i].hdr);
+        }
     }
+#if YYJSON_HAS_THREADS
+    if (has_lock) thread_mutex_destroy(&locked.mtx);
+#endif
+    if (mem) alc.free_(alc.ctx, mem);
+    if (dat_len) *dat_len = 0;
+    return false;
     
-    dat = (u8 *)yyjson_val_write_opts(root, flg, alc_ptr, &dat_len, err);
-    if (unlikely(!dat)) return false;
-    suc = write_dat_to_fp(fp, dat, dat_len, err);
-    alc_ptr->free_(alc_ptr->ctx, dat);
-    return suc;
+#undef return_err
 }
 
-bool yyjson_write_file(const char *path,
-                       const yyjson_doc *doc,
-                       yyjson_write_flag flg,
-                       const yyjson_alc *alc_ptr,
-                       yyjson_write_err *err) {
+char *yyjson_write_parallel(const yyjson_doc *doc,
+                            yyjson_write_flag flg,
+                            const yyjson_alc *alc_ptr,
+                            usize nthreads,
+                            usize *dat_len,
+                            yyjson_write_err *err) {
+    yyjson_write_err dummy_err;
+    usize dummy_dat_len;
     yyjson_val *root = doc ? doc->root : NULL;
-    return yyjson_val_write_file(path, root, flg, alc_ptr, err);
+    u8 *dat = NULL;
+    
+    err = err ? err : &dummy_err;
+    dat_len = dat_len ? dat_len : &dummy_dat_len;
+    if (!write_parallel_impl(root, flg, alc_ptr, nthreads, NULL, NULL,
+                             &dat, dat_len, err)) return NULL;
+    return (char *)dat;
 }
 
-bool yyjson_write_fp(FILE *fp,
-                    const yyjson_doc *doc,
-                    yyjson_write_flag flg,
-                     const yyjson_alc *alc_ptr,
-                    yyjson_write_err *err) {
+bool yyjson_write_parallel_stream(yyjson_write_fn fn,
+                                  void *ctx,
+                                  const yyjson_doc *doc,
+                                  yyjson_write_flag flg,
+                                  const yyjson_alc *alc_ptr,
+                                  usize nthreads,
+                                  yyjson_write_err *err) {
+    yyjson_write_err dummy_err;
     yyjson_val *root = doc ? doc->root : NULL;
-    return yyjson_val_write_fp(fp, root, flg, alc_ptr, err);
+    
+    err = err ? err : &dummy_err;
+    if (unlikely(!fn)) {
+        err->msg = "input callback is NULL";
+        err->code = YYJSON_WRITE_ERROR_INVALID_PARAMETER;
+        return false;
+    }
+    return write_parallel_impl(root, flg, alc_ptr, nthreads, fn, ctx,
+                               NULL, NULL, err);
 }
 
 
@@ -9672,6 +16948,7 @@ static_inline u8 *yyjson_mut_write_minify(const yyjson_mut_val *root,
                                           usize estimated_val_num,
                                           yyjson_write_flag flg,
                                           yyjson_alc alc,
+                                          write_sink *sink,
                                           usize *dat_len,
                                           yyjson_write_err *err) {
     
@@ -9685,6 +16962,9 @@ static_inline u8 *yyjson_mut_write_minify(const yyjson_mut_val *root,
     
 #define incr_len(_len) do { \
     ext_len = (usize)(_len); \
+    if (unlikely((u8 *)(cur + ext_len) >= (u8 *)ctx) && sink) { \
+        if (unlikely(!write_sink_flush(sink, hdr, &cur))) goto fail_sink; \
+    } \
     if (unlikely((u8 *)(cur + ext_len) >= (u8 *)ctx)) { \
         usize ctx_pos = (usize)((u8 *)ctx - hdr); \
         usize cur_pos = (usize)(cur - hdr); \
@@ -9725,6 +17005,7 @@ static_inline u8 *yyjson_mut_write_minify(const yyjson_mut_val *root,
     bool newline = has_write_flag(NEWLINE_AT_END) != 0;
     
     alc_len = estimated_val_num * YYJSON_WRITER_ESTIMATED_MINIFY_RATIO + 64;
+    if (sink) alc_len = sink->buf_size;
     alc_len = size_align_up(alc_len, sizeof(yyjson_mut_write_ctx));
     hdr = (u8 *)alc.malloc_(alc.ctx, alc_len);
     if (!hdr) goto fail_alloc;
@@ -9852,6 +17133,8 @@ fail_num:
     return_err(NAN_OR_INF, "nan or inf number is not allowed");
 fail_str:
     return_err(INVALID_STRING, "invalid utf-8 encoding in string");
+fail_sink:
+    return_err(FILE_WRITE, "file writing failed");
     
 #undef return_err
 #undef incr_len
@@ -9864,6 +17147,7 @@ static_inline u8 *yyjson_mut_write_pretty(const yyjson_mut_val *root,
                                           usize estimated_val_num,
                                           yyjson_write_flag flg,
                                           yyjson_alc alc,
+                                          write_sink *sink,
                                           usize *dat_len,
                                           yyjson_write_err *err) {
     
@@ -9877,6 +17161,9 @@ static_inline u8 *yyjson_mut_write_pretty(const yyjson_mut_val *root,
     
 #define incr_len(_len) do { \
     ext_len = (usize)(_len); \
+    if (unlikely((u8 *)(cur + ext_len) >= (u8 *)ctx) && sink) { \
+        if (unlikely(!write_sink_flush(sink, hdr, &cur))) goto fail_sink; \
+    } \
     if (unlikely((u8 *)(cur + ext_len) >= (u8 *)ctx)) { \
         usize ctx_pos = (usize)((u8 *)ctx - hdr); \
         usize cur_pos = (usize)(cur - hdr); \
@@ -9918,6 +17205,7 @@ static_inline u8 *yyjson_mut_write_pretty(const yyjson_mut_val *root,
     bool newline = has_write_flag(NEWLINE_AT_END) != 0;
     
     alc_len = estimated_val_num * YYJSON_WRITER_ESTIMATED_PRETTY_RATIO + 64;
+    if (sink) alc_len = sink->buf_size;
     alc_len = size_align_up(alc_len, sizeof(yyjson_mut_write_ctx));
     hdr = (u8 *)alc.malloc_(alc.ctx, alc_len);
     if (!hdr) goto fail_alloc;
@@ -10070,18 +17358,23 @@ fail_num:
     return_err(NAN_OR_INF, "nan or inf number is not allowed");
 fail_str:
     return_err(INVALID_STRING, "invalid utf-8 encoding in string");
+fail_sink:
+    return_err(FILE_WRITE, "file writing failed");
     
 #undef return_err
 #undef incr_len
 #undef check_str_len
 }
 
-static char *yyjson_mut_write_opts_impl(const yyjson_mut_val *val,
-                                        usize estimated_val_num,
-                                        yyjson_write_flag flg,
-                                        const yyjson_alc *alc_ptr,
-                                        usize *dat_len,
-                                        yyjson_write_err *err) {
+/** Write a value with options. If the sink is not NULL, the output is flushed
+    to the sink when the buffer is full, and the rest is returned. */
+static u8 *yyjson_mut_write_opts_impl(const yyjson_mut_val *val,
+                                      usize estimated_val_num,
+                                      yyjson_write_flag flg,
+                                      const yyjson_alc *alc_ptr,
+                                      write_sink *sink,
+                                      usize *dat_len,
+                                      yyjson_write_err *err) {
     yyjson_write_err dummy_err;
     usize dummy_dat_len;
     yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
@@ -10097,14 +17390,18 @@ static char *yyjson_mut_write_opts_impl(const yyjson_mut_val *val,
         return NULL;
     }
     
+    if (has_write_flag(CANONICAL)) {
+        return yyjson_write_canonical((void *)root, true, estimated_val_num,
+                                      flg, alc, sink, dat_len, err);
+    }
     if (!unsafe_yyjson_is_ctn(root) || unsafe_yyjson_get_len(root) == 0) {
-        return (char *)yyjson_mut_write_single(root, flg, alc, dat_len, err);
+        return yyjson_mut_write_single(root, flg, alc, dat_len, err);
     } else if (flg & (YYJSON_WRITE_PRETTY | YYJSON_WRITE_PRETTY_TWO_SPACES)) {
-        return (char *)yyjson_mut_write_pretty(root, estimated_val_num,
-                                               flg, alc, dat_len, err);
+        return yyjson_mut_write_pretty(root, estimated_val_num,
+                                       flg, alc, sink, dat_len, err);
     } else {
-        return (char *)yyjson_mut_write_minify(root, estimated_val_num,
-                                               flg, alc, dat_len, err);
+        return yyjson_mut_write_minify(root, estimated_val_num,
+                                       flg, alc, sink, dat_len, err);
     }
 }
 
@@ -10113,7 +17410,8 @@ char *yyjson_mut_val_write_opts(const yyjson_mut_val *val,
                                 const yyjson_alc *alc_ptr,
                                 usize *dat_len,
                                 yyjson_write_err *err) {
-    return yyjson_mut_write_opts_impl(val, 0, flg, alc_ptr, dat_len, err);
+    return (char *)yyjson_mut_write_opts_impl(val, 0, flg, alc_ptr, NULL,
+                                              dat_len, err);
 }
 
 char *yyjson_mut_write_opts(const yyjson_mut_doc *doc,
@@ -10130,8 +17428,65 @@ char *yyjson_mut_write_opts(const yyjson_mut_doc *doc,
         root = NULL;
         estimated_val_num = 0;
     }
-    return yyjson_mut_write_opts_impl(root, estimated_val_num,
-                                      flg, alc_ptr, dat_len, err);
+    return (char *)yyjson_mut_write_opts_impl(root, estimated_val_num,
+                                              flg, alc_ptr, NULL, dat_len, err);
+}
+
+/** Write a mutable value to a reusable buffer. */
+static bool yyjson_mut_write_buf_impl(char **buf,
+                                      usize *buf_size,
+                                      const yyjson_mut_val *val,
+                                      usize estimated_val_num,
+                                      yyjson_write_flag flg,
+                                      const yyjson_alc *alc_ptr,
+                                      usize *dat_len,
+                                      yyjson_write_err *err) {
+    yyjson_write_err dummy_err;
+    write_buf_ctx ctx;
+    yyjson_alc alc;
+    u8 *dat;
+    
+    err = err ? err : &dummy_err;
+    if (unlikely(!write_buf_init(&ctx, &alc, buf, buf_size, alc_ptr, err))) {
+        if (dat_len) *dat_len = 0;
+        return false;
+    }
+    dat = yyjson_mut_write_opts_impl(val, estimated_val_num, flg, &alc, NULL,
+                                     dat_len, err);
+    *buf = (char *)ctx.buf;
+    *buf_size = ctx.size;
+    return dat != NULL;
+}
+
+bool yyjson_mut_val_write_buf(char **buf,
+                              usize *buf_size,
+                              const yyjson_mut_val *val,
+                              yyjson_write_flag flg,
+                              const yyjson_alc *alc_ptr,
+                              usize *dat_len,
+                              yyjson_write_err *err) {
+    return yyjson_mut_write_buf_impl(buf, buf_size, val, 0, flg, alc_ptr,
+                                     dat_len, err);
+}
+
+bool yyjson_mut_write_buf(char **buf,
+                          usize *buf_size,
+                          const yyjson_mut_doc *doc,
+                          yyjson_write_flag flg,
+                          const yyjson_alc *alc_ptr,
+                          usize *dat_len,
+                          yyjson_write_err *err) {
+    yyjson_mut_val *root;
+    usize estimated_val_num;
+    if (likely(doc)) {
+        root = doc->root;
+        estimated_val_num = yyjson_mut_doc_estimated_val_num(doc);
+    } else {
+        root = NULL;
+        estimated_val_num = 0;
+    }
+    return yyjson_mut_write_buf_impl(buf, buf_size, root, estimated_val_num,
+                                     flg, alc_ptr, dat_len, err);
 }
 
 bool yyjson_mut_val_write_file(const char *path,
@@ -10204,4 +17559,478 @@ bool yyjson_mut_write_fp(FILE *fp,
     return yyjson_mut_val_write_fp(fp, root, flg, alc_ptr, err);
 }
 
+bool yyjson_mut_val_write_stream(yyjson_write_fn fn,
+                                 void *ctx,
+                                 const yyjson_mut_val *val,
+                                 yyjson_write_flag flg,
+                                 usize buf_size,
+                                 const yyjson_alc *alc_ptr,
+                                 yyjson_write_err *err) {
+    yyjson_write_err dummy_err;
+    write_sink sink;
+    u8 *dat;
+    usize dat_len = 0;
+    
+    alc_ptr = alc_ptr ? alc_ptr : &YYJSON_DEFAULT_ALC;
+    err = err ? err : &dummy_err;
+    if (unlikely(!write_sink_init(&sink, fn, ctx, buf_size, err))) {
+        return false;
+    }
+    dat = yyjson_mut_write_opts_impl(val, 0, flg, alc_ptr, &sink,
+                                     &dat_len, err);
+    return write_sink_end(&sink, dat, dat_len, alc_ptr, err);
+}
+
+bool yyjson_mut_write_stream(yyjson_write_fn fn,
+                             void *ctx,
+                             const yyjson_mut_doc *doc,
+                             yyjson_write_flag flg,
+                             usize buf_size,
+                             const yyjson_alc *alc_ptr,
+                             yyjson_write_err *err) {
+    yyjson_mut_val *root = doc ? doc->root : NULL;
+    return yyjson_mut_val_write_stream(fn, ctx, root, flg, buf_size,
+                                       alc_ptr, err);
+}
+
+bool yyjson_mut_val_write_fd(int fd,
+                             const yyjson_mut_val *val,
+                             yyjson_write_flag flg,
+                             const yyjson_alc *alc_ptr,
+                             yyjson_write_err *err) {
+    yyjson_write_err dummy_err;
+    err = err ? err : &dummy_err;
+    if (unlikely(fd < 0)) {
+        err->msg = "input fd is invalid";
+        err->code = YYJSON_WRITE_ERROR_INVALID_PARAMETER;
+        return false;
+    }
+#if YYJSON_HAS_FD_WRITE
+    return yyjson_mut_val_write_stream(write_dat_to_fd, (void *)&fd, val, flg,
+                                       0, alc_ptr, err);
+#else
+    (void)val;
+    (void)flg;
+    (void)alc_ptr;
+    err->msg = "file descriptor is not supported";
+    err->code = YYJSON_WRITE_ERROR_FILE_WRITE;
+    return false;
+#endif
+}
+
+bool yyjson_mut_write_fd(int fd,
+                         const yyjson_mut_doc *doc,
+                         yyjson_write_flag flg,
+                         const yyjson_alc *alc_ptr,
+                         yyjson_write_err *err) {
+    yyjson_mut_val *root = doc ? doc->root : NULL;
+    return yyjson_mut_val_write_fd(fd, root, flg, alc_ptr, err);
+}
+
+
+
+/*==============================================================================
+ * JSON Incremental Writer
+ *============================================================================*/
+
+/* The state of a container in the incremental writer. */
+#define WRITER_CTN_OBJ  0x01 /* the container is an object */
+#define WRITER_CTN_KEY  0x02 /* a key is written, a value is expected */
+#define WRITER_CTN_ITEM 0x04 /* the container is not empty */
+
+/* The initial buffer size of the non-streaming incremental writer. */
+#define WRITER_INIT_BUF_SIZE 0x100
+
+/* The initial stack size of the incremental writer. */
+#define WRITER_INIT_STK_SIZE 0x10
+
+struct yyjson_writer {
+    yyjson_alc alc;             /* the memory allocator */
+    yyjson_write_flag flg;      /* the write options */
+    write_sink sink;            /* the output callback, or NULL fn */
+    u8 *hdr;                    /* the output buffer */
+    u8 *cur;                    /* the output cursor */
+    u8 *end;                    /* the end of the output buffer */
+    u8 *stk;                    /* the state of each open container */
+    usize stk_len;              /* the number of open containers */
+    usize stk_cap;              /* the capacity of the stack */
+    const char_enc_type *enc_table; /* the string encoding table */
+    bool esc;                   /* escape unicode */
+    bool inv;                   /* allow invalid unicode */
+    usize spaces;               /* the indent spaces, 0 for minify */
+    bool has_root;              /* the root value is written */
+    bool finished;              /* the output is completed */
+    yyjson_write_err err;       /* the first error */
+};
+
+/** Record the first error of the writer, always returns false. */
+static_noinline bool writer_fail(yyjson_writer *w, yyjson_write_code code,
+                                 const char *msg) {
+    if (!w->err.code) {
+        w->err.code = code;
+        w->err.msg = msg;
+    }
+    return false;
+}
+
+/** Flush the output to the callback or grow the buffer, so that at least
+    `len` bytes are available. Returns false on error. */
+static_noinline bool writer_grow(yyjson_writer *w, usize len) {
+    usize cur_len = (usize)(w->cur - w->hdr);
+    usize alc_len = (usize)(w->end - w->hdr);
+    usize alc_inc;
+    u8 *tmp;
+    
+    if (w->sink.fn && cur_len) {
+        if (!w->sink.fn(w->sink.ctx, (const char *)w->hdr, cur_len)) {
+            return writer_fail(w, YYJSON_WRITE_ERROR_FILE_WRITE,
+                               "file writing failed");
+        }
+        w->cur = w->hdr;
+        cur_len = 0;
+        if (len < alc_len) return true;
+    }
+    alc_inc = yyjson_max(alc_len / 2, len);
+    if ((sizeof(usize) < 8) && size_add_is_overflow(alc_len, alc_inc))
+        goto fail_alloc;
+    tmp = (u8 *)w->alc.realloc_(w->alc.ctx, w->hdr, alc_len,
+                                alc_len + alc_inc);
+    if (unlikely(!tmp)) goto fail_alloc;
+    w->hdr = tmp;
+    w->cur = tmp + cur_len;
+    w->end = tmp + alc_len + alc_inc;
+    return true;
+    
+fail_alloc:
+    return writer_fail(w, YYJSON_WRITE_ERROR_MEMORY_ALLOCATION,
+                       "memory allocation failed");
+}
+
+/** Make sure at least `len` bytes are available in the buffer.
+    Returns false on error. */
+static_inline bool writer_reserve(yyjson_writer *w, usize len) {
+    if (likely(len < (usize)(w->end - w->cur))) return true;
+    return writer_grow(w, len);
+}
+
+/** Check the call sequence, reserve `len` bytes plus the separator and the
+    indent, and write the separator and the indent of the next key or value.
+    Returns false on error. */
+static_inline bool writer_begin(yyjson_writer *w, usize len, bool is_key) {
+    u8 *st, *cur;
+    usize level = w->stk_len;
+    
+    if (unlikely(w->err.code)) return false;
+    if (level == 0) {
+        if (unlikely(is_key)) goto fail_key;
+        if (unlikely(w->has_root)) {
+            return writer_fail(w, YYJSON_WRITE_ERROR_INVALID_PARAMETER,
+                               "unexpected value after the root value");
+        }
+        w->has_root = true;
+        return writer_reserve(w, len);
+    }
+    
+    st = w->stk + level - 1;
+    if (*st & WRITER_CTN_OBJ) {
+        if (unlikely(is_key != !(*st & WRITER_CTN_KEY))) {
+            if (is_key) goto fail_key;
+            return writer_fail(w, YYJSON_WRITE_ERROR_INVALID_PARAMETER,
+                               "unexpected value, a key is expected");
+        }
+        *st = (u8)(*st ^ WRITER_CTN_KEY);
+        /* the separator of a value is written after the key */
+        if (!is_key) return writer_reserve(w, len);
+    } else if (unlikely(is_key)) {
+        goto fail_key;
+    }
+    
+    if (unlikely(!writer_reserve(w, len + level * 4 + 2))) return false;
+    cur = w->cur;
+    if (*st & WRITER_CTN_ITEM) *cur++ = ',';
+    *st |= WRITER_CTN_ITEM;
+    if (w->spaces) {
+        *cur++ = '\n';
+        cur = write_indent(cur, level, w->spaces);
+    }
+    w->cur = cur;
+    return true;
+    
+fail_key:
+    return writer_fail(w, YYJSON_WRITE_ERROR_INVALID_PARAMETER,
+                       "unexpected key, a value is expected");
+}
+
+/** Write a string or a key. Returns false on error. */
+static_inline bool writer_str(yyjson_writer *w, const char *str, usize len,
+                              bool is_key) {
+    u8 *cur;
+    
+    if (unlikely(!str)) {
+        return writer_fail(w, YYJSON_WRITE_ERROR_INVALID_PARAMETER,
+                           "input string is NULL");
+    }
+    if ((sizeof(usize) < 8) && (len >= (USIZE_MAX - 16) / 6)) {
+        return writer_fail(w, YYJSON_WRITE_ERROR_MEMORY_ALLOCATION,
+                           "memory allocation failed");
+    }
+    if (unlikely(!writer_begin(w, len * 6 + 16, is_key))) return false;
+    cur = write_string(w->cur, w->esc, w->inv, (const u8 *)str, len,
+                       w->enc_table);
+    if (unlikely(!cur)) {
+        return writer_fail(w, YYJSON_WRITE_ERROR_INVALID_STRING,
+                           "invalid utf-8 encoding in string");
+    }
+    if (is_key) {
+        *cur++ = ':';
+        if (w->spaces) *cur++ = ' ';
+    }
+    w->cur = cur;
+    return true;
+}
+
+/** Write a number. Returns false on error. */
+static_inline bool writer_num(yyjson_writer *w, yyjson_val *val) {
+    u8 *cur;
+    
+    if (unlikely(!writer_begin(w, FP_BUF_LEN, false))) return false;
+    cur = write_number(w->cur, val, w->flg);
+    if (unlikely(!cur)) {
+        return writer_fail(w, YYJSON_WRITE_ERROR_NAN_OR_INF,
+                           "nan or inf number is not allowed");
+    }
+    w->cur = cur;
+    return true;
+}
+
+/** Begin a container. Returns false on error. */
+static_inline bool writer_ctn_begin(yyjson_writer *w, bool is_obj) {
+    u8 *tmp;
+    usize cap;
+    
+    if (unlikely(!w)) return false;
+    if (unlikely(!writer_begin(w, 2, false))) return false;
+    if (unlikely(w->stk_len == w->stk_cap)) {
+        cap = w->stk_cap * 2;
+        tmp = (u8 *)w->alc.realloc_(w->alc.ctx, w->stk, w->stk_cap, cap);
+        if (unlikely(!tmp)) {
+            return writer_fail(w, YYJSON_WRITE_ERROR_MEMORY_ALLOCATION,
+                               "memory allocation failed");
+        }
+        w->stk = tmp;
+        w->stk_cap = cap;
+    }
+    w->stk[w->stk_len++] = (u8)(is_obj ? WRITER_CTN_OBJ : 0);
+    *w->cur++ = (u8)('[' | ((u8)is_obj << 5));
+    return true;
+}
+
+/** End a container. Returns false on error. */
+static_inline bool writer_ctn_end(yyjson_writer *w, bool is_obj) {
+    u8 st, *cur;
+    usize level;
+    
+    if (unlikely(!w)) return false;
+    if (unlikely(w->err.code)) return false;
+    level = w->stk_len;
+    if (unlikely(level == 0 ||
+                 (w->stk[level - 1] & WRITER_CTN_OBJ) != (u8)is_obj)) {
+        return writer_fail(w, YYJSON_WRITE_ERROR_INVALID_PARAMETER,
+                           is_obj ? "unexpected end of object" :
+                                    "unexpected end of array");
+    }
+    st = w->stk[level - 1];
+    if (unlikely(st & WRITER_CTN_KEY)) {
+        return writer_fail(w, YYJSON_WRITE_ERROR_INVALID_PARAMETER,
+                           "unexpected end of object, a value is expected");
+    }
+    if (unlikely(!writer_reserve(w, level * 4 + 2))) return false;
+    level--;
+    cur = w->cur;
+    if (w->spaces && (st & WRITER_CTN_ITEM)) {
+        *cur++ = '\n';
+        cur = write_indent(cur, level, w->spaces);
+    }
+    *cur++ = (u8)(']' | ((u8)is_obj << 5));
+    w->cur = cur;
+    w->stk_len = level;
+    return true;
+}
+
+/** Create a writer, the output is passed to the sink if it's not NULL. */
+static yyjson_writer *writer_new(const write_sink *sink,
+                                 yyjson_write_flag flg,
+                                 const yyjson_alc *alc_ptr) {
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    usize buf_size = sink ? sink->buf_size : WRITER_INIT_BUF_SIZE;
+    yyjson_writer *w;
+    
+    if (unlikely(has_write_flag(CANONICAL))) return NULL;
+    w = (yyjson_writer *)alc.malloc_(alc.ctx, sizeof(yyjson_writer));
+    if (unlikely(!w)) return NULL;
+    memset(w, 0, sizeof(yyjson_writer));
+    w->hdr = (u8 *)alc.malloc_(alc.ctx, buf_size);
+    w->stk = (u8 *)alc.malloc_(alc.ctx, WRITER_INIT_STK_SIZE);
+    if (unlikely(!w->hdr || !w->stk)) {
+        if (w->hdr) alc.free_(alc.ctx, w->hdr);
+        if (w->stk) alc.free_(alc.ctx, w->stk);
+        alc.free_(alc.ctx, w);
+        return NULL;
+    }
+    w->alc = alc;
+    w->flg = flg;
+    if (sink) w->sink = *sink;
+    w->cur = w->hdr;
+    w->end = w->hdr + buf_size;
+    w->stk_cap = WRITER_INIT_STK_SIZE;
+    w->enc_table = get_enc_table_with_flag(flg);
+    w->esc = has_write_flag(ESCAPE_UNICODE) != 0;
+    w->inv = has_write_flag(ALLOW_INVALID_UNICODE) != 0;
+    if (flg & (YYJSON_WRITE_PRETTY | YYJSON_WRITE_PRETTY_TWO_SPACES)) {
+        w->spaces = has_write_flag(PRETTY_TWO_SPACES) ? 2 : 4;
+    }
+    return w;
+}
+
+yyjson_writer *yyjson_writer_new(yyjson_write_flag flg,
+                                 const yyjson_alc *alc_ptr) {
+    return writer_new(NULL, flg, alc_ptr);
+}
+
+yyjson_writer *yyjson_writer_new_stream(yyjson_write_fn fn,
+                                        void *ctx,
+                                        yyjson_write_flag flg,
+                                        usize buf_size,
+                                        const yyjson_alc *alc_ptr) {
+    yyjson_write_err err;
+    write_sink sink;
+    if (unlikely(!write_sink_init(&sink, fn, ctx, buf_size, &err))) {
+        return NULL;
+    }
+    return writer_new(&sink, flg, alc_ptr);
+}
+
+void yyjson_writer_free(yyjson_writer *w) {
+    if (!w) return;
+    w->alc.free_(w->alc.ctx, w->hdr);
+    w->alc.free_(w->alc.ctx, w->stk);
+    w->alc.free_(w->alc.ctx, w);
+}
+
+bool yyjson_writer_finish(yyjson_writer *w, yyjson_write_err *err) {
+    yyjson_write_err dummy_err;
+    yyjson_write_flag flg;
+    err = err ? err : &dummy_err;
+    
+    if (unlikely(!w)) {
+        err->msg = "input writer is NULL";
+        err->code = YYJSON_WRITE_ERROR_INVALID_PARAMETER;
+        return false;
+    }
+    if (!w->err.code && !w->finished) {
+        if (unlikely(w->stk_len || !w->has_root)) {
+            writer_fail(w, YYJSON_WRITE_ERROR_INVALID_PARAMETER,
+                        "incomplete JSON document");
+        } else if (likely(writer_reserve(w, 2))) {
+            flg = w->flg;
+            if (has_write_flag(NEWLINE_AT_END)) *w->cur++ = '\n';
+            if (w->sink.fn && w->cur > w->hdr) writer_grow(w, 0);
+            *w->cur = '\0';
+            w->finished = !w->err.code;
+        }
+    }
+    *err = w->err;
+    return !w->err.code;
+}
+
+const char *yyjson_writer_get_str(yyjson_writer *w, usize *len) {
+    if (unlikely(!w || w->sink.fn || !w->finished)) {
+        if (len) *len = 0;
+        return NULL;
+    }
+    if (len) *len = (usize)(w->cur - w->hdr);
+    return (const char *)w->hdr;
+}
+
+bool yyjson_writer_begin_arr(yyjson_writer *w) {
+    return writer_ctn_begin(w, false);
+}
+
+bool yyjson_writer_end_arr(yyjson_writer *w) {
+    return writer_ctn_end(w, false);
+}
+
+bool yyjson_writer_begin_obj(yyjson_writer *w) {
+    return writer_ctn_begin(w, true);
+}
+
+bool yyjson_writer_end_obj(yyjson_writer *w) {
+    return writer_ctn_end(w, true);
+}
+
+bool yyjson_writer_keyn(yyjson_writer *w, const char *key, usize len) {
+    if (unlikely(!w)) return false;
+    return writer_str(w, key, len, true);
+}
+
+bool yyjson_writer_null(yyjson_writer *w) {
+    if (unlikely(!w)) return false;
+    if (unlikely(!writer_begin(w, 8, false))) return false;
+    w->cur = write_null(w->cur);
+    return true;
+}
+
+bool yyjson_writer_bool(yyjson_writer *w, bool val) {
+    if (unlikely(!w)) return false;
+    if (unlikely(!writer_begin(w, 8, false))) return false;
+    w->cur = write_bool(w->cur, val);
+    return true;
+}
+
+bool yyjson_writer_uint(yyjson_writer *w, u64 num) {
+    yyjson_val val;
+    if (unlikely(!w)) return false;
+    val.tag = YYJSON_TYPE_NUM | YYJSON_SUBTYPE_UINT;
+    val.uni.u64 = num;
+    return writer_num(w, &val);
+}
+
+bool yyjson_writer_sint(yyjson_writer *w, i64 num) {
+    yyjson_val val;
+    if (unlikely(!w)) return false;
+    val.tag = YYJSON_TYPE_NUM | YYJSON_SUBTYPE_SINT;
+    val.uni.i64 = num;
+    return writer_num(w, &val);
+}
+
+bool yyjson_writer_real(yyjson_writer *w, f64 num) {
+    yyjson_val val;
+    if (unlikely(!w)) return false;
+    val.tag = YYJSON_TYPE_NUM | YYJSON_SUBTYPE_REAL;
+    val.uni.f64 = num;
+    return writer_num(w, &val);
+}
+
+bool yyjson_writer_strn(yyjson_writer *w, const char *str, usize len) {
+    if (unlikely(!w)) return false;
+    return writer_str(w, str, len, false);
+}
+
+bool yyjson_writer_rawn(yyjson_writer *w, const char *raw, usize len) {
+    if (unlikely(!w)) return false;
+    if (unlikely(!raw)) {
+        return writer_fail(w, YYJSON_WRITE_ERROR_INVALID_PARAMETER,
+                           "input raw is NULL");
+    }
+    if (unlikely(!writer_begin(w, len + 2, false))) return false;
+    w->cur = write_raw(w->cur, (const u8 *)raw, len);
+    return true;
+}
+
+#undef WRITER_CTN_OBJ
+#undef WRITER_CTN_KEY
+#undef WRITER_CTN_ITEM
+#undef WRITER_INIT_BUF_SIZE
+#undef WRITER_INIT_STK_SIZE
+
 #endif /* YYJSON_DISABLE_WRITER */
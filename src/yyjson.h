@@ -55,6 +55,17 @@
     - yyjson_read()
     - yyjson_read_opts()
     - yyjson_read_file()
+    - yyjson_read_parallel()
+    - yyjson_incr_new()
+    - yyjson_incr_read()
+    - yyjson_incr_free()
+    - yyjson_lines_new()
+    - yyjson_lines_new_fp()
+    - yyjson_lines_read()
+    - yyjson_lines_read_batch()
+    - yyjson_lines_free()
+    - yyjson_lazy_read() and the other yyjson_lazy_*() functions
+    - yyjson_read_select()
     - yyjson_read_number()
     - yyjson_mut_read_number()
  
@@ -97,6 +108,7 @@
     - yyjson_mut_patch()
     - yyjson_merge_patch()
     - yyjson_mut_merge_patch()
+    - yyjson_read_select()
  */
 #ifndef YYJSON_DISABLE_UTILS
 #endif
@@ -153,6 +165,27 @@
 #ifndef YYJSON_DISABLE_UTF8_VALIDATION
 #endif
 
+/*
+ Define as 1 to disable SIMD acceleration at compile-time.
+ 
+ By default, yyjson uses SSE2 on x86-64 and NEON on AArch64 to scan long
+ strings in blocks, and selects AVX2 or AVX-512 kernels at run-time if the CPU
+ supports them (GCC and Clang only). This flag falls back to the portable scalar
+ code, which may be useful for debugging or for exotic toolchains.
+ */
+#ifndef YYJSON_DISABLE_SIMD
+#endif
+
+/*
+ Define as 1 to disable multi-threading support at compile-time.
+ 
+ By default, `yyjson_read_parallel()` uses POSIX threads or Windows threads to
+ read large documents. This flag makes it read on the calling thread only, which
+ may be useful for platforms without thread support.
+ */
+#ifndef YYJSON_DISABLE_THREADS
+#endif
+
 /*
  Define as 1 to indicate that the target architecture does not support unaligned
  memory access. Please refer to the comments in the C file for details.
@@ -808,6 +841,35 @@ static const yyjson_read_flag YYJSON_READ_ALLOW_INVALID_UNICODE = 1 << 6;
     The flag will be overridden by `YYJSON_READ_NUMBER_AS_RAW` flag. */
 static const yyjson_read_flag YYJSON_READ_BIGNUM_AS_RAW         = 1 << 7;
 
+/** Read JSON with the two-stage structural index reader: the first stage
+    builds an index of the structural characters with SIMD, the second stage
+    builds the document from the index. The result is the same as the default
+    reader. This may be faster for pretty-printed documents, but slower for
+    minified documents, you should benchmark it with your own data.
+    This flag is ignored for documents with a non-container root, larger than
+    4GB, or read with `YYJSON_READ_ALLOW_COMMENTS`. */
+static const yyjson_read_flag YYJSON_READ_STRUCTURAL_INDEX      = 1 << 8;
+
+/** Read the file with memory mapping in `yyjson_read_file()`, instead of
+    reading the whole file into an allocated buffer. The file is mapped with
+    private copy-on-write pages and read in place, only the pages modified by
+    the reader (e.g. the pages with strings) take extra memory. The mapping is
+    kept until the document is freed, and the file should not be truncated
+    while it's mapped. `yyjson_compact_load_binary()` maps the snapshot file
+    with read-only shared pages.
+    This flag is ignored by other functions, or if the file cannot be mapped
+    (e.g. a pipe, or the platform doesn't support `mmap()`), and the file is
+    read into memory as usual. */
+static const yyjson_read_flag YYJSON_READ_MMAP                  = 1 << 9;
+
+/** Build a hash index of the keys of the large objects (32 keys or more), so
+    the keys of these objects can be found in constant time with
+    `yyjson_doc_obj_get()` and `yyjson_doc_obj_getn()`. The index takes 8 bytes
+    per key (with a load factor of 0.5), and is freed with the document.
+    This flag is ignored by the incremental and lines readers, or if the
+    document has more than 4G values. */
+static const yyjson_read_flag YYJSON_READ_KEY_INDEX             = 1 << 10;
+
 
 
 /** Result code for JSON reader. */
@@ -855,6 +917,9 @@ static const yyjson_read_code YYJSON_READ_ERROR_FILE_OPEN               = 12;
 /** Failed to read a file. */
 static const yyjson_read_code YYJSON_READ_ERROR_FILE_READ               = 13;
 
+/** Incomplete input data for incremental reading, more data is required. */
+static const yyjson_read_code YYJSON_READ_ERROR_MORE                    = 14;
+
 /** Error information for JSON reader. */
 typedef struct yyjson_read_err {
     /** Error code, see `yyjson_read_code` for all possible values. */
@@ -909,6 +974,7 @@ yyjson_api yyjson_doc *yyjson_read_opts(char *dat,
     If this path is NULL or invalid, the function will fail and return NULL.
  @param flg The JSON read options.
     Multiple options can be combined with `|` operator. 0 means no options.
+    Use `YYJSON_READ_MMAP` to read the file with memory mapping.
  @param alc The memory allocator used by JSON reader.
     Pass NULL to use the libc's default allocator.
  @param err A pointer to receive error information.
@@ -945,6 +1011,211 @@ yyjson_api yyjson_doc *yyjson_read_fp(FILE *fp,
                                       const yyjson_alc *alc,
                                       yyjson_read_err *err);
 
+/**
+ Read JSON with options using multiple threads.
+ 
+ The document is split into parts at the commas of the root container, the
+ parts are read concurrently and then joined into one document. The result
+ is the same as `yyjson_read_opts()`. The input is read on the calling thread
+ only if it's small (less than about 1MB per thread), the root is not an array
+ or object, or the flag `YYJSON_READ_ALLOW_COMMENTS` is used.
+ 
+ This function is thread-safe when:
+ 1. The `dat` is not modified by other threads.
+ 2. The `alc` is thread-safe or NULL.
+ 
+ @param dat The JSON data (UTF-8 without BOM), null-terminator is not required.
+    If this parameter is NULL, the function will fail and return NULL.
+ @param len The length of JSON data in bytes.
+    If this parameter is 0, the function will fail and return NULL.
+ @param flg The JSON read options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used by JSON reader.
+    Pass NULL to use the libc's default allocator.
+    The allocator is called with a lock, but a pool allocator is not suitable
+    for this function, as the parts are read into temporary buffers first.
+ @param nthreads The maximum number of threads, including the calling thread.
+    Pass 0 to use the number of online processors.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return A new JSON document, or NULL if an error occurs.
+    When it's no longer needed, it should be freed with `yyjson_doc_free()`.
+ */
+yyjson_api yyjson_doc *yyjson_read_parallel(char *dat,
+                                            size_t len,
+                                            yyjson_read_flag flg,
+                                            const yyjson_alc *alc,
+                                            size_t nthreads,
+                                            yyjson_read_err *err);
+
+/**
+ The state of an incremental JSON reader, see `yyjson_incr_new()`.
+ */
+typedef struct yyjson_incr_state yyjson_incr_state;
+
+/**
+ Creates a state for reading JSON incrementally, for example, from a socket
+ that delivers the data in chunks.
+ 
+ The chunks are passed to `yyjson_incr_read()` one by one. The reader keeps
+ the parsing state (such as the container stack and the position in an
+ unfinished string) between calls, so the data is not parsed again, except
+ for a number or literal that is split between chunks.
+ 
+ @param flg The JSON read options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+    The `YYJSON_READ_INSITU` flag is ignored, the data is copied into a buffer
+    owned by the state.
+ @param alc The memory allocator used by JSON reader.
+    Pass NULL to use the libc's default allocator.
+ @return A new state, or NULL if memory allocation failed.
+    When it's no longer needed, it should be freed with `yyjson_incr_free()`.
+ */
+yyjson_api yyjson_incr_state *yyjson_incr_new(yyjson_read_flag flg,
+                                              const yyjson_alc *alc);
+
+/**
+ Reads the next chunk of JSON data incrementally.
+ 
+ If the data read so far is not a complete JSON document, this function
+ returns NULL with the error code `YYJSON_READ_ERROR_MORE`, and the next chunk
+ should be passed in. Call this function with a zero `len` to mark the end of
+ input, the document is completed or an error is reported then.
+ 
+ The document is returned as soon as the root value is complete. The data
+ after the root value in the same chunk is checked in the same way as
+ `yyjson_read_opts()`, but the later chunks are not read. After a document is
+ returned or an error other than `YYJSON_READ_ERROR_MORE` occurs, the state
+ is finished and should be freed.
+ 
+ @param state The state created by `yyjson_incr_new()`.
+ @param dat The next chunk of JSON data, it's copied and may be reused
+    after the call. Pass NULL or a zero `len` to mark the end of input.
+ @param len The length of the chunk in bytes.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return A new JSON document, or NULL if more data is required or an error
+    occurs. When it's no longer needed, it should be freed with
+    `yyjson_doc_free()`.
+ */
+yyjson_api yyjson_doc *yyjson_incr_read(yyjson_incr_state *state,
+                                        const char *dat,
+                                        size_t len,
+                                        yyjson_read_err *err);
+
+/**
+ Release the state of an incremental JSON reader.
+ @param state The state created by `yyjson_incr_new()`. NULL is ignored.
+ */
+yyjson_api void yyjson_incr_free(yyjson_incr_state *state);
+
+/**
+ A reader of newline-delimited JSON (NDJSON, JSON Lines), see
+ `yyjson_lines_new()`.
+ */
+typedef struct yyjson_lines_reader yyjson_lines_reader;
+
+/**
+ Creates a reader for newline-delimited JSON, each line is a JSON document.
+ 
+ The lines are read with `yyjson_lines_read()` or `yyjson_lines_read_batch()`.
+ Each line is copied into a buffer owned by the reader, and the document is
+ allocated on the same buffer, which is reused for the following lines. So
+ there's no memory allocation per line, unless a line is longer than all the
+ lines before it.
+ 
+ The line feed `\n` separates the lines, and a `\r` before it is read as a
+ whitespace. Blank lines (and lines with only comments if the flag
+ `YYJSON_READ_ALLOW_COMMENTS` is used) are skipped. A value spanning multiple
+ lines is reported as an error.
+ 
+ @param dat The data of JSON lines (UTF-8 without BOM), it's not copied and
+    should be valid until the reader is freed.
+ @param len The length of data in bytes.
+ @param flg The JSON read options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+    The `YYJSON_READ_INSITU` and `YYJSON_READ_STOP_WHEN_DONE` flags are
+    ignored.
+ @param alc The memory allocator used by the reader.
+    Pass NULL to use the libc's default allocator.
+ @return A new reader, or NULL if an error occurs.
+    When it's no longer needed, it should be freed with `yyjson_lines_free()`.
+ */
+yyjson_api yyjson_lines_reader *yyjson_lines_new(const char *dat,
+                                                 size_t len,
+                                                 yyjson_read_flag flg,
+                                                 const yyjson_alc *alc);
+
+/**
+ Creates a reader for newline-delimited JSON from a file pointer.
+ 
+ The data is read from the current position of the file, using a buffer that
+ grows to hold the longest line. See `yyjson_lines_new()` for details.
+ 
+ @param fp The file pointer, it should be valid until the reader is freed.
+    The file is not closed by the reader.
+ @param flg The JSON read options, see `yyjson_lines_new()`.
+ @param alc The memory allocator used by the reader.
+    Pass NULL to use the libc's default allocator.
+ @return A new reader, or NULL if an error occurs.
+    When it's no longer needed, it should be freed with `yyjson_lines_free()`.
+ */
+yyjson_api yyjson_lines_reader *yyjson_lines_new_fp(FILE *fp,
+                                                    yyjson_read_flag flg,
+                                                    const yyjson_alc *alc);
+
+/**
+ Reads the next line as a JSON document.
+ 
+ @param rd The reader created by `yyjson_lines_new()`.
+ @param err A pointer to receive error information. The error position is
+    the byte offset in the whole input.
+    Pass NULL if you don't need error information.
+ @return The document of the next line, or NULL if there's no more line
+    (the error code is `YYJSON_READ_SUCCESS`) or an error occurs. An invalid
+    line is skipped, so reading can continue with the following lines.
+ 
+ @warning The document is owned by the reader, it's valid until the next call
+    to this reader and should not be freed.
+ */
+yyjson_api yyjson_doc *yyjson_lines_read(yyjson_lines_reader *rd,
+                                         yyjson_read_err *err);
+
+/**
+ Reads a batch of lines as JSON documents, the lines may be read concurrently.
+ 
+ The lines are loaded on the calling thread, then split into parts of about
+ the same data size and read on multiple threads. The threads are only used
+ if the batch is large enough (about 256KB per thread).
+ 
+ @param rd The reader created by `yyjson_lines_new()`.
+ @param docs An array to receive the documents, with at least `count` items.
+    The item is NULL if the line is invalid.
+ @param errs An array to receive error information, with at least `count`
+    items. The error position is the byte offset in the whole input.
+    Pass NULL if you don't need error information.
+ @param count The maximum number of lines to read.
+ @param nthreads The maximum number of threads, including the calling thread.
+    Pass 0 to use the number of online processors.
+ @return The number of lines read, or 0 if there's no more line. If the file
+    cannot be read, the last item has the error code
+    `YYJSON_READ_ERROR_FILE_READ`.
+ 
+ @warning The documents are owned by the reader, they're valid until the next
+    call to this reader and should not be freed.
+ */
+yyjson_api size_t yyjson_lines_read_batch(yyjson_lines_reader *rd,
+                                          yyjson_doc **docs,
+                                          yyjson_read_err *errs,
+                                          size_t count,
+                                          size_t nthreads);
+
+/**
+ Release a reader of newline-delimited JSON and the documents read by it.
+ @param rd The reader created by `yyjson_lines_new()`. NULL is ignored.
+ */
+yyjson_api void yyjson_lines_free(yyjson_lines_reader *rd);
+
 /**
  Read a JSON string.
  
@@ -1013,12 +1284,14 @@ yyjson_api_inline size_t yyjson_read_max_memory_usage(size_t len,
         for example: "[[[[[[[[".
      3. yyjson use 16 bytes per value, see struct yyjson_val.
      4. yyjson use dynamic memory with a growth factor of 1.5.
+     5. The structural index reader uses an index buffer of 64KB at most.
      
      The max memory size is (json_size / 2 * 16 * 1.5 + padding).
      */
     size_t mul = (size_t)12 + !(flg & YYJSON_READ_INSITU);
     size_t pad = 256;
     size_t max = (size_t)(~(size_t)0);
+    if (flg & YYJSON_READ_STRUCTURAL_INDEX) pad += 0x10000 + 0x200;
     if (flg & YYJSON_READ_STOP_WHEN_DONE) len = len < 256 ? 256 : len;
     if (len >= (max - pad - mul) / mul) return 0;
     return len * mul + pad;
@@ -1080,113 +1353,633 @@ yyjson_api_inline const char *yyjson_mut_read_number(const char *dat,
     return yyjson_read_number(dat, (yyjson_val *)val, flg, alc, err);
 }
 
-#endif /* YYJSON_DISABLE_READER) */
-
 
 
 /*==============================================================================
- * JSON Writer API
+ * JSON Lazy Reader API
  *============================================================================*/
 
-/** Run-time options for JSON writer. */
-typedef uint32_t yyjson_write_flag;
+/**
+ A lazy JSON document, see `yyjson_lazy_read()`.
+ */
+typedef struct yyjson_lazy_doc yyjson_lazy_doc;
 
-/** Default option:
-    - Write JSON minify.
-    - Report error on inf or nan number.
-    - Report error on invalid UTF-8 string.
-    - Do not escape unicode or slash. */
-static const yyjson_write_flag YYJSON_WRITE_NOFLAG                  = 0;
+/**
+ A value in a lazy JSON document, it's a position in the JSON data.
+ The value does not need to be destroyed, it's valid until the document is
+ freed.
+ */
+typedef struct yyjson_lazy_val {
+    yyjson_lazy_doc *doc; /**< the document, NULL if the value doesn't exist */
+    const char *cur; /**< the first character of the value, or NULL */
+} yyjson_lazy_val;
 
-/** Write JSON pretty with 4 space indent. */
-static const yyjson_write_flag YYJSON_WRITE_PRETTY                  = 1 << 0;
+/**
+ An iterator of the elements of an array or object in a lazy document.
+ 
+ @par Example
+ @code
+    yyjson_lazy_val key, val;
+    yyjson_lazy_iter iter;
+    yyjson_lazy_iter_init(obj, &iter);
+    while (yyjson_lazy_obj_next(&iter, &key, &val)) {
+        your_func(key, val);
+    }
+ @endcode
+ */
+typedef struct yyjson_lazy_iter {
+    yyjson_lazy_doc *doc; /**< the document */
+    const char *cur; /**< the next element, or the value returned last time */
+    bool skip; /**< whether `cur` should be skipped to get the next element */
+} yyjson_lazy_iter;
 
-/** Escape unicode as `uXXXX`, make the output ASCII only. */
-static const yyjson_write_flag YYJSON_WRITE_ESCAPE_UNICODE          = 1 << 1;
+/**
+ Read JSON lazily, the values are decoded only when they're accessed.
+ 
+ This function validates the structure of the document (brackets, commas,
+ colons, closed strings and literals) without building any values. The
+ values are found by navigating the document with `yyjson_lazy_obj_get()`,
+ `yyjson_lazy_arr_get()` or an iterator, and the unvisited values are skipped
+ quickly. The strings and numbers are decoded and validated (such as the
+ escape sequences, UTF-8 encoding and number format) only when they're
+ accessed with `yyjson_lazy_get_val()`.
+ 
+ This is faster than `yyjson_read_opts()` if only a few values of a large
+ document are accessed, but slower if most of the values are accessed.
+ 
+ @param dat The JSON data (UTF-8 without BOM), null-terminator is not required.
+    If this parameter is NULL, the function will fail and return NULL.
+    The data is copied, unless the flag `YYJSON_READ_INSITU` is used.
+ @param len The length of JSON data in bytes.
+    If this parameter is 0, the function will fail and return NULL.
+ @param flg The JSON read options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+    With `YYJSON_READ_INSITU`, the data is not copied or modified, it should
+    have `YYJSON_PADDING_SIZE` bytes of zero padding and be valid until the
+    document is freed. The `YYJSON_READ_STRUCTURAL_INDEX` flag is ignored.
+ @param alc The memory allocator used by the document.
+    Pass NULL to use the libc's default allocator.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return A new lazy document, or NULL if an error occurs.
+    When it's no longer needed, it should be freed with
+    `yyjson_lazy_doc_free()`.
+ 
+ @warning The document is not thread-safe, as the values are decoded into a
+    buffer owned by the document.
+ */
+yyjson_api yyjson_lazy_doc *yyjson_lazy_read(const char *dat,
+                                             size_t len,
+                                             yyjson_read_flag flg,
+                                             const yyjson_alc *alc,
+                                             yyjson_read_err *err);
 
-/** Escape '/' as '\/'. */
-static const yyjson_write_flag YYJSON_WRITE_ESCAPE_SLASHES          = 1 << 2;
+/**
+ Release a lazy JSON document, and the values decoded from it.
+ @param doc The document. NULL is ignored.
+ */
+yyjson_api void yyjson_lazy_doc_free(yyjson_lazy_doc *doc);
 
-/** Write inf and nan number as 'Infinity' and 'NaN' literal (non-standard). */
-static const yyjson_write_flag YYJSON_WRITE_ALLOW_INF_AND_NAN       = 1 << 3;
+/** Returns the root value of this lazy document.
+    Returns a NULL value if `doc` is NULL. */
+yyjson_api yyjson_lazy_val yyjson_lazy_doc_get_root(yyjson_lazy_doc *doc);
 
-/** Write inf and nan number as null literal.
-    This flag will override `YYJSON_WRITE_ALLOW_INF_AND_NAN` flag. */
-static const yyjson_write_flag YYJSON_WRITE_INF_AND_NAN_AS_NULL     = 1 << 4;
+/** Returns the value's type by its first character, without decoding it.
+    A number is `YYJSON_TYPE_NUM`, or `YYJSON_TYPE_RAW` if the document is read
+    with `YYJSON_READ_NUMBER_AS_RAW`.
+    Returns `YYJSON_TYPE_NONE` if the value doesn't exist. */
+yyjson_api yyjson_type yyjson_lazy_get_type(yyjson_lazy_val val);
 
-/** Allow invalid unicode when encoding string values (non-standard).
-    Invalid characters in string value will be copied byte by byte.
-    If `YYJSON_WRITE_ESCAPE_UNICODE` flag is also set, invalid character will be
-    escaped as `U+FFFD` (replacement character).
-    This flag does not affect the performance of correctly encoded strings. */
-static const yyjson_write_flag YYJSON_WRITE_ALLOW_INVALID_UNICODE   = 1 << 5;
+/**
+ Decodes a scalar value (null, boolean, number or string).
+ 
+ The result is the same as the value read by `yyjson_read_opts()`, and can be
+ accessed with the value API, such as `yyjson_get_str()` and
+ `yyjson_get_sint()`. The string is valid until the document is freed.
+ 
+ @param val The lazy value to be decoded.
+ @param out The value to receive the result.
+ @return false if the value doesn't exist, is a container, is invalid (such
+    as invalid escape sequence or number format) or memory allocation failed.
+ */
+yyjson_api bool yyjson_lazy_get_val(yyjson_lazy_val val, yyjson_val *out);
 
-/** Write JSON pretty with 2 space indent.
-    This flag will override `YYJSON_WRITE_PRETTY` flag. */
-static const yyjson_write_flag YYJSON_WRITE_PRETTY_TWO_SPACES       = 1 << 6;
+/**
+ Reads a lazy value (such as an array or object) as a new JSON document.
+ 
+ @param val The lazy value to be read.
+ @param alc The memory allocator used by the new document.
+    Pass NULL to use the libc's default allocator.
+ @param err A pointer to receive error information, the error position is
+    the offset in the data of the lazy document.
+    Pass NULL if you don't need error information.
+ @return A new JSON document, or NULL if an error occurs.
+    When it's no longer needed, it should be freed with `yyjson_doc_free()`.
+ */
+yyjson_api yyjson_doc *yyjson_lazy_get_doc(yyjson_lazy_val val,
+                                           const yyjson_alc *alc,
+                                           yyjson_read_err *err);
+
+/** Returns the element at the specified position in this array, the elements
+    before it are skipped. Returns a NULL value if `arr` is not an array or
+    the index is out of bounds. */
+yyjson_api yyjson_lazy_val yyjson_lazy_arr_get(yyjson_lazy_val arr,
+                                               size_t idx);
+
+/** Returns the value to which the specified key is mapped, the values before
+    it are skipped. Returns a NULL value if `obj` is not an object or no such
+    key. The `key` should be a null-terminated UTF-8 string. */
+yyjson_api yyjson_lazy_val yyjson_lazy_obj_get(yyjson_lazy_val obj,
+                                               const char *key);
 
-/** Adds a newline character `\n` at the end of the JSON.
-    This can be helpful for text editors or NDJSON. */
-static const yyjson_write_flag YYJSON_WRITE_NEWLINE_AT_END          = 1 << 7;
+/** Returns the value to which the specified key is mapped, the values before
+    it are skipped. Returns a NULL value if `obj` is not an object or no such
+    key. The `key` should be a UTF-8 string, null-terminator is not required,
+    and the `key_len` should be the length of the key, in bytes. */
+yyjson_api yyjson_lazy_val yyjson_lazy_obj_getn(yyjson_lazy_val obj,
+                                                const char *key,
+                                                size_t key_len);
 
+/**
+ Initialize an iterator for this array or object.
+ 
+ @param ctn The array or object to be iterated over.
+    If this parameter is not an array or object, `iter` will be set to empty.
+ @param iter The iterator to be initialized.
+    If this parameter is NULL, the function will fail and return false.
+ @return true if the `iter` has been successfully initialized.
+ 
+ @note The iterator does not need to be destroyed.
+ */
+yyjson_api bool yyjson_lazy_iter_init(yyjson_lazy_val ctn,
+                                      yyjson_lazy_iter *iter);
 
+/** Gets the next element of an array, returns false on end.
+    The value returned last time is skipped in this call. */
+yyjson_api bool yyjson_lazy_arr_next(yyjson_lazy_iter *iter,
+                                     yyjson_lazy_val *val);
 
-/** The highest 8 bits of `yyjson_write_flag` and real number value's `tag`
-    are reserved for controlling the output format of floating-point numbers. */
-#define YYJSON_WRITE_FP_FLAG_BITS 8
+/** Gets the next key and value of an object, returns false on end.
+    The value returned last time is skipped in this call. */
+yyjson_api bool yyjson_lazy_obj_next(yyjson_lazy_iter *iter,
+                                     yyjson_lazy_val *key,
+                                     yyjson_lazy_val *val);
 
-/** The highest 4 bits of flag are reserved for precision value. */
-#define YYJSON_WRITE_FP_PREC_BITS 4
 
-/** Write floating-point number using fixed-point notation.
-    - This is similar to ECMAScript `Number.prototype.toFixed(prec)`,
-      but with trailing zeros removed. The `prec` ranges from 1 to 15.
-    - This will produce shorter output but may lose some precision. */
-#define YYJSON_WRITE_FP_TO_FIXED(prec) ((yyjson_write_flag)( \
-    (uint32_t)((uint32_t)(prec)) << (32 - 4) ))
 
-/** Write floating-point numbers using single-precision (float).
-    - This casts `double` to `float` before serialization.
-    - This will produce shorter output, but may lose some precision.
-    - This flag is ignored if `YYJSON_WRITE_FP_TO_FIXED(prec)` is also used. */
-#define YYJSON_WRITE_FP_TO_FLOAT ((yyjson_write_flag)(1 << (32 - 5)))
+/*==============================================================================
+ * JSON Compact Document API
+ *============================================================================*/
 
+/**
+ A compact JSON document, see `yyjson_doc_compact_copy()`.
+ */
+typedef struct yyjson_compact_doc yyjson_compact_doc;
 
+/**
+ A value in a compact JSON document.
+ The value does not need to be destroyed, it's valid until the document is
+ freed.
+ */
+typedef struct yyjson_compact_val {
+    yyjson_compact_doc *doc; /**< the document, NULL if no such value */
+    const uint64_t *cur; /**< the first word of the value, or NULL */
+} yyjson_compact_val;
 
-/** Result code for JSON writer */
-typedef uint32_t yyjson_write_code;
+/**
+ An iterator of the elements of an array or object in a compact document.
+ 
+ @par Example
+ @code
+    yyjson_compact_val key, val;
+    yyjson_compact_iter iter;
+    yyjson_compact_iter_init(obj, &iter);
+    while (yyjson_compact_obj_next(&iter, &key, &val)) {
+        your_func(key, val);
+    }
+ @endcode
+ */
+typedef struct yyjson_compact_iter {
+    yyjson_compact_doc *doc; /**< the document */
+    const uint64_t *cur; /**< the next element */
+    size_t idx; /**< the index of the next element */
+    size_t max; /**< the number of elements */
+} yyjson_compact_iter;
 
-/** Success, no error. */
-static const yyjson_write_code YYJSON_WRITE_SUCCESS                     = 0;
+/**
+ Copies a JSON document into a compact document, which takes about half of
+ the memory of the input document.
+ 
+ Each value of a compact document is a 64-bit word: the type is stored in the
+ lower 8 bits, and the length, offset or value is stored in the higher 56
+ bits. The small numbers are stored in the word, the large numbers take
+ another word. The strings are stored in a string pool, the keys and short
+ strings with the same content are stored only once. The document holds no
+ pointers, and it's read-only.
+ 
+ The values can be accessed with `yyjson_compact_obj_get()`,
+ `yyjson_compact_arr_get()` and the iterators, and decoded with
+ `yyjson_compact_get_val()` to use the value API, such as `yyjson_get_str()`
+ and `yyjson_get_sint()`. A container can be copied back into a JSON document
+ with `yyjson_compact_get_doc()`.
+ 
+ @param doc The JSON document to be copied.
+    If this parameter is NULL, the function will fail and return NULL.
+ @param alc The memory allocator used by the compact document.
+    Pass NULL to use the libc's default allocator.
+ @return A new compact document, or NULL if memory allocation failed.
+    When it's no longer needed, it should be freed with
+    `yyjson_compact_doc_free()`.
+ */
+yyjson_api yyjson_compact_doc *yyjson_doc_compact_copy(yyjson_doc *doc,
+                                                       const yyjson_alc *alc);
 
-/** Invalid parameter, such as NULL document. */
-static const yyjson_write_code YYJSON_WRITE_ERROR_INVALID_PARAMETER     = 1;
+/**
+ Read JSON into a compact document, see `yyjson_doc_compact_copy()`.
+ 
+ The JSON is read with `yyjson_read_opts()` first, so the peak memory usage is
+ the same as reading a JSON document, and the read document is freed before
+ this function returns.
+ 
+ @param dat The JSON data (UTF-8 without BOM), null-terminator is not required.
+    If this parameter is NULL, the function will fail and return NULL.
+ @param len The length of JSON data in bytes.
+    If this parameter is 0, the function will fail and return NULL.
+ @param flg The JSON read options, same as `yyjson_read_opts()`.
+ @param alc The memory allocator used by the reader and the compact document.
+    Pass NULL to use the libc's default allocator.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return A new compact document, or NULL if an error occurs.
+    When it's no longer needed, it should be freed with
+    `yyjson_compact_doc_free()`.
+ */
+yyjson_api yyjson_compact_doc *yyjson_compact_read(const char *dat,
+                                                   size_t len,
+                                                   yyjson_read_flag flg,
+                                                   const yyjson_alc *alc,
+                                                   yyjson_read_err *err);
 
-/** Memory allocation failure occurs. */
-static const yyjson_write_code YYJSON_WRITE_ERROR_MEMORY_ALLOCATION     = 2;
+/**
+ Release a compact JSON document.
+ @param doc The document. NULL is ignored.
+ */
+yyjson_api void yyjson_compact_doc_free(yyjson_compact_doc *doc);
 
-/** Invalid value type in JSON document. */
-static const yyjson_write_code YYJSON_WRITE_ERROR_INVALID_VALUE_TYPE    = 3;
+/** Returns the root value of this compact document.
+    Returns a NULL value if `doc` is NULL. */
+yyjson_api yyjson_compact_val yyjson_compact_doc_get_root(
+    yyjson_compact_doc *doc);
 
-/** NaN or Infinity number occurs. */
-static const yyjson_write_code YYJSON_WRITE_ERROR_NAN_OR_INF            = 4;
+/** Returns the memory size of this compact document in bytes, including the
+    values and strings. Returns 0 if `doc` is NULL. */
+yyjson_api size_t yyjson_compact_doc_get_size(yyjson_compact_doc *doc);
 
-/** Failed to open a file. */
-static const yyjson_write_code YYJSON_WRITE_ERROR_FILE_OPEN             = 5;
+/** Returns the value's type.
+    Returns `YYJSON_TYPE_NONE` if the value doesn't exist. */
+yyjson_api yyjson_type yyjson_compact_get_type(yyjson_compact_val val);
 
-/** Failed to write a file. */
-static const yyjson_write_code YYJSON_WRITE_ERROR_FILE_WRITE            = 6;
+/** Returns the content length (string length, array size, object size).
+    Returns 0 if the value doesn't exist or is not string/array/object. */
+yyjson_api size_t yyjson_compact_get_len(yyjson_compact_val val);
 
-/** Invalid unicode in string. */
-static const yyjson_write_code YYJSON_WRITE_ERROR_INVALID_STRING        = 7;
+/**
+ Decodes a value into a `yyjson_val`.
+ 
+ The result can be accessed with the value API, such as `yyjson_get_str()`
+ and `yyjson_get_sint()`. The string is valid until the document is freed.
+ 
+ @param val The compact value to be decoded.
+ @param out The value to receive the result.
+ @return false if the value doesn't exist or is a container, use
+    `yyjson_compact_get_doc()` to copy a container.
+ */
+yyjson_api bool yyjson_compact_get_val(yyjson_compact_val val,
+                                       yyjson_val *out);
 
-/** Error information for JSON writer. */
-typedef struct yyjson_write_err {
-    /** Error code, see `yyjson_write_code` for all possible values. */
-    yyjson_write_code code;
-    /** Error message, constant, no need to free (NULL if success). */
-    const char *msg;
-} yyjson_write_err;
+/**
+ Copies a compact value (such as an array or object) into a new JSON document.
+ 
+ @param val The compact value to be copied.
+ @param alc The memory allocator used by the new document.
+    Pass NULL to use the libc's default allocator.
+ @return A new JSON document, or NULL if the value doesn't exist or memory
+    allocation failed. When it's no longer needed, it should be freed with
+    `yyjson_doc_free()`.
+ */
+yyjson_api yyjson_doc *yyjson_compact_get_doc(yyjson_compact_val val,
+                                              const yyjson_alc *alc);
+
+/** Returns the element at the specified position in this array.
+    Returns a NULL value if `arr` is not an array or the index is out of
+    bounds.
+    @warning This function takes a linear search time. */
+yyjson_api yyjson_compact_val yyjson_compact_arr_get(yyjson_compact_val arr,
+                                                     size_t idx);
+
+/** Returns the value to which the specified key is mapped.
+    Returns a NULL value if `obj` is not an object or no such key.
+    The `key` should be a null-terminated UTF-8 string.
+    @warning This function takes a linear search time. */
+yyjson_api yyjson_compact_val yyjson_compact_obj_get(yyjson_compact_val obj,
+                                                     const char *key);
+
+/** Returns the value to which the specified key is mapped.
+    Returns a NULL value if `obj` is not an object or no such key.
+    The `key` should be a UTF-8 string, null-terminator is not required,
+    and the `key_len` should be the length of the key, in bytes.
+    @warning This function takes a linear search time. */
+yyjson_api yyjson_compact_val yyjson_compact_obj_getn(yyjson_compact_val obj,
+                                                      const char *key,
+                                                      size_t key_len);
+
+/**
+ Initialize an iterator for this array or object.
+ 
+ @param ctn The array or object to be iterated over.
+    If this parameter is not an array or object, `iter` will be set to empty.
+ @param iter The iterator to be initialized.
+    If this parameter is NULL, the function will fail and return false.
+ @return true if the `iter` has been successfully initialized.
+ 
+ @note The iterator does not need to be destroyed.
+ */
+yyjson_api bool yyjson_compact_iter_init(yyjson_compact_val ctn,
+                                         yyjson_compact_iter *iter);
+
+/** Gets the next element of an array, returns false on end. */
+yyjson_api bool yyjson_compact_arr_next(yyjson_compact_iter *iter,
+                                        yyjson_compact_val *val);
+
+/** Gets the next key and value of an object, returns false on end. */
+yyjson_api bool yyjson_compact_obj_next(yyjson_compact_iter *iter,
+                                        yyjson_compact_val *key,
+                                        yyjson_compact_val *val);
+
+
+
+#if !defined(YYJSON_DISABLE_UTILS) || !YYJSON_DISABLE_UTILS
+
+/*==============================================================================
+ * JSON Selective Reader API
+ *============================================================================*/
+
+/**
+ Read JSON, and build only the values selected by JSON Pointers.
+ 
+ The document is validated by the lazy reader (see `yyjson_lazy_read()`), and
+ only the selected values and their parent containers are built, so the values
+ can be accessed with the same pointers, such as `yyjson_ptr_get()`. The other
+ values are skipped without being decoded, and don't take any memory in the
+ returned document.
+ 
+ In a parent container, the members that are not selected are removed, but the
+ array elements before a selected element are replaced with `null`, so the
+ selected elements keep their indexes. A parent container is removed if no
+ value in it is selected, the root value is always kept.
+ 
+ The pointers follow RFC 6901, and a `*` token selects all elements of an
+ array, for example, the `ts` of all events are selected by the pointer with
+ the tokens `events`, `*` and `ts`. An empty pointer selects the whole
+ document.
+ 
+ @param dat The JSON data (UTF-8 without BOM), null-terminator is not required.
+    If this parameter is NULL, the function will fail and return NULL.
+    The data is not modified.
+ @param len The length of JSON data in bytes.
+    If this parameter is 0, the function will fail and return NULL.
+ @param ptrs The JSON Pointers, each of them is a null-terminated string.
+ @param ptr_num The number of JSON Pointers. If this parameter is 0, only the
+    root value is kept (an empty array or object if it's a container).
+ @param flg The JSON read options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+    With `YYJSON_READ_INSITU`, the data is not copied, it should have
+    `YYJSON_PADDING_SIZE` bytes of zero padding, but the returned document
+    does not reference it. The `YYJSON_READ_STRUCTURAL_INDEX` flag is ignored.
+ @param alc The memory allocator used by JSON reader.
+    Pass NULL to use the libc's default allocator.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return A new JSON document, or NULL if an error occurs.
+    When it's no longer needed, it should be freed with `yyjson_doc_free()`.
+ 
+ @warning The values that are not selected are only validated by their
+    structure, an invalid string or number in them is not reported.
+ */
+yyjson_api yyjson_doc *yyjson_read_select(const char *dat,
+                                          size_t len,
+                                          const char *const *ptrs,
+                                          size_t ptr_num,
+                                          yyjson_read_flag flg,
+                                          const yyjson_alc *alc,
+                                          yyjson_read_err *err);
+
+#endif /* YYJSON_DISABLE_UTILS */
+
+#endif /* YYJSON_DISABLE_READER) */
+
+
+
+/*==============================================================================
+ * JSON Writer API
+ *============================================================================*/
+
+/** Run-time options for JSON writer. */
+typedef uint32_t yyjson_write_flag;
+
+/** Default option:
+    - Write JSON minify.
+    - Report error on inf or nan number.
+    - Report error on invalid UTF-8 string.
+    - Do not escape unicode or slash. */
+static const yyjson_write_flag YYJSON_WRITE_NOFLAG                  = 0;
+
+/** Write JSON pretty with 4 space indent. */
+static const yyjson_write_flag YYJSON_WRITE_PRETTY                  = 1 << 0;
+
+/** Escape unicode as `uXXXX`, make the output ASCII only. */
+static const yyjson_write_flag YYJSON_WRITE_ESCAPE_UNICODE          = 1 << 1;
+
+/** Escape '/' as '\/'. */
+static const yyjson_write_flag YYJSON_WRITE_ESCAPE_SLASHES          = 1 << 2;
+
+/** Write inf and nan number as 'Infinity' and 'NaN' literal (non-standard). */
+static const yyjson_write_flag YYJSON_WRITE_ALLOW_INF_AND_NAN       = 1 << 3;
+
+/** Write inf and nan number as null literal.
+    This flag will override `YYJSON_WRITE_ALLOW_INF_AND_NAN` flag. */
+static const yyjson_write_flag YYJSON_WRITE_INF_AND_NAN_AS_NULL     = 1 << 4;
+
+/** Allow invalid unicode when encoding string values (non-standard).
+    Invalid characters in string value will be copied byte by byte.
+    If `YYJSON_WRITE_ESCAPE_UNICODE` flag is also set, invalid character will be
+    escaped as `U+FFFD` (replacement character).
+    This flag does not affect the performance of correctly encoded strings. */
+static const yyjson_write_flag YYJSON_WRITE_ALLOW_INVALID_UNICODE   = 1 << 5;
+
+/** Write JSON pretty with 2 space indent.
+    This flag will override `YYJSON_WRITE_PRETTY` flag. */
+static const yyjson_write_flag YYJSON_WRITE_PRETTY_TWO_SPACES       = 1 << 6;
+
+/** Adds a newline character `\n` at the end of the JSON.
+    This can be helpful for text editors or NDJSON. */
+static const yyjson_write_flag YYJSON_WRITE_NEWLINE_AT_END          = 1 << 7;
+
+/** Write JSON in the canonical form of RFC 8785 (JSON Canonicalization Scheme).
+    - The members of each object are sorted by the UTF-16 code units of the
+      keys, the document is not modified. The duplicated keys are kept in order.
+    - The numbers are written as ECMAScript `Number.prototype.toString()`,
+      e.g. `1.0` as `1`, `-0.0` as `0`, `1e21` as `1e+21`. The integers beyond
+      2^53 are written as the nearest double, e.g. `2^64-1` as
+      `18446744073709552000`.
+    - Only '"', '\\' and the control characters in strings are escaped.
+    - Inf, nan and invalid unicode are always reported as errors.
+    - The raw values are written as is.
+    - All other flags except `YYJSON_WRITE_NEWLINE_AT_END` are ignored.
+    - The numbers may not be canonical if `YYJSON_DISABLE_FAST_FP_CONV` is set.
+    - This flag is not supported by the incremental writer, and the
+      multi-threaded writer writes the document on the calling thread. */
+static const yyjson_write_flag YYJSON_WRITE_CANONICAL               = 1 << 8;
+
+
+
+/** The highest 8 bits of `yyjson_write_flag` and real number value's `tag`
+    are reserved for controlling the output format of floating-point numbers. */
+#define YYJSON_WRITE_FP_FLAG_BITS 8
+
+/** The highest 4 bits of flag are reserved for precision value. */
+#define YYJSON_WRITE_FP_PREC_BITS 4
+
+/** Write floating-point number using fixed-point notation.
+    - This is similar to ECMAScript `Number.prototype.toFixed(prec)`,
+      but with trailing zeros removed. The `prec` ranges from 1 to 15.
+    - This will produce shorter output but may lose some precision. */
+#define YYJSON_WRITE_FP_TO_FIXED(prec) ((yyjson_write_flag)( \
+    (uint32_t)((uint32_t)(prec)) << (32 - 4) ))
+
+/** Write floating-point numbers using single-precision (float).
+    - This casts `double` to `float` before serialization.
+    - This will produce shorter output, but may lose some precision.
+    - This flag is ignored if `YYJSON_WRITE_FP_TO_FIXED(prec)` is also used. */
+#define YYJSON_WRITE_FP_TO_FLOAT ((yyjson_write_flag)(1 << (32 - 5)))
+
+
+
+/** Result code for JSON writer */
+typedef uint32_t yyjson_write_code;
+
+/** Success, no error. */
+static const yyjson_write_code YYJSON_WRITE_SUCCESS                     = 0;
+
+/** Invalid parameter, such as NULL document. */
+static const yyjson_write_code YYJSON_WRITE_ERROR_INVALID_PARAMETER     = 1;
+
+/** Memory allocation failure occurs. */
+static const yyjson_write_code YYJSON_WRITE_ERROR_MEMORY_ALLOCATION     = 2;
+
+/** Invalid value type in JSON document. */
+static const yyjson_write_code YYJSON_WRITE_ERROR_INVALID_VALUE_TYPE    = 3;
+
+/** NaN or Infinity number occurs. */
+static const yyjson_write_code YYJSON_WRITE_ERROR_NAN_OR_INF            = 4;
+
+/** Failed to open a file. */
+static const yyjson_write_code YYJSON_WRITE_ERROR_FILE_OPEN             = 5;
+
+/** Failed to write a file. */
+static const yyjson_write_code YYJSON_WRITE_ERROR_FILE_WRITE            = 6;
+
+/** Invalid unicode in string. */
+static const yyjson_write_code YYJSON_WRITE_ERROR_INVALID_STRING        = 7;
+
+/** Error information for JSON writer. */
+typedef struct yyjson_write_err {
+    /** Error code, see `yyjson_write_code` for all possible values. */
+    yyjson_write_code code;
+    /** Error message, constant, no need to free (NULL if success). */
+    const char *msg;
+} yyjson_write_err;
+
+
+
+#if !defined(YYJSON_DISABLE_READER) || !YYJSON_DISABLE_READER
+
+/*==============================================================================
+ * JSON Binary Snapshot API
+ *============================================================================*/
+
+/**
+ Saves a compact document to a binary snapshot file.
+ 
+ The snapshot holds no pointers, it can be loaded with
+ `yyjson_compact_load_binary()` on a machine with the same byte order.
+ 
+ @param doc The compact document to be saved.
+    If this parameter is NULL, the function will fail and return false.
+ @param path The file's path.
+    If this path is NULL or invalid, the function will fail and return false.
+    If this file is not empty, the content will be discarded.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return true if successful, false if an error occurs.
+ */
+yyjson_api bool yyjson_compact_doc_save_binary(yyjson_compact_doc *doc,
+                                               const char *path,
+                                               yyjson_write_err *err);
+
+/**
+ Saves a document to a binary snapshot file, the document is copied into a
+ compact document first, see `yyjson_doc_compact_copy()`.
+ 
+ @param doc The document to be saved.
+    If this parameter is NULL, the function will fail and return false.
+ @param path The file's path.
+    If this path is NULL or invalid, the function will fail and return false.
+    If this file is not empty, the content will be discarded.
+ @param alc The memory allocator used for the compact copy.
+    Pass NULL to use the libc's default allocator.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return true if successful, false if an error occurs.
+ */
+yyjson_api bool yyjson_doc_save_binary(yyjson_doc *doc,
+                                       const char *path,
+                                       const yyjson_alc *alc,
+                                       yyjson_write_err *err);
+
+/**
+ Loads a binary snapshot file as a compact document, without parsing.
+ 
+ With `YYJSON_READ_MMAP`, the file is mapped with read-only shared pages and
+ used in place, so the loading time doesn't depend on the file size, and the
+ pages are shared by all processes that map the same file. The mapping is
+ kept until the document is freed, and the file should not be modified while
+ it's mapped. Otherwise, or if the file cannot be mapped, the file is read
+ into memory.
+ 
+ Only the header and the size of the snapshot are validated, the values are
+ trusted, so the file should be saved by `yyjson_compact_doc_save_binary()`
+ or `yyjson_doc_save_binary()`.
+ 
+ @param path The snapshot file's path.
+    If this path is NULL or invalid, the function will fail and return NULL.
+ @param flg The read options, only `YYJSON_READ_MMAP` is supported,
+    others are ignored.
+ @param alc The memory allocator used by the document.
+    Pass NULL to use the libc's default allocator.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return A new compact document, or NULL if an error occurs.
+    When it's no longer needed, it should be freed with
+    `yyjson_compact_doc_free()`.
+ */
+yyjson_api yyjson_compact_doc *yyjson_compact_load_binary(
+    const char *path,
+    yyjson_read_flag flg,
+    const yyjson_alc *alc,
+    yyjson_read_err *err);
+
+#endif /* YYJSON_DISABLE_READER */
 
 
 
@@ -1425,48 +2218,330 @@ yyjson_api_inline char *yyjson_mut_write(const yyjson_mut_doc *doc,
     This string is encoded as UTF-8 with a null-terminator.
     When it's no longer needed, it should be freed with free() or alc->free().
  */
-yyjson_api char *yyjson_val_write_opts(const yyjson_val *val,
-                                       yyjson_write_flag flg,
-                                       const yyjson_alc *alc,
-                                       size_t *len,
-                                       yyjson_write_err *err);
+yyjson_api char *yyjson_val_write_opts(const yyjson_val *val,
+                                       yyjson_write_flag flg,
+                                       const yyjson_alc *alc,
+                                       size_t *len,
+                                       yyjson_write_err *err);
+
+/**
+ Write a value to JSON file with options.
+ 
+ This function is thread-safe when:
+ 1. The file is not accessed by other threads.
+ 2. The `alc` is thread-safe or NULL.
+ 
+ @param path The JSON file's path.
+    If this path is NULL or invalid, the function will fail and return false.
+    If this file is not empty, the content will be discarded.
+ @param val The JSON root value.
+    If this parameter is NULL, the function will fail and return NULL.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used by JSON writer.
+    Pass NULL to use the libc's default allocator.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return true if successful, false if an error occurs.
+ 
+ @warning On 32-bit operating system, files larger than 2GB may fail to write.
+ */
+yyjson_api bool yyjson_val_write_file(const char *path,
+                                      const yyjson_val *val,
+                                      yyjson_write_flag flg,
+                                      const yyjson_alc *alc,
+                                      yyjson_write_err *err);
+
+/**
+ Write a value to file pointer with options.
+ 
+ @param fp The file pointer.
+    The data will be written to the current position of the file.
+    If this path is NULL or invalid, the function will fail and return false.
+ @param val The JSON root value.
+    If this parameter is NULL, the function will fail and return NULL.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used by JSON writer.
+    Pass NULL to use the libc's default allocator.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return true if successful, false if an error occurs.
+ 
+ @warning On 32-bit operating system, files larger than 2GB may fail to write.
+ */
+yyjson_api bool yyjson_val_write_fp(FILE *fp,
+                                    const yyjson_val *val,
+                                    yyjson_write_flag flg,
+                                    const yyjson_alc *alc,
+                                    yyjson_write_err *err);
+
+/**
+ Write a value to JSON string.
+ 
+ This function is thread-safe.
+ 
+ @param val The JSON root value.
+    If this parameter is NULL, the function will fail and return NULL.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param len A pointer to receive output length in bytes (not including the
+    null-terminator). Pass NULL if you don't need length information.
+ @return A new JSON string, or NULL if an error occurs.
+    This string is encoded as UTF-8 with a null-terminator.
+    When it's no longer needed, it should be freed with free().
+ */
+yyjson_api_inline char *yyjson_val_write(const yyjson_val *val,
+                                         yyjson_write_flag flg,
+                                         size_t *len) {
+    return yyjson_val_write_opts(val, flg, NULL, len, NULL);
+}
+
+/**
+ Write a value to JSON string with options.
+ 
+ This function is thread-safe when:
+ 1. The `val` is not modified by other threads.
+ 2. The `alc` is thread-safe or NULL.
+ 
+ @param val The mutable JSON root value.
+    If this parameter is NULL, the function will fail and return NULL.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used by JSON writer.
+    Pass NULL to use the libc's default allocator.
+ @param len A pointer to receive output length in bytes (not including the
+    null-terminator). Pass NULL if you don't need length information.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return  A new JSON string, or NULL if an error occurs.
+    This string is encoded as UTF-8 with a null-terminator.
+    When it's no longer needed, it should be freed with free() or alc->free().
+ */
+yyjson_api char *yyjson_mut_val_write_opts(const yyjson_mut_val *val,
+                                           yyjson_write_flag flg,
+                                           const yyjson_alc *alc,
+                                           size_t *len,
+                                           yyjson_write_err *err);
+
+/**
+ Write a value to JSON file with options.
+ 
+ This function is thread-safe when:
+ 1. The file is not accessed by other threads.
+ 2. The `val` is not modified by other threads.
+ 3. The `alc` is thread-safe or NULL.
+ 
+ @param path The JSON file's path.
+    If this path is NULL or invalid, the function will fail and return false.
+    If this file is not empty, the content will be discarded.
+ @param val The mutable JSON root value.
+    If this parameter is NULL, the function will fail and return NULL.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used by JSON writer.
+    Pass NULL to use the libc's default allocator.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return true if successful, false if an error occurs.
+ 
+ @warning On 32-bit operating system, files larger than 2GB may fail to write.
+ */
+yyjson_api bool yyjson_mut_val_write_file(const char *path,
+                                          const yyjson_mut_val *val,
+                                          yyjson_write_flag flg,
+                                          const yyjson_alc *alc,
+                                          yyjson_write_err *err);
+
+/**
+ Write a value to JSON file with options.
+ 
+ @param fp The file pointer.
+    The data will be written to the current position of the file.
+    If this path is NULL or invalid, the function will fail and return false.
+ @param val The mutable JSON root value.
+    If this parameter is NULL, the function will fail and return NULL.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used by JSON writer.
+    Pass NULL to use the libc's default allocator.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return true if successful, false if an error occurs.
+ 
+ @warning On 32-bit operating system, files larger than 2GB may fail to write.
+ */
+yyjson_api bool yyjson_mut_val_write_fp(FILE *fp,
+                                        const yyjson_mut_val *val,
+                                        yyjson_write_flag flg,
+                                        const yyjson_alc *alc,
+                                        yyjson_write_err *err);
+
+/**
+ Write a value to JSON string.
+ 
+ This function is thread-safe when:
+ The `val` is not modified by other threads.
+ 
+ @param val The JSON root value.
+    If this parameter is NULL, the function will fail and return NULL.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param len A pointer to receive output length in bytes (not including the
+    null-terminator). Pass NULL if you don't need length information.
+ @return A new JSON string, or NULL if an error occurs.
+    This string is encoded as UTF-8 with a null-terminator.
+    When it's no longer needed, it should be freed with free().
+ */
+yyjson_api_inline char *yyjson_mut_val_write(const yyjson_mut_val *val,
+                                             yyjson_write_flag flg,
+                                             size_t *len) {
+    return yyjson_mut_val_write_opts(val, flg, NULL, len, NULL);
+}
+
+
+
+/*==============================================================================
+ * JSON Reusable Buffer Writer API
+ *============================================================================*/
+
+/**
+ Write a document to a reusable buffer with options.
+ 
+ The buffer is owned by the caller and allocated with `alc`. The output is
+ written to this buffer directly. If the buffer is too small, it's grown with
+ `alc` and the new buffer and size are returned, so the buffer size is the
+ size needed by the writer. A buffer kept across calls doesn't need any
+ allocation once it has grown large enough.
+ 
+ This function is thread-safe when:
+ 1. The `buf` is not accessed by other threads.
+ 2. The `alc` is thread-safe or NULL.
+ 
+ @param buf A pointer to the buffer, it receives the new buffer if it's grown.
+    The `*buf` can be NULL to allocate a new buffer.
+    The buffer should be freed with `alc` (or `free()` if `alc` is NULL).
+    If this parameter is NULL, the function will fail and return false.
+ @param buf_size A pointer to the buffer size in bytes, it receives the new
+    size if the buffer is grown.
+    If this parameter is NULL, the function will fail and return false.
+ @param doc The JSON document.
+    If this doc is NULL or has no root, the function will fail and return false.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator of the buffer.
+    Pass NULL to use the libc's default allocator.
+ @param len A pointer to receive output length in bytes (not including the
+    null-terminator). Pass NULL if you don't need length information.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return true if successful, the output is a null-terminated string in the
+    `*buf`. false if an error occurs, the `*buf` is still valid and owned by
+    the caller.
+ */
+yyjson_api bool yyjson_write_buf(char **buf,
+                                 size_t *buf_size,
+                                 const yyjson_doc *doc,
+                                 yyjson_write_flag flg,
+                                 const yyjson_alc *alc,
+                                 size_t *len,
+                                 yyjson_write_err *err);
+
+/** Write a mutable document to a reusable buffer with options,
+    see `yyjson_write_buf()`. */
+yyjson_api bool yyjson_mut_write_buf(char **buf,
+                                     size_t *buf_size,
+                                     const yyjson_mut_doc *doc,
+                                     yyjson_write_flag flg,
+                                     const yyjson_alc *alc,
+                                     size_t *len,
+                                     yyjson_write_err *err);
+
+/** Write a value to a reusable buffer with options,
+    see `yyjson_write_buf()`. */
+yyjson_api bool yyjson_val_write_buf(char **buf,
+                                     size_t *buf_size,
+                                     const yyjson_val *val,
+                                     yyjson_write_flag flg,
+                                     const yyjson_alc *alc,
+                                     size_t *len,
+                                     yyjson_write_err *err);
+
+/** Write a mutable value to a reusable buffer with options,
+    see `yyjson_write_buf()`. */
+yyjson_api bool yyjson_mut_val_write_buf(char **buf,
+                                         size_t *buf_size,
+                                         const yyjson_mut_val *val,
+                                         yyjson_write_flag flg,
+                                         const yyjson_alc *alc,
+                                         size_t *len,
+                                         yyjson_write_err *err);
+
+
+
+/*==============================================================================
+ * JSON Streaming Writer API
+ *============================================================================*/
+
+/**
+ The output callback of the streaming writer.
+ 
+ @param ctx The context passed to the writer.
+ @param dat The output data, it's not null-terminated and it's valid only
+    during this call.
+ @param len The length of the output data in bytes.
+ @return true if successful, false to stop writing, then the writer fails with
+    `YYJSON_WRITE_ERROR_FILE_WRITE`.
+ */
+typedef bool (*yyjson_write_fn)(void *ctx, const char *dat, size_t len);
 
 /**
- Write a value to JSON file with options.
+ Write a document to a callback with options.
+ 
+ The JSON is written into a buffer of `buf_size` bytes, and the buffer is
+ passed to the callback whenever it's full, so the memory usage doesn't
+ depend on the output size, and the first bytes are written early. The buffer
+ grows only if a single value (such as a long string) doesn't fit in it.
+ The output is the same as `yyjson_write_opts()`, without the null-terminator.
  
  This function is thread-safe when:
- 1. The file is not accessed by other threads.
- 2. The `alc` is thread-safe or NULL.
+ The `alc` is thread-safe or NULL.
  
- @param path The JSON file's path.
-    If this path is NULL or invalid, the function will fail and return false.
-    If this file is not empty, the content will be discarded.
- @param val The JSON root value.
-    If this parameter is NULL, the function will fail and return NULL.
+ @param fn The output callback.
+    If this parameter is NULL, the function will fail and return false.
+ @param ctx The context passed to the callback.
+ @param doc The JSON document.
+    If this doc is NULL or has no root, the function will fail and return false.
  @param flg The JSON write options.
     Multiple options can be combined with `|` operator. 0 means no options.
+ @param buf_size The buffer size in bytes, pass 0 to use the default size
+    (64KB).
  @param alc The memory allocator used by JSON writer.
     Pass NULL to use the libc's default allocator.
  @param err A pointer to receive error information.
     Pass NULL if you don't need error information.
  @return true if successful, false if an error occurs.
  
- @warning On 32-bit operating system, files larger than 2GB may fail to write.
+ @warning If an error occurs, a part of the output may have been passed to the
+    callback.
  */
-yyjson_api bool yyjson_val_write_file(const char *path,
-                                      const yyjson_val *val,
-                                      yyjson_write_flag flg,
-                                      const yyjson_alc *alc,
-                                      yyjson_write_err *err);
+yyjson_api bool yyjson_write_stream(yyjson_write_fn fn,
+                                    void *ctx,
+                                    const yyjson_doc *doc,
+                                    yyjson_write_flag flg,
+                                    size_t buf_size,
+                                    const yyjson_alc *alc,
+                                    yyjson_write_err *err);
 
 /**
- Write a value to file pointer with options.
+ Write a document to a file descriptor with options, see
+ `yyjson_write_stream()`.
  
- @param fp The file pointer.
-    The data will be written to the current position of the file.
-    If this path is NULL or invalid, the function will fail and return false.
- @param val The JSON root value.
-    If this parameter is NULL, the function will fail and return NULL.
+ @param fd The file descriptor, the data will be written to its current
+    position. If this fd is negative, the function will fail and return false.
+    The fd is not closed by this function.
+ @param doc The JSON document.
+    If this doc is NULL or has no root, the function will fail and return false.
  @param flg The JSON write options.
     Multiple options can be combined with `|` operator. 0 means no options.
  @param alc The memory allocator used by JSON writer.
@@ -1474,136 +2549,299 @@ yyjson_api bool yyjson_val_write_file(const char *path,
  @param err A pointer to receive error information.
     Pass NULL if you don't need error information.
  @return true if successful, false if an error occurs.
- 
- @warning On 32-bit operating system, files larger than 2GB may fail to write.
  */
-yyjson_api bool yyjson_val_write_fp(FILE *fp,
+yyjson_api bool yyjson_write_fd(int fd,
+                                const yyjson_doc *doc,
+                                yyjson_write_flag flg,
+                                const yyjson_alc *alc,
+                                yyjson_write_err *err);
+
+/** Write a mutable document to a callback with options,
+    see `yyjson_write_stream()`. */
+yyjson_api bool yyjson_mut_write_stream(yyjson_write_fn fn,
+                                        void *ctx,
+                                        const yyjson_mut_doc *doc,
+                                        yyjson_write_flag flg,
+                                        size_t buf_size,
+                                        const yyjson_alc *alc,
+                                        yyjson_write_err *err);
+
+/** Write a mutable document to a file descriptor with options,
+    see `yyjson_write_fd()`. */
+yyjson_api bool yyjson_mut_write_fd(int fd,
+                                    const yyjson_mut_doc *doc,
+                                    yyjson_write_flag flg,
+                                    const yyjson_alc *alc,
+                                    yyjson_write_err *err);
+
+/** Write a value to a callback with options,
+    see `yyjson_write_stream()`. */
+yyjson_api bool yyjson_val_write_stream(yyjson_write_fn fn,
+                                        void *ctx,
+                                        const yyjson_val *val,
+                                        yyjson_write_flag flg,
+                                        size_t buf_size,
+                                        const yyjson_alc *alc,
+                                        yyjson_write_err *err);
+
+/** Write a value to a file descriptor with options,
+    see `yyjson_write_fd()`. */
+yyjson_api bool yyjson_val_write_fd(int fd,
                                     const yyjson_val *val,
                                     yyjson_write_flag flg,
                                     const yyjson_alc *alc,
                                     yyjson_write_err *err);
 
-/**
- Write a value to JSON string.
- 
- This function is thread-safe.
- 
- @param val The JSON root value.
-    If this parameter is NULL, the function will fail and return NULL.
- @param flg The JSON write options.
-    Multiple options can be combined with `|` operator. 0 means no options.
- @param len A pointer to receive output length in bytes (not including the
-    null-terminator). Pass NULL if you don't need length information.
- @return A new JSON string, or NULL if an error occurs.
-    This string is encoded as UTF-8 with a null-terminator.
-    When it's no longer needed, it should be freed with free().
- */
-yyjson_api_inline char *yyjson_val_write(const yyjson_val *val,
-                                         yyjson_write_flag flg,
-                                         size_t *len) {
-    return yyjson_val_write_opts(val, flg, NULL, len, NULL);
-}
+/** Write a mutable value to a callback with options,
+    see `yyjson_write_stream()`. */
+yyjson_api bool yyjson_mut_val_write_stream(yyjson_write_fn fn,
+                                            void *ctx,
+                                            const yyjson_mut_val *val,
+                                            yyjson_write_flag flg,
+                                            size_t buf_size,
+                                            const yyjson_alc *alc,
+                                            yyjson_write_err *err);
+
+/** Write a mutable value to a file descriptor with options,
+    see `yyjson_write_fd()`. */
+yyjson_api bool yyjson_mut_val_write_fd(int fd,
+                                        const yyjson_mut_val *val,
+                                        yyjson_write_flag flg,
+                                        const yyjson_alc *alc,
+                                        yyjson_write_err *err);
+
+
+
+/*==============================================================================
+ * JSON Writer API (Multi-threaded)
+ *============================================================================*/
 
 /**
- Write a value to JSON string with options.
+ Write a document with options using multiple threads.
+ 
+ The children of the root array or object are split into parts with about the
+ same number of values, the parts are written concurrently into separate
+ buffers and then joined into one string. The output is the same as
+ `yyjson_write_opts()`, including the indentation of the pretty format.
+ The document is written on the calling thread only if it's small (less than
+ about 64K values per thread), or the root is not an array or object.
  
  This function is thread-safe when:
- 1. The `val` is not modified by other threads.
- 2. The `alc` is thread-safe or NULL.
+ The `alc` is thread-safe or NULL.
  
- @param val The mutable JSON root value.
-    If this parameter is NULL, the function will fail and return NULL.
+ @param doc The JSON document.
+    If this doc is NULL or has no root, the function will fail and return NULL.
  @param flg The JSON write options.
     Multiple options can be combined with `|` operator. 0 means no options.
  @param alc The memory allocator used by JSON writer.
     Pass NULL to use the libc's default allocator.
+    The allocator is called with a lock. The parts are written into temporary
+    buffers first, so the peak memory usage is about twice the output size.
+ @param nthreads The maximum number of threads, including the calling thread.
+    Pass 0 to use the number of online processors.
  @param len A pointer to receive output length in bytes (not including the
     null-terminator). Pass NULL if you don't need length information.
  @param err A pointer to receive error information.
     Pass NULL if you don't need error information.
- @return  A new JSON string, or NULL if an error occurs.
+ @return A new JSON string, or NULL if an error occurs.
     This string is encoded as UTF-8 with a null-terminator.
     When it's no longer needed, it should be freed with free() or alc->free().
  */
-yyjson_api char *yyjson_mut_val_write_opts(const yyjson_mut_val *val,
-                                           yyjson_write_flag flg,
-                                           const yyjson_alc *alc,
-                                           size_t *len,
-                                           yyjson_write_err *err);
+yyjson_api char *yyjson_write_parallel(const yyjson_doc *doc,
+                                       yyjson_write_flag flg,
+                                       const yyjson_alc *alc,
+                                       size_t nthreads,
+                                       size_t *len,
+                                       yyjson_write_err *err);
 
 /**
- Write a value to JSON file with options.
+ Write a document to a callback with options using multiple threads,
+ see `yyjson_write_parallel()`.
+ 
+ The parts are not joined, each part is passed to the callback in one call
+ in order, like the vectors of `writev()`, so the output is not copied.
+ The callback is called on the calling thread after all parts are written,
+ nothing is passed to the callback if an error occurs while writing the parts.
+ The output is the same as `yyjson_write_opts()`, without the null-terminator.
  
  This function is thread-safe when:
- 1. The file is not accessed by other threads.
- 2. The `val` is not modified by other threads.
- 3. The `alc` is thread-safe or NULL.
+ The `alc` is thread-safe or NULL.
  
- @param path The JSON file's path.
-    If this path is NULL or invalid, the function will fail and return false.
-    If this file is not empty, the content will be discarded.
- @param val The mutable JSON root value.
-    If this parameter is NULL, the function will fail and return NULL.
+ @param fn The output callback.
+    If this parameter is NULL, the function will fail and return false.
+ @param ctx The context passed to the callback.
+ @param doc The JSON document.
+    If this doc is NULL or has no root, the function will fail and return false.
  @param flg The JSON write options.
     Multiple options can be combined with `|` operator. 0 means no options.
  @param alc The memory allocator used by JSON writer.
     Pass NULL to use the libc's default allocator.
+    The allocator is called with a lock.
+ @param nthreads The maximum number of threads, including the calling thread.
+    Pass 0 to use the number of online processors.
  @param err A pointer to receive error information.
     Pass NULL if you don't need error information.
  @return true if successful, false if an error occurs.
+ */
+yyjson_api bool yyjson_write_parallel_stream(yyjson_write_fn fn,
+                                             void *ctx,
+                                             const yyjson_doc *doc,
+                                             yyjson_write_flag flg,
+                                             const yyjson_alc *alc,
+                                             size_t nthreads,
+                                             yyjson_write_err *err);
+
+
+
+/*==============================================================================
+ * JSON Incremental Writer API
+ *============================================================================*/
+
+/**
+ An incremental writer, which writes JSON values one by one without building
+ a document.
  
- @warning On 32-bit operating system, files larger than 2GB may fail to write.
+ The output is the same as writing a document with the same values and flags,
+ the writer checks the call sequence, so the output is always valid JSON.
+ If a call fails, all the following calls fail with the same error, which can
+ be retrieved by `yyjson_writer_finish()`.
+ 
+ The writer is not thread-safe, it should be used by a single thread.
  */
-yyjson_api bool yyjson_mut_val_write_file(const char *path,
-                                          const yyjson_mut_val *val,
-                                          yyjson_write_flag flg,
-                                          const yyjson_alc *alc,
-                                          yyjson_write_err *err);
+typedef struct yyjson_writer yyjson_writer;
 
 /**
- Write a value to JSON file with options.
+ Creates an incremental writer, the output is kept in memory and can be
+ retrieved by `yyjson_writer_get_str()` after `yyjson_writer_finish()`.
  
- @param fp The file pointer.
-    The data will be written to the current position of the file.
-    If this path is NULL or invalid, the function will fail and return false.
- @param val The mutable JSON root value.
-    If this parameter is NULL, the function will fail and return NULL.
  @param flg The JSON write options.
     Multiple options can be combined with `|` operator. 0 means no options.
- @param alc The memory allocator used by JSON writer.
+    The `YYJSON_WRITE_CANONICAL` flag is not supported.
+ @param alc The memory allocator used by the writer.
     Pass NULL to use the libc's default allocator.
- @param err A pointer to receive error information.
-    Pass NULL if you don't need error information.
- @return true if successful, false if an error occurs.
- 
- @warning On 32-bit operating system, files larger than 2GB may fail to write.
+ @return A new writer, or NULL if memory allocation failed or the flag is
+    not supported.
+    It should be freed with `yyjson_writer_free()`.
  */
-yyjson_api bool yyjson_mut_val_write_fp(FILE *fp,
-                                        const yyjson_mut_val *val,
-                                        yyjson_write_flag flg,
-                                        const yyjson_alc *alc,
-                                        yyjson_write_err *err);
+yyjson_api yyjson_writer *yyjson_writer_new(yyjson_write_flag flg,
+                                            const yyjson_alc *alc);
 
 /**
- Write a value to JSON string.
- 
- This function is thread-safe when:
- The `val` is not modified by other threads.
+ Creates an incremental writer, the output is passed to the callback whenever
+ the buffer is full, see `yyjson_write_stream()`.
  
- @param val The JSON root value.
+ @param fn The output callback.
     If this parameter is NULL, the function will fail and return NULL.
+ @param ctx The context passed to the callback.
  @param flg The JSON write options.
     Multiple options can be combined with `|` operator. 0 means no options.
- @param len A pointer to receive output length in bytes (not including the
+    The `YYJSON_WRITE_CANONICAL` flag is not supported.
+ @param buf_size The buffer size in bytes, pass 0 to use the default size
+    (64KB).
+ @param alc The memory allocator used by the writer.
+    Pass NULL to use the libc's default allocator.
+ @return A new writer, or NULL if an error occurs.
+    It should be freed with `yyjson_writer_free()`.
+ */
+yyjson_api yyjson_writer *yyjson_writer_new_stream(yyjson_write_fn fn,
+                                                   void *ctx,
+                                                   yyjson_write_flag flg,
+                                                   size_t buf_size,
+                                                   const yyjson_alc *alc);
+
+/** Release the writer and its output.
+    If the writer is NULL, this function does nothing. */
+yyjson_api void yyjson_writer_free(yyjson_writer *w);
+
+/**
+ Completes the output, and passes the rest of the output to the callback of
+ the streaming writer.
+ 
+ @param w The writer.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return true if successful, false if any call on the writer failed or the
+    document is incomplete (e.g. a container is not closed).
+ */
+yyjson_api bool yyjson_writer_finish(yyjson_writer *w, yyjson_write_err *err);
+
+/**
+ Returns the output of a finished writer, the string is null-terminated and
+ valid until the writer is freed.
+ 
+ @param w The writer.
+ @param len A pointer to receive the output length in bytes (not including the
     null-terminator). Pass NULL if you don't need length information.
- @return A new JSON string, or NULL if an error occurs.
-    This string is encoded as UTF-8 with a null-terminator.
-    When it's no longer needed, it should be freed with free().
+ @return The output, or NULL if the writer is NULL, is a streaming writer or
+    is not finished successfully.
  */
-yyjson_api_inline char *yyjson_mut_val_write(const yyjson_mut_val *val,
-                                             yyjson_write_flag flg,
-                                             size_t *len) {
-    return yyjson_mut_val_write_opts(val, flg, NULL, len, NULL);
+yyjson_api const char *yyjson_writer_get_str(yyjson_writer *w, size_t *len);
+
+/** Begins an array as the next value. Returns false on error. */
+yyjson_api bool yyjson_writer_begin_arr(yyjson_writer *w);
+
+/** Ends the current array. Returns false on error. */
+yyjson_api bool yyjson_writer_end_arr(yyjson_writer *w);
+
+/** Begins an object as the next value. Returns false on error.
+    Each value in the object should be preceded by a key. */
+yyjson_api bool yyjson_writer_begin_obj(yyjson_writer *w);
+
+/** Ends the current object. Returns false on error. */
+yyjson_api bool yyjson_writer_end_obj(yyjson_writer *w);
+
+/** Writes a key in the current object. Returns false on error.
+    The `key` should be a UTF-8 string with the specified length. */
+yyjson_api bool yyjson_writer_keyn(yyjson_writer *w,
+                                   const char *key, size_t len);
+
+/** Writes a key in the current object. Returns false on error.
+    The `key` should be a null-terminated UTF-8 string. */
+yyjson_api_inline bool yyjson_writer_key(yyjson_writer *w, const char *key) {
+    return yyjson_writer_keyn(w, key, key ? strlen(key) : 0);
+}
+
+/** Writes a null value. Returns false on error. */
+yyjson_api bool yyjson_writer_null(yyjson_writer *w);
+
+/** Writes a bool value. Returns false on error. */
+yyjson_api bool yyjson_writer_bool(yyjson_writer *w, bool val);
+
+/** Writes an unsigned integer value. Returns false on error. */
+yyjson_api bool yyjson_writer_uint(yyjson_writer *w, uint64_t num);
+
+/** Writes a signed integer value. Returns false on error. */
+yyjson_api bool yyjson_writer_sint(yyjson_writer *w, int64_t num);
+
+/** Writes a signed integer value. Returns false on error. */
+yyjson_api_inline bool yyjson_writer_int(yyjson_writer *w, int64_t num) {
+    return yyjson_writer_sint(w, num);
+}
+
+/** Writes a double value. Returns false on error.
+    The nan and inf are written according to the write flags. */
+yyjson_api bool yyjson_writer_real(yyjson_writer *w, double num);
+
+/** Writes a string value. Returns false on error.
+    The `str` should be a UTF-8 string with the specified length. */
+yyjson_api bool yyjson_writer_strn(yyjson_writer *w,
+                                   const char *str, size_t len);
+
+/** Writes a string value. Returns false on error.
+    The `str` should be a null-terminated UTF-8 string. */
+yyjson_api_inline bool yyjson_writer_str(yyjson_writer *w, const char *str) {
+    return yyjson_writer_strn(w, str, str ? strlen(str) : 0);
+}
+
+/** Writes a raw value as is. Returns false on error.
+    The `raw` should be a valid JSON value with the specified length. */
+yyjson_api bool yyjson_writer_rawn(yyjson_writer *w,
+                                   const char *raw, size_t len);
+
+/** Writes a raw value as is. Returns false on error.
+    The `raw` should be a null-terminated valid JSON value. */
+yyjson_api_inline bool yyjson_writer_raw(yyjson_writer *w, const char *raw) {
+    return yyjson_writer_rawn(w, raw, raw ? strlen(raw) : 0);
 }
 
 #endif /* YYJSON_DISABLE_WRITER */
@@ -1982,10 +3220,37 @@ yyjson_api_inline yyjson_val *yyjson_obj_get(yyjson_val *obj, const char *key);
     The `key` should be a UTF-8 string, null-terminator is not required.
     The `key_len` should be the length of the key, in bytes.
     
-    @warning This function takes a linear search time. */
+    @warning This function takes a linear search time.
+    @see yyjson_doc_obj_getn() for the large objects in a document read with
+    `YYJSON_READ_KEY_INDEX`. */
 yyjson_api_inline yyjson_val *yyjson_obj_getn(yyjson_val *obj, const char *key,
                                               size_t key_len);
 
+/** Returns the value to which the specified key is mapped, in an object of
+    the document. Returns NULL if this object contains no mapping for the key.
+    Returns NULL if `obj/key` is NULL, or type is not object.
+    
+    The `key` should be a null-terminated UTF-8 string.
+    
+    If the document is read with `YYJSON_READ_KEY_INDEX`, a large object is
+    searched with the key index in constant time, otherwise this is the same
+    as `yyjson_obj_get()`. */
+yyjson_api yyjson_val *yyjson_doc_obj_get(yyjson_doc *doc, yyjson_val *obj,
+                                          const char *key);
+
+/** Returns the value to which the specified key is mapped, in an object of
+    the document. Returns NULL if this object contains no mapping for the key.
+    Returns NULL if `obj/key` is NULL, or type is not object.
+    
+    The `key` should be a UTF-8 string, null-terminator is not required.
+    The `key_len` should be the length of the key, in bytes.
+    
+    If the document is read with `YYJSON_READ_KEY_INDEX`, a large object is
+    searched with the key index in constant time, otherwise this is the same
+    as `yyjson_obj_getn()`. */
+yyjson_api yyjson_val *yyjson_doc_obj_getn(yyjson_doc *doc, yyjson_val *obj,
+                                           const char *key, size_t key_len);
+
 
 
 /*==============================================================================
@@ -3962,6 +5227,159 @@ yyjson_api_inline bool yyjson_mut_obj_rename_keyn(yyjson_mut_doc *doc,
 
 
 
+/*==============================================================================
+ * Mutable JSON Object Index API
+ *============================================================================*/
+
+/**
+ Builds a hash index for the keys of an object, so the key-value pairs can be
+ found, set and removed with the `yyjson_mut_doc_obj_*()` functions below in
+ constant time. The order of the pairs is kept as usual.
+ 
+ The index of all objects is a single table held by the document, it's
+ allocated from the value pool and grows with the objects. It takes 3 pointers
+ per key at a load factor of at most 0.5.
+ 
+ @param doc The document which holds the object.
+ @param obj The object to index, it does nothing if the object is indexed.
+ @return Whether successful, false if memory allocation failed.
+ @warning Once indexed, the object should only be modified with the
+    `yyjson_mut_doc_obj_*()` functions of the same document, other modification
+    functions (such as `yyjson_mut_obj_add()` or `yyjson_mut_obj_clear()`) do
+    not update the index. If the object has duplicated keys, the lookup may
+    find any one of them.
+ */
+yyjson_api bool yyjson_mut_doc_obj_index(yyjson_mut_doc *doc,
+                                         yyjson_mut_val *obj);
+
+/** Returns whether the object is indexed by the document. */
+yyjson_api bool yyjson_mut_doc_obj_is_indexed(yyjson_mut_doc *doc,
+                                              yyjson_mut_val *obj);
+
+/** Same as `yyjson_mut_obj_get()`, but uses the index of the document if the
+    object is indexed, see `yyjson_mut_doc_obj_index()`. */
+yyjson_api yyjson_mut_val *yyjson_mut_doc_obj_get(yyjson_mut_doc *doc,
+                                                  yyjson_mut_val *obj,
+                                                  const char *key);
+
+/** Same as `yyjson_mut_obj_getn()`, but uses the index of the document if the
+    object is indexed, see `yyjson_mut_doc_obj_index()`. */
+yyjson_api yyjson_mut_val *yyjson_mut_doc_obj_getn(yyjson_mut_doc *doc,
+                                                   yyjson_mut_val *obj,
+                                                   const char *key,
+                                                   size_t key_len);
+
+/** Same as `yyjson_mut_obj_add()`, but keeps the index of the document
+    updated if the object is indexed, see `yyjson_mut_doc_obj_index()`.
+    Returns false if the index cannot grow, and the object is unchanged. */
+yyjson_api bool yyjson_mut_doc_obj_add(yyjson_mut_doc *doc,
+                                       yyjson_mut_val *obj,
+                                       yyjson_mut_val *key,
+                                       yyjson_mut_val *val);
+
+/** Same as `yyjson_mut_obj_put()`, but keeps the index of the document
+    updated if the object is indexed, see `yyjson_mut_doc_obj_index()`.
+    An existing key keeps its position, a new key is added at the end. */
+yyjson_api bool yyjson_mut_doc_obj_put(yyjson_mut_doc *doc,
+                                       yyjson_mut_val *obj,
+                                       yyjson_mut_val *key,
+                                       yyjson_mut_val *val);
+
+/** Same as `yyjson_mut_obj_insert()`, but keeps the index of the document
+    updated if the object is indexed, see `yyjson_mut_doc_obj_index()`.
+    @warning This function takes a linear time to find the position. */
+yyjson_api bool yyjson_mut_doc_obj_insert(yyjson_mut_doc *doc,
+                                          yyjson_mut_val *obj,
+                                          yyjson_mut_val *key,
+                                          yyjson_mut_val *val,
+                                          size_t idx);
+
+/** Same as `yyjson_mut_obj_remove_key()`, but keeps the index of the document
+    updated if the object is indexed, see `yyjson_mut_doc_obj_index()`. */
+yyjson_api yyjson_mut_val *yyjson_mut_doc_obj_remove_key(yyjson_mut_doc *doc,
+                                                         yyjson_mut_val *obj,
+                                                         const char *key);
+
+/** Same as `yyjson_mut_obj_remove_keyn()`, but keeps the index of the
+    document updated if the object is indexed, see `yyjson_mut_doc_obj_index()`.
+ */
+yyjson_api yyjson_mut_val *yyjson_mut_doc_obj_remove_keyn(yyjson_mut_doc *doc,
+                                                          yyjson_mut_val *obj,
+                                                          const char *key,
+                                                          size_t key_len);
+
+
+
+/*==============================================================================
+ * Mutable JSON Array Index API
+ *============================================================================*/
+
+/**
+ Builds a vector of the values of an array, so the values can be accessed,
+ inserted and removed by index with the `yyjson_mut_doc_arr_*()` functions
+ below without a linear search. The values are still linked as usual, so the
+ iterators and the writers work with the array as before.
+ 
+ The vector is allocated from the value pool of the document, it takes one
+ pointer per value, and a new vector is allocated when it's full.
+ 
+ @param doc The document which holds the array.
+ @param arr The array to index, it does nothing if the array is indexed.
+ @return Whether successful, false if memory allocation failed.
+ @warning Once indexed, the array should only be modified with the
+    `yyjson_mut_doc_arr_*()` functions of the same document, other modification
+    functions (such as `yyjson_mut_arr_append()` or `yyjson_mut_arr_clear()`)
+    do not update the vector.
+ */
+yyjson_api bool yyjson_mut_doc_arr_index(yyjson_mut_doc *doc,
+                                         yyjson_mut_val *arr);
+
+/** Returns whether the array is indexed by the document. */
+yyjson_api bool yyjson_mut_doc_arr_is_indexed(yyjson_mut_doc *doc,
+                                              yyjson_mut_val *arr);
+
+/** Same as `yyjson_mut_arr_get()`, but takes a constant time if the array is
+    indexed, see `yyjson_mut_doc_arr_index()`. */
+yyjson_api yyjson_mut_val *yyjson_mut_doc_arr_get(yyjson_mut_doc *doc,
+                                                  yyjson_mut_val *arr,
+                                                  size_t idx);
+
+/** Same as `yyjson_mut_arr_insert()`, but doesn't take a linear search time
+    if the array is indexed, see `yyjson_mut_doc_arr_index()`.
+    Returns false if the vector cannot grow, and the array is unchanged. */
+yyjson_api bool yyjson_mut_doc_arr_insert(yyjson_mut_doc *doc,
+                                          yyjson_mut_val *arr,
+                                          yyjson_mut_val *val,
+                                          size_t idx);
+
+/** Same as `yyjson_mut_arr_append()`, but keeps the vector updated if the
+    array is indexed, see `yyjson_mut_doc_arr_index()`.
+    Returns false if the vector cannot grow, and the array is unchanged. */
+yyjson_api bool yyjson_mut_doc_arr_append(yyjson_mut_doc *doc,
+                                          yyjson_mut_val *arr,
+                                          yyjson_mut_val *val);
+
+/** Same as `yyjson_mut_arr_replace()`, but takes a constant time if the array
+    is indexed, see `yyjson_mut_doc_arr_index()`. */
+yyjson_api yyjson_mut_val *yyjson_mut_doc_arr_replace(yyjson_mut_doc *doc,
+                                                      yyjson_mut_val *arr,
+                                                      size_t idx,
+                                                      yyjson_mut_val *val);
+
+/** Same as `yyjson_mut_arr_remove()`, but doesn't take a linear search time
+    if the array is indexed, see `yyjson_mut_doc_arr_index()`. */
+yyjson_api yyjson_mut_val *yyjson_mut_doc_arr_remove(yyjson_mut_doc *doc,
+                                                     yyjson_mut_val *arr,
+                                                     size_t idx);
+
+/** Same as `yyjson_mut_arr_remove_range()`, but doesn't take a linear search
+    time if the array is indexed, see `yyjson_mut_doc_arr_index()`. */
+yyjson_api bool yyjson_mut_doc_arr_remove_range(yyjson_mut_doc *doc,
+                                                yyjson_mut_val *arr,
+                                                size_t idx, size_t len);
+
+
+
 #if !defined(YYJSON_DISABLE_UTILS) || !YYJSON_DISABLE_UTILS
 
 /*==============================================================================
@@ -4683,6 +6101,8 @@ struct yyjson_doc {
     size_t val_read;
     /** The string pool used by JSON values (nullable). */
     char *str_pool;
+    /** The key index of large objects (nullable), see YYJSON_READ_KEY_INDEX. */
+    void *key_idx;
 };
 
 
@@ -5037,6 +6457,7 @@ yyjson_api_inline void yyjson_doc_free(yyjson_doc *doc) {
         yyjson_alc alc = doc->alc;
         memset(&doc->alc, 0, sizeof(alc));
         if (doc->str_pool) alc.free_(alc.ctx, doc->str_pool);
+        if (doc->key_idx) alc.free_(alc.ctx, doc->key_idx);
         alc.free_(alc.ctx, doc);
     }
 }
@@ -5545,6 +6966,7 @@ struct yyjson_mut_doc {
     yyjson_alc alc; /**< a valid allocator, nonnull */
     yyjson_str_pool str_pool; /**< string memory pool */
     yyjson_val_pool val_pool; /**< value memory pool */
+    void *obj_idx; /**< index of the indexed containers, nullable */
 };
 
 /* Ensures the capacity to at least equal to the specified byte length. */
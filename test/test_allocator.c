@@ -15,22 +15,22 @@ static void test_alc_pool_init(void) {
     
     memset(&alc, 0, sizeof(alc));
     yy_assert(!yyjson_alc_pool_init(&alc, NULL, 0));
-    yy_assert(!alc.malloc(NULL, 1));
-    yy_assert(!alc.realloc(NULL, NULL, 0, 1));
-    alc.free(NULL, NULL);
+    yy_assert(!alc.malloc_(NULL, 1));
+    yy_assert(!alc.realloc_(NULL, NULL, 0, 1));
+    alc.free_(NULL, NULL);
     
     memset(&alc, 0, sizeof(alc));
     yy_assert(!yyjson_alc_pool_init(&alc, NULL, 1024));
-    yy_assert(!alc.malloc(NULL, 1));
-    yy_assert(!alc.realloc(NULL, NULL, 0, 1));
-    alc.free(NULL, NULL);
+    yy_assert(!alc.malloc_(NULL, 1));
+    yy_assert(!alc.realloc_(NULL, NULL, 0, 1));
+    alc.free_(NULL, NULL);
     
     char small_buf[10];
     memset(&alc, 0, sizeof(alc));
     yy_assert(!yyjson_alc_pool_init(&alc, small_buf, sizeof(small_buf)));
-    yy_assert(!alc.malloc(NULL, 1));
-    yy_assert(!alc.realloc(NULL, NULL, 0, 1));
-    alc.free(NULL, NULL);
+    yy_assert(!alc.malloc_(NULL, 1));
+    yy_assert(!alc.realloc_(NULL, NULL, 0, 1));
+    alc.free_(NULL, NULL);
     
     size = 8 * sizeof(void *) - 1;
     buf = malloc(size);
@@ -47,100 +47,100 @@ static void test_alc_pool_func(void) {
     
     
     // suc and fail
-    ptr[0] = alc.malloc(alc.ctx, BUF_SIZE / 2);
+    ptr[0] = alc.malloc_(alc.ctx, BUF_SIZE / 2);
     yy_assert(ptr[0]);
     memset(ptr[0], 0, BUF_SIZE / 2);
-    ptr[1] = alc.malloc(alc.ctx, BUF_SIZE / 2);
+    ptr[1] = alc.malloc_(alc.ctx, BUF_SIZE / 2);
     yy_assert(!ptr[1]);
-    alc.free(alc.ctx, ptr[0]);
+    alc.free_(alc.ctx, ptr[0]);
     
     
     // alc large, free, alc again
     for (int i = 0; i < NUM_PTR; i++) {
-        ptr[i] = alc.malloc(alc.ctx, 32);
+        ptr[i] = alc.malloc_(alc.ctx, 32);
         yy_assert(ptr[i]);
         memset(ptr[i], 0, 32);
     }
     for (int i = 0; i < NUM_PTR; i += 2) {
-        alc.free(alc.ctx, ptr[i]);
+        alc.free_(alc.ctx, ptr[i]);
     }
     for (int i = 0; i < NUM_PTR; i += 2) {
-        ptr[i] = alc.malloc(alc.ctx, 16);
+        ptr[i] = alc.malloc_(alc.ctx, 16);
         yy_assert(ptr[i]);
         memset(ptr[i], 0, 16);
     }
     for (int i = NUM_PTR - 1; i >= 0; i--) {
-        alc.free(alc.ctx, ptr[i]);
+        alc.free_(alc.ctx, ptr[i]);
     }
     
     
     // alc large, free, alc small
     for (int i = 0; i < NUM_PTR; i++) {
-        ptr[i] = alc.malloc(alc.ctx, 32);
+        ptr[i] = alc.malloc_(alc.ctx, 32);
         yy_assert(ptr[i]);
         memset(ptr[i], 0, 32);
     }
     for (int i = 0; i < NUM_PTR; i += 2) {
-        alc.free(alc.ctx, ptr[i]);
+        alc.free_(alc.ctx, ptr[i]);
     }
     for (int i = 0; i < NUM_PTR; i += 2) {
-        ptr[i] = alc.malloc(alc.ctx, 1);
+        ptr[i] = alc.malloc_(alc.ctx, 1);
         yy_assert(ptr[i]);
         memset(ptr[i], 0, 1);
     }
     for (int i = NUM_PTR - 1; i >= 0; i--) {
-        alc.free(alc.ctx, ptr[i]);
+        alc.free_(alc.ctx, ptr[i]);
     }
     
     
     // alc small, free, alc large
     for (int i = 0; i < NUM_PTR; i++) {
-        ptr[i] = alc.malloc(alc.ctx, 16);
+        ptr[i] = alc.malloc_(alc.ctx, 16);
         yy_assert(ptr[i]);
         memset(ptr[i], 0, 16);
     }
     for (int i = 0; i < NUM_PTR; i += 2) {
-        alc.free(alc.ctx, ptr[i]);
+        alc.free_(alc.ctx, ptr[i]);
     }
     for (int i = 0; i < NUM_PTR; i += 2) {
-        ptr[i] = alc.malloc(alc.ctx, 32);
+        ptr[i] = alc.malloc_(alc.ctx, 32);
         yy_assert(ptr[i]);
         memset(ptr[i], 0, 32);
     }
     for (int i = 0; i < NUM_PTR; i++) {
-        alc.free(alc.ctx, ptr[i]);
+        alc.free_(alc.ctx, ptr[i]);
     }
     
     
     // alc small, realloc large
     for (int i = 0; i < NUM_PTR / 2; i++) {
-        ptr[i] = alc.malloc(alc.ctx, 8);
+        ptr[i] = alc.malloc_(alc.ctx, 8);
         yy_assert(ptr[i]);
         memset(ptr[i], 0, 8);
     }
     for (int i = 0; i < NUM_PTR / 2; i += 2) {
-        alc.free(alc.ctx, ptr[i]);
+        alc.free_(alc.ctx, ptr[i]);
     }
     for (int i = 1; i < NUM_PTR / 2; i += 2) {
-        ptr[i] = alc.realloc(alc.ctx, ptr[i], 8, 32);
+        ptr[i] = alc.realloc_(alc.ctx, ptr[i], 8, 32);
         yy_assert(ptr[i]);
         memset(ptr[i], 0, 32);
     }
     for (int i = 0; i < NUM_PTR / 2; i += 2) {
-        ptr[i] = alc.malloc(alc.ctx, 16);
+        ptr[i] = alc.malloc_(alc.ctx, 16);
         yy_assert(ptr[i]);
         memset(ptr[i], 0, 16);
     }
     for (int i = 0; i < NUM_PTR / 2; i++) {
-        alc.free(alc.ctx, ptr[i]);
+        alc.free_(alc.ctx, ptr[i]);
     }
     
     
     // same space realloc
-    ptr[0] = alc.malloc(alc.ctx, 64);
-    ptr[0] = alc.realloc(alc.ctx, ptr[0], 64, 128);
+    ptr[0] = alc.malloc_(alc.ctx, 64);
+    ptr[0] = alc.realloc_(alc.ctx, ptr[0], 64, 128);
     yy_assert(ptr[0]);
-    alc.free(alc.ctx, ptr[0]);
+    alc.free_(alc.ctx, ptr[0]);
     
     
     // random
@@ -155,25 +155,25 @@ static void test_alc_pool_func(void) {
         if (tmp) {
             bool is_realloc = (yy_rand_u32_uniform(4) == 0);
             if (is_realloc) {
-                tmp = alc.realloc(alc.ctx, tmp, tmp_size, tmp_size + inc);
+                tmp = alc.realloc_(alc.ctx, tmp, tmp_size, tmp_size + inc);
                 if (tmp) {
                     ptr[i] = tmp;
                     ptr_size[i] += inc;
                 }
             } else {
-                alc.free(alc.ctx, tmp);
+                alc.free_(alc.ctx, tmp);
                 ptr[i] = NULL;
                 ptr_size[i] = 0;
             }
         } else {
-            tmp = alc.malloc(alc.ctx, inc);
+            tmp = alc.malloc_(alc.ctx, inc);
             if (tmp) memset(tmp, 0xFF, inc);
             ptr[i] = tmp;
             ptr_size[i] = tmp ? inc : 0;
         }
     }
     for (int i = 0; i < NUM_PTR; i++) {
-        if (ptr[i]) alc.free(alc.ctx, ptr[i]);
+        if (ptr[i]) alc.free_(alc.ctx, ptr[i]);
     }
     
     
@@ -248,18 +248,18 @@ static void test_alc_dyn(void) {
     // new and destroy
     alc = yyjson_alc_dyn_new();
     yy_assert(alc);
-    yy_assert(!alc->malloc(alc->ctx, SIZE_MAX));
-    yy_assert(!alc->malloc(alc->ctx, SIZE_MAX - 16));
+    yy_assert(!alc->malloc_(alc->ctx, SIZE_MAX));
+    yy_assert(!alc->malloc_(alc->ctx, SIZE_MAX - 16));
     yyjson_alc_dyn_free(alc);
     yyjson_alc_dyn_free(NULL);
     
     
     // new, alloc, destroy
     alc = yyjson_alc_dyn_new();
-    ptr[0] = alc->malloc(alc->ctx, 0x100);
+    ptr[0] = alc->malloc_(alc->ctx, 0x100);
     yy_assert(ptr[0]);
     memset(ptr[0], 0xFF, 0x100);
-    alc->free(alc->ctx, ptr[0]);
+    alc->free_(alc->ctx, ptr[0]);
     yyjson_alc_dyn_free(alc);
     
     
@@ -268,10 +268,10 @@ static void test_alc_dyn(void) {
     yy_rand_reset(0);
     for (int p = 0; p < 1000; p++) {
         usize len = yy_rand_u32_uniform(0x4000) + 1;
-        ptr[0] = alc->malloc(alc->ctx, len);
+        ptr[0] = alc->malloc_(alc->ctx, len);
         yy_assert(ptr[0]);
         memset(ptr[0], 0xFF, len);
-        alc->free(alc->ctx, ptr[0]);
+        alc->free_(alc->ctx, ptr[0]);
     }
     yyjson_alc_dyn_free(alc);
     
@@ -281,10 +281,10 @@ static void test_alc_dyn(void) {
     yy_rand_reset(0);
     for (int p = 0; p < 1000; p++) {
         usize len = yy_rand_u32_uniform(0x4000) + 1;
-        ptr[0] = alc->malloc(alc->ctx, len);
+        ptr[0] = alc->malloc_(alc->ctx, len);
         yy_assert(ptr[0]);
         memset(ptr[0], 0xFF, len);
-        alc->free(alc->ctx, ptr[0]);
+        alc->free_(alc->ctx, ptr[0]);
     }
     yyjson_alc_dyn_free(alc);
     
@@ -295,13 +295,13 @@ static void test_alc_dyn(void) {
     for (int p = 0; p < 1000; p++) {
         usize len = yy_rand_u32_uniform(0x4000) + 1;
         usize inc = yy_rand_u32_uniform(0x4000) + 1;
-        ptr[0] = alc->malloc(alc->ctx, len);
+        ptr[0] = alc->malloc_(alc->ctx, len);
         yy_assert(ptr[0]);
         memset(ptr[0], 0xFF, len);
-        ptr[0] = alc->realloc(alc->ctx, ptr[0], len, len + inc);
+        ptr[0] = alc->realloc_(alc->ctx, ptr[0], len, len + inc);
         yy_assert(ptr[0]);
         memset(ptr[0], 0xFF, len + inc);
-        alc->free(alc->ctx, ptr[0]);
+        alc->free_(alc->ctx, ptr[0]);
     }
     yyjson_alc_dyn_free(alc);
     
@@ -319,19 +319,19 @@ static void test_alc_dyn(void) {
         if (tmp) {
             bool is_realloc = (yy_rand_u32_uniform(4) == 0);
             if (is_realloc) {
-                tmp = alc->realloc(alc->ctx, tmp, tmp_size, tmp_size + inc);
+                tmp = alc->realloc_(alc->ctx, tmp, tmp_size, tmp_size + inc);
                 if (tmp) {
                     memset(tmp, 0xFF, tmp_size + inc);
                     ptr[i] = tmp;
                     ptr_size[i] += inc;
                 }
             } else {
-                alc->free(alc->ctx, tmp);
+                alc->free_(alc->ctx, tmp);
                 ptr[i] = NULL;
                 ptr_size[i] = 0;
             }
         } else {
-            tmp = alc->malloc(alc->ctx, inc);
+            tmp = alc->malloc_(alc->ctx, inc);
             if (tmp) memset(tmp, 0xFF, inc);
             ptr[i] = tmp;
             ptr_size[i] = tmp ? inc : 0;
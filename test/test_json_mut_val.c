@@ -2288,10 +2288,367 @@ static void test_json_mut_equals_api(void) {
 }]", true);
 }
 
+/// Validate an indexed object with a plain object.
+static void validate_mut_obj_index(yyjson_mut_doc *doc, yyjson_mut_val *obj,
+                                   yyjson_mut_val *ref) {
+    char *obj_json = yyjson_mut_val_write(obj, 0, NULL);
+    char *ref_json = yyjson_mut_val_write(ref, 0, NULL);
+    yy_assert(obj_json && ref_json && strcmp(obj_json, ref_json) == 0);
+    free(obj_json);
+    free(ref_json);
+    
+    yyjson_mut_val *key, *val;
+    size_t idx, max;
+    yyjson_mut_obj_foreach(obj, idx, max, key, val) {
+        const char *str = yyjson_mut_get_str(key);
+        size_t len = yyjson_mut_get_len(key);
+        yy_assert(yyjson_mut_doc_obj_getn(doc, obj, str, len) == val);
+        yy_assert(yyjson_mut_equals(yyjson_mut_obj_getn(ref, str, len), val));
+    }
+    yy_assert(!yyjson_mut_doc_obj_get(doc, obj, "not_exist"));
+}
+
+static void test_json_mut_obj_index_api(void) {
+    yyjson_mut_doc *doc;
+    yyjson_mut_val *obj, *ref, *key, *val;
+    char keys[256][8];
+    
+    for (int i = 0; i < 256; i++) snprintf(keys[i], sizeof(keys[i]), "k%d", i);
+    
+    // random operations, compared with a plain object
+    doc = yyjson_mut_doc_new(NULL);
+    obj = yyjson_mut_obj(doc);
+    ref = yyjson_mut_obj(doc);
+    yy_assert(!yyjson_mut_doc_obj_is_indexed(doc, obj));
+    yy_assert(yyjson_mut_doc_obj_index(doc, obj));
+    yy_assert(yyjson_mut_doc_obj_index(doc, obj));
+    yy_assert(yyjson_mut_doc_obj_is_indexed(doc, obj));
+    yy_assert(!yyjson_mut_doc_obj_is_indexed(doc, ref));
+    yy_rand_reset(0);
+    for (int n = 0; n < 5000; n++) {
+        const char *str = keys[yy_rand_u32_uniform(256)];
+        u32 op = yy_rand_u32_uniform(4);
+        int num = (int)yy_rand_u32_uniform(1000);
+        bool has = yyjson_mut_obj_get(ref, str) != NULL;
+        if (op == 0 && !has) {
+            yy_assert(yyjson_mut_doc_obj_add(doc, obj, yyjson_mut_str(doc, str),
+                                             yyjson_mut_int(doc, num)));
+            yyjson_mut_obj_add(ref, yyjson_mut_str(doc, str),
+                               yyjson_mut_int(doc, num));
+        } else if (op == 0 || op == 1) {
+            val = (num % 8) ? yyjson_mut_int(doc, num) : NULL;
+            yy_assert(yyjson_mut_doc_obj_put(doc, obj, yyjson_mut_str(doc, str),
+                                             val));
+            yyjson_mut_obj_put(ref, yyjson_mut_str(doc, str),
+                               val ? yyjson_mut_int(doc, num) : NULL);
+        } else if (op == 2 && !has) {
+            size_t pos = yy_rand_u32_uniform(
+                (u32)yyjson_mut_obj_size(ref) + 1);
+            yy_assert(yyjson_mut_doc_obj_insert(doc, obj,
+                yyjson_mut_str(doc, str), yyjson_mut_int(doc, num), pos));
+            yyjson_mut_obj_insert(ref, yyjson_mut_str(doc, str),
+                                  yyjson_mut_int(doc, num), pos);
+        } else {
+            val = yyjson_mut_doc_obj_remove_key(doc, obj, str);
+            yyjson_mut_val *ref_val = yyjson_mut_obj_remove_key(ref, str);
+            yy_assert(!val == !ref_val);
+            yy_assert(!val || yyjson_mut_equals(val, ref_val));
+        }
+        if (n % 100 == 0) validate_mut_obj_index(doc, obj, ref);
+    }
+    validate_mut_obj_index(doc, obj, ref);
+    
+    // remove all pairs
+    while (yyjson_mut_obj_size(obj)) {
+        key = ((yyjson_mut_val *)obj->uni.ptr)->next->next;
+        yy_assert(yyjson_mut_doc_obj_remove_keyn(doc, obj, key->uni.str,
+                                                 yyjson_mut_get_len(key)));
+    }
+    yy_assert(!yyjson_mut_doc_obj_get(doc, obj, "k0"));
+    yy_assert(yyjson_mut_doc_obj_insert(doc, obj, yyjson_mut_str(doc, "a"),
+                                        yyjson_mut_int(doc, 1), 0));
+    yy_assert(!yyjson_mut_doc_obj_insert(doc, obj, yyjson_mut_str(doc, "b"),
+                                         yyjson_mut_int(doc, 2), 2));
+    yy_assert(yyjson_mut_doc_obj_insert(doc, obj, yyjson_mut_str(doc, "b"),
+                                        yyjson_mut_int(doc, 2), 0));
+    yy_assert(yyjson_mut_doc_obj_insert(doc, obj, yyjson_mut_str(doc, "c"),
+                                        yyjson_mut_int(doc, 3), 2));
+    yy_assert(yyjson_mut_doc_obj_insert(doc, obj, yyjson_mut_str(doc, "d"),
+                                        yyjson_mut_int(doc, 4), 1));
+    char *json = yyjson_mut_val_write(obj, 0, NULL);
+    yy_assert(json && strcmp(json, "{\"b\":2,\"d\":4,\"a\":1,\"c\":3}") == 0);
+    free(json);
+    yy_assert(yyjson_mut_get_int(yyjson_mut_doc_obj_get(doc, obj, "d")) == 4);
+    yyjson_mut_doc_free(doc);
+    
+    // indexed object with duplicated keys
+    doc = yyjson_mut_doc_new(NULL);
+    obj = yyjson_mut_obj(doc);
+    yyjson_mut_obj_add_int(doc, obj, "a", 1);
+    yyjson_mut_obj_add_int(doc, obj, "b", 2);
+    yyjson_mut_obj_add_int(doc, obj, "a", 3);
+    yyjson_mut_obj_add_int(doc, obj, "c", 4);
+    yyjson_mut_obj_add_int(doc, obj, "a", 5);
+    yy_assert(yyjson_mut_doc_obj_index(doc, obj));
+    val = yyjson_mut_doc_obj_get(doc, obj, "a");
+    yy_assert(val && yyjson_mut_get_int(val) % 2 == 1);
+    yy_assert(yyjson_mut_doc_obj_add(doc, obj, yyjson_mut_str(doc, "b"),
+                                     yyjson_mut_int(doc, 6)));
+    yy_assert(yyjson_mut_obj_size(obj) == 6);
+    yy_assert(yyjson_mut_doc_obj_put(doc, obj, yyjson_mut_str(doc, "a"),
+                                     yyjson_mut_int(doc, 7)));
+    yy_assert(yyjson_mut_obj_size(obj) == 4);
+    yy_assert(yyjson_mut_get_int(yyjson_mut_doc_obj_get(doc, obj, "a")) == 7);
+    yy_assert(yyjson_mut_doc_obj_remove_key(doc, obj, "b"));
+    json = yyjson_mut_val_write(obj, 0, NULL);
+    yy_assert(json && (strcmp(json, "{\"a\":7,\"c\":4}") == 0 ||
+                       strcmp(json, "{\"c\":4,\"a\":7}") == 0));
+    free(json);
+    yy_assert(yyjson_mut_doc_obj_put(doc, obj, yyjson_mut_str(doc, "a"), NULL));
+    yy_assert(yyjson_mut_doc_obj_put(doc, obj, yyjson_mut_str(doc, "x"), NULL));
+    json = yyjson_mut_val_write(obj, 0, NULL);
+    yy_assert(json && strcmp(json, "{\"c\":4}") == 0);
+    free(json);
+    
+    // objects without index, and invalid parameters
+    ref = yyjson_mut_obj(doc);
+    yy_assert(yyjson_mut_doc_obj_add(doc, ref, yyjson_mut_str(doc, "a"),
+                                     yyjson_mut_int(doc, 1)));
+    yy_assert(yyjson_mut_doc_obj_add(NULL, ref, yyjson_mut_str(doc, "b"),
+                                     yyjson_mut_int(doc, 2)));
+    yy_assert(yyjson_mut_doc_obj_put(doc, ref, yyjson_mut_str(doc, "a"),
+                                     yyjson_mut_int(doc, 3)));
+    yy_assert(yyjson_mut_doc_obj_insert(doc, ref, yyjson_mut_str(doc, "c"),
+                                        yyjson_mut_int(doc, 4), 0));
+    yy_assert(yyjson_mut_get_int(yyjson_mut_doc_obj_get(doc, ref, "a")) == 3);
+    yy_assert(yyjson_mut_get_int(yyjson_mut_doc_obj_remove_key(doc, ref, "b"))
+              == 2);
+    json = yyjson_mut_val_write(ref, 0, NULL);
+    yy_assert(json && strcmp(json, "{\"c\":4,\"a\":3}") == 0);
+    free(json);
+    yy_assert(!yyjson_mut_doc_obj_index(NULL, ref));
+    yy_assert(!yyjson_mut_doc_obj_index(doc, NULL));
+    yy_assert(!yyjson_mut_doc_obj_index(doc, yyjson_mut_arr(doc)));
+    yy_assert(!yyjson_mut_doc_obj_is_indexed(NULL, obj));
+    yy_assert(!yyjson_mut_doc_obj_is_indexed(doc, NULL));
+    yy_assert(!yyjson_mut_doc_obj_get(doc, obj, NULL));
+    yy_assert(!yyjson_mut_doc_obj_get(doc, NULL, "a"));
+    yy_assert(!yyjson_mut_doc_obj_add(doc, obj, NULL, yyjson_mut_int(doc, 1)));
+    yy_assert(!yyjson_mut_doc_obj_add(doc, obj, yyjson_mut_int(doc, 1),
+                                      yyjson_mut_int(doc, 1)));
+    yy_assert(!yyjson_mut_doc_obj_add(doc, obj, yyjson_mut_str(doc, "a"), NULL));
+    yy_assert(!yyjson_mut_doc_obj_put(doc, obj, NULL, NULL));
+    yy_assert(!yyjson_mut_doc_obj_insert(doc, obj, yyjson_mut_str(doc, "a"),
+                                         NULL, 0));
+    yy_assert(!yyjson_mut_doc_obj_remove_key(doc, obj, NULL));
+    yy_assert(!yyjson_mut_doc_obj_remove_keyn(doc, NULL, "a", 1));
+    yy_assert(yyjson_mut_obj_size(obj) == 1);
+    yyjson_mut_doc_free(doc);
+    
+    // memory allocation failure
+    char buf[4096];
+    yyjson_alc alc;
+    yy_assert(yyjson_alc_pool_init(&alc, buf, sizeof(buf)));
+    doc = yyjson_mut_doc_new(&alc);
+    yy_assert(doc);
+    yy_assert(yyjson_mut_doc_set_val_pool_size(doc, 8));
+    obj = yyjson_mut_obj(doc);
+    yy_assert(yyjson_mut_doc_obj_index(doc, obj));
+    int count = 0;
+    bool idx_fail = false;
+    while (count < 256) {
+        key = yyjson_mut_str(doc, keys[count]);
+        val = yyjson_mut_int(doc, count);
+        if (!key || !val) break;
+        if (!yyjson_mut_doc_obj_add(doc, obj, key, val)) {
+            idx_fail = true;
+            break;
+        }
+        count++;
+    }
+    yy_assert(idx_fail && count > 0);
+    yy_assert(yyjson_mut_obj_size(obj) == (size_t)count);
+    for (int i = 0; i < count; i++) {
+        yy_assert(yyjson_mut_get_int(yyjson_mut_doc_obj_get(doc, obj, keys[i]))
+                  == i);
+    }
+    yyjson_mut_doc_free(doc);
+}
+
+
+
+/// Validate an indexed array with a plain array.
+static void validate_mut_arr_index(yyjson_mut_doc *doc, yyjson_mut_val *arr,
+                                   yyjson_mut_val *ref) {
+    char *arr_json = yyjson_mut_val_write(arr, 0, NULL);
+    char *ref_json = yyjson_mut_val_write(ref, 0, NULL);
+    yy_assert(arr_json && ref_json && strcmp(arr_json, ref_json) == 0);
+    free(arr_json);
+    free(ref_json);
+    
+    yyjson_mut_val *val;
+    size_t idx, max;
+    yyjson_mut_arr_foreach(arr, idx, max, val) {
+        yy_assert(yyjson_mut_doc_arr_get(doc, arr, idx) == val);
+    }
+    yy_assert(!yyjson_mut_doc_arr_get(doc, arr, max));
+}
+
+static void test_json_mut_arr_index_api(void) {
+    yyjson_mut_doc *doc;
+    yyjson_mut_val *arr, *ref, *val, *old;
+    
+    // random operations, compared with a plain array
+    doc = yyjson_mut_doc_new(NULL);
+    arr = yyjson_mut_arr(doc);
+    ref = yyjson_mut_arr(doc);
+    for (int i = 0; i < 10; i++) {
+        yyjson_mut_arr_add_int(doc, arr, i);
+        yyjson_mut_arr_add_int(doc, ref, i);
+    }
+    yy_assert(!yyjson_mut_doc_arr_is_indexed(doc, arr));
+    yy_assert(yyjson_mut_doc_arr_index(doc, arr));
+    yy_assert(yyjson_mut_doc_arr_index(doc, arr));
+    yy_assert(yyjson_mut_doc_arr_is_indexed(doc, arr));
+    yy_assert(!yyjson_mut_doc_arr_is_indexed(doc, ref));
+    validate_mut_arr_index(doc, arr, ref);
+    yy_rand_reset(0);
+    for (int n = 0; n < 5000; n++) {
+        size_t len = yyjson_mut_arr_size(ref);
+        size_t idx = yy_rand_u32_uniform((u32)len + 2);
+        size_t num = yy_rand_u32_uniform(4);
+        int op = (int)yy_rand_u32_uniform(5);
+        if (op == 0 || op == 1) {
+            yy_assert(yyjson_mut_doc_arr_insert(doc, arr,
+                yyjson_mut_int(doc, n), idx) == (idx <= len));
+            yyjson_mut_arr_insert(ref, yyjson_mut_int(doc, n), idx);
+        } else if (op == 2) {
+            yy_assert(yyjson_mut_doc_arr_append(doc, arr,
+                                                yyjson_mut_int(doc, n)));
+            yyjson_mut_arr_append(ref, yyjson_mut_int(doc, n));
+        } else if (op == 3) {
+            val = yyjson_mut_int(doc, n);
+            old = yyjson_mut_doc_arr_replace(doc, arr, idx, val);
+            yy_assert(!old == (idx >= len));
+            yy_assert(!old || yyjson_mut_equals(old,
+                yyjson_mut_arr_replace(ref, idx, yyjson_mut_int(doc, n))));
+        } else if (num == 1) {
+            old = yyjson_mut_doc_arr_remove(doc, arr, idx);
+            yy_assert(!old == (idx >= len));
+            yy_assert(!old || yyjson_mut_equals(old,
+                                                yyjson_mut_arr_remove(ref, idx)));
+        } else {
+            yy_assert(yyjson_mut_doc_arr_remove_range(doc, arr, idx, num) ==
+                      (idx + num <= len));
+            yyjson_mut_arr_remove_range(ref, idx, num);
+        }
+        yy_assert(yyjson_mut_arr_size(arr) == yyjson_mut_arr_size(ref));
+        if (n % 100 == 0) validate_mut_arr_index(doc, arr, ref);
+    }
+    validate_mut_arr_index(doc, arr, ref);
+    
+    // remove all and add again
+    yy_assert(yyjson_mut_doc_arr_remove_range(doc, arr, 0,
+                                              yyjson_mut_arr_size(arr)));
+    yy_assert(yyjson_mut_arr_size(arr) == 0);
+    yy_assert(!yyjson_mut_doc_arr_get(doc, arr, 0));
+    yy_assert(!yyjson_mut_doc_arr_remove(doc, arr, 0));
+    yy_assert(!yyjson_mut_doc_arr_remove_range(doc, arr, 0, 1));
+    yy_assert(!yyjson_mut_doc_arr_remove_range(doc, arr, 1, SIZE_MAX));
+    yy_assert(yyjson_mut_doc_arr_remove_range(doc, arr, 0, 0));
+    yy_assert(yyjson_mut_doc_arr_insert(doc, arr, yyjson_mut_int(doc, 2), 0));
+    yy_assert(yyjson_mut_doc_arr_replace(doc, arr, 0, yyjson_mut_int(doc, 3)));
+    yy_assert(yyjson_mut_doc_arr_insert(doc, arr, yyjson_mut_int(doc, 1), 0));
+    yy_assert(yyjson_mut_doc_arr_append(doc, arr, yyjson_mut_int(doc, 5)));
+    yy_assert(yyjson_mut_doc_arr_insert(doc, arr, yyjson_mut_int(doc, 4), 2));
+    char *json = yyjson_mut_val_write(arr, 0, NULL);
+    yy_assert(json && strcmp(json, "[1,3,4,5]") == 0);
+    free(json);
+    yy_assert(yyjson_mut_get_int(yyjson_mut_arr_get_last(arr)) == 5);
+    yy_assert(yyjson_mut_get_int(yyjson_mut_doc_arr_get(doc, arr, 3)) == 5);
+    yyjson_mut_doc_free(doc);
+    
+    // arrays without index, and invalid parameters
+    doc = yyjson_mut_doc_new(NULL);
+    arr = yyjson_mut_arr(doc);
+    yy_assert(yyjson_mut_doc_arr_append(doc, arr, yyjson_mut_int(doc, 2)));
+    yy_assert(yyjson_mut_doc_arr_append(NULL, arr, yyjson_mut_int(doc, 3)));
+    yy_assert(yyjson_mut_doc_arr_insert(doc, arr, yyjson_mut_int(doc, 1), 0));
+    yy_assert(yyjson_mut_get_int(yyjson_mut_doc_arr_get(doc, arr, 2)) == 3);
+    yy_assert(yyjson_mut_get_int(yyjson_mut_doc_arr_replace(doc, arr, 2,
+        yyjson_mut_int(doc, 4))) == 3);
+    yy_assert(yyjson_mut_get_int(yyjson_mut_doc_arr_remove(doc, arr, 0)) == 1);
+    yy_assert(yyjson_mut_doc_arr_remove_range(doc, arr, 0, 1));
+    json = yyjson_mut_val_write(arr, 0, NULL);
+    yy_assert(json && strcmp(json, "[4]") == 0);
+    free(json);
+    yy_assert(!yyjson_mut_doc_arr_index(NULL, arr));
+    yy_assert(!yyjson_mut_doc_arr_index(doc, NULL));
+    yy_assert(!yyjson_mut_doc_arr_index(doc, yyjson_mut_obj(doc)));
+    yy_assert(!yyjson_mut_doc_arr_is_indexed(NULL, arr));
+    yy_assert(yyjson_mut_doc_arr_index(doc, arr));
+    yy_assert(!yyjson_mut_doc_arr_is_indexed(doc, NULL));
+    yy_assert(!yyjson_mut_doc_obj_is_indexed(doc, arr));
+    yy_assert(!yyjson_mut_doc_arr_get(doc, NULL, 0));
+    yy_assert(!yyjson_mut_doc_arr_insert(doc, arr, NULL, 0));
+    yy_assert(!yyjson_mut_doc_arr_insert(doc, arr, yyjson_mut_int(doc, 1), 2));
+    yy_assert(!yyjson_mut_doc_arr_append(doc, arr, NULL));
+    yy_assert(!yyjson_mut_doc_arr_replace(doc, arr, 0, NULL));
+    yy_assert(!yyjson_mut_doc_arr_replace(doc, arr, 1, yyjson_mut_int(doc, 1)));
+    yy_assert(!yyjson_mut_doc_arr_remove(doc, arr, 1));
+    yy_assert(yyjson_mut_arr_size(arr) == 1);
+    
+    // indexed objects and arrays in the same document
+    val = yyjson_mut_obj(doc);
+    yy_assert(yyjson_mut_doc_obj_index(doc, val));
+    for (int i = 0; i < 1000; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "k%d", i);
+        yy_assert(yyjson_mut_doc_arr_append(doc, arr, yyjson_mut_int(doc, i)));
+        yy_assert(yyjson_mut_doc_obj_add(doc, val, yyjson_mut_strcpy(doc, key),
+                                         yyjson_mut_int(doc, i)));
+    }
+    yy_assert(yyjson_mut_get_int(yyjson_mut_doc_arr_get(doc, arr, 1000)) == 999);
+    yy_assert(yyjson_mut_get_int(yyjson_mut_doc_obj_get(doc, val, "k999")) == 999);
+    yy_assert(yyjson_mut_obj_size(val) == 1000);
+    yyjson_mut_doc_free(doc);
+    
+    // memory allocation failure
+    char buf[4096];
+    yyjson_alc alc;
+    yy_assert(yyjson_alc_pool_init(&alc, buf, sizeof(buf)));
+    doc = yyjson_mut_doc_new(&alc);
+    yy_assert(doc);
+    yy_assert(yyjson_mut_doc_set_val_pool_size(doc, 8));
+    arr = yyjson_mut_arr(doc);
+    yy_assert(yyjson_mut_doc_arr_index(doc, arr));
+    int count = 0;
+    bool idx_fail = false;
+    while (count < 1000) {
+        val = yyjson_mut_int(doc, count);
+        if (!val) break;
+        if (!yyjson_mut_doc_arr_append(doc, arr, val)) {
+            idx_fail = true;
+            break;
+        }
+        count++;
+    }
+    yy_assert(idx_fail && count > 0);
+    yy_assert(yyjson_mut_arr_size(arr) == (size_t)count);
+    for (int i = 0; i < count; i++) {
+        yy_assert(yyjson_mut_get_int(yyjson_mut_doc_arr_get(doc, arr, i)) == i);
+    }
+    yyjson_mut_doc_free(doc);
+}
+
+
+
 yy_test_case(test_json_mut_val) {
     test_json_mut_val_api();
     test_json_mut_arr_api();
     test_json_mut_obj_api();
+    test_json_mut_obj_index_api();
+    test_json_mut_arr_index_api();
     test_json_mut_doc_api();
     test_json_mut_equals_api();
 }
@@ -18,9 +18,223 @@ typedef enum {
     FLAG_INF_NAN    = 1 << 2,
     FLAG_EXTRA      = 1 << 3,
     FLAG_NUM_RAW    = 1 << 4,
-    FLAG_MAX        = 1 << 5,
+    FLAG_INDEX      = 1 << 5,
+    FLAG_MAX        = 1 << 6,
 } flag_type;
 
+// Read data in chunks with the incremental reader, compare with the default
+// reader. The document is returned as soon as the root value is complete, so
+// the content after it is not checked if it's in the later chunks.
+static void test_incr_read(const char *dat, usize len, yyjson_read_flag flg, usize chunk) {
+    flg &= ~YYJSON_READ_INSITU;
+    yyjson_read_err err, incr_err;
+    yyjson_doc *doc = yyjson_read_opts((char *)(void *)(usize)(const void *)dat, len, flg, NULL, &err);
+    yyjson_incr_state *state = yyjson_incr_new(flg, NULL);
+    yy_assert(state);
+    
+    yyjson_doc *incr_doc = NULL;
+    usize pos = 0;
+    bool fin = false;
+    while (true) {
+        if (pos < len) {
+            usize n = len - pos < chunk ? len - pos : chunk;
+            incr_doc = yyjson_incr_read(state, dat + pos, n, &incr_err);
+            pos += n;
+        } else {
+            incr_doc = yyjson_incr_read(state, NULL, 0, &incr_err);
+            fin = true;
+        }
+        if (incr_err.code != YYJSON_READ_ERROR_MORE) break;
+        yy_assert(!fin);
+    }
+    yy_assert(!yyjson_incr_read(state, "1", 1, NULL));
+    yyjson_incr_free(state);
+    
+    if (incr_doc && !fin) {
+        yy_assert(doc || err.code == YYJSON_READ_ERROR_UNEXPECTED_CONTENT ||
+                  err.code == YYJSON_READ_ERROR_INVALID_COMMENT);
+        yy_assert(doc || err.pos >= yyjson_doc_get_read_size(incr_doc));
+    } else {
+        yy_assert(!doc == !incr_doc);
+        yy_assert(err.code == incr_err.code);
+        yy_assert(err.pos == incr_err.pos);
+        yy_assert(yyjson_doc_get_read_size(doc) == yyjson_doc_get_read_size(incr_doc));
+    }
+    if (doc && incr_doc) {
+        yy_assert(yyjson_doc_get_val_count(doc) == yyjson_doc_get_val_count(incr_doc));
+        yy_assert(yyjson_equals(doc->root, incr_doc->root));
+    }
+    yyjson_doc_free(doc);
+    yyjson_doc_free(incr_doc);
+}
+
+// Walk a lazy value and decode all scalars, compare with the value read by the
+// default reader if it's not NULL. Returns false if a value cannot be decoded.
+static bool test_lazy_walk(yyjson_lazy_val lazy, yyjson_val *val) {
+    yyjson_type type = yyjson_lazy_get_type(lazy);
+    yyjson_lazy_iter iter;
+    yyjson_lazy_val lkey, lval;
+    yyjson_val tmp;
+    if (type == YYJSON_TYPE_ARR) {
+        usize idx = 0;
+        yy_assert(yyjson_lazy_iter_init(lazy, &iter));
+        yy_assert(!val || yyjson_is_arr(val));
+        while (yyjson_lazy_arr_next(&iter, &lval)) {
+            yyjson_val *item = val ? yyjson_arr_get(val, idx) : NULL;
+            yy_assert(!val || item);
+            if (!test_lazy_walk(lval, item)) return false;
+            if (idx < 3) yy_assert(yyjson_lazy_arr_get(lazy, idx).cur == lval.cur);
+            idx++;
+        }
+        yy_assert(!val || idx == yyjson_arr_size(val));
+        yy_assert(!yyjson_lazy_arr_get(lazy, idx).cur);
+        return true;
+    }
+    if (type == YYJSON_TYPE_OBJ) {
+        usize idx = 0;
+        yy_assert(yyjson_lazy_iter_init(lazy, &iter));
+        yy_assert(!val || yyjson_is_obj(val));
+        while (yyjson_lazy_obj_next(&iter, &lkey, &lval)) {
+            if (!yyjson_lazy_get_val(lkey, &tmp)) return false;
+            yy_assert(yyjson_is_str(&tmp));
+            if (val) {
+                yyjson_val *item = yyjson_obj_getn(val, yyjson_get_str(&tmp), yyjson_get_len(&tmp));
+                yy_assert(item);
+                // the first value of duplicated keys
+                yyjson_lazy_val first = yyjson_lazy_obj_getn(lazy, yyjson_get_str(&tmp), yyjson_get_len(&tmp));
+                yy_assert(first.cur && first.cur <= lval.cur);
+                if (first.cur == lval.cur && !test_lazy_walk(lval, item)) return false;
+            }
+            if (!test_lazy_walk(lval, NULL)) return false;
+            idx++;
+        }
+        yy_assert(!val || idx == yyjson_obj_size(val));
+        return true;
+    }
+    if (!yyjson_lazy_get_val(lazy, &tmp)) return false;
+    yy_assert(yyjson_get_type(&tmp) == type ||
+              (type == YYJSON_TYPE_NUM && yyjson_get_type(&tmp) == YYJSON_TYPE_RAW));
+    if (val) {
+        yy_assert(yyjson_equals(&tmp, val));
+        if (yyjson_is_str(val)) yy_assert(yyjson_get_str(&tmp)[yyjson_get_len(&tmp)] == '\0');
+    }
+    return true;
+}
+
+// Read data with the lazy reader, compare with the default reader. The lazy
+// reader validates the structure only, the content errors are found when the
+// values are decoded.
+static void test_lazy_read(const char *dat, usize len, yyjson_read_flag flg) {
+    flg &= ~YYJSON_READ_INSITU;
+    yyjson_read_err err, lazy_err;
+    yyjson_doc *doc = yyjson_read_opts((char *)(void *)(usize)(const void *)dat, len, flg, NULL, &err);
+    yyjson_lazy_doc *lazy = yyjson_lazy_read(dat, len, flg, NULL, &lazy_err);
+    if (doc) {
+        yy_assert(lazy);
+        yy_assert(lazy_err.code == YYJSON_READ_SUCCESS);
+        yy_assert(test_lazy_walk(yyjson_lazy_doc_get_root(lazy), doc->root));
+        
+        yyjson_read_err sub_err;
+        yyjson_doc *sub = yyjson_lazy_get_doc(yyjson_lazy_doc_get_root(lazy), NULL, &sub_err);
+        yy_assert(sub && yyjson_equals(sub->root, doc->root));
+        yyjson_doc_free(sub);
+    } else if (lazy) {
+        yy_assert(!test_lazy_walk(yyjson_lazy_doc_get_root(lazy), NULL));
+    } else {
+        yy_assert(lazy_err.code != YYJSON_READ_SUCCESS && lazy_err.msg);
+        yy_assert(lazy_err.pos <= len);
+    }
+    
+#if !YYJSON_DISABLE_UTILS
+    // an empty pointer selects the whole document, the content is validated
+    const char *ptr = "";
+    yyjson_read_err sel_err;
+    yyjson_doc *sel = yyjson_read_select(dat, len, &ptr, 1, flg, NULL, &sel_err);
+    if (doc) {
+        yy_assert(sel && yyjson_equals(sel->root, doc->root));
+        yy_assert(sel->val_read == doc->val_read);
+        yy_assert(sel->dat_read == doc->dat_read);
+    } else {
+        yy_assert(!sel && sel_err.code != YYJSON_READ_SUCCESS && sel_err.msg);
+        yy_assert(sel_err.pos <= len);
+        if (!lazy) yy_assert(sel_err.code == lazy_err.code && sel_err.pos == lazy_err.pos);
+    }
+    yyjson_doc_free(sel);
+#endif
+    
+    yyjson_lazy_doc_free(lazy);
+    yyjson_doc_free(doc);
+}
+
+// Find all keys of all objects with the key index, the result should be the
+// same as the linear search.
+static void test_key_index(yyjson_doc *doc) {
+    if (!doc) return;
+    yyjson_val *val = doc->root, *end = doc->root + doc->val_read;
+    for (; val < end; val++) {
+        if (!yyjson_is_obj(val)) continue;
+        yyjson_val *key, *tmp;
+        size_t idx, max;
+        yyjson_obj_foreach(val, idx, max, key, tmp) {
+            const char *str = yyjson_get_str(key);
+            size_t len = yyjson_get_len(key);
+            yy_assert(yyjson_doc_obj_getn(doc, val, str, len) == yyjson_obj_getn(val, str, len));
+        }
+        yy_assert(!yyjson_doc_obj_get(doc, val, "\x01\x02"));
+    }
+}
+
+// Walk the compact value with the value of the document, the types, lengths,
+// numbers and strings should be the same.
+static void test_compact_walk(yyjson_compact_val cval, yyjson_val *val) {
+    yy_assert(yyjson_compact_get_type(cval) == yyjson_get_type(val));
+    yy_assert(yyjson_compact_get_len(cval) == yyjson_get_len(val));
+    yyjson_compact_iter iter;
+    yyjson_compact_val ckey, cchild;
+    yyjson_val tmp, *key, *child;
+    size_t idx, max;
+    switch (yyjson_get_type(val)) {
+        case YYJSON_TYPE_ARR:
+            yy_assert(!yyjson_compact_get_val(cval, &tmp));
+            yy_assert(yyjson_compact_iter_init(cval, &iter));
+            yyjson_arr_foreach(val, idx, max, child) {
+                yy_assert(yyjson_compact_arr_next(&iter, &cchild));
+                test_compact_walk(cchild, child);
+            }
+            yy_assert(!yyjson_compact_arr_next(&iter, &cchild));
+            break;
+        case YYJSON_TYPE_OBJ:
+            yy_assert(!yyjson_compact_get_val(cval, &tmp));
+            yy_assert(yyjson_compact_iter_init(cval, &iter));
+            yyjson_obj_foreach(val, idx, max, key, child) {
+                yy_assert(yyjson_compact_obj_next(&iter, &ckey, &cchild));
+                test_compact_walk(ckey, key);
+                test_compact_walk(cchild, child);
+            }
+            yy_assert(!yyjson_compact_obj_next(&iter, &ckey, &cchild));
+            break;
+        default:
+            yy_assert(yyjson_compact_get_val(cval, &tmp));
+            yy_assert(yyjson_equals(&tmp, val));
+            yy_assert(tmp.tag == val->tag);
+            break;
+    }
+}
+
+// Copy the document into a compact document, the values should be the same.
+static void test_compact_copy(yyjson_doc *doc) {
+    if (!doc) return;
+    yyjson_compact_doc *cdoc = yyjson_doc_compact_copy(doc, NULL);
+    yy_assert(cdoc);
+    yyjson_compact_val root = yyjson_compact_doc_get_root(cdoc);
+    test_compact_walk(root, doc->root);
+    yyjson_doc *copy = yyjson_compact_get_doc(root, NULL);
+    yy_assert(copy && yyjson_equals(copy->root, doc->root));
+    yy_assert(yyjson_doc_get_val_count(copy) == yyjson_doc_get_val_count(doc));
+    yyjson_doc_free(copy);
+    yyjson_compact_doc_free(cdoc);
+}
+
 static void test_read_file(const char *path, flag_type type, expect_type expect) {
     
 #if YYJSON_DISABLE_UTF8_VALIDATION
@@ -41,6 +255,7 @@ static void test_read_file(const char *path, flag_type type, expect_type expect)
     if (type & FLAG_INF_NAN) flag |= YYJSON_READ_ALLOW_INF_AND_NAN;
     if (type & FLAG_EXTRA) flag |= YYJSON_READ_STOP_WHEN_DONE;
     if (type & FLAG_NUM_RAW) flag |= YYJSON_READ_NUMBER_AS_RAW;
+    if (type & FLAG_INDEX) flag |= YYJSON_READ_STRUCTURAL_INDEX;
     
     // test read from file
     yyjson_read_err err;
@@ -59,6 +274,59 @@ static void test_read_file(const char *path, flag_type type, expect_type expect)
         yy_assert(err.code != YYJSON_READ_SUCCESS);
         yy_assert(err.msg != NULL);
     }
+    
+    // test structural index reader, should have the same result
+    yyjson_read_err idx_err;
+    yyjson_doc *idx_doc = yyjson_read_file(path, flag | YYJSON_READ_STRUCTURAL_INDEX, NULL, &idx_err);
+    yy_assertf(!doc == !idx_doc, "index reader has different result:\n%s\n", path);
+    yy_assert(err.code == idx_err.code);
+    yy_assert(err.pos == idx_err.pos);
+    yy_assert(yyjson_doc_get_read_size(doc) == yyjson_doc_get_read_size(idx_doc));
+    yy_assert(yyjson_doc_get_val_count(doc) == yyjson_doc_get_val_count(idx_doc));
+#if !YYJSON_DISABLE_WRITER
+    if (doc) {
+        char *ret = yyjson_write(doc, YYJSON_WRITE_ALLOW_INF_AND_NAN, NULL);
+        char *idx_ret = yyjson_write(idx_doc, YYJSON_WRITE_ALLOW_INF_AND_NAN, NULL);
+        yy_assert(ret && idx_ret && strcmp(ret, idx_ret) == 0);
+        free(ret);
+        free(idx_ret);
+    }
+#endif
+    yyjson_doc_free(idx_doc);
+    
+    // test memory-mapped file, should have the same result
+    yyjson_read_err map_err;
+    yyjson_doc *map_doc = yyjson_read_file(path, flag | YYJSON_READ_MMAP, NULL, &map_err);
+    yy_assertf(!doc == !map_doc, "mmap reader has different result:\n%s\n", path);
+    yy_assert(err.code == map_err.code);
+    yy_assert(err.pos == map_err.pos);
+    yy_assert(yyjson_doc_get_read_size(doc) == yyjson_doc_get_read_size(map_doc));
+    yy_assert(yyjson_doc_get_val_count(doc) == yyjson_doc_get_val_count(map_doc));
+    if (doc) yy_assert(yyjson_equals(doc->root, map_doc->root));
+    yyjson_doc_free(map_doc);
+    
+    // test key index, should find the same values
+    yyjson_doc *key_doc = yyjson_read_file(path, flag | YYJSON_READ_KEY_INDEX, NULL, NULL);
+    yy_assert(!doc == !key_doc);
+    test_key_index(key_doc);
+    yyjson_doc_free(key_doc);
+    
+    // test compact document, should have the same values
+    test_compact_copy(doc);
+    
+    // test incremental reader, should have the same result
+    {
+        u8 *dat;
+        usize len;
+        if (yy_file_read(path, &dat, &len)) {
+            test_incr_read((const char *)dat, len, flag, 1);
+            test_incr_read((const char *)dat, len, flag, 7);
+            test_incr_read((const char *)dat, len, flag, 4096);
+            test_lazy_read((const char *)dat, len, flag);
+            free(dat);
+        }
+    }
+    
     if (doc) { // test write again
 #if !YYJSON_DISABLE_WRITER
         usize len;
@@ -79,6 +347,7 @@ static void test_read_file(const char *path, flag_type type, expect_type expect)
     char alc_buf[64];
     yy_assert(yyjson_alc_pool_init(&alc_small, alc_buf, sizeof(void *) * 8));
     yy_assert(!yyjson_read_file(path, flag, &alc_small, NULL));
+    yy_assert(!yyjson_read_file(path, flag | YYJSON_READ_MMAP, &alc_small, NULL));
     
     
     // test read insitu
@@ -285,7 +554,1081 @@ static void test_json_encoding(void) {
     yy_dir_free(names);
 }
 
+// Long whitespace runs are skipped in blocks, test each block boundary.
+static void test_json_spaces(void) {
+    const char *pattern[] = { " ", "\t", "\n", "\r\n", " \t\n\r", "  \n" };
+    const char *tokens[] = { "[", "1", ",", "{", "\"a\"", ":", "[]", "}", "]" };
+    usize token_num = sizeof(tokens) / sizeof(tokens[0]);
+    
+    for (usize p = 0; p < sizeof(pattern) / sizeof(pattern[0]); p++) {
+        for (usize len = 0; len <= 100; len++) {
+            char ws[128];
+            usize pat_len = strlen(pattern[p]);
+            for (usize i = 0; i < len; i++) ws[i] = pattern[p][i % pat_len];
+            ws[len] = '\0';
+            
+#if YYJSON_DISABLE_NON_STANDARD
+            int c_num = 1;
+#else
+            int c_num = 2;
+#endif
+            for (int c = 0; c < c_num; c++) {
+                // with comments: "ws/*c*/ws" between each token
+                char buf[3000] = { 0 };
+                strcat(buf, ws);
+                if (c) strcat(buf, "/*c*/");
+                for (usize t = 0; t < token_num; t++) {
+                    strcat(buf, tokens[t]);
+                    strcat(buf, ws);
+                    if (c) strcat(buf, "/*c*/");
+                    if (c) strcat(buf, ws);
+                }
+                
+                yyjson_read_flag flg = c ? YYJSON_READ_ALLOW_COMMENTS : 0;
+                yyjson_doc *doc = yyjson_read(buf, strlen(buf), flg);
+                yy_assertf(doc, "read fail: %s\n", buf);
+                yyjson_val *root = yyjson_doc_get_root(doc);
+                yy_assert(yyjson_arr_size(root) == 2);
+                yy_assert(yyjson_get_int(yyjson_arr_get(root, 0)) == 1);
+                yyjson_val *obj = yyjson_arr_get(root, 1);
+                yy_assert(yyjson_is_arr(yyjson_obj_get(obj, "a")));
+                yy_assert(doc->dat_read == strlen(buf));
+                yyjson_doc_free(doc);
+            }
+        }
+    }
+}
+
+// The structural index is built in chunks, test strings across the chunks.
+static void test_json_index(void) {
+    const char *fills[] = { "a", "\\\\", "\\\"", "\\n", "\xC3\xA9", " ", "{}" };
+    for (usize f = 0; f < sizeof(fills) / sizeof(fills[0]); f++) {
+        for (usize len = 0x3FC0; len <= 0x4040; len += 3) {
+            // [1,"fill...fill",{"k":"fill...fill"}]
+            usize fill_len = strlen(fills[f]);
+            char *buf = (char *)malloc(len * 2 + 64);
+            char *cur = buf;
+            cur += sprintf(cur, "[1,\"");
+            for (usize i = 0; i + fill_len <= len / 2; i += fill_len) {
+                memcpy(cur, fills[f], fill_len);
+                cur += fill_len;
+            }
+            cur += sprintf(cur, "\", {\"k\" : \"");
+            for (usize i = 0; i + fill_len <= len / 2; i += fill_len) {
+                memcpy(cur, fills[f], fill_len);
+                cur += fill_len;
+            }
+            cur += sprintf(cur, "\"}]");
+            
+            usize buf_len = (usize)(cur - buf);
+            for (usize trunc = 0; trunc < 2; trunc++) {
+                usize dat_len = trunc ? buf_len - 4 - len / 4 : buf_len;
+                yyjson_read_err err, idx_err;
+                yyjson_doc *doc = yyjson_read_opts(buf, dat_len, 0, NULL, &err);
+                yyjson_doc *idx_doc = yyjson_read_opts(buf, dat_len, YYJSON_READ_STRUCTURAL_INDEX, NULL, &idx_err);
+                yy_assert(trunc ? !doc : !!doc);
+                yy_assert(!doc == !idx_doc);
+                yy_assert(err.code == idx_err.code);
+                yy_assert(err.pos == idx_err.pos);
+                if (doc) {
+                    yyjson_val *str = yyjson_arr_get(doc->root, 1);
+                    yyjson_val *idx_str = yyjson_arr_get(idx_doc->root, 1);
+                    yy_assert(yyjson_equals(str, idx_str));
+                    str = yyjson_obj_get(yyjson_arr_get(doc->root, 2), "k");
+                    idx_str = yyjson_obj_get(yyjson_arr_get(idx_doc->root, 2), "k");
+                    yy_assert(yyjson_equals(str, idx_str));
+                }
+                yyjson_doc_free(doc);
+                yyjson_doc_free(idx_doc);
+            }
+            free(buf);
+        }
+    }
+}
+
+// Read large documents with multiple threads, compare with the default reader.
+static void test_json_parallel_one(char *dat, usize len, yyjson_read_flag flg) {
+    yyjson_read_err err, par_err;
+    char *buf = (char *)malloc(len + YYJSON_PADDING_SIZE);
+    char *par_buf = (char *)malloc(len + YYJSON_PADDING_SIZE);
+    memcpy(buf, dat, len);
+    memcpy(par_buf, dat, len);
+    yyjson_doc *doc = yyjson_read_opts(buf, len, flg, NULL, &err);
+    yyjson_doc *par_doc = yyjson_read_parallel(par_buf, len, flg, NULL, 4, &par_err);
+    yy_assert(!doc == !par_doc);
+    yy_assert(err.code == par_err.code);
+    if (!(flg & YYJSON_READ_INSITU)) yy_assert(err.pos == par_err.pos);
+    yy_assert(yyjson_doc_get_read_size(doc) == yyjson_doc_get_read_size(par_doc));
+    yy_assert(yyjson_doc_get_val_count(doc) == yyjson_doc_get_val_count(par_doc));
+    if (doc) yy_assert(yyjson_equals(doc->root, par_doc->root));
+    yyjson_doc_free(doc);
+    yyjson_doc_free(par_doc);
+    free(buf);
+    free(par_buf);
+}
+
+static void test_json_parallel(void) {
+    const char *record =
+        "{\"id\":%d,\"name\":\"a\\\"[b,\\\\\",\"tags\":[\"x}\", \"y\\n\"],"
+        "\"v\":[1.5,-2e3,true,null,{\"k\":[]}], \"s\":\"\xC3\xA9,{\"}";
+    usize cap = 0x500000;
+    char *dat = (char *)malloc(cap + 256);
+    
+    for (int is_obj = 0; is_obj <= 1; is_obj++) {
+        char *cur = dat;
+        int id = 0;
+        *cur++ = is_obj ? '{' : '[';
+        while ((usize)(cur - dat) < cap) {
+            if (id) cur += sprintf(cur, id % 7 ? "," : " ,\n  ");
+            if (is_obj) cur += sprintf(cur, "\"key%d\":", id);
+            cur += sprintf(cur, record, id);
+            id++;
+        }
+        *cur++ = is_obj ? '}' : ']';
+        usize len = (usize)(cur - dat);
+        
+        test_json_parallel_one(dat, len, 0);
+        test_json_parallel_one(dat, len, YYJSON_READ_INSITU);
+        test_json_parallel_one(dat, len, YYJSON_READ_NUMBER_AS_RAW);
+        
+        // trailing comma
+        cur[-1] = ',';
+        *cur = is_obj ? '}' : ']';
+        test_json_parallel_one(dat, len + 1, 0);
+        test_json_parallel_one(dat, len + 1, YYJSON_READ_ALLOW_TRAILING_COMMAS);
+        cur[-1] = is_obj ? '}' : ']';
+        
+        // extra content after the document
+        const char *extra = " [1,{\"a\", 2]";
+        memcpy(cur, extra, strlen(extra));
+        test_json_parallel_one(dat, len + strlen(extra), 0);
+        test_json_parallel_one(dat, len + strlen(extra), YYJSON_READ_STOP_WHEN_DONE);
+        test_json_parallel_one(dat, len + strlen(extra), YYJSON_READ_STOP_WHEN_DONE | YYJSON_READ_INSITU);
+        
+        // truncated document
+        test_json_parallel_one(dat, len - 1, 0);
+        test_json_parallel_one(dat, len / 2, 0);
+        
+        // invalid content in the middle
+        for (usize i = 0; i < 4; i++) {
+            char *pos = dat + len / 4 * i + len / 8;
+            char c = *pos;
+            *pos = i % 2 ? '"' : ']';
+            test_json_parallel_one(dat, len, 0);
+            test_json_parallel_one(dat, len, YYJSON_READ_INSITU);
+            *pos = c;
+        }
+    }
+    
+    // small or non-container documents
+    test_json_parallel_one((char *)"[1,2,3]", 7, 0);
+    test_json_parallel_one((char *)"  \"abc\"", 7, 0);
+    yy_assert(!yyjson_read_parallel(NULL, 0, 0, NULL, 0, NULL));
+    free(dat);
+}
+
+// Read documents in chunks, tokens are split at every position.
+static void test_json_incr(void) {
+    const char *docs[] = {
+        "[1,-2.5e-3,true,false,null,\"abc\",[],{},[[{\"a\":[]}]]]",
+        "{\"a\\\"b\\\\\":\"\\u00e9\\uD83D\\uDE00\xC3\xA9\", \"n\" : 18446744073709551616}",
+        "  \"str\\\\\"  ",
+        "  12345678901234567890  ",
+        " /* a */ [1 // b\n, /**/ 2 /* c */] // d",
+        "[1,2,]",
+        "{\"a\":1,}",
+        "[NaN, -Infinity, inf, nan]",
+        "[1.5e, 2]",
+        "[\"\\u00\", 1]",
+        "[tru, 1]",
+        "[1 2]",
+        "{\"a\" 1}",
+        "[1,\"\xC3\"]",
+        "[1]] ",
+        "[1] /* unclosed",
+        "[1] /",
+        "\xEF\xBB\xBF[1]",
+        "   ",
+        "/* a */",
+        "/* a",
+    };
+    yyjson_read_flag flgs[] = {
+        0,
+        YYJSON_READ_ALLOW_COMMENTS | YYJSON_READ_ALLOW_TRAILING_COMMAS,
+        YYJSON_READ_ALLOW_INF_AND_NAN | YYJSON_READ_NUMBER_AS_RAW,
+        YYJSON_READ_STOP_WHEN_DONE | YYJSON_READ_ALLOW_INVALID_UNICODE,
+    };
+    for (usize d = 0; d < sizeof(docs) / sizeof(docs[0]); d++) {
+        usize len = strlen(docs[d]);
+        for (usize f = 0; f < sizeof(flgs) / sizeof(flgs[0]); f++) {
+            for (usize chunk = 1; chunk <= len; chunk++) {
+                test_incr_read(docs[d], len, flgs[f], chunk);
+            }
+        }
+    }
+    
+    // large document with long strings, the buffer grows many times
+    usize cap = 0x100000;
+    char *dat = (char *)malloc(cap + 256);
+    char *cur = dat;
+    *cur++ = '[';
+    for (int i = 0; (usize)(cur - dat) < cap; i++) {
+        cur += sprintf(cur, "{\"id\":%d,\"s\":\"", i);
+        for (int j = 0; j < i % 100; j++) cur += sprintf(cur, j % 10 ? "ab" : "\\n");
+        cur += sprintf(cur, "\"},");
+    }
+    cur[-1] = ']';
+    test_incr_read(dat, (usize)(cur - dat), 0, 1000);
+    test_incr_read(dat, (usize)(cur - dat), YYJSON_READ_NUMBER_AS_RAW, 333);
+    free(dat);
+    
+    // invalid parameters and finished state
+    yyjson_read_err err;
+    yyjson_incr_state *state;
+    yy_assert(!yyjson_incr_read(NULL, "1", 1, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    yyjson_incr_free(NULL);
+    
+    state = yyjson_incr_new(0, NULL);
+    yy_assert(!yyjson_incr_read(state, NULL, 0, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_incr_read(state, "1", 1, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    yyjson_incr_free(state);
+    
+    state = yyjson_incr_new(0, NULL);
+    yy_assert(!yyjson_incr_read(state, "[1,", 3, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_MORE);
+    yy_assert(err.pos == 3);
+    yyjson_incr_free(state); // free unfinished state
+    
+    // allocation failure
+    yyjson_alc alc;
+    char buf[1024];
+    yy_assert(yyjson_alc_pool_init(&alc, buf, sizeof(buf)));
+    state = yyjson_incr_new(0, &alc);
+    yy_assert(state);
+    yy_assert(!yyjson_incr_read(state, "[1,2,3]", 7, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_MEMORY_ALLOCATION);
+    yyjson_incr_free(state);
+}
+
+// Read JSON lines with the lines reader, compare each line with the default
+// reader. Lines are read from memory or file, one by one or in batches.
+static void test_lines_read(const char *dat, usize len, yyjson_read_flag flg,
+                            bool use_file, usize count, usize nthreads) {
+    yyjson_lines_reader *rd;
+    FILE *file = NULL;
+    if (use_file) {
+        file = tmpfile();
+        yy_assert(file);
+        yy_assert(fwrite(dat, 1, len, file) == len);
+        rewind(file);
+        rd = yyjson_lines_new_fp(file, flg, NULL);
+    } else {
+        rd = yyjson_lines_new(dat, len, flg, NULL);
+    }
+    yy_assert(rd);
+    
+    yyjson_doc **docs = (yyjson_doc **)malloc(count * sizeof(yyjson_doc *));
+    yyjson_read_err *errs = (yyjson_read_err *)malloc(count * sizeof(yyjson_read_err));
+    usize num = 0, idx = 0;
+    const char *cur = dat, *end = dat + len;
+    while (cur < end) {
+        const char *eol = (const char *)memchr(cur, '\n', (usize)(end - cur));
+        if (!eol) eol = end;
+        usize line_len = (usize)(eol - cur);
+        usize i = 0;
+        while (i < line_len && (cur[i] == ' ' || cur[i] == '\t' || cur[i] == '\r')) i++;
+        yyjson_read_err err;
+        yyjson_doc *doc = yyjson_read_opts((char *)(void *)(usize)(const void *)cur, line_len,
+                                           flg & ~YYJSON_READ_STOP_WHEN_DONE, NULL, &err);
+        if (i < line_len && (doc || err.code != YYJSON_READ_ERROR_EMPTY_CONTENT)) {
+            if (idx == num) {
+                if (count == 1) {
+                    docs[0] = yyjson_lines_read(rd, &errs[0]);
+                    num = 1;
+                } else {
+                    num = yyjson_lines_read_batch(rd, docs, errs, count, nthreads);
+                }
+                idx = 0;
+            }
+            yy_assert(idx < num);
+            yy_assert(!doc == !docs[idx]);
+            yy_assert(err.code == errs[idx].code);
+            if (doc) {
+                yy_assert(yyjson_equals(doc->root, docs[idx]->root));
+                yy_assert(yyjson_doc_get_read_size(doc) == yyjson_doc_get_read_size(docs[idx]));
+            } else {
+                yy_assert(err.pos + (usize)(cur - dat) == errs[idx].pos);
+            }
+            idx++;
+        }
+        yyjson_doc_free(doc);
+        cur = eol + 1;
+    }
+    yy_assert(idx == num);
+    if (count == 1) {
+        yyjson_read_err err;
+        yy_assert(!yyjson_lines_read(rd, &err));
+        yy_assert(err.code == YYJSON_READ_SUCCESS);
+    } else {
+        yy_assert(yyjson_lines_read_batch(rd, docs, errs, count, nthreads) == 0);
+    }
+    yyjson_lines_free(rd);
+    if (file) fclose(file);
+    free(docs);
+    free(errs);
+}
+
+// Read JSON lines with blank, invalid and long lines.
+static void test_json_lines(void) {
+    const char *lines[] = {
+        "{\"id\":%d,\"name\":\"a\\\"b\",\"tags\":[\"x\",\"y\\n\"],\"v\":[1.5,-2e3,true,null]}",
+        "[%d, \"\xC3\xA9\", {}]  \r",
+        "  %d  ",
+        "",
+        "   \r",
+        "// comment %d",
+        "/* %d */ [1, 2,] /* b */",
+        "{\"a\": %d",
+        "[%d] [2]",
+        "\"%d",
+    };
+    usize line_num = sizeof(lines) / sizeof(lines[0]);
+    usize cap = 0x200000;
+    char *dat = (char *)malloc(cap + 0x40000);
+    char *cur = dat;
+    for (int i = 0; (usize)(cur - dat) < cap; i++) {
+        cur += sprintf(cur, lines[(usize)i % line_num], i);
+        *cur++ = '\n';
+        if (i % 1000 == 999) {
+            // a long line, the slot and stream buffer grow
+            *cur++ = '[';
+            for (int j = 0; j < i; j++) cur += sprintf(cur, "%d,", j);
+            cur[-1] = ']';
+            *cur++ = '\n';
+        }
+    }
+    usize len = (usize)(cur - dat);
+    
+    yyjson_read_flag flgs[] = {
+        0,
+        YYJSON_READ_ALLOW_COMMENTS | YYJSON_READ_ALLOW_TRAILING_COMMAS,
+        YYJSON_READ_NUMBER_AS_RAW | YYJSON_READ_STOP_WHEN_DONE,
+    };
+    for (usize f = 0; f < sizeof(flgs) / sizeof(flgs[0]); f++) {
+        for (int use_file = 0; use_file <= 1; use_file++) {
+            test_lines_read(dat, len, flgs[f], use_file, 1, 1);
+            test_lines_read(dat, len, flgs[f], use_file, 7, 1);
+            test_lines_read(dat, len, flgs[f], use_file, 5000, 4);
+            test_lines_read(dat, len, flgs[f], use_file, 100000, 0);
+        }
+    }
+    
+    // short inputs, the last line may not end with a line feed
+    const char *small[] = { "", "\n", "1", "1\n", "1\n\n2", "\r\n[1]\r\n", "[1,\n2]" };
+    for (usize i = 0; i < sizeof(small) / sizeof(small[0]); i++) {
+        for (int use_file = 0; use_file <= 1; use_file++) {
+            test_lines_read(small[i], strlen(small[i]), 0, use_file, 1, 1);
+            test_lines_read(small[i], strlen(small[i]), 0, use_file, 3, 2);
+        }
+    }
+    free(dat);
+    
+    // invalid parameters
+    yyjson_read_err err;
+    yyjson_doc *doc;
+    yy_assert(!yyjson_lines_new(NULL, 1, 0, NULL));
+    yy_assert(!yyjson_lines_new_fp(NULL, 0, NULL));
+    yy_assert(!yyjson_lines_read(NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    yyjson_lines_free(NULL);
+    yyjson_lines_reader *rd = yyjson_lines_new(NULL, 0, 0, NULL);
+    yy_assert(rd);
+    yy_assert(!yyjson_lines_read(rd, &err));
+    yy_assert(err.code == YYJSON_READ_SUCCESS);
+    yy_assert(yyjson_lines_read_batch(rd, &doc, NULL, 0, 0) == 0);
+    yyjson_lines_free(rd);
+    
+    // allocation failure, the reader continues with the shorter lines
+    yyjson_alc alc;
+    char buf[1024];
+    const char *str = "[1]\n[1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,"
+                      "21,22,23,24,25,26,27,28,29,30,31,32,33,34,35,36,37,38]\n[2]";
+    yy_assert(yyjson_alc_pool_init(&alc, buf, sizeof(buf)));
+    rd = yyjson_lines_new(str, strlen(str), 0, &alc);
+    yy_assert(rd);
+    doc = yyjson_lines_read(rd, &err);
+    yy_assert(yyjson_get_len(yyjson_doc_get_root(doc)) == 1);
+    yy_assert(!yyjson_lines_read(rd, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_MEMORY_ALLOCATION);
+    yy_assert(err.pos == 4);
+    doc = yyjson_lines_read(rd, &err);
+    yy_assert(yyjson_get_len(yyjson_doc_get_root(doc)) == 1);
+    yy_assert(!yyjson_lines_read(rd, &err));
+    yyjson_lines_free(rd);
+}
+
+// Read documents lazily, access a few values of a large document.
+static void test_json_lazy(void) {
+    const char *docs[] = {
+        "[1,-2.5e-3,true,false,null,\"abc\",[],{},[[{\"a\":[]}]]]",
+        "{\"a\\\"b\\\\\":\"\\u00e9\\uD83D\\uDE00\xC3\xA9\", \"n\" : 18446744073709551616}",
+        "{\"a\":1,\"a\":2,\"\\u0061\":3}",
+        "  \"str\\\\\"  ",
+        "  12345678901234567890  ",
+        " /* [\" */ [1 // ]\"\n, /**/ [2, \"]/*\"] /* } */] // {",
+        "[1,2,]",
+        "{\"a\":1,}",
+        "[NaN, -Infinity, inf, nan, +1]",
+        "[1.5e, 2]",
+        "[1x, 2]",
+        "[\"\\u00\", 1]",
+        "[\"\\x\"]",
+        "[\"\x01\"]",
+        "[1,\"\xC3\"]",
+        "[tru, 1]",
+        "[nul]",
+        "[1 2]",
+        "{\"a\" 1}",
+        "{1:1}",
+        "[1]] ",
+        "[1] /* unclosed",
+        "[1] x",
+        "[1,",
+        "[\"abc",
+        "\xEF\xBB\xBF[1]",
+        "   ",
+        "/* a */",
+        "/* a",
+    };
+    yyjson_read_flag flgs[] = {
+        0,
+        YYJSON_READ_ALLOW_COMMENTS | YYJSON_READ_ALLOW_TRAILING_COMMAS,
+        YYJSON_READ_ALLOW_INF_AND_NAN | YYJSON_READ_NUMBER_AS_RAW,
+        YYJSON_READ_STOP_WHEN_DONE | YYJSON_READ_ALLOW_INVALID_UNICODE,
+        YYJSON_READ_BIGNUM_AS_RAW,
+    };
+    for (usize d = 0; d < sizeof(docs) / sizeof(docs[0]); d++) {
+        for (usize f = 0; f < sizeof(flgs) / sizeof(flgs[0]); f++) {
+            test_lazy_read(docs[d], strlen(docs[d]), flgs[f]);
+        }
+    }
+    
+    // large document, strings with escaped quotes and brackets cross blocks
+    usize cap = 0x100000;
+    char *dat = (char *)malloc(cap + 256);
+    char *cur = dat;
+    cur += sprintf(cur, "{\"skip\":[");
+    for (int i = 0; (usize)(cur - dat) < cap; i++) {
+        cur += sprintf(cur, "{\"id\":%d,\"s\":\"", i);
+        for (int j = 0; j < i % 70; j++) cur += sprintf(cur, j % 7 ? "]" : "\\\"}\\\\");
+        cur += sprintf(cur, "\",\"v\":[[%d],{}]},", i);
+    }
+    cur[-1] = ']';
+    cur += sprintf(cur, ",\"user\":{\"id\":42,\"name\":\"yy\\njson\"},\"last\":[1,2,3]}");
+    usize len = (usize)(cur - dat);
+    test_lazy_read(dat, len, 0);
+    test_lazy_read(dat, len, YYJSON_READ_ALLOW_COMMENTS);
+    
+    yyjson_read_err err;
+    yyjson_val val;
+    yyjson_lazy_doc *lazy = yyjson_lazy_read(dat, len, 0, NULL, &err);
+    yyjson_lazy_val root = yyjson_lazy_doc_get_root(lazy);
+    yyjson_lazy_val user = yyjson_lazy_obj_get(root, "user");
+    yy_assert(yyjson_lazy_get_type(user) == YYJSON_TYPE_OBJ);
+    yy_assert(yyjson_lazy_get_val(yyjson_lazy_obj_get(user, "id"), &val));
+    yy_assert(yyjson_get_sint(&val) == 42);
+    yy_assert(yyjson_lazy_get_val(yyjson_lazy_obj_get(user, "name"), &val));
+    yy_assert(strcmp(yyjson_get_str(&val), "yy\njson") == 0);
+    yy_assert(!yyjson_lazy_get_val(user, &val));
+    yy_assert(yyjson_lazy_get_val(yyjson_lazy_arr_get(yyjson_lazy_obj_get(root, "last"), 2), &val));
+    yy_assert(yyjson_get_int(&val) == 3);
+    yy_assert(!yyjson_lazy_obj_get(root, "none").cur);
+    yy_assert(!yyjson_lazy_obj_get(user, NULL).cur);
+    yy_assert(!yyjson_lazy_arr_get(user, 0).cur);
+    yy_assert(yyjson_lazy_get_type(yyjson_lazy_obj_get(root, "none")) == YYJSON_TYPE_NONE);
+    yyjson_doc *doc = yyjson_lazy_get_doc(user, NULL, &err);
+    yy_assert(doc && yyjson_obj_size(doc->root) == 2);
+    yyjson_doc_free(doc);
+    yyjson_lazy_doc_free(lazy);
+    
+    // in-situ, the data is not modified
+    memset(dat + len, 0, YYJSON_PADDING_SIZE);
+    char *copy = (char *)malloc(len);
+    memcpy(copy, dat, len);
+    lazy = yyjson_lazy_read(dat, len, YYJSON_READ_INSITU, NULL, &err);
+    yy_assert(test_lazy_walk(yyjson_lazy_doc_get_root(lazy), NULL));
+    yy_assert(memcmp(copy, dat, len) == 0);
+    yyjson_lazy_doc_free(lazy);
+    free(copy);
+    
+    // deep nesting
+    len = 0;
+    for (int i = 0; i < 1000; i++) {
+        if (i % 2) dat[len++] = '[';
+        else len += (usize)sprintf(dat + len, "{\"k\":");
+    }
+    for (int i = 999; i >= 0; i--) dat[len++] = i % 2 ? ']' : '}';
+    test_lazy_read(dat, len, 0);
+    test_lazy_read(dat, len - 1, 0);
+    free(dat);
+    
+    // error position
+    lazy = yyjson_lazy_read("[1,{\"a\":2 3}]", 13, 0, NULL, &err);
+    yy_assert(!lazy && err.code == YYJSON_READ_ERROR_UNEXPECTED_CHARACTER && err.pos == 10);
+    lazy = yyjson_lazy_read("[1,[\"a\"", 7, 0, NULL, &err);
+    yy_assert(!lazy && err.code == YYJSON_READ_ERROR_UNEXPECTED_END && err.pos == 7);
+    lazy = yyjson_lazy_read("[1, [2, 3e]]", 12, 0, NULL, &err);
+    root = yyjson_lazy_doc_get_root(lazy);
+    yy_assert(yyjson_lazy_get_val(yyjson_lazy_arr_get(root, 0), &val));
+    yy_assert(!yyjson_lazy_get_val(yyjson_lazy_arr_get(yyjson_lazy_arr_get(root, 1), 1), &val));
+    yy_assert(!yyjson_lazy_get_doc(root, NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_NUMBER && err.pos == 10);
+    yyjson_lazy_doc_free(lazy);
+    
+    // invalid parameters
+    yy_assert(!yyjson_lazy_read(NULL, 1, 0, NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_lazy_read("1", 0, 0, NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    root = yyjson_lazy_doc_get_root(NULL);
+    yy_assert(!root.cur && !yyjson_lazy_get_val(root, &val));
+    yy_assert(!yyjson_lazy_get_doc(root, NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    yyjson_lazy_iter iter;
+    yy_assert(!yyjson_lazy_iter_init(root, &iter));
+    yy_assert(!yyjson_lazy_arr_next(&iter, NULL));
+    yy_assert(!yyjson_lazy_obj_next(NULL, NULL, NULL));
+    yyjson_lazy_doc_free(NULL);
+    
+    // allocation failure
+    yyjson_alc alc;
+    char buf[256];
+    yy_assert(yyjson_alc_pool_init(&alc, buf, sizeof(buf)));
+    char str[1000];
+    memset(str, ' ', sizeof(str));
+    str[0] = '1';
+    yy_assert(!yyjson_lazy_read(str, sizeof(str), 0, &alc, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_MEMORY_ALLOCATION);
+}
+
+#if !YYJSON_DISABLE_UTILS
+// Read a document with the selective reader, the selected values should be the
+// same as the values read by the default reader.
+static yyjson_doc *test_select_read(const char *dat, const char **ptrs, usize num,
+                                    yyjson_read_flag flg, const char *expect) {
+    yyjson_read_err err;
+    yyjson_doc *sel = yyjson_read_select(dat, strlen(dat), ptrs, num, flg, NULL, &err);
+    yy_assert(sel && err.code == YYJSON_READ_SUCCESS);
+    yyjson_doc *doc = yyjson_read_opts((char *)(void *)(usize)(const void *)dat, strlen(dat), flg, NULL, NULL);
+    yy_assert(doc);
+    for (usize i = 0; i < num; i++) {
+        if (strchr(ptrs[i], '*')) continue;
+        yyjson_val *val = yyjson_ptr_get(doc->root, ptrs[i]);
+        yyjson_val *sel_val = yyjson_ptr_get(sel->root, ptrs[i]);
+        yy_assert(!val == !sel_val);
+        if (val) yy_assert(yyjson_equals(val, sel_val));
+    }
+    yyjson_doc_free(doc);
+#if !YYJSON_DISABLE_WRITER
+    if (expect) {
+        char *str = yyjson_write(sel, 0, NULL);
+        yy_assertf(str && strcmp(str, expect) == 0, "expect: %s\nreturn: %s\n", expect, str);
+        free(str);
+    }
+#else
+    (void)expect;
+#endif
+    return sel;
+}
+
+// Read a few values of documents with JSON Pointers.
+static void test_json_select(void) {
+    const char *dat = "{\"user\":{\"id\":1,\"name\":\"a\\\"b\"},"
+                      "\"events\":[{\"ts\":1,\"x\":[1,2]},{\"y\":2},{\"ts\":3},{\"z\":[]}],"
+                      "\"a/b\":{\"m~n\":true},\"arr\":[0,1,[2],3,4,5],"
+                      "\"k\\u0065y\":\"v\\n\",\"dup\":1,\"dup\":[2],\"big\":[1e9]}";
+    const char *ptrs[] = { "/user/id", "/events/*/ts", "/a~1b/m~0n", "/arr/3",
+                           "/missing", "/user/id/x", "/arr/2/0/x", "/key", "/dup" };
+    yyjson_doc *doc;
+    
+    doc = test_select_read(dat, ptrs, sizeof(ptrs) / sizeof(ptrs[0]), 0,
+        "{\"user\":{\"id\":1},\"events\":[{\"ts\":1},null,{\"ts\":3}],"
+        "\"a/b\":{\"m~n\":true},\"arr\":[null,null,null,3],"
+        "\"key\":\"v\\n\",\"dup\":1,\"dup\":[2]}");
+    yy_assert(yyjson_doc_get_read_size(doc) == strlen(dat));
+    yy_assert(yyjson_doc_get_val_count(doc) == 31);
+    yyjson_doc_free(doc);
+    
+    // a pointer to a parent selects all the children
+    const char *user[] = { "/user/id", "/user", "/arr/2" };
+    doc = test_select_read(dat, user, 3, 0, "{\"user\":{\"id\":1,\"name\":\"a\\\"b\"},\"arr\":[null,null,[2]]}");
+    yyjson_doc_free(doc);
+    
+    // no pointer, or nothing is selected
+    doc = test_select_read(dat, NULL, 0, 0, "{}");
+    yyjson_doc_free(doc);
+    doc = test_select_read(dat, ptrs + 4, 3, 0, "{}");
+    yyjson_doc_free(doc);
+    doc = test_select_read(" [[1], 2] ", ptrs, 2, 0, "[]");
+    yyjson_doc_free(doc);
+    doc = test_select_read(" \"abc\" ", ptrs, 1, 0, "\"abc\"");
+    yyjson_doc_free(doc);
+    
+    // wildcard in nested arrays, raw numbers
+    const char *all[] = { "/*/*" };
+    doc = test_select_read("[[1, 2.5], {\"*\": 3}, [], [[4]]]", all, 1, YYJSON_READ_NUMBER_AS_RAW,
+                           "[[1,2.5],{\"*\":3},null,[[4]]]");
+    yy_assert(yyjson_is_raw(yyjson_ptr_get(doc->root, "/0/1")));
+    yyjson_doc_free(doc);
+    const char *star[] = { "/*" };
+    doc = test_select_read("{\"*\": 1, \"a\": 2}", star, 1, 0, "{\"*\":1}");
+    yyjson_doc_free(doc);
+    
+    // comments and trailing commas
+    const char *cmt[] = { "/b/1" };
+    doc = test_select_read("{\"a\": [\"]\" /* ] */], // }\n \"b\" : [1, {\"c\": \"}\"}, ], }",
+                           cmt, 1, YYJSON_READ_ALLOW_COMMENTS | YYJSON_READ_ALLOW_TRAILING_COMMAS,
+                           "{\"b\":[null,{\"c\":\"}\"}]}");
+    yyjson_doc_free(doc);
+    
+    // the content of the values that are not selected is not validated
+    yyjson_read_err err;
+    const char *bad = "{\"a\": \"\\x\", \"b\": [1, -], \"c\": 1}";
+    const char *ptr_a[] = { "/a" }, *ptr_b[] = { "/b/1" }, *ptr_c[] = { "/c" };
+    doc = yyjson_read_select(bad, strlen(bad), ptr_c, 1, 0, NULL, &err);
+    yy_assert(doc && yyjson_get_int(yyjson_ptr_get(doc->root, "/c")) == 1);
+    yyjson_doc_free(doc);
+    doc = yyjson_read_select(bad, strlen(bad), ptr_a, 1, 0, NULL, &err);
+    yy_assert(!doc && err.code == YYJSON_READ_ERROR_INVALID_STRING && err.pos == 8);
+    doc = yyjson_read_select(bad, strlen(bad), ptr_b, 1, 0, NULL, &err);
+    yy_assert(!doc && err.code == YYJSON_READ_ERROR_INVALID_NUMBER && err.pos == 22);
+    doc = yyjson_read_select("[1x]", 4, star, 1, 0, NULL, &err);
+    yy_assert(!doc && err.code == YYJSON_READ_ERROR_UNEXPECTED_CHARACTER && err.pos == 2);
+    doc = yyjson_read_select("[1, 2", 5, ptr_a, 1, 0, NULL, &err);
+    yy_assert(!doc && err.code == YYJSON_READ_ERROR_UNEXPECTED_END);
+    
+    // invalid parameters
+    const char *inv[] = { "/a", "a" }, *nul[] = { NULL };
+    yy_assert(!yyjson_read_select(dat, strlen(dat), inv, 2, 0, NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    inv[1] = "/a~2";
+    yy_assert(!yyjson_read_select(dat, strlen(dat), inv, 2, 0, NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_read_select(dat, strlen(dat), nul, 1, 0, NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_read_select(dat, strlen(dat), NULL, 1, 0, NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_read_select(NULL, 1, ptrs, 1, 0, NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_read_select(dat, 0, ptrs, 1, 0, NULL, NULL));
+    
+    // large document, only a few values are built
+    usize cap = 0x100000, len, num = 0;
+    char *buf = (char *)malloc(cap + 256);
+    char *cur = buf;
+    cur += sprintf(cur, "{\"events\":[");
+    while ((usize)(cur - buf) < cap) {
+        cur += sprintf(cur, "{\"id\":\"%d\\t\",\"data\":[[1,2,{\"ts\":0}],\"]\\\\\"],\"ts\":%d},", (int)num, (int)num);
+        num++;
+    }
+    cur[-1] = ']';
+    cur += sprintf(cur, ",\"user\":{\"id\":42}}");
+    len = (usize)(cur - buf);
+    const char *tele[] = { "/user/id", "/events/*/ts" };
+    doc = yyjson_read_select(buf, len, tele, 2, 0, NULL, &err);
+    yy_assert(doc);
+    yy_assert(yyjson_get_int(yyjson_ptr_get(doc->root, "/user/id")) == 42);
+    yyjson_val *events = yyjson_ptr_get(doc->root, "/events");
+    yy_assert(yyjson_arr_size(events) == num);
+    yyjson_val *event;
+    usize idx, max;
+    yyjson_arr_foreach(events, idx, max, event) {
+        yy_assert(yyjson_obj_size(event) == 1);
+        yy_assert(yyjson_get_sint(yyjson_obj_get(event, "ts")) == (i64)idx);
+    }
+    yy_assert(yyjson_doc_get_val_count(doc) == 7 + num * 3);
+    yyjson_doc_free(doc);
+    
+    // in-situ, the data is not modified
+    memset(buf + len, 0, YYJSON_PADDING_SIZE);
+    const char *ids[] = { "/events/*/id" };
+    doc = yyjson_read_select(buf, len, ids, 1, YYJSON_READ_INSITU, NULL, &err);
+    yy_assert(doc);
+    yy_assert(strcmp(yyjson_get_str(yyjson_ptr_get(doc->root, "/events/1/id")), "1\t") == 0);
+    yy_assert(buf[len - 1] == '}');
+    yyjson_doc_free(doc);
+    free(buf);
+    
+    // memory allocation failure
+    char pool[2048];
+    yyjson_alc alc;
+    bool done = false;
+    for (usize size = 0; size <= sizeof(pool) && !done; size += 16) {
+        yy_assert(yyjson_alc_pool_init(&alc, pool, size) || size < 64);
+        if (size < 64) continue;
+        doc = yyjson_read_select(dat, strlen(dat), ptrs, 4, 0, &alc, &err);
+        if (doc) done = true;
+        else yy_assert(err.code == YYJSON_READ_ERROR_MEMORY_ALLOCATION);
+        yyjson_doc_free(doc);
+    }
+    yy_assert(done);
+}
+#else
+static void test_json_select(void) {}
+#endif
+
+// Find keys in large objects with the key index.
+static void test_json_key_index(void) {
+    // objects with different sizes, nested, with duplicated and escaped keys
+    usize cap = 0x100000;
+    char *dat = (char *)malloc(cap);
+    char *cur = dat;
+    cur += sprintf(cur, "{\"small\":{\"a\":1,\"b\":2},\"list\":[");
+    for (int n = 30; n < 40; n++) {
+        cur += sprintf(cur, "{");
+        for (int i = 0; i < n; i++) {
+            cur += sprintf(cur, "\"k%d\":%d,", i, i);
+        }
+        cur += sprintf(cur, "\"k0\":-1,\"\":0,\"\\u006b\\u0031x\":\"esc\",\"nested\":{");
+        for (int i = 0; i < 40; i++) {
+            cur += sprintf(cur, "\"k%d\":[%d],", i, i + 100);
+        }
+        cur[-1] = '}';
+        cur += sprintf(cur, "},");
+    }
+    cur[-1] = ']';
+    cur += sprintf(cur, "}");
+    usize len = (usize)(cur - dat);
+    
+    yyjson_read_err err;
+    yyjson_doc *doc = yyjson_read_opts(dat, len, YYJSON_READ_KEY_INDEX, NULL, &err);
+    yy_assert(doc && doc->key_idx);
+    test_key_index(doc);
+    
+    yyjson_val *list = yyjson_obj_get(doc->root, "list");
+    yyjson_val *obj = yyjson_arr_get(list, 5); // 35 keys + 4
+    yy_assert(yyjson_obj_size(obj) == 39);
+    yy_assert(yyjson_get_int(yyjson_doc_obj_get(doc, obj, "k0")) == 0);
+    yy_assert(yyjson_get_int(yyjson_doc_obj_get(doc, obj, "k34")) == 34);
+    yy_assert(!yyjson_doc_obj_get(doc, obj, "k35"));
+    yy_assert(yyjson_get_int(yyjson_doc_obj_getn(doc, obj, "", 0)) == 0);
+    yy_assert(yyjson_equals_str(yyjson_doc_obj_get(doc, obj, "k1x"), "esc"));
+    yy_assert(yyjson_equals_str(yyjson_doc_obj_getn(doc, obj, "k1xyz", 3), "esc"));
+    yyjson_val *nested = yyjson_doc_obj_get(doc, obj, "nested");
+    yy_assert(yyjson_get_int(yyjson_arr_get_first(yyjson_doc_obj_get(doc, nested, "k39"))) == 139);
+    yyjson_val *small = yyjson_doc_obj_get(doc, doc->root, "small");
+    yy_assert(yyjson_get_int(yyjson_doc_obj_get(doc, small, "b")) == 2);
+    yy_assert(!yyjson_doc_obj_get(doc, small, "c"));
+    
+    // invalid parameters, or values not in the document
+    yy_assert(!yyjson_doc_obj_get(doc, NULL, "k0"));
+    yy_assert(!yyjson_doc_obj_get(doc, obj, NULL));
+    yy_assert(!yyjson_doc_obj_get(doc, list, "k0"));
+    yy_assert(yyjson_doc_obj_get(NULL, obj, "k0") == yyjson_obj_get(obj, "k0"));
+    yyjson_doc *other = yyjson_read_opts(dat, len, 0, NULL, NULL);
+    yy_assert(other && !other->key_idx);
+    yyjson_val *other_obj = yyjson_arr_get(yyjson_obj_get(other->root, "list"), 5);
+    yy_assert(yyjson_doc_obj_get(doc, other_obj, "k7") == yyjson_obj_get(other_obj, "k7"));
+    yy_assert(yyjson_doc_obj_get(other, other_obj, "k7") == yyjson_obj_get(other_obj, "k7"));
+    yyjson_doc_free(other);
+    yyjson_doc_free(doc);
+    
+    // no large object, no index
+    doc = yyjson_read_opts((char *)"{\"a\":[{\"b\":1}]}", 15, YYJSON_READ_KEY_INDEX, NULL, NULL);
+    yy_assert(doc && !doc->key_idx);
+    yyjson_doc_free(doc);
+    
+    // other readers
+    doc = yyjson_read_parallel(dat, len, YYJSON_READ_KEY_INDEX, NULL, 2, NULL);
+    yy_assert(doc && doc->key_idx);
+    test_key_index(doc);
+    yyjson_doc_free(doc);
+    
+    // memory allocation failure for the index
+    usize size = yyjson_read_max_memory_usage(len, 0);
+    void *buf = malloc(size);
+    yyjson_alc alc;
+    bool idx_fail = false;
+    for (; size > 0x1000; size -= 0x100) {
+        yy_assert(yyjson_alc_pool_init(&alc, buf, size));
+        doc = yyjson_read_opts(dat, len, 0, &alc, &err);
+        if (!doc) break;
+        yyjson_doc_free(doc);
+        doc = yyjson_read_opts(dat, len, YYJSON_READ_KEY_INDEX, &alc, &err);
+        if (doc) {
+            yy_assert(doc->key_idx);
+            yyjson_doc_free(doc);
+        } else {
+            yy_assert(err.code == YYJSON_READ_ERROR_MEMORY_ALLOCATION);
+            idx_fail = true;
+        }
+    }
+    yy_assert(idx_fail);
+    free(buf);
+    free(dat);
+}
+
+// Read values from compact documents.
+static void test_json_compact(void) {
+    const char *str = "{\"a\":1,\"b\":-1,\"c\":18446744073709551615,"
+    "\"d\":-9223372036854775808,\"e\":1.5,\"f\":0.1,\"g\":\"str\","
+    "\"h\":\"str\",\"i\":[true,null,[],{}],\"j\":{\"a\":\"a\"},"
+    "\"k\":-36028797018963968,\"l\":72057594037927935}";
+    yyjson_read_err err;
+    yyjson_compact_doc *cdoc = yyjson_compact_read(str, strlen(str), 0, NULL, &err);
+    yy_assert(cdoc && err.code == YYJSON_READ_SUCCESS);
+    yyjson_compact_val root = yyjson_compact_doc_get_root(cdoc);
+    yy_assert(yyjson_compact_get_type(root) == YYJSON_TYPE_OBJ);
+    yy_assert(yyjson_compact_get_len(root) == 12);
+    
+    // numbers, inline or with an extended word
+    yyjson_val val;
+    yy_assert(yyjson_compact_get_val(yyjson_compact_obj_get(root, "a"), &val));
+    yy_assert(yyjson_is_uint(&val) && yyjson_get_uint(&val) == 1);
+    yy_assert(yyjson_compact_get_val(yyjson_compact_obj_get(root, "b"), &val));
+    yy_assert(yyjson_is_sint(&val) && yyjson_get_sint(&val) == -1);
+    yy_assert(yyjson_compact_get_val(yyjson_compact_obj_get(root, "c"), &val));
+    yy_assert(yyjson_get_uint(&val) == UINT64_MAX);
+    yy_assert(yyjson_compact_get_val(yyjson_compact_obj_get(root, "d"), &val));
+    yy_assert(yyjson_get_sint(&val) == INT64_MIN);
+    yy_assert(yyjson_compact_get_val(yyjson_compact_obj_get(root, "e"), &val));
+    yy_assert(yyjson_get_real(&val) == 1.5);
+    yy_assert(yyjson_compact_get_val(yyjson_compact_obj_get(root, "f"), &val));
+    yy_assert(yyjson_get_real(&val) == 0.1);
+    yy_assert(yyjson_compact_get_val(yyjson_compact_obj_get(root, "k"), &val));
+    yy_assert(yyjson_get_sint(&val) == -36028797018963968LL);
+    yy_assert(yyjson_compact_get_val(yyjson_compact_obj_get(root, "l"), &val));
+    yy_assert(yyjson_get_uint(&val) == 72057594037927935ULL);
+    
+    // short strings are stored once
+    yyjson_val g, h, key;
+    yy_assert(yyjson_compact_get_val(yyjson_compact_obj_get(root, "g"), &g));
+    yy_assert(yyjson_compact_get_val(yyjson_compact_obj_get(root, "h"), &h));
+    yy_assert(yyjson_equals_str(&g, "str") && g.uni.str == h.uni.str);
+    yyjson_compact_iter iter;
+    yyjson_compact_val ckey, cval;
+    yy_assert(yyjson_compact_iter_init(root, &iter));
+    yy_assert(yyjson_compact_obj_next(&iter, &ckey, &cval));
+    yy_assert(yyjson_compact_get_val(ckey, &key));
+    yyjson_compact_val j = yyjson_compact_obj_get(root, "j");
+    yy_assert(yyjson_compact_get_val(yyjson_compact_obj_get(j, "a"), &val));
+    yy_assert(yyjson_equals_str(&val, "a") && val.uni.str == key.uni.str);
+    
+    // arrays and containers
+    yyjson_compact_val arr = yyjson_compact_obj_getn(root, "ijk", 1);
+    yy_assert(yyjson_compact_get_type(arr) == YYJSON_TYPE_ARR);
+    yy_assert(yyjson_compact_get_len(arr) == 4);
+    yy_assert(yyjson_compact_get_val(yyjson_compact_arr_get(arr, 0), &val));
+    yy_assert(yyjson_is_true(&val));
+    yy_assert(yyjson_compact_get_type(yyjson_compact_arr_get(arr, 1)) == YYJSON_TYPE_NULL);
+    yy_assert(yyjson_compact_get_len(yyjson_compact_arr_get(arr, 2)) == 0);
+    yy_assert(yyjson_compact_get_type(yyjson_compact_arr_get(arr, 3)) == YYJSON_TYPE_OBJ);
+    yy_assert(!yyjson_compact_arr_get(arr, 4).cur);
+    yy_assert(!yyjson_compact_get_val(arr, &val));
+    yyjson_doc *doc = yyjson_compact_get_doc(arr, NULL);
+    yy_assert(doc && yyjson_arr_size(doc->root) == 4);
+    yy_assert(yyjson_is_obj(yyjson_arr_get(doc->root, 3)));
+    yyjson_doc_free(doc);
+    doc = yyjson_compact_get_doc(yyjson_compact_obj_get(root, "c"), NULL);
+    yy_assert(doc && yyjson_get_uint(doc->root) == UINT64_MAX);
+    yyjson_doc_free(doc);
+    
+    // not found, or invalid parameters
+    yy_assert(!yyjson_compact_obj_get(root, "m").cur);
+    yy_assert(!yyjson_compact_obj_get(root, NULL).cur);
+    yy_assert(!yyjson_compact_obj_get(arr, "a").cur);
+    yy_assert(!yyjson_compact_arr_get(root, 0).cur);
+    yyjson_compact_val none = yyjson_compact_obj_get(root, "m");
+    yy_assert(yyjson_compact_get_type(none) == YYJSON_TYPE_NONE);
+    yy_assert(yyjson_compact_get_len(none) == 0);
+    yy_assert(!yyjson_compact_get_val(none, &val));
+    yy_assert(!yyjson_compact_get_val(root, NULL));
+    yy_assert(!yyjson_compact_get_doc(none, NULL));
+    yy_assert(!yyjson_compact_iter_init(none, &iter));
+    yy_assert(!yyjson_compact_arr_next(&iter, &cval));
+    yy_assert(!yyjson_compact_iter_init(root, NULL));
+    yy_assert(!yyjson_compact_doc_get_root(NULL).cur);
+    yy_assert(yyjson_compact_doc_get_size(NULL) == 0);
+    yy_assert(!yyjson_doc_compact_copy(NULL, NULL));
+    yyjson_compact_doc_free(NULL);
+    yyjson_compact_doc_free(cdoc);
+    
+    // read errors
+    yy_assert(!yyjson_compact_read(NULL, 1, 0, NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_compact_read("[1,2", 4, 0, NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_UNEXPECTED_END);
+    yy_assert(!yyjson_compact_read("[1,2", 4, 0, NULL, NULL));
+    
+    // an array of small numbers takes about a half of the memory
+    usize cap = 0x20000;
+    char *dat = (char *)malloc(cap);
+    char *cur = dat;
+    cur += sprintf(cur, "[");
+    for (int i = 0; i < 4000; i++) {
+        cur += sprintf(cur, "[%d,%d.5,\"v%d\",\"id\"],", i, i, i % 10);
+    }
+    cur[-1] = ']';
+    usize len = (usize)(cur - dat);
+    doc = yyjson_read_opts(dat, len, 0, NULL, NULL);
+    yy_assert(doc);
+    cdoc = yyjson_doc_compact_copy(doc, NULL);
+    yy_assert(cdoc);
+    usize size = yyjson_doc_get_val_count(doc) * sizeof(yyjson_val);
+    yy_assert(yyjson_compact_doc_get_size(cdoc) < size * 6 / 10);
+    test_compact_copy(doc);
+    
+    // memory allocation failure
+    char alc_buf[256];
+    yyjson_alc alc;
+    yy_assert(yyjson_alc_pool_init(&alc, alc_buf, sizeof(alc_buf)));
+    yy_assert(!yyjson_doc_compact_copy(doc, &alc));
+    yy_assert(!yyjson_compact_get_doc(yyjson_compact_doc_get_root(cdoc), &alc));
+    yy_assert(!yyjson_compact_read(dat, len, 0, &alc, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_MEMORY_ALLOCATION);
+    yyjson_compact_doc_free(cdoc);
+    yyjson_doc_free(doc);
+    free(dat);
+}
+
+// Save and load binary snapshots.
+static void test_json_binary(void) {
+    const char *path = "__yyjson_test_tmp__.bin";
+    usize cap = 0x20000;
+    char *dat = (char *)malloc(cap);
+    char *cur = dat;
+    cur += sprintf(cur, "{\"list\":[");
+    for (int i = 0; i < 2000; i++) {
+        cur += sprintf(cur, "{\"id\":%d,\"v\":%d.25,\"s\":\"str%d\"},", i, -i, i);
+    }
+    cur[-1] = ']';
+    cur += sprintf(cur, ",\"big\":18446744073709551615,\"empty\":\"\"}");
+    usize len = (usize)(cur - dat);
+    yyjson_doc *doc = yyjson_read_opts(dat, len, 0, NULL, NULL);
+    yy_assert(doc);
+    
+    // save and load, with and without memory mapping
+    yyjson_write_err werr;
+    yyjson_read_err err;
+    yy_file_delete(path);
+    yy_assert(yyjson_doc_save_binary(doc, path, NULL, &werr));
+    yy_assert(werr.code == YYJSON_WRITE_SUCCESS && !werr.msg);
+    for (int map = 0; map < 2; map++) {
+        yyjson_read_flag flg = map ? YYJSON_READ_MMAP : 0;
+        yyjson_compact_doc *cdoc = yyjson_compact_load_binary(path, flg, NULL, &err);
+        yy_assert(cdoc && err.code == YYJSON_READ_SUCCESS);
+        yyjson_compact_val root = yyjson_compact_doc_get_root(cdoc);
+        test_compact_walk(root, doc->root);
+        yyjson_val val;
+        yyjson_compact_val list = yyjson_compact_obj_get(root, "list");
+        yy_assert(yyjson_compact_get_val(yyjson_compact_obj_get(yyjson_compact_arr_get(list, 1999), "s"), &val));
+        yy_assert(yyjson_equals_str(&val, "str1999"));
+        yyjson_doc *copy = yyjson_compact_get_doc(root, NULL);
+        yy_assert(copy && yyjson_equals(copy->root, doc->root));
+        yyjson_doc_free(copy);
+        
+        // save the loaded document again
+        const char *path2 = "__yyjson_test_tmp2__.bin";
+        yy_assert(yyjson_compact_doc_save_binary(cdoc, path2, NULL));
+        u8 *dat1, *dat2;
+        usize len1, len2;
+        yy_assert(yy_file_read(path, &dat1, &len1));
+        yy_assert(yy_file_read(path2, &dat2, &len2));
+        yy_assert(len1 == len2 && memcmp(dat1, dat2, len1) == 0);
+        free(dat1);
+        free(dat2);
+        yy_file_delete(path2);
+        yyjson_compact_doc_free(cdoc);
+    }
+    
+    // a scalar document
+    yyjson_doc *num = yyjson_read("-1", 2, 0);
+    yy_assert(yyjson_doc_save_binary(num, path, NULL, NULL));
+    yyjson_compact_doc *cdoc = yyjson_compact_load_binary(path, YYJSON_READ_MMAP, NULL, NULL);
+    yyjson_val val;
+    yy_assert(yyjson_compact_get_val(yyjson_compact_doc_get_root(cdoc), &val));
+    yy_assert(yyjson_get_sint(&val) == -1);
+    yyjson_compact_doc_free(cdoc);
+    yyjson_doc_free(num);
+    
+    // invalid parameters
+    yy_assert(!yyjson_doc_save_binary(NULL, path, NULL, &werr));
+    yy_assert(werr.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_doc_save_binary(doc, NULL, NULL, &werr));
+    yy_assert(werr.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_compact_doc_save_binary(NULL, path, &werr));
+    yy_assert(werr.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_doc_save_binary(doc, "", NULL, &werr));
+    yy_assert(werr.code == YYJSON_WRITE_ERROR_FILE_OPEN);
+    yy_assert(!yyjson_compact_load_binary(NULL, 0, NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_compact_load_binary("", 0, NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_FILE_OPEN);
+    yy_assert(!yyjson_compact_load_binary("", YYJSON_READ_MMAP, NULL, NULL));
+    
+    // invalid snapshots, the JSON text, truncated or with extra content
+    yy_assert(yyjson_doc_save_binary(doc, path, NULL, NULL));
+    u8 *bin;
+    usize bin_len;
+    yy_assert(yy_file_read(path, &bin, &bin_len));
+    for (int map = 0; map < 2; map++) {
+        yyjson_read_flag flg = map ? YYJSON_READ_MMAP : 0;
+        yy_file_write(path, (u8 *)dat, len);
+        yy_assert(!yyjson_compact_load_binary(path, flg, NULL, &err));
+        yy_assert(err.code == YYJSON_READ_ERROR_UNEXPECTED_CONTENT);
+        yy_file_write(path, bin, 16);
+        yy_assert(!yyjson_compact_load_binary(path, flg, NULL, &err));
+        yy_assert(err.code == YYJSON_READ_ERROR_UNEXPECTED_END);
+        yy_file_write(path, bin, bin_len - 1);
+        yy_assert(!yyjson_compact_load_binary(path, flg, NULL, &err));
+        yy_assert(err.code == YYJSON_READ_ERROR_UNEXPECTED_END);
+        yy_file_write(path, bin, 0);
+        yy_assert(!yyjson_compact_load_binary(path, flg, NULL, &err));
+        yy_assert(err.code == YYJSON_READ_ERROR_UNEXPECTED_END);
+        u8 *ext = (u8 *)malloc(bin_len + 8);
+        memcpy(ext, bin, bin_len);
+        memset(ext + bin_len, 0, 8);
+        yy_file_write(path, ext, bin_len + 8);
+        yy_assert(!yyjson_compact_load_binary(path, flg, NULL, &err));
+        yy_assert(err.code == YYJSON_READ_ERROR_UNEXPECTED_CONTENT);
+        ext[8] ^= 0xFF; // byte order mark
+        yy_file_write(path, ext, bin_len);
+        yy_assert(!yyjson_compact_load_binary(path, flg, NULL, &err));
+        yy_assert(err.code == YYJSON_READ_ERROR_UNEXPECTED_CONTENT);
+        free(ext);
+    }
+    
+    // memory allocation failure
+    yy_file_write(path, bin, bin_len);
+    char alc_buf[64];
+    yyjson_alc alc;
+    yy_assert(yyjson_alc_pool_init(&alc, alc_buf, sizeof(alc_buf)));
+    yy_assert(!yyjson_compact_load_binary(path, 0, &alc, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_MEMORY_ALLOCATION);
+    yy_assert(!yyjson_compact_load_binary(path, YYJSON_READ_MMAP, &alc, NULL));
+    yy_assert(!yyjson_doc_save_binary(doc, path, &alc, &werr));
+    yy_assert(werr.code == YYJSON_WRITE_ERROR_MEMORY_ALLOCATION);
+    
+    yy_file_delete(path);
+    free(bin);
+    yyjson_doc_free(doc);
+    free(dat);
+}
+
 yy_test_case(test_json_reader) {
+    test_json_spaces();
+    test_json_index();
+    test_json_parallel();
+    test_json_incr();
+    test_json_lines();
+    test_json_lazy();
+    test_json_select();
+    test_json_key_index();
+    test_json_compact();
+    test_json_binary();
     test_json_yyjson();
     test_json_checker();
     test_json_parsing();
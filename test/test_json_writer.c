@@ -2,6 +2,10 @@
 
 #include "yyjson.h"
 #include "yy_test_utils.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 
 #if !YYJSON_DISABLE_WRITER
@@ -49,6 +53,143 @@ static usize mut_val_get_num(yyjson_mut_val *val) {
 }
 
 
+// The output of the streaming writer.
+typedef struct {
+    char *dat;
+    usize len;
+    usize cap;
+    usize max_chunk;
+    usize calls;
+    usize fail_at; // fail at this call if it's not 0
+} stream_buf;
+
+static bool stream_buf_write(void *ctx, const char *dat, usize len) {
+    stream_buf *buf = (stream_buf *)ctx;
+    yy_assert(dat && len > 0);
+    if (++buf->calls == buf->fail_at) return false;
+    if (buf->len + len > buf->cap) {
+        buf->cap = (buf->len + len) * 2;
+        buf->dat = (char *)realloc(buf->dat, buf->cap);
+    }
+    memcpy(buf->dat + buf->len, dat, len);
+    buf->len += len;
+    if (buf->max_chunk < len) buf->max_chunk = len;
+    return true;
+}
+
+// Check the output of the streaming writer with different buffer sizes.
+static void validate_json_write_stream(yyjson_mut_doc *doc, yyjson_doc *idoc,
+                                       yyjson_write_flag flg, yyjson_alc *alc,
+                                       const char *expect, usize len) {
+    usize buf_sizes[] = { 0, 1, 64, 100 };
+    for (usize i = 0; i < sizeof(buf_sizes) / sizeof(buf_sizes[0]); i++) {
+        for (int type = 0; type < 4; type++) {
+            stream_buf buf;
+            memset(&buf, 0, sizeof(buf));
+            yyjson_write_err err;
+            bool suc;
+            usize size = buf_sizes[i];
+            if (type == 0) {
+                suc = yyjson_mut_write_stream(stream_buf_write, &buf, doc, flg, size, alc, &err);
+            } else if (type == 1) {
+                suc = yyjson_mut_val_write_stream(stream_buf_write, &buf, doc->root, flg, size, alc, &err);
+            } else if (type == 2) {
+                suc = yyjson_write_stream(stream_buf_write, &buf, idoc, flg, size, alc, &err);
+            } else {
+                suc = yyjson_val_write_stream(stream_buf_write, &buf, idoc->root, flg, size, alc, &err);
+            }
+            yy_assert(suc && err.code == YYJSON_WRITE_SUCCESS);
+            yy_assert(buf.len == len && memcmp(buf.dat, expect, len) == 0);
+            
+            // stop writing in the callback
+            if (buf.calls > 1) {
+                usize calls = buf.calls;
+                free(buf.dat);
+                memset(&buf, 0, sizeof(buf));
+                buf.fail_at = calls;
+                if (type < 2) {
+                    suc = yyjson_mut_write_stream(stream_buf_write, &buf, doc, flg, size, alc, &err);
+                } else {
+                    suc = yyjson_write_stream(stream_buf_write, &buf, idoc, flg, size, alc, &err);
+                }
+                yy_assert(!suc && err.code == YYJSON_WRITE_ERROR_FILE_WRITE);
+            }
+            free(buf.dat);
+        }
+    }
+}
+
+// Write a value with the incremental writer.
+static bool writer_write_val(yyjson_writer *w, yyjson_val *val) {
+    usize idx, max;
+    yyjson_val *k, *v;
+    
+    switch (yyjson_get_type(val)) {
+        case YYJSON_TYPE_NULL:
+            return yyjson_writer_null(w);
+        case YYJSON_TYPE_BOOL:
+            return yyjson_writer_bool(w, yyjson_get_bool(val));
+        case YYJSON_TYPE_NUM:
+            if (yyjson_is_uint(val)) return yyjson_writer_uint(w, yyjson_get_uint(val));
+            if (yyjson_is_sint(val)) return yyjson_writer_sint(w, yyjson_get_sint(val));
+            return yyjson_writer_real(w, yyjson_get_real(val));
+        case YYJSON_TYPE_STR:
+            return yyjson_writer_strn(w, yyjson_get_str(val), yyjson_get_len(val));
+        case YYJSON_TYPE_RAW:
+            return yyjson_writer_rawn(w, yyjson_get_raw(val), yyjson_get_len(val));
+        case YYJSON_TYPE_ARR:
+            if (!yyjson_writer_begin_arr(w)) return false;
+            yyjson_arr_foreach(val, idx, max, v) {
+                if (!writer_write_val(w, v)) return false;
+            }
+            return yyjson_writer_end_arr(w);
+        case YYJSON_TYPE_OBJ:
+            if (!yyjson_writer_begin_obj(w)) return false;
+            yyjson_obj_foreach(val, idx, max, k, v) {
+                if (!yyjson_writer_keyn(w, yyjson_get_str(k), yyjson_get_len(k))) return false;
+                if (!writer_write_val(w, v)) return false;
+            }
+            return yyjson_writer_end_obj(w);
+        default:
+            return false;
+    }
+}
+
+// Check the output of the incremental writer.
+static void validate_json_write_incr(yyjson_doc *idoc, yyjson_write_flag flg,
+                                     yyjson_alc *alc,
+                                     const char *expect, usize len) {
+    yyjson_write_err err;
+    usize out_len;
+    
+    yyjson_writer *w = yyjson_writer_new(flg, alc);
+    yy_assert(w);
+    yy_assert(writer_write_val(w, idoc->root));
+    yy_assert(!yyjson_writer_get_str(w, &out_len) && out_len == 0);
+    yy_assert(yyjson_writer_finish(w, &err));
+    yy_assert(err.code == YYJSON_WRITE_SUCCESS);
+    const char *out = yyjson_writer_get_str(w, &out_len);
+    yy_assertf(out && out_len == len && memcmp(out, expect, len) == 0,
+               "write with flag 0x%x\nexpect:\n%s\noutput:\n%s\n", flg, expect, out);
+    yy_assert(out[len] == '\0');
+    yy_assert(yyjson_writer_finish(w, &err));
+    yy_assert(!yyjson_writer_null(w));
+    yy_assert(!yyjson_writer_finish(w, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+    yyjson_writer_free(w);
+    
+    stream_buf buf;
+    memset(&buf, 0, sizeof(buf));
+    w = yyjson_writer_new_stream(stream_buf_write, &buf, flg, 64, alc);
+    yy_assert(w);
+    yy_assert(writer_write_val(w, idoc->root));
+    yy_assert(yyjson_writer_finish(w, &err));
+    yy_assert(!yyjson_writer_get_str(w, NULL));
+    yy_assert(buf.len == len && memcmp(buf.dat, expect, len) == 0);
+    yyjson_writer_free(w);
+    free(buf.dat);
+}
+
 static void validate_json_write_with_flag(yyjson_write_flag flg,
                                           yyjson_mut_doc *doc,
                                           yyjson_alc *alc,
@@ -183,6 +324,34 @@ static void validate_json_write_with_flag(yyjson_write_flag flg,
     yy_assert(!yyjson_val_write_fp(NULL, idoc->root, flg, alc, NULL));
     
     
+    // write to callback and file descriptor
+    validate_json_write_stream(doc, idoc, flg, alc, ret, len);
+    validate_json_write_incr(idoc, flg, alc, ret, len);
+    
+    
+    // write to a reusable buffer
+    char *buf = NULL;
+    usize buf_size = 0, buf_len;
+    yy_assert(yyjson_mut_write_buf(&buf, &buf_size, doc, flg, alc, &buf_len, NULL));
+    yy_assert(buf_len == len && memcmp(buf, ret, len) == 0 && buf[len] == '\0');
+    yy_assert(yyjson_val_write_buf(&buf, &buf_size, idoc->root, flg, alc, &buf_len, NULL));
+    yy_assert(buf_len == len && memcmp(buf, ret, len) == 0 && buf[len] == '\0');
+    if (alc) alc->free_(alc->ctx, buf);
+    else free(buf);
+#if defined(__unix__) || defined(__APPLE__)
+    int tmp_fd = open(tmp_file_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    yy_assert(tmp_fd >= 0);
+    yy_assert(yyjson_write_fd(tmp_fd, idoc, flg, alc, NULL));
+    yy_assert(yyjson_mut_val_write_fd(tmp_fd, doc->root, flg, alc, NULL));
+    close(tmp_fd);
+    yy_assert(yy_file_read(tmp_file_path, &dat2, &dat2_len));
+    yy_assert(dat2_len == len * 2);
+    yy_assert(memcmp(dat2, ret, len) == 0 && memcmp(dat2 + len, ret, len) == 0);
+    free(dat2);
+    yy_file_delete(tmp_file_path);
+#endif
+    
+    
     // copy mutable doc and write again
     yyjson_mut_doc *mdoc = yyjson_doc_mut_copy(idoc, NULL);
     yy_assert(mdoc);
@@ -202,7 +371,7 @@ static void validate_json_write_with_flag(yyjson_write_flag flg,
     yyjson_mut_doc_free(mdoc);
     
     
-    if (alc) alc->free(alc->ctx, (void *)ret);
+    if (alc) alc->free_(alc->ctx, (void *)ret);
     else free((void *)ret);
 #endif
 }
@@ -261,7 +430,7 @@ static void validate_json_write_ex(yyjson_mut_doc *doc,
         char buf[64];
         yyjson_alc small_alc;
         yyjson_alc_pool_init(&small_alc, buf, 8 * sizeof(void *));
-        for (int i = 1; i < 64; i++) small_alc.malloc(small_alc.ctx, i);
+        for (int i = 1; i < 64; i++) small_alc.malloc_(small_alc.ctx, i);
         validate_json_write_ex(doc, &small_alc, NULL, NULL, NULL, NULL);
     }
 }
@@ -721,7 +890,754 @@ static void test_json_write(yyjson_alc *alc) {
     yyjson_mut_doc_free(doc);
 }
 
+// Write large documents to a callback, the chunks should be bounded.
+static void test_json_write_stream(void) {
+    yyjson_mut_doc *doc = yyjson_mut_doc_new(NULL);
+    yyjson_mut_val *root = yyjson_mut_arr(doc);
+    yyjson_mut_doc_set_root(doc, root);
+    for (int i = 0; i < 10000; i++) {
+        yyjson_mut_val *obj = yyjson_mut_arr_add_obj(doc, root);
+        yyjson_mut_obj_add_int(doc, obj, "id", i);
+        yyjson_mut_obj_add_str(doc, obj, "name", "value");
+    }
+    for (int pretty = 0; pretty < 2; pretty++) {
+        yyjson_write_flag flg = pretty ? YYJSON_WRITE_PRETTY : 0;
+        usize len;
+        char *ret = yyjson_mut_write(doc, flg, &len);
+        yy_assert(ret);
+        stream_buf buf;
+        memset(&buf, 0, sizeof(buf));
+        yy_assert(yyjson_mut_write_stream(stream_buf_write, &buf, doc, flg, 256, NULL, NULL));
+        yy_assert(buf.len == len && memcmp(buf.dat, ret, len) == 0);
+        yy_assert(buf.max_chunk <= 256 && buf.calls > len / 256);
+        free(buf.dat);
+        free(ret);
+    }
+    
+    // the buffer grows for a long string
+    usize str_len = 4096;
+    char *str = (char *)malloc(str_len);
+    memset(str, 'a', str_len);
+    yyjson_mut_arr_add_strn(doc, root, str, str_len);
+    usize len;
+    char *ret = yyjson_mut_write(doc, 0, &len);
+    yy_assert(ret);
+    stream_buf buf;
+    memset(&buf, 0, sizeof(buf));
+    yy_assert(yyjson_mut_write_stream(stream_buf_write, &buf, doc, 0, 256, NULL, NULL));
+    yy_assert(buf.len == len && memcmp(buf.dat, ret, len) == 0);
+    yy_assert(buf.max_chunk > str_len);
+    free(buf.dat);
+    free(ret);
+    free(str);
+    
+    // invalid parameters
+    yyjson_write_err err;
+    yy_assert(!yyjson_mut_write_stream(NULL, NULL, doc, 0, 0, NULL, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_mut_write_stream(stream_buf_write, &buf, NULL, 0, 0, NULL, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_write_stream(stream_buf_write, &buf, NULL, 0, 0, NULL, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_mut_write_fd(-1, doc, 0, NULL, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_write_fd(-1, NULL, 0, NULL, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+    
+    // memory allocation failure
+    char alc_buf[64];
+    yyjson_alc alc;
+    yy_assert(yyjson_alc_pool_init(&alc, alc_buf, sizeof(alc_buf)));
+    yy_assert(!yyjson_mut_write_stream(stream_buf_write, &buf, doc, 0, 0, &alc, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_MEMORY_ALLOCATION);
+    yyjson_mut_doc_free(doc);
+}
+
+// Build documents with the incremental writer.
+static void test_json_write_incr(void) {
+    yyjson_writer *w;
+    yyjson_write_err err;
+    const char *str;
+    usize len;
+    
+    // minify and pretty
+    for (int pretty = 0; pretty < 3; pretty++) {
+        yyjson_write_flag flg = pretty == 0 ? 0 :
+            pretty == 1 ? YYJSON_WRITE_PRETTY : YYJSON_WRITE_PRETTY_TWO_SPACES;
+        w = yyjson_writer_new(flg | YYJSON_WRITE_NEWLINE_AT_END, NULL);
+        yy_assert(yyjson_writer_begin_obj(w));
+        yy_assert(yyjson_writer_key(w, "id"));
+        yy_assert(yyjson_writer_uint(w, 123));
+        yy_assert(yyjson_writer_key(w, "neg"));
+        yy_assert(yyjson_writer_int(w, -1));
+        yy_assert(yyjson_writer_key(w, "pi"));
+        yy_assert(yyjson_writer_real(w, 1.5));
+        yy_assert(yyjson_writer_key(w, "name"));
+        yy_assert(yyjson_writer_str(w, "a\"b"));
+        yy_assert(yyjson_writer_key(w, "list"));
+        yy_assert(yyjson_writer_begin_arr(w));
+        yy_assert(yyjson_writer_null(w));
+        yy_assert(yyjson_writer_bool(w, true));
+        yy_assert(yyjson_writer_raw(w, "1e3"));
+        yy_assert(yyjson_writer_begin_arr(w));
+        yy_assert(yyjson_writer_end_arr(w));
+        yy_assert(yyjson_writer_begin_obj(w));
+        yy_assert(yyjson_writer_end_obj(w));
+        yy_assert(yyjson_writer_end_arr(w));
+        yy_assert(yyjson_writer_end_obj(w));
+        yy_assert(yyjson_writer_finish(w, &err));
+        str = yyjson_writer_get_str(w, &len);
+        if (pretty == 0) {
+            yy_assert(strcmp(str, "{\"id\":123,\"neg\":-1,\"pi\":1.5,"
+                "\"name\":\"a\\\"b\",\"list\":[null,true,1e3,[],{}]}\n") == 0);
+        } else if (pretty == 1) {
+            yy_assert(strcmp(str, "{\n"
+                "    \"id\": 123,\n"
+                "    \"neg\": -1,\n"
+                "    \"pi\": 1.5,\n"
+                "    \"name\": \"a\\\"b\",\n"
+                "    \"list\": [\n"
+                "        null,\n"
+                "        true,\n"
+                "        1e3,\n"
+                "        [],\n"
+                "        {}\n"
+                "    ]\n"
+                "}\n") == 0);
+        } else {
+            yy_assert(strcmp(str, "{\n"
+                "  \"id\": 123,\n"
+                "  \"neg\": -1,\n"
+                "  \"pi\": 1.5,\n"
+                "  \"name\": \"a\\\"b\",\n"
+                "  \"list\": [\n"
+                "    null,\n"
+                "    true,\n"
+                "    1e3,\n"
+                "    [],\n"
+                "    {}\n"
+                "  ]\n"
+                "}\n") == 0);
+        }
+        yyjson_writer_free(w);
+    }
+    
+    // single value
+    w = yyjson_writer_new(0, NULL);
+    yy_assert(yyjson_writer_str(w, "abc"));
+    yy_assert(yyjson_writer_finish(w, NULL));
+    yy_assert(strcmp(yyjson_writer_get_str(w, NULL), "\"abc\"") == 0);
+    yyjson_writer_free(w);
+    
+    // deep nesting and long values
+    w = yyjson_writer_new(0, NULL);
+    for (int i = 0; i < 1000; i++) yy_assert(yyjson_writer_begin_arr(w));
+    for (int i = 0; i < 1000; i++) yy_assert(yyjson_writer_end_arr(w));
+    yy_assert(yyjson_writer_finish(w, NULL));
+    str = yyjson_writer_get_str(w, &len);
+    yy_assert(len == 2000 && str[999] == '[' && str[1000] == ']');
+    yyjson_writer_free(w);
+    
+    // streaming output is bounded
+    stream_buf buf;
+    memset(&buf, 0, sizeof(buf));
+    w = yyjson_writer_new_stream(stream_buf_write, &buf, YYJSON_WRITE_PRETTY, 256, NULL);
+    yy_assert(yyjson_writer_begin_arr(w));
+    for (int i = 0; i < 10000; i++) {
+        yy_assert(yyjson_writer_begin_obj(w));
+        yy_assert(yyjson_writer_key(w, "id"));
+        yy_assert(yyjson_writer_int(w, i));
+        yy_assert(yyjson_writer_end_obj(w));
+    }
+    yy_assert(yyjson_writer_end_arr(w));
+    yy_assert(yyjson_writer_finish(w, NULL));
+    yy_assert(buf.max_chunk <= 256 && buf.calls > buf.len / 256);
+#if !YYJSON_DISABLE_READER
+    yyjson_doc *doc = yyjson_read(buf.dat, buf.len, 0);
+    yy_assert(yyjson_arr_size(yyjson_doc_get_root(doc)) == 10000);
+    yyjson_doc_free(doc);
+#endif
+    yyjson_writer_free(w);
+    free(buf.dat);
+    
+    // callback failure
+    memset(&buf, 0, sizeof(buf));
+    buf.fail_at = 1;
+    w = yyjson_writer_new_stream(stream_buf_write, &buf, 0, 64, NULL);
+    yy_assert(yyjson_writer_begin_arr(w));
+    for (int i = 0; i < 100 && yyjson_writer_uint(w, 1); i++) {}
+    yy_assert(!yyjson_writer_end_arr(w));
+    yy_assert(!yyjson_writer_finish(w, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_FILE_WRITE);
+    yyjson_writer_free(w);
+    free(buf.dat);
+    
+    // invalid call sequence
+    w = yyjson_writer_new(0, NULL);
+    yy_assert(!yyjson_writer_key(w, "a"));
+    yy_assert(!yyjson_writer_finish(w, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_writer_get_str(w, NULL));
+    yyjson_writer_free(w);
+    
+    w = yyjson_writer_new(0, NULL);
+    yy_assert(yyjson_writer_begin_obj(w));
+    yy_assert(!yyjson_writer_uint(w, 1));
+    yy_assert(!yyjson_writer_key(w, "a")); // the error is kept
+    yyjson_writer_free(w);
+    
+    w = yyjson_writer_new(0, NULL);
+    yy_assert(yyjson_writer_begin_obj(w));
+    yy_assert(yyjson_writer_key(w, "a"));
+    yy_assert(!yyjson_writer_key(w, "b"));
+    yyjson_writer_free(w);
+    
+    w = yyjson_writer_new(0, NULL);
+    yy_assert(yyjson_writer_begin_obj(w));
+    yy_assert(yyjson_writer_key(w, "a"));
+    yy_assert(!yyjson_writer_end_obj(w));
+    yyjson_writer_free(w);
+    
+    w = yyjson_writer_new(0, NULL);
+    yy_assert(yyjson_writer_begin_arr(w));
+    yy_assert(!yyjson_writer_key(w, "a"));
+    yyjson_writer_free(w);
+    
+    w = yyjson_writer_new(0, NULL);
+    yy_assert(yyjson_writer_begin_arr(w));
+    yy_assert(!yyjson_writer_end_obj(w));
+    yyjson_writer_free(w);
+    
+    w = yyjson_writer_new(0, NULL);
+    yy_assert(!yyjson_writer_end_arr(w));
+    yyjson_writer_free(w);
+    
+    w = yyjson_writer_new(0, NULL);
+    yy_assert(yyjson_writer_begin_arr(w));
+    yy_assert(!yyjson_writer_finish(w, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+    yyjson_writer_free(w);
+    
+    w = yyjson_writer_new(0, NULL);
+    yy_assert(yyjson_writer_null(w));
+    yy_assert(!yyjson_writer_null(w));
+    yyjson_writer_free(w);
+    
+    w = yyjson_writer_new(0, NULL);
+    yy_assert(!yyjson_writer_str(w, NULL));
+    yy_assert(!yyjson_writer_finish(w, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+    yyjson_writer_free(w);
+    
+    w = yyjson_writer_new(0, NULL);
+    yy_assert(!yyjson_writer_raw(w, NULL));
+    yyjson_writer_free(w);
+    
+    // invalid values
+    w = yyjson_writer_new(0, NULL);
+    yy_assert(!yyjson_writer_strn(w, "\xff", 1));
+    yy_assert(!yyjson_writer_finish(w, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_STRING);
+    yyjson_writer_free(w);
+    
+    w = yyjson_writer_new(0, NULL);
+    yy_assert(!yyjson_writer_real(w, (f64)NAN));
+    yy_assert(!yyjson_writer_finish(w, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_NAN_OR_INF);
+    yyjson_writer_free(w);
+    
+    // invalid parameters
+    yy_assert(!yyjson_writer_new_stream(NULL, NULL, 0, 0, NULL));
+    yy_assert(!yyjson_writer_finish(NULL, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_writer_get_str(NULL, NULL));
+    yy_assert(!yyjson_writer_begin_arr(NULL));
+    yy_assert(!yyjson_writer_end_arr(NULL));
+    yy_assert(!yyjson_writer_key(NULL, "a"));
+    yy_assert(!yyjson_writer_null(NULL));
+    yy_assert(!yyjson_writer_bool(NULL, true));
+    yy_assert(!yyjson_writer_uint(NULL, 1));
+    yy_assert(!yyjson_writer_sint(NULL, 1));
+    yy_assert(!yyjson_writer_real(NULL, 1.0));
+    yy_assert(!yyjson_writer_str(NULL, "a"));
+    yy_assert(!yyjson_writer_raw(NULL, "1"));
+    yyjson_writer_free(NULL);
+    
+    // memory allocation failure
+    char alc_buf[64];
+    yyjson_alc alc;
+    yy_assert(yyjson_alc_pool_init(&alc, alc_buf, sizeof(alc_buf)));
+    yy_assert(!yyjson_writer_new(0, &alc));
+    char alc_buf2[1024];
+    yy_assert(yyjson_alc_pool_init(&alc, alc_buf2, sizeof(alc_buf2)));
+    w = yyjson_writer_new(0, &alc);
+    yy_assert(w);
+    bool suc = true;
+    for (int i = 0; i < 1000 && suc; i++) suc = yyjson_writer_begin_arr(w);
+    yy_assert(!suc);
+    yy_assert(!yyjson_writer_finish(w, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_MEMORY_ALLOCATION);
+    yyjson_writer_free(w);
+}
+// An allocator which counts the allocations.
+typedef struct {
+    usize count;
+    bool fail;
+} count_alc_ctx;
+
+static void *count_malloc(void *ctx, usize size) {
+    count_alc_ctx *c = (count_alc_ctx *)ctx;
+    if (c->fail) return NULL;
+    c->count++;
+    return malloc(size);
+}
+
+static void *count_realloc(void *ctx, void *ptr, usize old_size, usize size) {
+    count_alc_ctx *c = (count_alc_ctx *)ctx;
+    (void)old_size;
+    if (c->fail) return NULL;
+    c->count++;
+    return realloc(ptr, size);
+}
+
+static void count_free(void *ctx, void *ptr) {
+    (void)ctx;
+    free(ptr);
+}
+
+// Write to a reusable buffer, the buffer is grown only if it's too small.
+static void test_json_write_buf(void) {
+    count_alc_ctx ctx = { 0, false };
+    yyjson_alc alc = { count_malloc, count_realloc, count_free, &ctx };
+    yyjson_write_err err;
+    char *buf = NULL;
+    usize buf_size = 0, len;
+    
+    yyjson_mut_doc *doc = yyjson_mut_doc_new(NULL);
+    yyjson_mut_val *root = yyjson_mut_arr(doc);
+    yyjson_mut_doc_set_root(doc, root);
+    for (int i = 0; i < 1000; i++) {
+        yyjson_mut_val *obj = yyjson_mut_arr_add_obj(doc, root);
+        yyjson_mut_obj_add_int(doc, obj, "id", i);
+        yyjson_mut_obj_add_str(doc, obj, "name", "value");
+    }
+    
+    yyjson_write_flag flags[] = { 0, YYJSON_WRITE_PRETTY, YYJSON_WRITE_NEWLINE_AT_END };
+    for (usize i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+        yyjson_write_flag flg = flags[i];
+        usize expect_len;
+        char *expect = yyjson_mut_write(doc, flg, &expect_len);
+        yy_assert(expect);
+    
+        // the first call may grow the buffer, the next calls reuse it
+        yy_assert(yyjson_mut_write_buf(&buf, &buf_size, doc, flg, &alc, &len, &err));
+        yy_assert(err.code == YYJSON_WRITE_SUCCESS);
+        yy_assert(len == expect_len && memcmp(buf, expect, len) == 0 && buf[len] == '\0');
+        yy_assert(buf_size > len);
+        ctx.count = 0;
+        for (int n = 0; n < 3; n++) {
+            char *old = buf;
+            len = 0;
+            yy_assert(yyjson_mut_write_buf(&buf, &buf_size, doc, flg, &alc, &len, NULL));
+            yy_assert(buf == old && len == expect_len && memcmp(buf, expect, len) == 0);
+            yy_assert(yyjson_mut_val_write_buf(&buf, &buf_size, root, flg, &alc, &len, NULL));
+            yy_assert(len == expect_len && memcmp(buf, expect, len) == 0);
+        }
+        yy_assert(ctx.count == 0);
+    
+#if !YYJSON_DISABLE_READER
+        yyjson_doc *idoc = yyjson_read(expect, expect_len, 0);
+        yy_assert(yyjson_write_buf(&buf, &buf_size, idoc, flg, &alc, &len, NULL));
+        yy_assert(len == expect_len && memcmp(buf, expect, len) == 0);
+        ctx.count = 0;
+        yy_assert(yyjson_val_write_buf(&buf, &buf_size, idoc->root, flg, &alc, &len, NULL));
+        yy_assert(len == expect_len && memcmp(buf, expect, len) == 0);
+        yy_assert(ctx.count == 0);
+        yyjson_doc_free(idoc);
+#endif
+        free(expect);
+    }
+    
+    // single value
+    ctx.count = 0;
+    yyjson_mut_val *str = yyjson_mut_str(doc, "abc");
+    yy_assert(yyjson_mut_val_write_buf(&buf, &buf_size, str, 0, &alc, &len, NULL));
+    yy_assert(len == 5 && strcmp(buf, "\"abc\"") == 0);
+    yy_assert(ctx.count == 0);
+    
+    // the buffer is kept on error
+    usize old_size = buf_size;
+    yyjson_mut_val *inv = yyjson_mut_strn(doc, "\xff", 1);
+    yy_assert(!yyjson_mut_val_write_buf(&buf, &buf_size, inv, 0, &alc, &len, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_STRING && len == 0);
+    yy_assert(buf && buf_size == old_size);
+    yy_assert(!yyjson_mut_write_buf(&buf, &buf_size, NULL, 0, &alc, &len, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+    yy_assert(buf && buf_size == old_size);
+    free(buf);
+    
+    // a NULL buffer is allocated, its size is ignored
+    buf = NULL;
+    buf_size = 100;
+    yy_assert(yyjson_mut_write_buf(&buf, &buf_size, doc, 0, NULL, &len, NULL));
+    yy_assert(buf && buf_size > len && buf[len] == '\0');
+    free(buf);
+    
+    // memory allocation failure
+    buf = NULL;
+    buf_size = 0;
+    ctx.fail = true;
+    yy_assert(!yyjson_mut_write_buf(&buf, &buf_size, doc, 0, &alc, &len, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_MEMORY_ALLOCATION);
+    yy_assert(!buf && buf_size == 0);
+    
+    // invalid parameters
+    yy_assert(!yyjson_mut_write_buf(NULL, &buf_size, doc, 0, NULL, &len, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER && len == 0);
+    yy_assert(!yyjson_write_buf(&buf, NULL, NULL, 0, NULL, NULL, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+    
+    yyjson_mut_doc_free(doc);
+}
+
+// Write large documents with multiple threads, compare with the default writer.
+static void test_json_write_parallel_one(yyjson_doc *doc, yyjson_write_flag flg,
+                                         usize nthreads) {
+    yyjson_write_err err, par_err;
+    usize len, par_len;
+    char *ret = yyjson_write_opts(doc, flg, NULL, &len, &err);
+    char *par_ret = yyjson_write_parallel(doc, flg, NULL, nthreads, &par_len, &par_err);
+    yy_assert(!ret == !par_ret);
+    yy_assert(err.code == par_err.code);
+    if (ret) {
+        yy_assert(len == par_len && memcmp(ret, par_ret, len) == 0);
+        yy_assert(par_ret[par_len] == '\0');
+    } else {
+        yy_assert(par_len == 0);
+    }
+    
+    // the parts are passed to the callback in order
+    stream_buf buf;
+    memset(&buf, 0, sizeof(buf));
+    bool suc = yyjson_write_parallel_stream(stream_buf_write, &buf, doc, flg, NULL, nthreads, &par_err);
+    yy_assert(suc == !!ret);
+    yy_assert(err.code == par_err.code);
+    if (ret) {
+        yy_assert(buf.len == len && memcmp(buf.dat, ret, len) == 0);
+    } else {
+        yy_assert(buf.len == 0);
+    }
+    free(buf.dat);
+    free(ret);
+    free(par_ret);
+}
+
+static void test_json_write_parallel(void) {
+    yyjson_write_err err;
+    for (int is_obj = 0; is_obj <= 1; is_obj++) {
+        yyjson_mut_doc *mdoc = yyjson_mut_doc_new(NULL);
+        yyjson_mut_val *root = is_obj ? yyjson_mut_obj(mdoc) : yyjson_mut_arr(mdoc);
+        yyjson_mut_val *last = NULL;
+        yyjson_mut_doc_set_root(mdoc, root);
+        for (int i = 0; i < 40000; i++) {
+            yyjson_mut_val *obj = yyjson_mut_obj(mdoc);
+            yyjson_mut_obj_add_int(mdoc, obj, "id", i);
+            yyjson_mut_obj_add_str(mdoc, obj, "name", "a\"b\\c");
+            yyjson_mut_val *arr = yyjson_mut_obj_add_arr(mdoc, obj, "v");
+            yyjson_mut_arr_add_real(mdoc, arr, 1.5);
+            yyjson_mut_arr_add_bool(mdoc, arr, true);
+            yyjson_mut_arr_add_null(mdoc, arr);
+            last = arr;
+            yyjson_mut_obj_add_obj(mdoc, obj, "e");
+            if (is_obj) {
+                char key[16];
+                snprintf(key, sizeof(key), "k%d", i);
+                yyjson_mut_obj_add(root, yyjson_mut_strcpy(mdoc, key), obj);
+            } else {
+                yyjson_mut_arr_append(root, obj);
+            }
+            if (i % 1000 == 0) {
+                // empty containers and scalars between the records
+                if (is_obj) {
+                    yyjson_mut_obj_add_arr(mdoc, root, "empty");
+                    yyjson_mut_obj_add_str(mdoc, root, "s", "\xC3\xA9");
+                } else {
+                    yyjson_mut_arr_add_arr(mdoc, root);
+                    yyjson_mut_arr_add_str(mdoc, root, "\xC3\xA9");
+                }
+            }
+        }
+        yyjson_doc *doc = yyjson_mut_doc_imut_copy(mdoc, NULL);
+        yy_assert(doc);
+        
+        yyjson_write_flag flags[] = {
+            0,
+            YYJSON_WRITE_PRETTY,
+            YYJSON_WRITE_PRETTY_TWO_SPACES,
+            YYJSON_WRITE_NEWLINE_AT_END,
+            YYJSON_WRITE_PRETTY | YYJSON_WRITE_NEWLINE_AT_END,
+            YYJSON_WRITE_ESCAPE_UNICODE | YYJSON_WRITE_ESCAPE_SLASHES,
+        };
+        for (usize i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+            test_json_write_parallel_one(doc, flags[i], 4);
+            test_json_write_parallel_one(doc, flags[i], 3);
+        }
+        test_json_write_parallel_one(doc, 0, 0);
+        test_json_write_parallel_one(doc, 0, 1);
+        test_json_write_parallel_one(doc, 0, 1000);
+        yyjson_doc_free(doc);
+        
+        // invalid string in the last part
+        yyjson_mut_arr_add_strn(mdoc, last, "\xff", 1);
+        doc = yyjson_mut_doc_imut_copy(mdoc, NULL);
+        test_json_write_parallel_one(doc, 0, 4);
+        test_json_write_parallel_one(doc, YYJSON_WRITE_PRETTY, 4);
+        test_json_write_parallel_one(doc, YYJSON_WRITE_ALLOW_INVALID_UNICODE, 4);
+        yyjson_doc_free(doc);
+        yyjson_mut_arr_remove_last(last);
+        
+        // one large child between small children
+        yyjson_mut_val *outer = yyjson_mut_arr(mdoc);
+        yyjson_mut_arr_add_int(mdoc, outer, 1);
+        yyjson_mut_arr_append(outer, root);
+        yyjson_mut_arr_add_int(mdoc, outer, 2);
+        yyjson_mut_doc_set_root(mdoc, outer);
+        doc = yyjson_mut_doc_imut_copy(mdoc, NULL);
+        test_json_write_parallel_one(doc, 0, 4);
+        test_json_write_parallel_one(doc, YYJSON_WRITE_PRETTY, 4);
+        
+        // callback failure, nothing is written if a part fails
+        stream_buf buf;
+        memset(&buf, 0, sizeof(buf));
+        buf.fail_at = 2;
+        yy_assert(!yyjson_write_parallel_stream(stream_buf_write, &buf, doc, 0, NULL, 4, &err));
+        yy_assert(err.code == YYJSON_WRITE_ERROR_FILE_WRITE);
+        free(buf.dat);
+        
+        // the allocator is called with a lock
+        count_alc_ctx ctx = { 0, false };
+        yyjson_alc alc = { count_malloc, count_realloc, count_free, &ctx };
+        usize len, par_len;
+        char *ret = yyjson_write(doc, 0, &len);
+        char *par_ret = yyjson_write_parallel(doc, 0, &alc, 4, &par_len, &err);
+        yy_assert(par_ret && par_len == len && memcmp(ret, par_ret, len) == 0);
+        yy_assert(ctx.count > 2);
+        free(ret);
+        free(par_ret);
+        ctx.fail = true;
+        yy_assert(!yyjson_write_parallel(doc, 0, &alc, 4, &par_len, &err));
+        yy_assert(err.code == YYJSON_WRITE_ERROR_MEMORY_ALLOCATION && par_len == 0);
+        yy_assert(!yyjson_write_parallel_stream(stream_buf_write, &buf, doc, 0, &alc, 4, &err));
+        yy_assert(err.code == YYJSON_WRITE_ERROR_MEMORY_ALLOCATION);
+        yyjson_doc_free(doc);
+        yyjson_mut_doc_free(mdoc);
+    }
+    
+    // small or non-container documents
+    yyjson_mut_doc *mdoc = yyjson_mut_doc_new(NULL);
+    yyjson_mut_val *arr = yyjson_mut_arr(mdoc);
+    yyjson_mut_arr_add_int(mdoc, arr, 1);
+    yyjson_mut_arr_add_int(mdoc, arr, 2);
+    yyjson_mut_doc_set_root(mdoc, arr);
+    yyjson_doc *doc = yyjson_mut_doc_imut_copy(mdoc, NULL);
+    test_json_write_parallel_one(doc, 0, 4);
+    test_json_write_parallel_one(doc, YYJSON_WRITE_PRETTY, 4);
+    yyjson_doc_free(doc);
+    yyjson_mut_doc_set_root(mdoc, yyjson_mut_str(mdoc, "abc"));
+    doc = yyjson_mut_doc_imut_copy(mdoc, NULL);
+    test_json_write_parallel_one(doc, YYJSON_WRITE_NEWLINE_AT_END, 4);
+    yyjson_doc_free(doc);
+    yyjson_mut_doc_free(mdoc);
+    
+    // invalid parameters
+    yy_assert(!yyjson_write_parallel(NULL, 0, NULL, 4, NULL, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_write_parallel_stream(NULL, NULL, NULL, 0, NULL, 4, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_write_parallel_stream(stream_buf_write, NULL, NULL, 0, NULL, 4, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+}
+
+// Check the canonical output of a mutable document and its immutable copy.
+static void validate_json_write_canonical(yyjson_mut_doc *doc, const char *expect) {
+    yyjson_write_flag flg = YYJSON_WRITE_CANONICAL;
+    yyjson_write_err err;
+    usize len;
+    char *ret = yyjson_mut_write_opts(doc, flg, NULL, &len, &err);
+    if (!expect) {
+        yy_assert(!ret && len == 0 && err.code != YYJSON_WRITE_SUCCESS);
+        return;
+    }
+    yy_assert(ret && len == strlen(expect) && strcmp(ret, expect) == 0);
+    free(ret);
+    
+    // the pretty flags are ignored, the newline is added
+    ret = yyjson_mut_write_opts(doc, flg | YYJSON_WRITE_PRETTY | YYJSON_WRITE_ESCAPE_UNICODE |
+                                YYJSON_WRITE_NEWLINE_AT_END, NULL, &len, NULL);
+    yy_assert(ret && len == strlen(expect) + 1 && ret[len - 1] == '\n');
+    yy_assert(memcmp(ret, expect, len - 1) == 0);
+    free(ret);
+    
+    yyjson_doc *idoc = yyjson_mut_doc_imut_copy(doc, NULL);
+    ret = yyjson_write_opts(idoc, flg, NULL, &len, NULL);
+    yy_assert(ret && len == strlen(expect) && strcmp(ret, expect) == 0);
+    free(ret);
+    
+    // the streaming writer has the same output
+    stream_buf buf;
+    memset(&buf, 0, sizeof(buf));
+    yy_assert(yyjson_write_stream(stream_buf_write, &buf, idoc, flg, 64, NULL, NULL));
+    yy_assert(buf.len == strlen(expect) && memcmp(buf.dat, expect, buf.len) == 0);
+    free(buf.dat);
+    yyjson_doc_free(idoc);
+}
+
+// Write JSON in the canonical form of RFC 8785.
+static void test_json_write_canonical(void) {
+    yyjson_mut_doc *doc = yyjson_mut_doc_new(NULL);
+    yyjson_mut_val *root, *obj, *arr;
+    
+    // the keys are sorted by UTF-16 code units (RFC 8785, 3.2.3)
+    const char *keys[] = {
+        "\xE2\x82\xAC", "\r", "\xEF\xAC\xB3", "1", "\xF0\x9F\x98\x80", "\xC2\x80", "\xC3\xB6"
+    };
+    root = yyjson_mut_obj(doc);
+    yyjson_mut_doc_set_root(doc, root);
+    for (usize i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+        yyjson_mut_obj_add_int(doc, root, keys[i], (int64_t)i);
+    }
+    validate_json_write_canonical(doc, "{\"\\r\":1,\"1\":3,\"\xC2\x80\":5,\"\xC3\xB6\":6,"
+                                  "\"\xE2\x82\xAC\":0,\"\xF0\x9F\x98\x80\":4,\"\xEF\xAC\xB3\":2}");
+    
+    // nested objects, the duplicated keys are kept in order
+    root = yyjson_mut_obj(doc);
+    yyjson_mut_doc_set_root(doc, root);
+    obj = yyjson_mut_obj_add_obj(doc, root, "b");
+    yyjson_mut_obj_add_int(doc, obj, "z", 1);
+    yyjson_mut_obj_add_int(doc, obj, "y", 2);
+    yyjson_mut_obj_add_obj(doc, obj, "x");
+    arr = yyjson_mut_obj_add_arr(doc, root, "a");
+    yyjson_mut_arr_add_arr(doc, arr);
+    obj = yyjson_mut_arr_add_obj(doc, arr);
+    yyjson_mut_obj_add_str(doc, obj, "d", "1");
+    yyjson_mut_obj_add_str(doc, obj, "c", "2");
+    yyjson_mut_obj_add_str(doc, obj, "d", "3");
+    yyjson_mut_obj_add_null(doc, root, "ab");
+    yyjson_mut_obj_add_bool(doc, root, "", false);
+    validate_json_write_canonical(doc, "{\"\":false,\"a\":[[],{\"c\":\"2\",\"d\":\"1\",\"d\":\"3\"}],"
+                                  "\"ab\":null,\"b\":{\"x\":{},\"y\":2,\"z\":1}}");
+    
+    // large object, the keys are sorted with merge sort
+    root = yyjson_mut_obj(doc);
+    yyjson_mut_doc_set_root(doc, root);
+    for (int i = 999; i >= 0; i--) {
+        char key[16];
+        snprintf(key, sizeof(key), "%03d", i % 500);
+        yyjson_mut_obj_add(root, yyjson_mut_strcpy(doc, key), yyjson_mut_int(doc, i));
+    }
+    char *expect = (char *)malloc(16 * 1000 + 2), *cur = expect;
+    *cur++ = '{';
+    for (int i = 0; i < 500; i++) {
+        cur += sprintf(cur, "%s\"%03d\":%d,\"%03d\":%d", i ? "," : "", i, i + 500, i, i);
+    }
+    *cur++ = '}';
+    *cur = '\0';
+    validate_json_write_canonical(doc, expect);
+    free(expect);
+    
+    // strings are escaped only where it's required, with lowercase hex digits
+    root = yyjson_mut_arr(doc);
+    yyjson_mut_doc_set_root(doc, root);
+    yyjson_mut_arr_add_str(doc, root, "\xE2\x82\xAC$\x0F\nA'B\"\\/\x7F\x1F\b");
+    yyjson_mut_arr_add_strn(doc, root, "\\u\0", 3);
+    validate_json_write_canonical(doc, "[\"\xE2\x82\xAC$\\u000f\\nA'B\\\"\\\\/\x7F\\u001f\\b\","
+                                  "\"\\\\u\\u0000\"]");
+    
+    // scalars
+    yyjson_mut_doc_set_root(doc, yyjson_mut_str(doc, "a/b"));
+    validate_json_write_canonical(doc, "\"a/b\"");
+    yyjson_mut_doc_set_root(doc, yyjson_mut_true(doc));
+    validate_json_write_canonical(doc, "true");
+    yyjson_mut_doc_set_root(doc, yyjson_mut_arr(doc));
+    validate_json_write_canonical(doc, "[]");
+    yyjson_mut_doc_set_root(doc, yyjson_mut_rawcpy(doc, "1.00"));
+    validate_json_write_canonical(doc, "1.00");
+    
+    // numbers are written as ECMAScript
+    struct { yyjson_mut_val *val; const char *str; } nums[] = {
+        { yyjson_mut_uint(doc, 0), "0" },
+        { yyjson_mut_sint(doc, -1), "-1" },
+        { yyjson_mut_uint(doc, 9007199254740992ULL), "9007199254740992" },
+        { yyjson_mut_sint(doc, -9007199254740992LL), "-9007199254740992" },
+        { yyjson_mut_real(doc, -0.0), "0" },
+#if !YYJSON_DISABLE_FAST_FP_CONV
+        { yyjson_mut_uint(doc, 9007199254740993ULL), "9007199254740992" },
+        { yyjson_mut_uint(doc, UINT64_MAX), "18446744073709552000" },
+        { yyjson_mut_sint(doc, INT64_MIN), "-9223372036854776000" },
+        { yyjson_mut_real(doc, 1.0), "1" },
+        { yyjson_mut_real(doc, -100.0), "-100" },
+        { yyjson_mut_real(doc, 4.5), "4.5" },
+        { yyjson_mut_real(doc, 0.002), "0.002" },
+        { yyjson_mut_real(doc, 333333333.33333329), "333333333.3333333" },
+        { yyjson_mut_real(doc, 1e30), "1e+30" },
+        { yyjson_mut_real(doc, 1e21), "1e+21" },
+        { yyjson_mut_real(doc, 1e20), "100000000000000000000" },
+        { yyjson_mut_real(doc, 1.5e-7), "1.5e-7" },
+        { yyjson_mut_real(doc, 0.000001), "0.000001" },
+        { yyjson_mut_real(doc, 1e-27), "1e-27" },
+        { yyjson_mut_real(doc, 5e-324), "5e-324" },
+        { yyjson_mut_real(doc, -1.7976931348623157e308), "-1.7976931348623157e+308" },
+#endif
+    };
+    for (usize i = 0; i < sizeof(nums) / sizeof(nums[0]); i++) {
+        yyjson_mut_doc_set_root(doc, nums[i].val);
+        validate_json_write_canonical(doc, nums[i].str);
+    }
+    
+    // errors
+    root = yyjson_mut_obj(doc);
+    yyjson_mut_doc_set_root(doc, root);
+    obj = yyjson_mut_obj_add_obj(doc, root, "a");
+    yyjson_mut_obj_add_real(doc, obj, "b", INFINITY);
+    validate_json_write_canonical(doc, NULL);
+    root = yyjson_mut_arr(doc);
+    yyjson_mut_doc_set_root(doc, root);
+    yyjson_mut_arr_add_strn(doc, root, "\xff", 1);
+    validate_json_write_canonical(doc, NULL);
+    root = yyjson_mut_obj(doc);
+    yyjson_mut_doc_set_root(doc, root);
+    yyjson_mut_obj_add_int(doc, root, "\xff", 1);
+    validate_json_write_canonical(doc, NULL);
+    yyjson_mut_doc_set_root(doc, yyjson_mut_real(doc, NAN));
+    validate_json_write_canonical(doc, NULL);
+    
+    // the incremental writer doesn't support this flag
+    yy_assert(!yyjson_writer_new(YYJSON_WRITE_CANONICAL, NULL));
+    
+#if !YYJSON_DISABLE_READER && !YYJSON_DISABLE_FAST_FP_CONV
+    // the example of RFC 8785, 3.2.2
+    const char *src = "{\"numbers\":[333333333.33333329,1E30,4.50,2e-3,0.000000000000000000000000001],"
+        "\"string\":\"\\u20ac$\\u000F\\u000aA'\\u0042\\u0022\\u005c\\\\\\\"\\/\","
+        "\"literals\":[null,true,false]}";
+    const char *dst = "{\"literals\":[null,true,false],\"numbers\":[333333333.3333333,1e+30,4.5,0.002,1e-27],"
+        "\"string\":\"\xE2\x82\xAC$\\u000f\\nA'B\\\"\\\\\\\\\\\"/\"}";
+    yyjson_doc *idoc = yyjson_read(src, strlen(src), 0);
+    usize len;
+    char *ret = yyjson_write(idoc, YYJSON_WRITE_CANONICAL, &len);
+    yy_assert(ret && strcmp(ret, dst) == 0);
+    free(ret);
+    yyjson_doc_free(idoc);
+#endif
+    
+    yyjson_mut_doc_free(doc);
+}
+
 yy_test_case(test_json_writer) {
+    test_json_write_stream();
+    test_json_write_incr();
+    test_json_write_buf();
+    test_json_write_parallel();
+    test_json_write_canonical();
     // test read and roundtrip
     {
         yyjson_alc alc;
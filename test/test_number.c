@@ -771,7 +771,7 @@ static void test_real_fast(f64 num, yyjson_alc *alc,
         const char *end = yyjson_read_number(str, &val_out, 0, alc, NULL);
         yy_assert(end && *end == '\0');
         yy_assert(val_out.uni.f64 == val.uni.f64);
-        alc->free(alc->ctx, str);
+        alc->free_(alc->ctx, str);
     }
     
     /// float to shortest
@@ -787,7 +787,7 @@ static void test_real_fast(f64 num, yyjson_alc *alc,
             f64 num2;
             f64_read(str, &num2);
             yy_assert(val2.uni.f64 == num2);
-            alc->free(alc->ctx, str);
+            alc->free_(alc->ctx, str);
         }
     }
     
@@ -805,7 +805,7 @@ static void test_real_fast(f64 num, yyjson_alc *alc,
                 f64 num2;
                 f64_read(str, &num2);
                 yy_assert(val2.uni.f64 == num2);
-                alc->free(alc->ctx, str);
+                alc->free_(alc->ctx, str);
             }
         }
     }
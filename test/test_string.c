@@ -259,8 +259,60 @@ static void validate_read_write(string_set set) {
     validate_write(set);
 }
 
+/// Build a string with a special character at `pos` surrounded by plain ASCII,
+/// long strings are scanned in blocks, this tests each block boundary.
+static void validate_long_string(usize pos, usize len, string_set spc) {
+    string_set set;
+    string_val *src[5] = { &spc.str, &spc.esc_non, &spc.esc_sla,
+                           &spc.esc_uni, &spc.esc_all };
+    string_val *dst[5] = { &set.str, &set.esc_non, &set.esc_sla,
+                           &set.esc_uni, &set.esc_all };
+    char *buf[5];
+    
+    for (int i = 0; i < 5; i++) {
+        usize buf_len = len + src[i]->len;
+        buf[i] = malloc(buf_len + 1);
+        for (usize j = 0; j < pos; j++) buf[i][j] = (char)('a' + j % 26);
+        memcpy(buf[i] + pos, src[i]->str, src[i]->len);
+        for (usize j = pos; j < len; j++) {
+            buf[i][j + src[i]->len] = (char)('A' + j % 26);
+        }
+        buf[i][buf_len] = '\0';
+        dst[i]->str = buf[i];
+        dst[i]->len = buf_len;
+    }
+    set.invalid_unicode = false;
+    validate_read_write(set);
+    for (int i = 0; i < 5; i++) free(buf[i]);
+}
+
+static void test_long_string(void) {
+    string_set spc[] = {
+        { { "", 0 }, { "", 0 }, { "", 0 }, { "", 0 }, { "", 0 } },
+        { { "\"", 1 }, { "\\\"", 2 }, { "\\\"", 2 }, { "\\\"", 2 }, { "\\\"", 2 } },
+        { { "\\", 1 }, { "\\\\", 2 }, { "\\\\", 2 }, { "\\\\", 2 }, { "\\\\", 2 } },
+        { { "\n", 1 }, { "\\n", 2 }, { "\\n", 2 }, { "\\n", 2 }, { "\\n", 2 } },
+        { { "\x1F", 1 }, { "\\u001F", 6 }, { "\\u001F", 6 }, { "\\u001F", 6 }, { "\\u001F", 6 } },
+        { { "/", 1 }, { "/", 1 }, { "\\/", 2 }, { "/", 1 }, { "\\/", 2 } },
+        { { "\xC3\xA9", 2 }, { "\xC3\xA9", 2 }, { "\xC3\xA9", 2 }, { "\\u00E9", 6 }, { "\\u00E9", 6 } },
+        { { "\xE2\x9C\x85", 3 }, { "\xE2\x9C\x85", 3 }, { "\xE2\x9C\x85", 3 }, { "\\u2705", 6 }, { "\\u2705", 6 } },
+        { { "\xF0\x9F\x98\x80", 4 }, { "\xF0\x9F\x98\x80", 4 }, { "\xF0\x9F\x98\x80", 4 }, { "\\uD83D\\uDE00", 12 }, { "\\uD83D\\uDE00", 12 } },
+        { { "\x7F", 1 }, { "\x7F", 1 }, { "\x7F", 1 }, { "\x7F", 1 }, { "\x7F", 1 } },
+    };
+    
+    for (usize i = 0; i < sizeof(spc) / sizeof(spc[0]); i++) {
+        for (usize len = 0; len <= 200; len += (len < 140 ? 1 : 7)) {
+            for (usize pos = 0; pos <= len; pos++) {
+                validate_long_string(pos, len, spc[i]);
+            }
+        }
+    }
+}
+
 yy_test_case(test_string) {
     
+    test_long_string();
+    
     validate_read_write((string_set) {
         { "", 0 },
         { "", 0 },